@@ -25,6 +25,7 @@
  */
 
 #import "ATR800GameCore.h"
+#import <PVAtari800/PVAtari800-Swift.h>
 
 @import PVSupport;
 //#import <PVSupport/OERingBuffer.h>
@@ -190,6 +191,9 @@ __weak static ATR800GameCore * _currentCore;
         Screen_show_disk_led = FALSE;
     }
 
+    // Optionally render POKEY audio per output change rather than through mzpokeysnd's long resampling filter
+    POKEYSND_enable_blep = ATR800GameCore.blep_pokey ? TRUE : FALSE;
+
     int arg = 4;
     int *argc = &arg;
     char *argv[] = {"", "-sound", "-audio8", "-dsprate 44100"};
@@ -0,0 +1,41 @@
+//
+//  ATR800Options.swift
+//  PVAtari800
+//
+//  Created by Provenance Team on 10/17/26.
+//  Copyright © 2026 Provenance Emu. All rights reserved.
+//
+
+import Foundation
+import PVSupport
+
+extension ATR800GameCore: CoreOptional {
+    enum Options {
+        enum Audio {
+            static let blepPokey: CoreOption =
+                .bool(.init(
+                    title: "Band-limited POKEY",
+                    description: "Render POKEY audio with band-limited steps instead of the filtered resampler. Faster, with a brighter top end. Experimental.",
+                    requiresRestart: true),
+                defaultValue: false)
+
+            static var allOptions: [CoreOption] = [blepPokey]
+        }
+    }
+
+    public static var options: [CoreOption] = {
+        var options = [CoreOption]()
+
+        let audioOptions: CoreOption = .group(.init(title: "Audio",
+                                                     description: nil),
+                                               subOptions: Options.Audio.allOptions)
+
+        options.append(audioOptions)
+        return options
+    }()
+}
+
+@objc
+extension ATR800GameCore {
+    public static var blep_pokey: Bool { valueForOption(Options.Audio.blepPokey).asBool }
+}
@@ -193,6 +193,11 @@ int CFG_LoadConfig(const char *alternate_config_filename)
 			else if (strcmp(string, "ENABLE_NEW_POKEY") == 0) {
 #ifdef SOUND
 				POKEYSND_enable_new_pokey = Util_sscanbool(ptr);
+#endif /* SOUND */
+			}
+			else if (strcmp(string, "ENABLE_BLEP_POKEY") == 0) {
+#ifdef SOUND
+				POKEYSND_enable_blep = Util_sscanbool(ptr);
 #endif /* SOUND */
 			}
 			else if (strcmp(string, "STEREO_POKEY") == 0) {
@@ -408,6 +413,7 @@ int CFG_WriteConfig(void)
 
 #ifdef SOUND
 	fprintf(fp, "ENABLE_NEW_POKEY=%d\n", POKEYSND_enable_new_pokey);
+	fprintf(fp, "ENABLE_BLEP_POKEY=%d\n", POKEYSND_enable_blep);
 #ifdef STEREO_SOUND
 	fprintf(fp, "STEREO_POKEY=%d\n", POKEYSND_stereo_enabled);
 #endif
@@ -24,6 +24,7 @@
 
 #include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #ifdef ASAP /* external project, see http://asap.sf.net */
@@ -94,6 +95,19 @@ static const int filter_size_8_8 = 1214;
 /* Flags and quality */
 static int snd_quality = 0;
 
+/* Band-limited step synthesis (see blip_add_change) */
+#define BLIP_PHASES 64         /* sub-sample positions of a step */
+#define BLIP_TAPS 32           /* kernel width in output samples */
+#define BLIP_KERNEL_BITS 13    /* each kernel phase sums to 1 << BLIP_KERNEL_BITS */
+#define BLIP_LEVEL_BITS 8      /* fractional bits of the output level */
+#define BLIP_CUTOFF 0.375      /* kernel cutoff, relative to the playback frequency */
+#define BLIP_CHUNK 1024        /* max samples rendered between two reads */
+#define BLIP_BUF_SIZE (BLIP_CHUNK + BLIP_TAPS + 4)
+
+static int blip_enabled = 0;
+static double blip_samples_per_tick; /* set by the functions producing the output */
+static int blip_kernel[BLIP_PHASES][BLIP_TAPS];
+
 /* Poly tables */
 static int poly4tbl[15];
 static int poly5tbl[31];
@@ -262,6 +276,13 @@ typedef struct stPokeyState
 
     int speaker;
 
+    /* Band-limited step buffer: blip_buf holds step differences,
+       blip_integ is the running sum of the ones already read out */
+    double blip_time;  /* current time in output samples from blip_buf[0] */
+    int blip_level;    /* last output level, BLIP_LEVEL_BITS fixed point */
+    int blip_integ;
+    int blip_buf[BLIP_BUF_SIZE];
+
 } PokeyState;
 
 PokeyState pokey_states[NPOKEYS];
@@ -415,6 +436,12 @@ static void ResetPokeyState(PokeyState* ps)
 
     /* GTIA speaker */
     ps->speaker = 0;
+
+    /* Band-limited step buffer */
+    ps->blip_time = 0;
+    ps->blip_level = 0;
+    ps->blip_integ = 0;
+    memset(ps->blip_buf, 0, sizeof(ps->blip_buf));
 }
 
 
@@ -513,8 +540,91 @@ static double interp_read_resam_all(PokeyState* ps, double frac)
 }
 #endif  /* SYNCHRONIZED_SOUND */
 
+/* Band-limited step synthesis
+ *
+ * Instead of queueing output changes and running the long remez filter
+ * over the queue for every output sample, each change is rendered once:
+ * its difference from the previous level is added to blip_buf as a
+ * windowed-sinc impulse placed at the change's (fractional) output sample
+ * position, and output samples are the running sum of blip_buf. This
+ * costs BLIP_TAPS additions per output change instead of roughly
+ * filter_size multiplications per output sample.
+ *
+ * Sample blip_buf[i] is final once blip_time >= i, because a change at
+ * time t only touches blip_buf[floor(t) + 1 ...]. The constant latency is
+ * BLIP_TAPS / 2 + 1 samples.
+ */
+
+static double blip_bessel_i0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    int k;
+    for (k = 1; k < 32; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+static void build_blip_kernel(void)
+{
+    static const double beta = 5.6; /* Kaiser window, ~60dB stopband */
+    double h[BLIP_TAPS];
+    int phase, i;
+
+    for (phase = 0; phase < BLIP_PHASES; phase++) {
+        double sum = 0;
+        int isum = 0, imax = 0;
+        for (i = 0; i < BLIP_TAPS; i++) {
+            /* distance of tap i from the kernel centre */
+            double x = 1 + i - (double)phase / BLIP_PHASES - BLIP_TAPS / 2;
+            double w = x / (BLIP_TAPS / 2);
+            double sinc = x == 0 ? 1.0 : sin(2 * M_PI * BLIP_CUTOFF * x) / (2 * M_PI * BLIP_CUTOFF * x);
+            h[i] = w * w >= 1 ? 0 : sinc * blip_bessel_i0(beta * sqrt(1 - w * w));
+            sum += h[i];
+        }
+        for (i = 0; i < BLIP_TAPS; i++) {
+            blip_kernel[phase][i] = (int)floor(h[i] / sum * (1 << BLIP_KERNEL_BITS) + 0.5);
+            isum += blip_kernel[phase][i];
+            if (blip_kernel[phase][i] > blip_kernel[phase][imax])
+                imax = i;
+        }
+        /* each step must integrate to exactly its height, or the output drifts */
+        blip_kernel[phase][imax] += (1 << BLIP_KERNEL_BITS) - isum;
+    }
+}
+
+static void blip_add_change(PokeyState* ps, qev_t a)
+{
+    int level = (int)(a * (1 << BLIP_LEVEL_BITS) + 0.5);
+    int delta = level - ps->blip_level;
+    double t = ps->blip_time > 0 ? ps->blip_time : 0;
+    int pos = (int)t;
+    int phase = (int)((t - pos) * BLIP_PHASES + 0.5);
+    int *buf;
+    const int *k;
+    int i;
+
+    if (delta == 0)
+        return;
+    ps->blip_level = level;
+
+    if (phase == BLIP_PHASES) {
+        phase = 0;
+        ++pos;
+    }
+    buf = ps->blip_buf + pos + 1;
+    k = blip_kernel[phase];
+    for (i = 0; i < BLIP_TAPS; i++)
+        buf[i] += delta * k[i];
+}
+
 static void add_change(PokeyState* ps, qev_t a)
 {
+    if (blip_enabled) {
+        blip_add_change(ps, a);
+        return;
+    }
     ps->qev[ps->qeend] = a;
     ps->qet[ps->qeend] = ps->curtick; /*0;*/
     ++ps->qeend;
@@ -1018,7 +1128,10 @@ static void advance_ticks(PokeyState* ps, int ticks)
 #endif
 
         advance_polies(ps,ta);
-        bump_qe_subticks(ps,ta);
+        if (blip_enabled)
+            ps->blip_time += ta * blip_samples_per_tick;
+        else
+            bump_qe_subticks(ps,ta);
 
         if(need)
         {
@@ -1255,6 +1368,8 @@ found:
 
 static void mzpokeysnd_process_8(void* sndbuffer, int sndn);
 static void mzpokeysnd_process_16(void* sndbuffer, int sndn);
+static void blip_process_8(void* sndbuffer, int sndn);
+static void blip_process_16(void* sndbuffer, int sndn);
 static void Update_pokey_sound_mz(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain);
 #ifdef SERIO_SOUND
 static void Update_serio_sound_mz(int out, UBYTE data);
@@ -1283,6 +1398,7 @@ static void Update_vol_only_sound_mz( void );
 
 #ifdef SYNCHRONIZED_SOUND
 static void generate_sync(unsigned int num_ticks);
+static void generate_sync_blip(unsigned int num_ticks);
 
 static void init_syncsound(void)
 {
@@ -1290,12 +1406,12 @@ static void init_syncsound(void)
     unsigned int ticks_per_frame = Atari800_tv_mode*114;
     ticks_per_sample = (double)ticks_per_frame / samples_per_frame;
     samp_pos = 0.0;
-    POKEYSND_GenerateSync = generate_sync;
+    POKEYSND_GenerateSync = blip_enabled ? generate_sync_blip : generate_sync;
 }
 #endif /* SYNCHRONIZED_SOUND */
 
 int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
-                        int flags, int quality
+                        int flags, int quality, int blep
 #ifdef __PLUS
                         , int clear_regs
 #endif
@@ -1304,6 +1420,10 @@ int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
     double cutoff;
 
     snd_quality = quality;
+#ifdef VOL_ONLY_SOUND
+    blep = FALSE; /* the process functions mix in POKEYSND_sampout per sample */
+#endif
+    blip_enabled = blep;
 
     POKEYSND_Update_ptr = Update_pokey_sound_mz;
 #ifdef SERIO_SOUND
@@ -1320,7 +1440,10 @@ int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
 	POKEYSND_samp_freq=playback_freq;
 #endif  /* VOL_ONLY_SOUND */
 
-	POKEYSND_Process_ptr = (flags & POKEYSND_BIT16) ? mzpokeysnd_process_16 : mzpokeysnd_process_8;
+	if (blip_enabled)
+		POKEYSND_Process_ptr = (flags & POKEYSND_BIT16) ? blip_process_16 : blip_process_8;
+	else
+		POKEYSND_Process_ptr = (flags & POKEYSND_BIT16) ? mzpokeysnd_process_16 : mzpokeysnd_process_8;
 
     switch(playback_freq)
     {
@@ -1399,9 +1522,15 @@ int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
     default:
         pokey_frq = (int)(((double)pokey_frq_ideal/POKEYSND_playback_freq) + 0.5)
           * POKEYSND_playback_freq;
-	filter_size = remez_filter_table((double)POKEYSND_playback_freq/pokey_frq,
-					 &cutoff, quality);
-	audible_frq = (int ) (cutoff * pokey_frq);
+	if (blip_enabled) {
+		build_blip_kernel();
+		audible_frq = (int) (BLIP_CUTOFF * POKEYSND_playback_freq);
+	}
+	else {
+		filter_size = remez_filter_table((double)POKEYSND_playback_freq/pokey_frq,
+						 &cutoff, quality);
+		audible_frq = (int ) (cutoff * pokey_frq);
+	}
     }
 
     build_poly4();
@@ -2308,6 +2437,58 @@ void mzpokeysnd_debugreset(UBYTE chip)
 
 #define MAX_SAMPLE 152
 
+/* Reads n final samples of ps into buffer (every stride-th SWORD or UBYTE),
+   or just drops them if buffer is NULL. */
+static void blip_read(PokeyState* ps, void* buffer, int stride, int n, int bit16)
+{
+    static const double unit = 1.0 / (1 << (BLIP_LEVEL_BITS + BLIP_KERNEL_BITS));
+    int integ = ps->blip_integ;
+    int live;
+    int i;
+
+    if (buffer == NULL) {
+        for (i = 0; i < n; i++)
+            integ += ps->blip_buf[i];
+    }
+    else if (bit16) {
+        /* same gain and DC offset as mzpokeysnd_process_16, no dither */
+        static const double gain = 65535.0 / MAX_SAMPLE / 4 * M_PI * 0.95;
+        SWORD *out = (SWORD *) buffer;
+        for (i = 0; i < n; i++) {
+            double v;
+            integ += ps->blip_buf[i];
+            v = floor((integ * unit - MAX_SAMPLE / 2.0) * gain + 0.5);
+            *out = (SWORD) (v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+            out += stride;
+        }
+    }
+    else {
+        static const double gain = 255.0 / MAX_SAMPLE / 4 * M_PI * 0.95;
+        UBYTE *out = (UBYTE *) buffer;
+        for (i = 0; i < n; i++) {
+            double v;
+            integ += ps->blip_buf[i];
+            v = floor((integ * unit - MAX_SAMPLE / 2.0) * gain
+                      + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+            *out = (UBYTE) (v > 255 ? 255 : v < 0 ? 0 : v);
+            out += stride;
+        }
+    }
+    ps->blip_integ = integ;
+
+    /* move the pending part of the buffer to the front */
+    live = (int)ps->blip_time + BLIP_TAPS + 2 - n;
+    if (live > BLIP_BUF_SIZE - n)
+        live = BLIP_BUF_SIZE - n;
+    if (live > 0) {
+        memmove(ps->blip_buf, ps->blip_buf + n, live * sizeof(int));
+        memset(ps->blip_buf + live, 0, n * sizeof(int));
+    }
+    else
+        memset(ps->blip_buf, 0, sizeof(ps->blip_buf));
+    ps->blip_time -= n;
+}
+
 static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
 {
     int i;
@@ -2405,6 +2586,43 @@ static void mzpokeysnd_process_16(void* sndbuffer, int sndn)
     }
 }
 
+static void blip_process(void* sndbuffer, int sndn, int bit16)
+{
+    int const sample_bytes = bit16 ? 2 : 1;
+    UBYTE *buffer = (UBYTE *) sndbuffer;
+    int nframes;
+    int i;
+
+    if(num_cur_pokeys<1)
+        return; /* module was not initialized */
+
+    blip_samples_per_tick = 1.0 / (pokey_frq/POKEYSND_playback_freq);
+
+    /* if there are two pokeys, then the signal is stereo */
+    nframes = sndn / num_cur_pokeys;
+    while(nframes > 0)
+    {
+        int n = nframes < BLIP_CHUNK ? nframes : BLIP_CHUNK;
+        for(i=0; i<num_cur_pokeys; i++)
+        {
+            advance_ticks(pokey_states + i, n * (pokey_frq/POKEYSND_playback_freq));
+            blip_read(pokey_states + i, buffer + i * sample_bytes, num_cur_pokeys, n, bit16);
+        }
+        buffer += n * num_cur_pokeys * sample_bytes;
+        nframes -= n;
+    }
+}
+
+static void blip_process_8(void* sndbuffer, int sndn)
+{
+    blip_process(sndbuffer, sndn, FALSE);
+}
+
+static void blip_process_16(void* sndbuffer, int sndn)
+{
+    blip_process(sndbuffer, sndn, TRUE);
+}
+
 #ifdef SYNCHRONIZED_SOUND
 static void generate_sync(unsigned int num_ticks)
 {
@@ -2456,6 +2674,63 @@ static void generate_sync(unsigned int num_ticks)
 			advance_ticks(pokey_states + i, num_ticks);
 	}
 }
+
+/* Same sample clock as generate_sync, but the pokeys are advanced and read
+   out once per run of up to BLIP_CHUNK samples instead of once per sample. */
+static void generate_sync_blip(unsigned int num_ticks)
+{
+	unsigned int const sample_bytes = (POKEYSND_snd_flags & POKEYSND_BIT16) ? 2 : 1;
+	unsigned int const frame_bytes = num_cur_pokeys * sample_bytes;
+	UBYTE *buffer = POKEYSND_process_buffer + POKEYSND_process_buffer_fill;
+	UBYTE *buffer_end = POKEYSND_process_buffer + POKEYSND_process_buffer_length;
+	int buffer_full = FALSE;
+	int done = FALSE;
+	unsigned int i;
+
+	blip_samples_per_tick = 1.0 / ticks_per_sample;
+	while (!done) {
+		unsigned int run_ticks = 0;
+		int n = 0;
+
+		while (n < BLIP_CHUNK) {
+			double int_part;
+			double new_samp_pos = modf(samp_pos + ticks_per_sample, &int_part);
+			unsigned int ticks = (unsigned int)int_part;
+			if (ticks > num_ticks - run_ticks) {
+				samp_pos -= num_ticks - run_ticks;
+				done = TRUE;
+				break;
+			}
+			if (buffer + (n + 1) * frame_bytes > buffer_end) {
+				buffer_full = done = TRUE;
+				break;
+			}
+			samp_pos = new_samp_pos;
+			run_ticks += ticks;
+			++n;
+		}
+
+		for (i = 0; i < num_cur_pokeys; ++i) {
+			advance_ticks(pokey_states + i, run_ticks);
+			blip_read(pokey_states + i, buffer + i * sample_bytes, num_cur_pokeys, n, sample_bytes == 2);
+		}
+		buffer += n * frame_bytes;
+		num_ticks -= run_ticks;
+	}
+
+	POKEYSND_process_buffer_fill = buffer - POKEYSND_process_buffer;
+	/* remaining ticks; samples that did not fit in the buffer are dropped */
+	while (num_ticks > 0) {
+		unsigned int const max_ticks = (unsigned int)(BLIP_CHUNK * ticks_per_sample);
+		unsigned int ticks = num_ticks < max_ticks ? num_ticks : max_ticks;
+		for (i = 0; i < num_cur_pokeys; ++i) {
+			advance_ticks(pokey_states + i, ticks);
+			if (buffer_full)
+				blip_read(pokey_states + i, NULL, 0, (int)pokey_states[i].blip_time, FALSE);
+		}
+		num_ticks -= ticks;
+	}
+}
 #endif /* SYNCHRONIZED_SOUND */
 
 #ifdef SERIO_SOUND
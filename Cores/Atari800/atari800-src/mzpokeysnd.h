@@ -7,7 +7,8 @@ int MZPOKEYSND_Init(ULONG freq17,
                         int playback_freq,
                         UBYTE num_pokeys,
                         int flags,
-                        int quality
+                        int quality,
+                        int blep
 #ifdef __PLUS
                         , int clear_regs
 #endif
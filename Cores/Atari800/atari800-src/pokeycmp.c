@@ -0,0 +1,479 @@
+/*
+ * pokeycmp.c - Render SAP tunes with several POKEY engines and compare them
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+ * Usage: pokeycmp [-dsprate <rate>] [-seconds <n>] [-test] file.sap ...
+ *
+ * Plays each SAP file through mzpokeysnd (remez filter) and through its
+ * band-limited step renderer, writes file-mz.wav and file-blep.wav, and
+ * prints the render time of both and their signal-to-difference ratio,
+ * after aligning them for their different filter latencies.
+ *
+ * Only TYPE R files (raw POKEY register dumps, written once per FASTPLAY
+ * scanlines) can be played, as other SAP types need a 6502 and the player
+ * routine. -test renders a built-in register sequence (tones, joined
+ * 16-bit channels, poly noise, high-pass filters and volume-only writes)
+ * to test.wav files instead.
+ *
+ * Build from this directory with:
+ *   cc -O2 -o pokeycmp pokeycmp.c pokeysnd.c mzpokeysnd.c remez.c -lm
+ */
+
+#include "config.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "atari.h"
+#include "antic.h"
+#include "gtia.h"
+#include "log.h"
+#include "pokey.h"
+#include "pokeysnd.h"
+#include "sndsave.h"
+#include "util.h"
+
+/* The parts of the emulator the sound engines read */
+unsigned int ANTIC_screenline_cpu_clock = 0;
+int ANTIC_xpos = 0;
+#ifdef NEW_CYCLE_EXACT
+int ANTIC_cur_screen_pos = ANTIC_NOT_DRAWING;
+const int *ANTIC_cpu2antic_ptr = NULL;
+#endif
+int Atari800_tv_mode = Atari800_TV_PAL;
+int GTIA_speaker = 0;
+
+/* pokey.c state, only read by the pokeysnd.c engine */
+UBYTE POKEY_AUDF[4 * POKEY_MAXPOKEYS];
+UBYTE POKEY_AUDC[4 * POKEY_MAXPOKEYS];
+UBYTE POKEY_AUDCTL[POKEY_MAXPOKEYS];
+int POKEY_Base_mult[POKEY_MAXPOKEYS];
+UBYTE POKEY_poly9_lookup[POKEY_POLY9_SIZE];
+UBYTE POKEY_poly17_lookup[16385];
+
+void Log_print(char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+}
+
+int SndSave_CloseSoundFile(void)
+{
+	return TRUE;
+}
+
+int SndSave_WriteToSoundFile(const UBYTE *ucBuffer, unsigned int uiSize)
+{
+	return 0;
+}
+
+void *Util_malloc(size_t size)
+{
+	void *ptr = malloc(size);
+	if (ptr == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+	return ptr;
+}
+
+typedef struct {
+	int stereo;
+	int fastplay;	/* scanlines between register writes */
+	int frames;
+	const UBYTE *regs;	/* 9 bytes per chip per frame */
+} Tune;
+
+enum { ENGINE_MZ, ENGINE_BLEP, ENGINE_COUNT };
+static const char * const engine_names[ENGINE_COUNT] = { "mz", "blep" };
+
+static int playback_freq = 44100;
+
+/* Returns the number of 16-bit samples (frames * channels) written to *out. */
+static long Render(const Tune *tune, int engine, SWORD **out, double *seconds)
+{
+	int const channels = tune->stereo ? 2 : 1;
+	long capacity = (long)((double)tune->frames * tune->fastplay * 114 / POKEYSND_FREQ_17_EXACT * playback_freq + 16) * channels;
+	long count = 0;
+	clock_t start;
+	int frame;
+
+	*out = (SWORD *)Util_malloc(capacity * sizeof(SWORD));
+
+	POKEYSND_enable_new_pokey = TRUE;
+	POKEYSND_enable_blep = engine == ENGINE_BLEP;
+	ANTIC_screenline_cpu_clock = 0;
+	POKEYSND_Init(POKEYSND_FREQ_17_EXACT, playback_freq, channels, POKEYSND_BIT16);
+
+	start = clock();
+	for (frame = 0; frame < tune->frames; frame++) {
+		const UBYTE *regs = tune->regs + frame * 9 * channels;
+		int lines;
+		int chip;
+		int i;
+
+		for (chip = 0; chip < channels; chip++)
+			for (i = 0; i < 9; i++)
+				POKEYSND_Update(POKEY_OFFSET_AUDF1 + i, regs[chip * 9 + i], chip, 4);
+
+		/* the process buffer holds a little more than one TV frame */
+		for (lines = tune->fastplay; lines > 0; ) {
+			int step = lines < Atari800_tv_mode ? lines : Atari800_tv_mode;
+			int n;
+			ANTIC_screenline_cpu_clock += step * 114;
+			lines -= step;
+			n = POKEYSND_UpdateProcessBuffer();
+			if (count + n > capacity)
+				n = capacity - count;
+			memcpy(*out + count, POKEYSND_process_buffer, n * sizeof(SWORD));
+			count += n;
+		}
+	}
+	*seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	return count;
+}
+
+static int WriteWav(const char *filename, const SWORD *samples, long count, int channels)
+{
+	UBYTE header[44];
+	ULONG const data_size = count * 2;
+	ULONG const fields[] = { 36 + data_size, 16, 0x00010001 | (channels << 16), playback_freq,
+	                         playback_freq * channels * 2, 0x00100000 | (channels * 2), data_size };
+	FILE *fp;
+	long i;
+
+	memcpy(header, "RIFF....WAVEfmt ....................data....", 44);
+	for (i = 0; i < 7; i++) {
+		static const int offsets[] = { 4, 16, 20, 24, 28, 32, 40 };
+		UBYTE *p = header + offsets[i];
+		p[0] = (UBYTE)fields[i];
+		p[1] = (UBYTE)(fields[i] >> 8);
+		p[2] = (UBYTE)(fields[i] >> 16);
+		p[3] = (UBYTE)(fields[i] >> 24);
+	}
+
+	fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		perror(filename);
+		return FALSE;
+	}
+	fwrite(header, 1, sizeof(header), fp);
+	for (i = 0; i < count; i++) {
+		fputc(samples[i] & 0xff, fp);
+		fputc((samples[i] >> 8) & 0xff, fp);
+	}
+	fclose(fp);
+	return TRUE;
+}
+
+/* Signal-to-difference ratio of x against ref in dB, after matching the
+   lag, gain and DC offset of x to ref. The engines' filters have different,
+   fractional latencies, so the lag is refined in 1/16 sample steps with a
+   windowed-sinc interpolation of x; whole-sample alignment alone would
+   show a fraction of a sample of delay as a difference at high frequencies.
+   mzpokeysnd's remez filter has a few percent of passband ripple, hence
+   the gain matching. */
+#define CMP_TAPS 32
+#define CMP_STEPS 16
+static double Compare(const SWORD *ref, long ref_count, const SWORD *x, long x_count, int channels,
+                      double *best_lag, double *best_gain)
+{
+	static double interp[CMP_STEPS][CMP_TAPS];
+	long frames = (ref_count < x_count ? ref_count : x_count) / channels;
+	double mean = 0, best = -1, best_snr = 0;
+	int lag, step, j;
+	long i;
+
+	/* the first 20 seconds are plenty */
+	if (frames > 20L * playback_freq)
+		frames = 20L * playback_freq;
+	*best_lag = 0;
+	*best_gain = 1;
+	if (frames < 4 * CMP_TAPS + 128)
+		return 0;
+
+	for (i = 0; i < frames; i++)
+		mean += ref[i * channels];
+	mean /= frames;
+	for (lag = -64; lag <= 64; lag++) {
+		double dot = 0;
+		for (i = 64; i < frames - 64; i++)
+			dot += (ref[i * channels] - mean) * x[(i + lag) * channels];
+		if (dot > best) {
+			best = dot;
+			*best_lag = lag;
+		}
+	}
+
+	for (step = 0; step < CMP_STEPS; step++)
+		for (j = 0; j < CMP_TAPS; j++) {
+			double t = j - CMP_TAPS / 2 + 1 - (double)step / CMP_STEPS;
+			double w = 0.42 + 0.5 * cos(M_PI * t / (CMP_TAPS / 2)) + 0.08 * cos(2 * M_PI * t / (CMP_TAPS / 2));
+			interp[step][j] = t == 0 ? 1 : sin(M_PI * t) / (M_PI * t) * w;
+		}
+
+	lag = (int)*best_lag;
+	best = -1;
+	for (step = -CMP_STEPS; step <= CMP_STEPS; step++) {
+		int const whole = lag - 1 + (step + CMP_STEPS) / CMP_STEPS;
+		const double *h = interp[(step + CMP_STEPS) % CMP_STEPS];
+		double n = 0, sr = 0, sy = 0, srr = 0, syy = 0, sry = 0;
+		double var_r, var_y, cov, residual;
+		for (i = 64 + CMP_TAPS; i < frames - 64 - CMP_TAPS; i++) {
+			int c;
+			for (c = 0; c < channels; c++) {
+				const SWORD *px = x + (i + whole - CMP_TAPS / 2 + 1) * channels + c;
+				double const r = ref[i * channels + c];
+				double y = 0;
+				for (j = 0; j < CMP_TAPS; j++)
+					y += px[j * channels] * h[j];
+				n++;
+				sr += r;
+				sy += y;
+				srr += r * r;
+				syy += y * y;
+				sry += r * y;
+			}
+		}
+		var_r = srr - sr * sr / n;
+		var_y = syy - sy * sy / n;
+		cov = sry - sr * sy / n;
+		if (var_r <= 0 || var_y <= 0)
+			continue;
+		residual = var_r - cov * cov / var_y;
+		if (best < 0 || residual < best) {
+			best = residual;
+			best_snr = residual <= 0 ? INFINITY : 10 * log10(var_r / residual);
+			*best_lag = whole + (double)((step + CMP_STEPS) % CMP_STEPS) / CMP_STEPS;
+			*best_gain = cov / var_y;
+		}
+	}
+	return best_snr;
+}
+
+static int LoadSap(const char *filename, Tune *tune, UBYTE **data)
+{
+	FILE *fp;
+	long size;
+	long pos = 0;
+	int type = 0;
+	int ntsc = FALSE;
+
+	fp = fopen(filename, "rb");
+	if (fp == NULL) {
+		perror(filename);
+		return FALSE;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	*data = (UBYTE *)Util_malloc(size + 1);
+	size = (long)fread(*data, 1, size, fp);
+	fclose(fp);
+	(*data)[size] = '\0';
+
+	if (size < 5 || memcmp(*data, "SAP\r\n", 5) != 0) {
+		fprintf(stderr, "%s: not a SAP file\n", filename);
+		return FALSE;
+	}
+
+	tune->stereo = FALSE;
+	tune->fastplay = 0;
+	/* text header lines (upper-case tags), up to the binary part */
+	while (pos < size && (*data)[pos] >= 'A' && (*data)[pos] <= 'Z') {
+		const char *line = (const char *)*data + pos;
+		long len = 0;
+		while (pos + len < size && (*data)[pos + len] != '\n')
+			len++;
+		if (strncmp(line, "TYPE ", 5) == 0)
+			type = line[5];
+		else if (strncmp(line, "STEREO", 6) == 0)
+			tune->stereo = TRUE;
+		else if (strncmp(line, "NTSC", 4) == 0)
+			ntsc = TRUE;
+		else if (strncmp(line, "FASTPLAY ", 9) == 0)
+			tune->fastplay = atoi(line + 9);
+		pos += len + 1;
+	}
+	if (pos + 1 < size && (*data)[pos] == 0xff && (*data)[pos + 1] == 0xff)
+		pos += 2;
+
+	if (type != 'R') {
+		fprintf(stderr, "%s: TYPE %c needs a 6502 player, only TYPE R is supported\n", filename, type ? type : '?');
+		return FALSE;
+	}
+	Atari800_tv_mode = ntsc ? Atari800_TV_NTSC : Atari800_TV_PAL;
+	if (tune->fastplay <= 0)
+		tune->fastplay = Atari800_tv_mode;
+	tune->regs = *data + pos;
+	tune->frames = (int)((size - pos) / (9 * (tune->stereo ? 2 : 1)));
+	return TRUE;
+}
+
+/* A few seconds of register writes exercising the main POKEY modes. */
+static UBYTE *BuildTest(Tune *tune)
+{
+	int const frames = 50 * 12;
+	UBYTE *regs = (UBYTE *)Util_malloc(frames * 9);
+	int f;
+
+	for (f = 0; f < frames; f++) {
+		UBYTE *r = regs + f * 9;
+		int const t = f % 50;
+		memset(r, 0, 9);
+		switch (f / 100) {
+		case 0: /* pure tone sweep on 4 channels */
+			r[0] = (UBYTE)(255 - f * 2);
+			r[1] = 0xa8;
+			r[2] = (UBYTE)(60 + f);
+			r[3] = 0xa6;
+			r[4] = (UBYTE)(f * 7);
+			r[5] = 0xa4;
+			r[6] = 3 + t;
+			r[7] = 0xa2;
+			break;
+		case 1: /* joined 16-bit channels at 1.79 MHz */
+			r[0] = (UBYTE)(f * 37);
+			r[2] = (UBYTE)(f / 4);
+			r[3] = 0xaf;
+			r[8] = 0x50;
+			break;
+		case 2: /* poly noise: 17-bit, 9-bit and 5+4-bit */
+			r[0] = (UBYTE)(t * 5);
+			r[1] = 0x08 | (t % 16);
+			r[2] = 0x40;
+			r[3] = 0x88;
+			r[4] = 0x20;
+			r[5] = 0x46;
+			r[8] = f & 1 ? 0x80 : 0x00;
+			break;
+		case 3: /* high-pass filters */
+			r[0] = 0x40;
+			r[1] = 0xaa;
+			r[2] = 0x80;
+			r[3] = 0xaa;
+			r[4] = (UBYTE)(0x41 + t);
+			r[6] = (UBYTE)(0x81 + t);
+			r[8] = 0x06;
+			break;
+		case 4: /* volume-only sample playback */
+			r[1] = 0x10 | ((f * 5) & 0x0f);
+			r[3] = 0x10 | ((f * 3) & 0x0f);
+			break;
+		default: /* ultrasonic tones and 15 kHz clock */
+			r[0] = 1 + t % 4;
+			r[1] = 0xaf;
+			r[2] = 0x10 + t;
+			r[3] = 0xa8;
+			r[8] = 0x01 | (t & 8 ? 0x20 : 0);
+			break;
+		}
+	}
+	Atari800_tv_mode = Atari800_TV_PAL;
+	tune->stereo = FALSE;
+	tune->fastplay = Atari800_TV_PAL;
+	tune->frames = frames;
+	tune->regs = regs;
+	return regs;
+}
+
+static void CompareEngines(const char *name, Tune *tune, int max_seconds)
+{
+	int const channels = tune->stereo ? 2 : 1;
+	double const tune_seconds = (double)tune->frames * tune->fastplay * 114 / POKEYSND_FREQ_17_EXACT;
+	SWORD *out[ENGINE_COUNT];
+	long count[ENGINE_COUNT];
+	int e;
+
+	if (max_seconds > 0 && tune_seconds > max_seconds)
+		tune->frames = (int)(tune->frames * max_seconds / tune_seconds);
+
+	printf("%s: %.1f s, %s, %d scanlines per write\n", name, (double)tune->frames * tune->fastplay * 114 / POKEYSND_FREQ_17_EXACT,
+	       tune->stereo ? "stereo" : "mono", tune->fastplay);
+	for (e = 0; e < ENGINE_COUNT; e++) {
+		char filename[FILENAME_MAX];
+		double seconds;
+		const char *ext = strrchr(name, '.');
+		int base_len = ext ? (int)(ext - name) : (int)strlen(name);
+
+		count[e] = Render(tune, e, &out[e], &seconds);
+		snprintf(filename, sizeof(filename), "%.*s-%s.wav", base_len, name, engine_names[e]);
+		WriteWav(filename, out[e], count[e], channels);
+		printf("  %-4s %8.2f ms/s of audio  -> %s", engine_names[e],
+		       seconds * 1000 / ((double)count[e] / channels / playback_freq), filename);
+		if (e != ENGINE_MZ) {
+			double lag, gain;
+			double snr = Compare(out[ENGINE_MZ], count[ENGINE_MZ], out[e], count[e], channels, &lag, &gain);
+			printf("  (%.1f dB vs mz, lag %+.2f samples, gain %.3f)", snr, lag, gain);
+		}
+		printf("\n");
+	}
+	for (e = 0; e < ENGINE_COUNT; e++)
+		free(out[e]);
+}
+
+int main(int argc, char *argv[])
+{
+	int max_seconds = 0;
+	int test = FALSE;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-dsprate") == 0 && i + 1 < argc)
+			playback_freq = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc)
+			max_seconds = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-test") == 0)
+			test = TRUE;
+		else if (argv[i][0] == '-') {
+			printf("Usage: %s [-dsprate <rate>] [-seconds <n>] [-test] file.sap ...\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (test) {
+		Tune tune;
+		UBYTE *regs = BuildTest(&tune);
+		CompareEngines("test.sap", &tune, max_seconds);
+		free(regs);
+	}
+	for (i = 1; i < argc; i++) {
+		Tune tune;
+		UBYTE *data = NULL;
+		if (argv[i][0] == '-') {
+			if (strcmp(argv[i], "-dsprate") == 0 || strcmp(argv[i], "-seconds") == 0)
+				i++;
+			continue;
+		}
+		if (LoadSap(argv[i], &tune, &data))
+			CompareEngines(argv[i], &tune, max_seconds);
+		free(data);
+	}
+	return 0;
+}
@@ -158,6 +158,7 @@ int mz_clear_regs = 0;
 #endif
 
 int POKEYSND_enable_new_pokey = TRUE;
+int POKEYSND_enable_blep = FALSE;  /* when TRUE, the new pokey renders band-limited steps instead of running its resampling filter: much faster */
 int POKEYSND_bienias_fix = TRUE;  /* when TRUE, high frequencies get emulated: better sound but slower */
 #if defined(__PLUS) && !defined(_WX_)
 #define BIENIAS_FIX (g_Sound.nBieniasFix)
@@ -287,7 +288,8 @@ int POKEYSND_DoInit(void)
 
 	if (POKEYSND_enable_new_pokey)
 		return MZPOKEYSND_Init(snd_freq17, POKEYSND_playback_freq,
-				POKEYSND_num_pokeys, POKEYSND_snd_flags, mz_quality
+				POKEYSND_num_pokeys, POKEYSND_snd_flags, mz_quality,
+				POKEYSND_enable_blep
 #ifdef __PLUS
 				, mz_clear_regs
 #endif
@@ -86,6 +86,7 @@ extern UBYTE POKEYSND_num_pokeys;
 extern int POKEYSND_snd_flags;
 
 extern int POKEYSND_enable_new_pokey;
+extern int POKEYSND_enable_blep;
 extern int POKEYSND_stereo_enabled;
 extern int POKEYSND_serio_sound_enabled;
 extern int POKEYSND_console_sound_enabled;
@@ -3732,6 +3732,7 @@ static int SoundSettings(void)
 		UI_MENU_CHECK(8, "Serial IO Sound:"),
 #endif
 		UI_MENU_ACTION(9, "Enable higher frequencies:"),
+		UI_MENU_ACTION(10, "Band-limited step synthesis:"),
 		UI_MENU_END
 	};
 
@@ -3772,6 +3773,7 @@ static int SoundSettings(void)
 		SetItemChecked(menu_array, 8, POKEYSND_serio_sound_enabled);
 #endif
 		FindMenuItem(menu_array, 9)->suffix = POKEYSND_enable_new_pokey ? "N/A" : POKEYSND_bienias_fix ? "Yes" : "No ";
+		FindMenuItem(menu_array, 10)->suffix = !POKEYSND_enable_new_pokey ? "N/A" : POKEYSND_enable_blep ? "Yes" : "No ";
 
 		option = UI_driver->fSelect("Sound Settings", 0, option, menu_array, NULL);
 		switch (option) {
@@ -3862,6 +3864,14 @@ static int SoundSettings(void)
 			if (!POKEYSND_enable_new_pokey)
 				POKEYSND_bienias_fix = !POKEYSND_bienias_fix;
 			break;
+		case 10:
+			if (POKEYSND_enable_new_pokey) {
+				POKEYSND_enable_blep = !POKEYSND_enable_blep;
+				POKEYSND_DoInit();
+				UI_driver->fMessage("Will reboot to apply the change", 1);
+				return TRUE; /* reboot required */
+			}
+			break;
 		default:
 #ifdef SOUND_THIN_API
 			if (!Sound_enabled)
@@ -0,0 +1,115 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by Provenance Team                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License version 2 as     *
+ *   published by the Free Software Foundation.                            *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License version 2 for more details.                *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   version 2 along with this program; if not, write to the               *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+// Times every resampler on synthetic Game Boy rate input and prints a hash of
+// its output. resamplebench and resamplebench_scalar (the same program with
+// the scalar stereo kernel forced) must print identical hashes.
+//
+// usage: resamplebench [frames [outrate]]
+
+#include "../resampler.h"
+#include "../resamplerinfo.h"
+#include "../src/stereofirmac.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+namespace {
+
+enum { in_rate = 2097152, samples_per_frame = 35112 };
+
+// Deterministic mix of square waves and noise, with full-scale runs to reach
+// the extremes of the accumulators.
+void makeInput(std::vector<short> &buf, std::size_t frames) {
+	buf.resize(frames * samples_per_frame * 2);
+	unsigned long lfsr = 0x12345678;
+	for (std::size_t i = 0; i < buf.size() / 2; ++i) {
+		lfsr = lfsr * 1103515245 + 12345;
+		int const noise = static_cast<int>((lfsr >> 16) & 0x7FFF) - 0x4000;
+		int l = (i / 4793) & 1 ? 12000 : -12000;
+		int r = (i / 1187) & 1 ? 9000 : -9000;
+		l += noise / 2;
+		r -= noise / 2;
+		if ((i / samples_per_frame) % 8 == 7) {
+			l = (i / 2399) & 1 ? 32767 : -32768;
+			r = -32768;
+		}
+
+		buf[2 * i    ] = static_cast<short>(l);
+		buf[2 * i + 1] = static_cast<short>(r);
+	}
+}
+
+unsigned long fnv1a(unsigned long h, short const *p, std::size_t n) {
+	for (std::size_t i = 0; i < n; ++i) {
+		unsigned const v = static_cast<unsigned short>(p[i]);
+		h = ((h ^ (v & 0xFF)) * 16777619) & 0xFFFFFFFF;
+		h = ((h ^ (v >> 8)) * 16777619) & 0xFFFFFFFF;
+	}
+
+	return h;
+}
+
+// A kernel phase with all negative taps summing to -0x10000 against -32768
+// input gives +2^31, one past what a 32-bit accumulator holds.
+bool checkEdge() {
+	short k[19];
+	short s[2 * 19];
+	for (int i = 0; i < 19; ++i) {
+		k[i] = i < 16 ? -4096 : 0;
+		s[2 * i] = -32768;
+		s[2 * i + 1] = 32767;
+	}
+
+	long acc[2];
+	stereoFirMac()(k, s, 19, acc);
+	return static_cast<double>(acc[0]) == 2147483648.0
+	    && acc[1] == -4096L * 32767 * 16;
+}
+
+} // anon namespace
+
+int main(int argc, char *argv[]) {
+	std::size_t const frames = argc > 1 ? std::strtoul(argv[1], 0, 0) : 600;
+	long const outRate = argc > 2 ? std::strtol(argv[2], 0, 0) : 48000;
+	std::vector<short> in;
+	makeInput(in, frames);
+
+	std::printf("stereo kernel: %s\n", stereoFirMacName());
+	bool const edgeOk = sizeof(long) < 8 || checkEdge();
+	std::printf("+2^31 edge: %s\n", edgeOk ? "ok" : "FAIL");
+
+	for (std::size_t n = 0; n < ResamplerInfo::num(); ++n) {
+		Resampler *const r = ResamplerInfo::get(n).create(in_rate, outRate, samples_per_frame);
+		std::vector<short> out(r->maxOut(samples_per_frame) * 2);
+		unsigned long hash = 2166136261UL;
+		std::clock_t const start = std::clock();
+		for (std::size_t f = 0; f < frames; ++f) {
+			std::size_t const outlen = r->resample(&out[0],
+				&in[f * samples_per_frame * 2], samples_per_frame);
+			hash = fnv1a(hash, &out[0], outlen * 2);
+		}
+
+		double const us = (std::clock() - start) * 1e6 / CLOCKS_PER_SEC / (frames ? frames : 1);
+		std::printf("%-36s %8.1f us/frame  hash %08lx\n", ResamplerInfo::get(n).desc, us, hash);
+		delete r;
+	}
+
+	return edgeOk ? 0 : 1;
+}
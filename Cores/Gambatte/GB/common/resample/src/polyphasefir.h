@@ -21,6 +21,7 @@
 
 #include "array.h"
 #include "rshift16_round.h"
+#include "stereofirmac.h"
 #include <algorithm>
 #include <cstring>
 
@@ -35,6 +36,7 @@ public:
 private:
 	short const *const kernel_;
 	Array<short> const prevbuf_;
+	StereoFirMac const stereoMac_;
 	unsigned div_;
 	std::size_t x_;
 };
@@ -45,6 +47,7 @@ PolyphaseFir<channels, phases>::PolyphaseFir(short const *kernel,
                                              unsigned div)
 : kernel_(kernel)
 , prevbuf_(phaseLen * channels)
+, stereoMac_(stereoFirMac())
 , div_(div)
 , x_(0)
 {
@@ -115,6 +118,21 @@ std::size_t PolyphaseFir<channels, phases>::filter(short *out,
 		}
 	}
 
+	if (channels == 2) {
+		// Stereo is the common case and the hot loop, so it goes through the SIMD
+		// multiply-accumulate. Same indexing as the generic loop below.
+		for (; x < inlen; x += div_) {
+			short const *const k = kernel_ + ((x + 1) % phases) * phaseLen;
+			short const *const s = in + (x / phases + 1 - phaseLen) * channels;
+			long acc[2];
+			stereoMac_(k, s, phaseLen, acc);
+
+			out[0] = rshift16_round(acc[0]);
+			out[1] = rshift16_round(acc[1]);
+			out += 2;
+		}
+	}
+
 	// We could easily get rid of the division and modulus here by updating the
 	// k and s pointers incrementally. However, we currently only use powers of 2
 	// and we would end up referencing more variables which often compiles to bad
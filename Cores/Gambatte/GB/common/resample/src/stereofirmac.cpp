@@ -0,0 +1,163 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by Provenance Team                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License version 2 as     *
+ *   published by the Free Software Foundation.                            *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License version 2 for more details.                *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   version 2 along with this program; if not, write to the               *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#include "stereofirmac.h"
+#include <climits>
+
+#if defined(STEREOFIRMAC_FORCE_SCALAR)
+// Used by the resampler benchmark to build a scalar reference.
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define STEREOFIRMAC_NEON
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STEREOFIRMAC_SSE2
+#define STEREOFIRMAC_SSE2_TARGET
+#elif defined(__GNUC__) && defined(__i386__)
+// 32-bit x86 builds that don't assume SSE2 get it through a function attribute,
+// and use it if cpuid says so.
+#include <emmintrin.h>
+#define STEREOFIRMAC_SSE2
+#define STEREOFIRMAC_SSE2_TARGET __attribute__((target("sse2")))
+#define STEREOFIRMAC_SSE2_CPUCHECK
+#endif
+
+namespace {
+
+void macScalar(short const *k, short const *s, std::size_t len, long acc[2]) {
+	long accl = 0, accr = 0;
+	for (std::size_t i = 0; i < len; ++i) {
+		accl += k[i] * s[2 * i    ];
+		accr += k[i] * s[2 * i + 1];
+	}
+
+	acc[0] = accl;
+	acc[1] = accr;
+}
+
+#if defined(STEREOFIRMAC_NEON) || defined(STEREOFIRMAC_SSE2)
+// The 32-bit sums are exact modulo 2^32 and the true sum is within [-0x10000 * 32768, 0x10000 * 32768],
+// so the only ambiguous result is INT_MIN, which is also what +2^31 (an all -32768 input against a
+// kernel phase whose taps are all negative) wraps to. Redo that rare case at full width.
+inline void fixWrapped(short const *k, short const *s, std::size_t len, long acc[2]) {
+	if (acc[0] == INT_MIN || acc[1] == INT_MIN)
+		macScalar(k, s, len, acc);
+}
+#endif
+
+#ifdef STEREOFIRMAC_NEON
+void macNeon(short const *k, short const *s, std::size_t len, long acc[2]) {
+	// vld2 does the deinterleaving, so each channel is a plain widening dot product.
+	int32x4_t accl0 = vdupq_n_s32(0), accl1 = vdupq_n_s32(0);
+	int32x4_t accr0 = vdupq_n_s32(0), accr1 = vdupq_n_s32(0);
+	std::size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		int16x8_t const kv = vld1q_s16(k + i);
+		int16x8x2_t const sv = vld2q_s16(s + 2 * i);
+		accl0 = vmlal_s16(accl0, vget_low_s16(sv.val[0]), vget_low_s16(kv));
+		accr0 = vmlal_s16(accr0, vget_low_s16(sv.val[1]), vget_low_s16(kv));
+		accl1 = vmlal_s16(accl1, vget_high_s16(sv.val[0]), vget_high_s16(kv));
+		accr1 = vmlal_s16(accr1, vget_high_s16(sv.val[1]), vget_high_s16(kv));
+	}
+
+	if (i + 4 <= len) {
+		int16x4_t const kv = vld1_s16(k + i);
+		int16x4x2_t const sv = vld2_s16(s + 2 * i);
+		accl0 = vmlal_s16(accl0, sv.val[0], kv);
+		accr0 = vmlal_s16(accr0, sv.val[1], kv);
+		i += 4;
+	}
+
+	int32x4_t const l = vaddq_s32(accl0, accl1);
+	int32x4_t const r = vaddq_s32(accr0, accr1);
+	int32x2_t const lr = vpadd_s32(vpadd_s32(vget_low_s32(l), vget_high_s32(l)),
+	                               vpadd_s32(vget_low_s32(r), vget_high_s32(r)));
+	macScalar(k + i, s + 2 * i, len - i, acc);
+	acc[0] = static_cast<int>(acc[0] + vget_lane_s32(lr, 0));
+	acc[1] = static_cast<int>(acc[1] + vget_lane_s32(lr, 1));
+	fixWrapped(k, s, len, acc);
+}
+#endif
+
+#ifdef STEREOFIRMAC_SSE2
+STEREOFIRMAC_SSE2_TARGET
+void macSse2(short const *k, short const *s, std::size_t len, long acc[2]) {
+	// pmaddwd sums adjacent pairs, so the samples are rearranged to l0 l1 r0 r1 l2 l3 r2 r3,
+	// and the kernel duplicated to k0 k1 k0 k1 k2 k3 k2 k3. Even lanes then accumulate the
+	// left channel and odd lanes the right.
+	__m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+	std::size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		__m128i const kv = _mm_loadu_si128(reinterpret_cast<__m128i const *>(k + i));
+		__m128i s0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 2 * i));
+		__m128i s1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 2 * i + 8));
+		s0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s0, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		s1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s1, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(s0, _mm_unpacklo_epi32(kv, kv)));
+		acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(s1, _mm_unpackhi_epi32(kv, kv)));
+	}
+
+	if (i + 4 <= len) {
+		__m128i const kv = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(k + i));
+		__m128i s0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s + 2 * i));
+		s0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s0, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(s0, _mm_unpacklo_epi32(kv, kv)));
+		i += 4;
+	}
+
+	acc0 = _mm_add_epi32(acc0, acc1);
+	acc0 = _mm_add_epi32(acc0, _mm_srli_si128(acc0, 8));
+	macScalar(k + i, s + 2 * i, len - i, acc);
+	acc[0] = static_cast<int>(acc[0] + _mm_cvtsi128_si32(acc0));
+	acc[1] = static_cast<int>(acc[1] + _mm_cvtsi128_si32(_mm_srli_si128(acc0, 4)));
+	fixWrapped(k, s, len, acc);
+}
+#endif
+
+struct Impl {
+	StereoFirMac mac;
+	char const *name;
+};
+
+Impl selectImpl() {
+#if defined(STEREOFIRMAC_NEON)
+	Impl const impl = { macNeon, "NEON" };
+	return impl;
+#elif defined(STEREOFIRMAC_SSE2)
+#ifdef STEREOFIRMAC_SSE2_CPUCHECK
+	if (!__builtin_cpu_supports("sse2")) {
+		Impl const impl = { macScalar, "scalar" };
+		return impl;
+	}
+#endif
+	Impl const impl = { macSse2, "SSE2" };
+	return impl;
+#else
+	Impl const impl = { macScalar, "scalar" };
+	return impl;
+#endif
+}
+
+Impl const & impl() {
+	static Impl const impl = selectImpl();
+	return impl;
+}
+
+} // anon namespace
+
+StereoFirMac stereoFirMac() { return impl().mac; }
+char const * stereoFirMacName() { return impl().name; }
@@ -0,0 +1,39 @@
+/***************************************************************************
+ *   Copyright (C) 2026 by Provenance Team                                 *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License version 2 as     *
+ *   published by the Free Software Foundation.                            *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License version 2 for more details.                *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   version 2 along with this program; if not, write to the               *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef STEREOFIRMAC_H
+#define STEREOFIRMAC_H
+
+#include <cstddef>
+
+/**
+  * Multiply-accumulates one polyphase FIR phase against interleaved stereo input:
+  * acc[0] = sum(kernel[i] * in[2 * i]), acc[1] = sum(kernel[i] * in[2 * i + 1]), for i < len.
+  *
+  * The SIMD versions accumulate in 32 bits. For the kernels makeSincKernel produces (the sum
+  * of a phase's absolute values is at most 0x10000) that only wraps at +2^31, which they
+  * detect and redo at full width, so every version gives the same results as the scalar one.
+  */
+typedef void (*StereoFirMac)(short const *kernel, short const *in, std::size_t len, long acc[2]);
+
+/** Returns the fastest StereoFirMac supported by the CPU, chosen on first call. */
+StereoFirMac stereoFirMac();
+
+/** Short description of the version stereoFirMac() returns, e.g. "NEON". */
+char const * stereoFirMacName();
+
+#endif
@@ -650,6 +650,9 @@ void system_frame_gen(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* complete deferred scanlines */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
@@ -973,6 +976,9 @@ void system_frame_scd(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* complete deferred scanlines */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
@@ -1379,6 +1385,9 @@ void system_frame_sms(int do_skip)
   }
   while (++line < bitmap.viewport.h);
 
+  /* complete deferred scanlines */
+  RENDER_SYNC();
+
   /* check viewport changes */
   if (bitmap.viewport.w != bitmap.viewport.ow)
   {
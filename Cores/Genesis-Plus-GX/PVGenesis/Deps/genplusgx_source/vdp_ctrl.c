@@ -1151,6 +1151,9 @@ unsigned int vdp_68k_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  /* Sprite collision flag is updated when queued lines are rendered */
+  RENDER_SYNC();
+
   /* Cycle-accurate VDP status read (adjust CPU time with current instruction execution time) */
   cycles += m68k_cycles();
 
@@ -1214,6 +1217,9 @@ unsigned int vdp_z80_ctrl_r(unsigned int cycles)
 {
   unsigned int temp;
 
+  /* Sprite collision flag is updated when queued lines are rendered */
+  RENDER_SYNC();
+
   /* Check if DMA busy flag is set (Mega Drive VDP specific) */
   if (status & 2)
   {
@@ -1462,6 +1468,12 @@ static void vdp_reg_w(unsigned int r, unsigned int d, unsigned int cycles)
     return;
   }
 
+  /* Render queued lines with previous register value (line counter, auto-increment & DMA registers are not used for rendering) */
+  if ((d != reg[r]) && (r != 10) && (r != 15) && (r < 19))
+  {
+    RENDER_SYNC();
+  }
+
   switch(r)
   {
     case 0: /* CTRL #1 */
@@ -2160,6 +2172,9 @@ static void vdp_bus_w(unsigned int data)
       {
         int name;
 
+        /* Render queued lines with previous VRAM content */
+        RENDER_SYNC();
+
         /* Write data to VRAM */
         *p = data;
 
@@ -2192,6 +2207,9 @@ static void vdp_bus_w(unsigned int data)
         /* CRAM index (64 words) */
         int index = (addr >> 1) & 0x3F;
 
+        /* Render queued lines with previous palette */
+        RENDER_SYNC();
+
         /* Write CRAM data */
         *p = data;
 
@@ -2229,6 +2247,9 @@ static void vdp_bus_w(unsigned int data)
 
     case 0x05:  /* VSRAM */
     {
+      /* Render queued lines with previous VSRAM content */
+      RENDER_SYNC();
+
       *(uint16 *)&vsram[addr & 0x7E] = data;
 
       /* 2-cell Vscroll mode */
@@ -2635,6 +2656,9 @@ static void vdp_z80_data_w_m5(unsigned int data)
       {
         int name;
 
+        /* Render queued lines with previous VRAM content */
+        RENDER_SYNC();
+
         /* Write data */
         WRITE_BYTE(vram, index, data);
 
@@ -2667,6 +2691,9 @@ static void vdp_z80_data_w_m5(unsigned int data)
         /* CRAM index (64 words) */
         int index = (addr >> 1) & 0x3F;
 
+        /* Render queued lines with previous palette */
+        RENDER_SYNC();
+
         /* Write CRAM data */
         *p = data;
 
@@ -2688,6 +2715,9 @@ static void vdp_z80_data_w_m5(unsigned int data)
 
     case 0x05: /* VSRAM */
     {
+      /* Render queued lines with previous VSRAM content */
+      RENDER_SYNC();
+
       /* Write low byte to even address & high byte to odd address */
       WRITE_BYTE(vsram, (addr & 0x7F) ^ 1, data);
       break;
@@ -3098,6 +3128,9 @@ static void vdp_dma_copy(unsigned int length)
     /* VRAM source address */
     uint16 source = dma_src;
 
+    /* Render queued lines with previous VRAM content */
+    RENDER_SYNC();
+
     do
     {
       /* Read byte from adjacent VRAM source address */
@@ -3132,6 +3165,9 @@ static void vdp_dma_copy(unsigned int length)
 /* DMA Fill */
 static void vdp_dma_fill(unsigned int length)
 {
+  /* Render queued lines with previous VRAM, CRAM or VSRAM content */
+  RENDER_SYNC();
+
   /* Check destination code (CD0-CD3) */
   switch (code & 0x0F)
   {
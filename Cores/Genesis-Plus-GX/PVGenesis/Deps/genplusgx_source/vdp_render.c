@@ -43,6 +43,25 @@
 #include "md_ntsc.h"
 #include "sms_ntsc.h"
 
+#ifdef HAVE_RENDER_THREADS
+#include <pthread.h>
+
+/* Max. number of rendering worker threads */
+#define MAX_RENDER_THREADS 8
+
+/* Max. number of deferred lines (and line buffers) */
+#define MAX_RENDER_LINES 320
+
+/* Number of deferred lines handed to worker threads at once */
+#define RENDER_BATCH 8
+
+#if defined(_MSC_VER)
+#define RENDER_TLS __declspec(thread)
+#else
+#define RENDER_TLS __thread
+#endif
+#endif
+
 #ifndef HAVE_NO_SPRITE_LIMIT
 #define MAX_SPRITES_PER_LINE 20
 #define TMS_MAX_SPRITES_PER_LINE 4
@@ -578,7 +597,19 @@ static PIXEL_OUT_T pixel_lut[3][0x200];
 static PIXEL_OUT_T pixel_lut_m4[0x40];
 
 /* Background & Sprite line buffers */
+#ifdef HAVE_RENDER_THREADS
+/* each thread renders into its own line buffers (see render_sync) */
+static uint8 ALIGNED_(4) linebuf_main[2][0x200];
+static RENDER_TLS uint8 (*linebuf)[0x200] = linebuf_main;
+
+/* Line buffers of deferred lines */
+static uint8 ALIGNED_(4) render_buf[MAX_RENDER_LINES][2][0x200];
+
+/* Line buffer contents before first queued line */
+static uint8 render_last[0x200];
+#else
 static uint8 linebuf[2][0x200];
+#endif
 
 /* Sprite limit flag */
 static uint8 spr_ovr;
@@ -592,10 +623,11 @@ typedef struct
   uint16 size;
 } object_info_t;
 
-static object_info_t obj_info[2][MAX_SPRITES_PER_LINE];
+/* Third entry holds the sprite list of deferred lines (see render_sync) */
+static object_info_t obj_info[3][MAX_SPRITES_PER_LINE];
 
 /* Sprite Counter */
-static uint8 object_count[2];
+static uint8 object_count[3];
 
 /* Sprite Collision Info */
 uint16 spr_col;
@@ -4087,7 +4119,13 @@ void render_reset(void)
   memset(bitmap.data, 0, bitmap.pitch * bitmap.height);
 
   /* Clear line buffers */
+#ifdef HAVE_RENDER_THREADS
+  memset(linebuf_main, 0, sizeof(linebuf_main));
+  memset(render_buf, 0, sizeof(render_buf));
+  memset(render_last, 0, sizeof(render_last));
+#else
   memset(linebuf, 0, sizeof(linebuf));
+#endif
 
   /* Clear color palettes */
   memset(pixel, 0, sizeof(pixel));
@@ -4100,12 +4138,360 @@ void render_reset(void)
 }
 
 
+#ifdef HAVE_RENDER_THREADS
+/*--------------------------------------------------------------------------*/
+/* Deferred line rendering (Mode 5)                                         */
+/*                                                                          */
+/* render_line() only updates the pattern cache, latches the sprite list    */
+/* and parses sprites for next line. Background layers of queued lines are  */
+/* rendered by worker threads while 68k & Z80 keep running, then sprite     */
+/* layers (in line order, as sprite masking & collision depend on previous  */
+/* lines) and pixel output are completed by render_sync().                  */
+/*                                                                          */
+/* Since renderers read VDP state directly, VRAM, CRAM, VSRAM & register    */
+/* writes as well as VDP status reads call render_sync() first, so that     */
+/* queued lines are always rendered with the state they were latched with.  */
+/*--------------------------------------------------------------------------*/
+
+typedef struct
+{
+  int line;
+  uint16 max_pixels;
+  uint8 count;
+  object_info_t obj[MAX_SPRITES_PER_LINE];
+} render_job_t;
+
+static struct
+{
+  pthread_t thread[MAX_RENDER_THREADS];
+  pthread_mutex_t lock;
+  pthread_cond_t work;
+  pthread_cond_t done;
+  int threads;    /* number of running worker threads */
+  int init;       /* 1 = worker threads have been started */
+  int quit;
+  int phase;      /* 0 = background layers, 1 = pixel output */
+  int submitted;  /* number of queued lines made available to worker threads */
+  int next;       /* next line to be processed */
+  int finished;   /* number of processed lines */
+} render_mt;
+
+static render_job_t render_job[MAX_RENDER_LINES];
+
+/* Marks off-screen pixels not written by background rendering (never produced by lut[0] or lut[4]) */
+#define RENDER_UNSET 0x30
+
+/* Number of queued lines */
+int render_pending;
+
+static void render_job_run(int phase, render_job_t *job)
+{
+  linebuf = render_buf[job->line];
+
+  if (phase == 0)
+  {
+    memset(&linebuf[0][0], RENDER_UNSET, 0x20);
+    memset(&linebuf[0][0x20 + bitmap.viewport.w], RENDER_UNSET, 0x200 - 0x20 - bitmap.viewport.w);
+    render_bg(job->line);
+  }
+  else
+  {
+    remap_line(job->line);
+  }
+}
+
+static void *render_thread(void *arg)
+{
+  render_job_t *job;
+  int phase;
+
+  pthread_mutex_lock(&render_mt.lock);
+
+  while (!render_mt.quit)
+  {
+    if (render_mt.next < render_mt.submitted)
+    {
+      job = &render_job[render_mt.next++];
+      phase = render_mt.phase;
+
+      pthread_mutex_unlock(&render_mt.lock);
+      render_job_run(phase, job);
+      pthread_mutex_lock(&render_mt.lock);
+
+      if (++render_mt.finished == render_mt.submitted)
+      {
+        pthread_cond_signal(&render_mt.done);
+      }
+    }
+    else
+    {
+      pthread_cond_wait(&render_mt.work, &render_mt.lock);
+    }
+  }
+
+  pthread_mutex_unlock(&render_mt.lock);
+
+  return NULL;
+}
+
+static void render_start(void)
+{
+  int i;
+
+  pthread_mutex_init(&render_mt.lock, NULL);
+  pthread_cond_init(&render_mt.work, NULL);
+  pthread_cond_init(&render_mt.done, NULL);
+
+  render_mt.quit = render_mt.phase = render_mt.submitted = render_mt.next = render_mt.finished = 0;
+
+  for (i = 0; (i < config.render_threads) && (i < MAX_RENDER_THREADS); i++)
+  {
+    if (pthread_create(&render_mt.thread[i], NULL, render_thread, NULL))
+    {
+      break;
+    }
+  }
+
+  /* Deferred rendering still works (on the emulation thread only) if no worker thread could be started */
+  render_mt.threads = i;
+  render_mt.init = 1;
+}
+
+void render_shutdown(void)
+{
+  int i;
+
+  if (!render_mt.init)
+  {
+    return;
+  }
+
+  render_sync();
+
+  pthread_mutex_lock(&render_mt.lock);
+  render_mt.quit = 1;
+  pthread_cond_broadcast(&render_mt.work);
+  pthread_mutex_unlock(&render_mt.lock);
+
+  for (i = 0; i < render_mt.threads; i++)
+  {
+    pthread_join(render_mt.thread[i], NULL);
+  }
+
+  pthread_cond_destroy(&render_mt.done);
+  pthread_cond_destroy(&render_mt.work);
+  pthread_mutex_destroy(&render_mt.lock);
+
+  render_mt.threads = render_mt.init = 0;
+  linebuf = linebuf_main;
+}
+
+/* Make queued lines available to worker threads */
+static void render_submit(void)
+{
+  pthread_mutex_lock(&render_mt.lock);
+  render_mt.submitted = render_pending;
+  pthread_cond_broadcast(&render_mt.work);
+  pthread_mutex_unlock(&render_mt.lock);
+}
+
+/* Run one rendering phase for all queued lines, this thread included */
+static void render_run(int phase)
+{
+  render_job_t *job;
+  int i;
+
+  /* Not worth waking up worker threads (nothing has been submitted yet either) */
+  if (!render_mt.threads || (render_pending < RENDER_BATCH))
+  {
+    for (i = 0; i < render_pending; i++)
+    {
+      render_job_run(phase, &render_job[i]);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&render_mt.lock);
+
+  if (phase != render_mt.phase)
+  {
+    render_mt.phase = phase;
+    render_mt.next = render_mt.finished = 0;
+  }
+
+  render_mt.submitted = render_pending;
+  pthread_cond_broadcast(&render_mt.work);
+
+  while (render_mt.next < render_mt.submitted)
+  {
+    job = &render_job[render_mt.next++];
+
+    pthread_mutex_unlock(&render_mt.lock);
+    render_job_run(phase, job);
+    pthread_mutex_lock(&render_mt.lock);
+
+    render_mt.finished++;
+  }
+
+  while (render_mt.finished < render_mt.submitted)
+  {
+    pthread_cond_wait(&render_mt.done, &render_mt.lock);
+  }
+
+  pthread_mutex_unlock(&render_mt.lock);
+}
+
+/* Off-screen sprite pixels (and collisions) see what previous line left in line buffer */
+static void render_margins(uint8 *dst, const uint8 *src)
+{
+  int x;
+
+  for (x = 0; x < 0x20; x++)
+  {
+    if (dst[x] == RENDER_UNSET) dst[x] = src[x];
+  }
+
+  for (x = 0x20 + bitmap.viewport.w; x < 0x200; x++)
+  {
+    if (dst[x] == RENDER_UNSET) dst[x] = src[x];
+  }
+}
+
+void render_sync(void)
+{
+  render_job_t *job;
+  uint16 max_pixels = max_sprite_pixels;
+  int i;
+
+  if (!render_pending)
+  {
+    return;
+  }
+
+  /* Background layers */
+  render_run(0);
+
+  /* Sprite layers */
+  for (i = 0; i < render_pending; i++)
+  {
+    job = &render_job[i];
+    linebuf = render_buf[job->line];
+
+    render_margins(linebuf[0], i ? render_buf[render_job[i - 1].line][0] : render_last);
+
+    /* Latched sprite list */
+    object_count[2] = job->count;
+    memcpy(obj_info[2], job->obj, job->count * sizeof(object_info_t));
+    max_sprite_pixels = job->max_pixels;
+
+    render_obj(2);
+
+    /* Left-most column blanking */
+    if (reg[0] & 0x20)
+    {
+      if (system_hw > SYSTEM_SGII)
+      {
+        memset(&linebuf[0][0x20], 0x40, 8);
+      }
+    }
+
+    /* Horizontal borders */
+    if (bitmap.viewport.x > 0)
+    {
+      memset(&linebuf[0][0x20 - bitmap.viewport.x], 0x40, bitmap.viewport.x);
+      memset(&linebuf[0][0x20 + bitmap.viewport.w], 0x40, bitmap.viewport.x);
+    }
+  }
+
+  max_sprite_pixels = max_pixels;
+
+  /* Pixel output */
+  render_run(1);
+
+  /* Reset queue */
+  if (render_mt.threads)
+  {
+    pthread_mutex_lock(&render_mt.lock);
+    render_mt.phase = render_mt.submitted = render_mt.next = render_mt.finished = 0;
+    pthread_mutex_unlock(&render_mt.lock);
+  }
+
+  /* blank_line() & remap_line() still apply to the last rendered line */
+  linebuf = render_buf[render_job[render_pending - 1].line];
+
+  render_pending = 0;
+}
+
+static void render_line_deferred(int line)
+{
+  render_job_t *job;
+
+  /* Line is being redrawn */
+  if (render_pending && ((render_job[render_pending - 1].line >= line) || (render_pending == MAX_RENDER_LINES)))
+  {
+    render_sync();
+  }
+
+  /* Update pattern cache (VRAM writes already waited for queued lines) */
+  if (bg_list_index)
+  {
+    update_bg_pattern_cache(bg_list_index);
+    bg_list_index = 0;
+  }
+
+  /* Latch sprite list for current line */
+  job = &render_job[render_pending];
+  job->line = line;
+  job->max_pixels = max_sprite_pixels;
+  job->count = object_count[line & 1];
+  memcpy(job->obj, obj_info[line & 1], job->count * sizeof(object_info_t));
+
+  /* Parse sprites for next line */
+  if (line < (bitmap.viewport.h - 1))
+  {
+    parse_satb(line);
+  }
+
+  /* Keep previous line buffer contents (queued lines may reuse the same line buffer) */
+  if (!render_pending)
+  {
+    memcpy(render_last, linebuf[0], 0x200);
+  }
+
+  /* blank_line() & remap_line() apply to this line */
+  linebuf = render_buf[line];
+
+  /* Hand queued lines to worker threads */
+  if ((++render_pending - render_mt.submitted >= RENDER_BATCH) && render_mt.threads)
+  {
+    render_submit();
+  }
+}
+#endif
+
+
 /*--------------------------------------------------------------------------*/
 /* Line rendering functions                                                 */
 /*--------------------------------------------------------------------------*/
 
 void render_line(int line)
 {
+#ifdef HAVE_RENDER_THREADS
+  /* Deferred rendering (Mode 5 only) */
+  if (config.render_threads && (reg[1] & 0x40) && (parse_satb == parse_satb_m5) && (line < MAX_RENDER_LINES))
+  {
+    if (!render_mt.init)
+    {
+      render_start();
+    }
+
+    render_line_deferred(line);
+    return;
+  }
+
+  RENDER_SYNC();
+#endif
+
   /* Check display status */
   if (reg[1] & 0x40)
   {
@@ -4167,6 +4553,8 @@ void render_line(int line)
 
 void blank_line(int line, int offset, int width)
 {
+  RENDER_SYNC();
+
   memset(&linebuf[0][0x20 + offset], 0x40, width);
   remap_line(line);
 }
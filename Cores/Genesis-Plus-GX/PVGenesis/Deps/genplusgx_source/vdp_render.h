@@ -140,4 +140,14 @@ extern void (*render_obj)(int line);
 extern void (*parse_satb)(int line);
 extern void (*update_bg_pattern_cache)(int index);
 
+/* Deferred line rendering */
+#ifdef HAVE_RENDER_THREADS
+extern int render_pending;
+extern void render_sync(void);
+extern void render_shutdown(void);
+#define RENDER_SYNC() do { if (render_pending) render_sync(); } while (0)
+#else
+#define RENDER_SYNC()
+#endif
+
 #endif /* _RENDER_H_ */
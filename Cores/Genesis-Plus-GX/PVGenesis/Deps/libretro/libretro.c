@@ -2543,6 +2543,9 @@ void retro_unload_game(void)
       bram_save();
 
    audio_shutdown();
+#ifdef HAVE_RENDER_THREADS
+   render_shutdown();
+#endif
 #if defined(USE_NTSC)
     free(md_ntsc);
     free(sms_ntsc);
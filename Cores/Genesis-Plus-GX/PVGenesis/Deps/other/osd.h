@@ -80,6 +80,9 @@
 #define MODE5_MAX_SPRITES_PER_LINE (config.no_sprite_limit ? MAX_SPRITES_PER_LINE : (bitmap.viewport.w >> 4))
 #define MODE5_MAX_SPRITE_PIXELS (config.no_sprite_limit ? MAX_SPRITES_PER_LINE * 32 : max_sprite_pixels)
 
+/* Mode 5 scanlines can be rendered by worker threads (config.render_threads) */
+#define HAVE_RENDER_THREADS
+
 typedef struct
 {
   int8 device;
@@ -129,6 +132,7 @@ typedef struct
   uint8 gun_cursor;
   uint32 overclock;
   uint8 no_sprite_limit;
+  uint8 render_threads;
 } t_config;
 
 t_config config; //extern t_config config;
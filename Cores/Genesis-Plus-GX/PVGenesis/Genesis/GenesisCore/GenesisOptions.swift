@@ -48,7 +48,20 @@ extension PVGenesisEmulatorCore: CoreOptional {
                              ],
                 defaultValue: 0)
             
-            static var allOptions: [CoreOption] = [overscan, gg_extra]
+            static let renderThreads: CoreOption =
+                .enumeration(.init(
+                    title: "Render Threads",
+                    description: "Render Genesis scanlines on extra CPU cores while the emulated CPUs keep running. Helps slower devices; output is identical.",
+                    requiresRestart: true),
+                             values:[
+                               .init(title: "Off", description: "Render on the emulation thread", value: 0),
+                               .init(title: "1", description: "1 worker thread", value: 1),
+                               .init(title: "2", description: "2 worker threads", value: 2),
+                               .init(title: "3", description: "3 worker threads", value: 3),
+                             ],
+                defaultValue: 0)
+
+            static var allOptions: [CoreOption] = [overscan, gg_extra, renderThreads]
         }
         
         enum Sound {
@@ -180,6 +193,7 @@ extension PVGenesisEmulatorCore {
     
     public static var gg_extra: Bool { valueForOption(Options.Video.gg_extra).asBool }
     public static var overscan: Int { valueForOption(Options.Video.overscan).asInt! }
+    public static var render_threads: Int { valueForOption(Options.Video.renderThreads).asInt! }
 }
 
 //@objc public extension PVGenesisEmulatorCore {
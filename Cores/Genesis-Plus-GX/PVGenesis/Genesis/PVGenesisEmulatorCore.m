@@ -616,6 +616,7 @@ static bool environment_callback(unsigned cmd, void *data)
         config.overscan = PVGenesisEmulatorCore.overscan; /* 0 = no borders , 1 = vertical borders only, 2 = horizontal borders only, 3 = full borders */
   //      config.aspect_ratio = 0;
         config.gg_extra = PVGenesisEmulatorCore.gg_extra; /* 1 = show extended Game Gear screen (256x192) */
+        config.render_threads = PVGenesisEmulatorCore.render_threads; /* 0 = render on emulation thread, N = worker threads for Mode 5 scanlines */
   //      config.ntsc     = 0;
   //      config.lcd        = 0; /* 0.8 fixed point */
   //      config.render   = 0;
@@ -107,6 +107,7 @@ __attribute__((visibility("default")))
 @property (nonatomic, assign) NSUInteger maxDiscs;
 
 @property (nonatomic, assign) BOOL video_opengl;
+@property (nonatomic, assign) NSInteger runAheadFrames;
 
 -(void)setMedia:(BOOL)open forDisc:(NSUInteger)disc;
 -(void)changeDisplayMode;
@@ -33,6 +33,7 @@
 #include <mednafen/state-driver.h>
 #include <mednafen/mednafen-driver.h>
 #include <mednafen/MemoryStream.h>
+#include <mednafen/state.h>
 #pragma clang diagnostic pop
 
 #import "MednafenGameCore.h"
@@ -50,6 +51,7 @@
 
 #import <Foundation/Foundation.h>
 #import <PVSupport/OERingBuffer.h>
+#import <PVSupport/PVAudioRing.h>
 #import <PVSupport/PVSupport-Swift.h>
 #import <PVSupport/PVEmulatorCore.h>
 #import <PVLogging/PVLogging.h>
@@ -86,6 +88,8 @@ int mednafenCurrentDisplayMode = 1;
     OEIntSize mednafenCoreAspect;
     
     Mednafen::EmulateSpecStruct spec;
+    
+    PVAudioRing *audioRing;
 }
 
 @end
@@ -263,6 +267,9 @@ static void mednafen_init(MednafenGameCore* current)
     BOOL psx_h_overscan = current.psx_h_overscan;
     Mednafen::MDFNI_SetSettingB("psx.h_overscan", psx_h_overscan); // Show horizontal overscan area. 1 default
     Mednafen::MDFNI_SetSetting("psx.region_default", "na"); // Set default region to North America if auto detect fails, default: jp
+
+    const char* psx_renderer = current.psx_gpu_mt ? "mt" : "st";
+    Mednafen::MDFNI_SetSetting("psx.renderer", psx_renderer); // GPU command execution on a dedicated thread, default: st
     
     Mednafen::MDFNI_SetSettingB("psx.input.analog_mode_ct", false); // Enable Analog mode toggle
     /*
@@ -485,18 +492,39 @@ static void mednafen_init(MednafenGameCore* current)
         delete backBufferSurf;
         delete frontBufferSurf;
     }
+    
+    delete audioRing;
 }
 
 # pragma mark - Execution
 
+// Run-ahead: after the real frame, save state, emulate runAheadFrames hidden frames and present the last one,
+// then restore the state, so the displayed frame reflects the current input that many frames sooner.
+static Mednafen::StateIncremental* runAheadState = NULL;
+static Mednafen::MemoryStream* runAheadStream = NULL;
+
+static void runahead_cleanup(void) {
+    if(runAheadState) {
+        Mednafen::MDFNSS_Incremental_Destroy(runAheadState);
+        runAheadState = NULL;
+    }
+    
+    delete runAheadStream;
+    runAheadStream = NULL;
+}
+
 static void emulation_run(BOOL skipFrame) {
     GET_CURRENT_OR_RETURN();
     
     static int16_t sound_buf[0x10000];
+    static int16_t runahead_sound_buf[0x10000];
     int32 rects[game->fb_height];//int32 *rects = new int32[game->fb_height]; //(int32 *)malloc(sizeof(int32) * game->fb_height);
     memset(rects, 0, game->fb_height*sizeof(int32));
     rects[0] = ~0;
     
+    // Modules without SoundOutputStateAction can't keep the hidden frames out of their sound output, so they don't run ahead.
+    const NSInteger runAheadFrames = skipFrame || !game->StateAction || !game->SoundOutputStateAction ? 0 : current.runAheadFrames;
+    
     current->spec = {0};
     current->spec.surface = backBufferSurf;
     current->spec.SoundRate = current->sampleRate;
@@ -506,11 +534,72 @@ static void emulation_run(BOOL skipFrame) {
     current->spec.SoundBufSize = 0;
     current->spec.SoundVolume = 1.0;
     current->spec.soundmultiplier = 1.0;
-    current->spec.skip = skipFrame;
+    current->spec.skip = skipFrame || runAheadFrames > 0;
     
     MDFNI_Emulate(&current->spec);
     
-    current->mednafenCoreTiming = current->masterClock / current->spec.MasterCycles;
+    // Keep the real frame's audio; the hidden frames' audio is discarded.
+    int16_t* const SoundBuf = current->spec.SoundBuf;
+    const int32 SoundBufSize = current->spec.SoundBufSize;
+    const int64 MasterCycles = current->spec.MasterCycles;
+    
+    if(runAheadFrames > 0) {
+        try {
+            if(!runAheadState) {
+                runAheadState = Mednafen::MDFNSS_Incremental_Create();
+                runAheadStream = new Mednafen::MemoryStream(65536, false);
+            }
+            
+            // Only pages of RAM that changed since the previous frame's snapshot are saved.
+            runAheadStream->truncate(0);
+            runAheadStream->rewind();
+            Mednafen::MDFNSS_SaveSMIncremental(runAheadStream, runAheadState);
+            
+            // Resampler history and the like aren't in save states; without this, every real frame's sound would continue
+            // from the end of the last hidden frame's.
+            MDFNI_BeginHidden();
+            
+            for(NSInteger i = 0; i < runAheadFrames; i++) {
+                memset(rects, 0, game->fb_height*sizeof(int32));
+                rects[0] = ~0;
+                
+                current->spec.SoundBuf = runahead_sound_buf;
+                current->spec.SoundBufMaxSize = sizeof(runahead_sound_buf) / 2;
+                current->spec.SoundBufSize = 0;
+                current->spec.skip = i < (runAheadFrames - 1);
+                
+                // Rolled back below, so these frames must not reach rewind or movie recording.
+                MDFNI_EmulateHidden(&current->spec);
+            }
+            
+            runAheadStream->rewind();
+            Mednafen::MDFNSS_LoadSMIncremental(runAheadStream, runAheadState);
+            MDFNI_EndHidden();
+        } catch(std::exception &e) {
+            ELOG(@"Run-ahead disabled: %s", e.what());
+            runahead_cleanup();
+            current.runAheadFrames = 0;
+        }
+    }
+    
+    current->mednafenCoreTiming = current->masterClock / MasterCycles;
+    
+    // Dynamic rate control: run up to 0.5% fast while the audio ring is under half full, and as much slow while it's
+    // over, so it settles instead of slowly draining or overflowing when the host's audio clock doesn't quite match.
+    current->mednafenCoreTiming *= PVAudioRingRateAdjustment(current->audioRing, 0.005);
+    
+#if DEBUG
+    static unsigned audioStatsFrames = 0;
+    
+    if(++audioStatsFrames == 600) {
+        PVAudioRingStats stats;
+        
+        PVAudioRingGetStats(current->audioRing, &stats);
+        DLOG(@"Audio ring: %zu-%zu of %zu bytes filled, %llu bytes dropped, %llu bytes short", stats.minFill, stats.maxFill, stats.capacity, stats.overrunBytes, stats.underrunBytes);
+        current->audioRing->resetWatermarks();
+        audioStatsFrames = 0;
+    }
+#endif
     
     // Fix for game stutter. mednafenCoreTiming flutters on init before settling so
     // now we reset the game speed each frame to make sure current->gameInterval
@@ -527,7 +616,7 @@ static void emulation_run(BOOL skipFrame) {
     }
     current->videoHeight  = current->spec.DisplayRect.h;
     
-    update_audio_batch(current->spec.SoundBuf, current->spec.SoundBufSize);
+    update_audio_batch(SoundBuf, SoundBufSize);
 }
 
 - (BOOL)loadFileAtPath:(NSString *)path error:(NSError**)error {
@@ -872,10 +961,10 @@ static void emulation_run(BOOL skipFrame) {
     if (self.maxDiscs > 1) {
         // Parse number of discs in m3u
         NSString *m3uString = [NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:nil];
-        NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:@".cue|.ccd" options:NSRegularExpressionCaseInsensitive error:nil];
+        NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:@".cue|.ccd|.chd" options:NSRegularExpressionCaseInsensitive error:nil];
         NSUInteger numberOfMatches = [regex numberOfMatchesInString:m3uString options:0 range:NSMakeRange(0, [m3uString length])];
         
-        ILOG(@"Loaded m3u containing %lu cue sheets or ccd",numberOfMatches);
+        ILOG(@"Loaded m3u containing %lu cue sheets, ccd or chd images",numberOfMatches);
     }
     
     //    BOOL success =
@@ -897,6 +986,10 @@ static void emulation_run(BOOL skipFrame) {
     //        return NO;
     //    }
     
+    // About four frames' worth, rounded up to a power of two; the rate control above keeps it around half full.
+    delete audioRing;
+    audioRing = new PVAudioRing([self audioBufferSizeForBuffer:0] * 4);
+    
     emulation_run(NO);
     
     return YES;
@@ -1068,6 +1161,7 @@ static void emulation_run(BOOL skipFrame) {
 
 - (void)stopEmulation
 {
+    runahead_cleanup();
     Mednafen::MDFNI_CloseGame();
     Mednafen::MDFNI_Kill();
     [super stopEmulation];
@@ -1145,10 +1239,16 @@ static size_t update_audio_batch(const int16_t *data, size_t frames)
 {
     GET_CURRENT_OR_RETURN(frames);
     
-    [[current ringBufferAtIndex:0] write:data maxLength:frames * [current channelCount] * 2];
+    // Whatever doesn't fit is dropped and counted as an overrun; this never blocks the emulation thread.
+    current->audioRing->writeFrames(data, frames, (unsigned)[current channelCount]);
     return frames;
 }
 
+- (PVAudioRing *)audioRingAtIndex:(NSUInteger)index
+{
+    return index == 0 ? audioRing : NULL;
+}
+
 - (double)audioSampleRate
 {
     return sampleRate ? sampleRate : 48000;
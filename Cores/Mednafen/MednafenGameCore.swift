@@ -81,7 +81,7 @@ extension MednafenGameCore: CoreOptional {
         
         let globalGroup:CoreOption = .group(.init(title: "Core",
                                                 description: "Global options for all Mednafen cores."),
-                                          subOptions: [cd_image_memcache])
+                                          subOptions: [cd_image_memcache, runAheadOption])
         options.append(globalGroup)
         
             // These seem to be broken, mednafen console says not found
@@ -107,7 +107,7 @@ extension MednafenGameCore: CoreOptional {
         
         let psxGroup:CoreOption = .group(.init(title: "PlayStation",
                                                      description: ""),
-                                          subOptions: [psx_h_overscan])
+                                          subOptions: [psx_h_overscan, psx_gpu_mt])
         
         options.append(psxGroup)
         
@@ -253,6 +253,20 @@ extension MednafenGameCore: CoreOptional {
             requiresRestart: true), defaultValue: false)
     }()
 
+    // MARK: Global - Run-ahead
+    static var runAheadOption: CoreOption = {
+        .enumeration(.init(title: "Run-ahead",
+                           description: "Reduces input latency by emulating frames ahead and rolling back each frame. Each frame of run-ahead costs roughly one extra frame of emulation. Supported on NES, SNES, PC Engine, Game Boy and Lynx; ignored on other systems.",
+                           requiresRestart: true),
+                     values: [
+                        .init(title: "Off", description: "Off", value: 0),
+                        .init(title: "1 frame", description: "1 frame", value: 1),
+                        .init(title: "2 frames", description: "2 frames", value: 2),
+                        .init(title: "3 frames", description: "3 frames", value: 3),
+                     ],
+                     defaultValue: 0)
+    }()
+
     // MARK: PCE
     static var pceFastOption: CoreOption = {
 		.bool(.init(
@@ -284,6 +298,13 @@ extension MednafenGameCore: CoreOptional {
             description: "Show horizontal overscan area.",
             requiresRestart: true), defaultValue: true)
     }()
+
+    static var psx_gpu_mt: CoreOption = {
+        .bool(.init(
+            title: "Multi-threaded GPU",
+            description: "Run GPU rendering on a second CPU core. GPU draw timing is not emulated in this mode, so a few timing-sensitive games may misbehave.",
+            requiresRestart: true), defaultValue: false)
+    }()
     
     // MARK: SS
     static var ss_h_overscan: CoreOption = {
@@ -361,6 +382,7 @@ extension MednafenGameCore: CoreOptional {
         
     // PSX
     @objc(psx_h_overscan) var psx_h_overscan: Bool { MednafenGameCore.valueForOption(MednafenGameCore.psx_h_overscan).asBool }
+    @objc(psx_gpu_mt) var psx_gpu_mt: Bool { MednafenGameCore.valueForOption(MednafenGameCore.psx_gpu_mt).asBool }
 
     // SS
     @objc(ss_region_default) var ss_region_default: Int { MednafenGameCore.valueForOption(MednafenGameCore.ss_region_default).asInt ?? 0 }
@@ -396,5 +418,6 @@ extension MednafenGameCore: CoreOptional {
     // TODO: Fix me, FINISH FOR MAKE BETTER
     func parseOptions() {
         self.video_opengl = MednafenGameCore.valueForOption(MednafenGameCore.video_openglOption).asBool;
+        self.runAheadFrames = MednafenGameCore.valueForOption(MednafenGameCore.runAheadOption).asInt ?? 0
     }
 }
@@ -0,0 +1 @@
+/* See types.h. */
@@ -0,0 +1,4 @@
+/* The libchdr copy vendored with Genesis Plus GX includes that core's
+   types.h, osd.h and macros.h.  These stand-ins let the "chdr" target in
+   PVMednafen.xcodeproj build it on its own; chd.c only needs the stdio
+   cdStream mapping from macros.h. */
@@ -45,6 +45,7 @@ namespace Time
  static INLINE std::string StrTime(const struct tm& tin) { return StrTime("%c", tin); }
  static INLINE std::string StrTime(void) { return StrTime("%c", LocalTime()); }
 
+ int64 MonoNS(void);	// Nanoseconds(resolution is platform-dependent)
  int64 MonoUS(void);	// Microseconds
  static INLINE uint32 MonoMS(void) { return MonoUS() / 1000; } // Milliseconds
 
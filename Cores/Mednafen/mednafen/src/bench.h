@@ -0,0 +1,80 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* bench.h - Per-subsystem time accounting for benchmarking
+**  Copyright (C) 2026 Provenance Team
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef __MDFN_BENCH_H
+#define __MDFN_BENCH_H
+
+#include <mednafen/Time.h>
+
+namespace Mednafen
+{
+
+enum
+{
+ MDFN_BENCH_VIDEO = 0,
+ MDFN_BENCH_SOUND,
+
+ MDFN_BENCH_COUNT
+};
+
+struct MDFN_BenchStats
+{
+ bool Enabled;			// Set by the driver; section timing costs two clock reads per scope, so it's off by default.
+ bool Kernels;			// Set by the driver before loading a game; modules with SIMD kernels then time them against the
+				// scalar versions while initializing, and print the results with MDFN_printf().
+ int64 Time[MDFN_BENCH_COUNT];	// Accumulated nanoseconds.
+ uint64 Hits[MDFN_BENCH_COUNT];	// Number of scopes entered.
+};
+
+MDFN_HIDE extern MDFN_BenchStats MDFNBench;
+
+//
+// Adds the time spent in its scope to section 'which'.  Place around coarse-grained entry points(scanline renderer,
+// sound buffer flush, etc.), not per-pixel or per-sample code, and don't nest scopes.
+//
+// Anything not covered by a scope is counted as CPU/other time by the benchmark driver.
+//
+class MDFN_BenchScope
+{
+ public:
+
+ // 'active' lets code that may also run on a worker thread opt out there; MDFNBench isn't thread-safe.
+ INLINE MDFN_BenchScope(const unsigned which, const bool active = true) : w(which), start(MDFN_UNLIKELY(MDFNBench.Enabled) && active ? Time::MonoNS() : -1)
+ {
+
+ }
+
+ INLINE ~MDFN_BenchScope()
+ {
+  if(MDFN_UNLIKELY(start >= 0))
+  {
+   MDFNBench.Time[w] += Time::MonoNS() - start;
+   MDFNBench.Hits[w]++;
+  }
+ }
+
+ private:
+ const unsigned w;
+ const int64 start;
+};
+
+}
+#endif
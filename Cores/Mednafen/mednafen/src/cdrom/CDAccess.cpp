@@ -24,6 +24,10 @@
 #include "CDAccess_Image.h"
 #include "CDAccess_CCD.h"
 
+#ifdef HAVE_LIBCHDR
+ #include "CDAccess_CHD.h"
+#endif
+
 namespace Mednafen
 {
 
@@ -39,12 +43,25 @@ CDAccess::~CDAccess()
 
 }
 
+bool CDAccess::Prefetch(int32 lba)
+{
+ return false;
+}
+
 CDAccess* CDAccess_Open(VirtualFS* vfs, const std::string& path, bool image_memcache)
 {
  CDAccess *ret = NULL;
 
  if(path.size() >= 4 && !MDFN_strazicmp(path.c_str() + path.size() - 4, ".ccd"))
   ret = new CDAccess_CCD(vfs, path, image_memcache);
+ else if(path.size() >= 4 && !MDFN_strazicmp(path.c_str() + path.size() - 4, ".chd"))
+ {
+#ifdef HAVE_LIBCHDR
+  ret = new CDAccess_CHD(vfs, path, image_memcache);
+#else
+  throw MDFN_Error(0, _("Support for CHD disc images was not compiled in."));
+#endif
+ }
  else
   ret = new CDAccess_Image(vfs, path, image_memcache);
 
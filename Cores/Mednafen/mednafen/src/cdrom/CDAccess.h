@@ -44,6 +44,12 @@ class CDAccess
 
  virtual void Read_TOC(CDUtility::TOC *toc) = 0;
 
+ // Optional hint that sectors starting at 'lba' will probably be read soon; called by the
+ // CD read thread when it has nothing else to do, from the same thread as Read_Raw_Sector().
+ //
+ // Should do a bounded amount of work per call, and return true if calling it again would do more.
+ virtual bool Prefetch(int32 lba);
+
  private:
  CDAccess(const CDAccess&);	// No copy constructor.
  CDAccess& operator=(const CDAccess&); // No assignment operator.
@@ -0,0 +1,626 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* CDAccess_CHD.cpp:
+**  Copyright (C) 2026 Provenance Team
+**  Pregap and subchannel handling adapted from Mednafen's CDAccess_Image.cpp.
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ Notes and TODO:
+
+	Only the native filesystem is supported(libchdr does its own file I/O), so CHD files inside of archives
+	won't load.
+
+	Parent(delta) CHDs are not supported.
+
+	GD-ROM CHDs are rejected.
+*/
+
+#include <mednafen/mednafen.h>
+#include <mednafen/general.h>
+
+#include "CDAccess_CHD.h"
+
+#ifndef cdStream
+#define cdStream FILE
+#endif
+
+#include <chd.h>
+#include <cdrom.h>
+
+#include <trio/trio.h>
+
+namespace Mednafen
+{
+
+using namespace CDUtility;
+
+//
+// Number of hunks past the one containing the most recently-read sector that Prefetch() will decompress ahead
+// of time.
+//
+static const uint32 PrefetchHunks = 2;
+
+//
+// Default hunk cache size; a hunk is usually 8 frames(~19.5KiB), so this is ~1.25MiB.
+//
+static const size_t HunkCacheSize = 64;
+
+CDAccess_CHD::CDAccess_CHD(VirtualFS* vfs, const std::string& path, bool image_memcache) : chd(nullptr), hunk_cache_counter(0)
+{
+ try
+ {
+  Load(path, image_memcache);
+ }
+ catch(...)
+ {
+  Cleanup();
+  throw;
+ }
+}
+
+CDAccess_CHD::~CDAccess_CHD()
+{
+ Cleanup();
+}
+
+void CDAccess_CHD::Cleanup(void)
+{
+ if(chd)
+ {
+  chd_close(chd);
+  chd = nullptr;
+ }
+
+ hunk_cache.clear();
+ hunk_cache_slot.clear();
+}
+
+void CDAccess_CHD::Load(const std::string& path, bool image_memcache)
+{
+ chd_error err;
+
+ err = chd_open(path.c_str(), CHD_OPEN_READ, nullptr, &chd);
+ if(err != CHDERR_NONE)
+ {
+  chd = nullptr;
+  throw MDFN_Error(0, _("Error opening CHD \"%s\": %s"), path.c_str(), chd_error_string(err));
+ }
+
+ const chd_header* head = chd_get_header(chd);
+
+ hunk_bytes = head->hunkbytes;
+ total_hunks = head->totalhunks;
+
+ if(!hunk_bytes || (hunk_bytes % CD_FRAME_SIZE))
+  throw MDFN_Error(0, _("CHD hunk size of %u bytes is not a multiple of the CD frame size."), (unsigned)hunk_bytes);
+
+ frames_per_hunk = hunk_bytes / CD_FRAME_SIZE;
+
+ //
+ // With image memcache enabled, keep every hunk that's ever decompressed; we still decompress lazily,
+ // since decompressing an entire disc up-front would take several seconds.
+ //
+ hunk_cache_max = image_memcache ? total_hunks : HunkCacheSize;
+ hunk_cache.reserve(std::min<size_t>(hunk_cache_max, HunkCacheSize));
+ hunk_cache_slot.assign(total_hunks, -1);
+
+ ParseTrackMetadata();
+ GenerateTOC();
+}
+
+void CDAccess_CHD::ParseTrackMetadata(void)
+{
+ static const struct
+ {
+  const char* name;
+  uint32 format;
+ } FormatTable[] =
+ {
+  { "AUDIO", CHD_TF_AUDIO },
+  { "MODE1", CHD_TF_MODE1 },
+  { "MODE1_RAW", CHD_TF_MODE1_RAW },
+  { "MODE2", CHD_TF_MODE2 },
+  { "MODE2_FORM_MIX", CHD_TF_MODE2 },
+  { "MODE2_FORM1", CHD_TF_MODE2_FORM1 },
+  { "MODE2_FORM2", CHD_TF_MODE2_FORM2 },
+  { "MODE2_RAW", CHD_TF_MODE2_RAW },
+ };
+ uint32 frame_offset = 0;
+ int32 RunningLBA = -150;
+
+ FirstTrack = 1;
+ NumTracks = 0;
+ disc_type = DISC_TYPE_CDDA_OR_M1;
+
+ {
+  char tmp[512];
+
+  if(chd_get_metadata(chd, GDROM_TRACK_METADATA_TAG, 0, tmp, sizeof(tmp), nullptr, nullptr, nullptr) == CHDERR_NONE)
+   throw MDFN_Error(0, _("GD-ROM CHD images are not supported."));
+ }
+
+ for(unsigned i = 0; i < 99; i++)
+ {
+  char meta[512];
+  char type[64], subtype[32], pgtype[32], pgsub[32];
+  int tracknum = 0, frames = 0, pregap = 0, postgap = 0;
+  CHD_Track* t;
+
+  memset(meta, 0, sizeof(meta));
+  type[0] = subtype[0] = pgtype[0] = pgsub[0] = 0;
+
+  if(chd_get_metadata(chd, CDROM_TRACK_METADATA2_TAG, i, meta, sizeof(meta) - 1, nullptr, nullptr, nullptr) == CHDERR_NONE)
+  {
+   if(trio_sscanf(meta, CDROM_TRACK_METADATA2_FORMAT, &tracknum, type, subtype, &frames, &pregap, pgtype, pgsub, &postgap) != 8)
+    throw MDFN_Error(0, _("Malformed CHD track metadata: %s"), meta);
+  }
+  else if(chd_get_metadata(chd, CDROM_TRACK_METADATA_TAG, i, meta, sizeof(meta) - 1, nullptr, nullptr, nullptr) == CHDERR_NONE)
+  {
+   if(trio_sscanf(meta, CDROM_TRACK_METADATA_FORMAT, &tracknum, type, subtype, &frames) != 4)
+    throw MDFN_Error(0, _("Malformed CHD track metadata: %s"), meta);
+  }
+  else
+   break;
+
+  if(tracknum != (int)(i + 1))
+   throw MDFN_Error(0, _("CHD track metadata out of order; expected track %u, got track %d."), i + 1, tracknum);
+
+  if(frames < 0 || pregap < 0 || postgap < 0 || pregap > frames)
+   throw MDFN_Error(0, _("Bad frame count in CHD track %d metadata."), tracknum);
+
+  t = &Tracks[tracknum];
+  t->format = ~0U;
+
+  for(auto const& fte : FormatTable)
+  {
+   if(!strcmp(type, fte.name))
+   {
+    t->format = fte.format;
+    break;
+   }
+  }
+
+  if(t->format == ~0U)
+   throw MDFN_Error(0, _("Unsupported CHD track type \"%s\" for track %d."), type, tracknum);
+
+  if(!strcmp(subtype, "RW"))
+   t->subtype = CHD_SUB_RW;
+  else if(!strcmp(subtype, "RW_RAW"))
+   t->subtype = CHD_SUB_RW_RAW;
+  else
+   t->subtype = CHD_SUB_NONE;
+
+  switch(t->format)
+  {
+   case CHD_TF_AUDIO:
+	t->subq_control = 0;
+	break;
+
+   case CHD_TF_MODE2:
+   case CHD_TF_MODE2_FORM1:
+   case CHD_TF_MODE2_FORM2:
+   case CHD_TF_MODE2_RAW:
+	disc_type = DISC_TYPE_CD_XA;
+	t->subq_control = SUBQ_CTRLF_DATA;
+	break;
+
+   default:
+	t->subq_control = SUBQ_CTRLF_DATA;
+	break;
+  }
+
+  //
+  // A "V" pregap type means the pregap sectors are stored in the CHD, ahead of the INDEX 01 sectors, and included
+  // in FRAMES.
+  //
+  if(pgtype[0] == 'V')
+  {
+   t->pregap = 0;
+   t->pregap_dv = pregap;
+  }
+  else
+  {
+   t->pregap = pregap;
+   t->pregap_dv = 0;
+  }
+
+  if(tracknum == FirstTrack)
+   t->pregap += 150;
+
+  t->postgap = postgap;
+  t->frame_offset = frame_offset;
+
+  RunningLBA += t->pregap;
+  RunningLBA += t->pregap_dv;
+  t->LBA = RunningLBA;
+  t->sectors = frames - t->pregap_dv;
+  RunningLBA += t->sectors;
+  RunningLBA += t->postgap;
+
+  //
+  // Each track's frames are padded out to a multiple of CD_TRACK_PADDING within the CHD.
+  //
+  frame_offset += (frames + CD_TRACK_PADDING - 1) / CD_TRACK_PADDING * CD_TRACK_PADDING;
+
+  NumTracks++;
+ }
+
+ if(!NumTracks)
+  throw MDFN_Error(0, _("No CD track metadata found in CHD; is it a CD image?"));
+
+ if((uint64)frame_offset > (uint64)total_hunks * frames_per_hunk + CD_TRACK_PADDING)
+  throw MDFN_Error(0, _("CHD track metadata describes more frames than the CHD contains."));
+
+ total_sectors = RunningLBA;
+}
+
+bool CDAccess_CHD::LBA_to_Frame(int32 lba, uint32* frame) const
+{
+ for(int32 track = FirstTrack; track < (FirstTrack + NumTracks); track++)
+ {
+  const CHD_Track* t = &Tracks[track];
+
+  if(lba >= (t->LBA - t->pregap_dv) && lba < (t->LBA + t->sectors))
+  {
+   *frame = t->frame_offset + (lba - (t->LBA - t->pregap_dv));
+   return true;
+  }
+ }
+
+ return false;
+}
+
+const uint8* CDAccess_CHD::GetHunk(uint32 hunknum)
+{
+ HunkCacheEntry* hce = nullptr;
+ int32 slot;
+
+ if(hunknum >= total_hunks)
+  throw MDFN_Error(0, _("Error reading CHD hunk %u: %s"), (unsigned)hunknum, chd_error_string(CHDERR_HUNK_OUT_OF_RANGE));
+
+ hunk_cache_counter++;
+
+ if((slot = hunk_cache_slot[hunknum]) >= 0)
+ {
+  hunk_cache[slot].last_use = hunk_cache_counter;
+  return hunk_cache[slot].data.get();
+ }
+
+ //
+ // With image memcache, there's a slot for every hunk, so nothing is ever evicted; only a failed read can leave a
+ // slot unused.
+ //
+ if(hunk_cache.size() < hunk_cache_max)
+ {
+  slot = hunk_cache.size();
+  hunk_cache.emplace_back();
+  hce = &hunk_cache.back();
+  hce->data.reset(new uint8[hunk_bytes]);
+ }
+ else
+ {
+  slot = 0;
+
+  for(size_t i = 1; i < hunk_cache.size(); i++)
+  {
+   if(hunk_cache[i].last_use < hunk_cache[slot].last_use)
+    slot = i;
+  }
+
+  hce = &hunk_cache[slot];
+
+  if(hce->hunknum != ~0U)
+   hunk_cache_slot[hce->hunknum] = -1;
+ }
+
+ //
+ // Invalidate before reading, so a decompression error doesn't leave stale data tagged with the new hunk number.
+ //
+ hce->hunknum = ~0U;
+ hce->last_use = 0;
+
+ chd_error err = chd_read(chd, hunknum, hce->data.get());
+ if(err != CHDERR_NONE)
+  throw MDFN_Error(0, _("Error reading CHD hunk %u: %s"), (unsigned)hunknum, chd_error_string(err));
+
+ hce->hunknum = hunknum;
+ hce->last_use = hunk_cache_counter;
+ hunk_cache_slot[hunknum] = slot;
+
+ return hce->data.get();
+}
+
+bool CDAccess_CHD::Prefetch(int32 lba)
+{
+ uint32 frame;
+
+ if(!LBA_to_Frame(lba, &frame))
+  return false;
+
+ const uint32 base_hunk = frame / frames_per_hunk;
+
+ for(uint32 i = 0; i <= PrefetchHunks && (base_hunk + i) < total_hunks; i++)
+ {
+  const uint32 hunknum = base_hunk + i;
+
+  if(hunk_cache_slot[hunknum] < 0)
+  {
+   try
+   {
+    GetHunk(hunknum);
+   }
+   catch(...)
+   {
+    // Errors will be reported when(if) the sector is actually read.
+    return false;
+   }
+   return true;
+  }
+ }
+
+ return false;
+}
+
+void CDAccess_CHD::Read_Raw_Sector(uint8 *buf, int32 lba)
+{
+ uint8 SimuQ[0xC];
+ int32 track;
+ const CHD_Track* ct;
+
+ //
+ // Leadout synthesis
+ //
+ if(lba >= total_sectors)
+ {
+  uint8 data_synth_mode = (disc_type == DISC_TYPE_CD_XA ? 0x02 : 0x01);
+
+  switch(Tracks[FirstTrack + NumTracks - 1].format)
+  {
+   case CHD_TF_AUDIO:
+	break;
+
+   case CHD_TF_MODE1:
+   case CHD_TF_MODE1_RAW:
+	data_synth_mode = 0x01;
+	break;
+
+   default:
+	data_synth_mode = 0x02;
+	break;
+  }
+
+  synth_leadout_sector_lba(data_synth_mode, toc, lba, buf);
+  return;
+ }
+
+ memset(buf + 2352, 0, 96);
+ track = MakeSubPQ(lba, buf + 2352);
+ subq_deinterleave(buf + 2352, SimuQ);
+
+ ct = &Tracks[track];
+
+ //
+ // Handle pregap and postgap reading
+ //
+ if(lba < (ct->LBA - ct->pregap_dv) || lba >= (ct->LBA + ct->sectors))
+ {
+  int32 pg_offset = lba - ct->LBA;
+  const CHD_Track* et = ct;
+
+  if(pg_offset < -150)
+  {
+   if((ct->subq_control & SUBQ_CTRLF_DATA) && (FirstTrack < track) && !(Tracks[track - 1].subq_control & SUBQ_CTRLF_DATA))
+    et = &Tracks[track - 1];
+  }
+
+  memset(buf, 0, 2352);
+  switch(et->format)
+  {
+   case CHD_TF_AUDIO:
+	break;
+
+   case CHD_TF_MODE1:
+   case CHD_TF_MODE1_RAW:
+	encode_mode1_sector(lba + 150, buf);
+	break;
+
+   default:
+	buf[12 +  6] = 0x20;
+	buf[12 + 10] = 0x20;
+	encode_mode2_form2_sector(lba + 150, buf);
+	break;
+  }
+ }
+ else
+ {
+  const uint32 frame = ct->frame_offset + (lba - (ct->LBA - ct->pregap_dv));
+  const uint8* fd = GetHunk(frame / frames_per_hunk) + (frame % frames_per_hunk) * CD_FRAME_SIZE;
+
+  switch(ct->format)
+  {
+   case CHD_TF_AUDIO:
+	// CHD stores audio samples MSB-first; raw sectors hold them LSB-first.
+	for(unsigned i = 0; i < 588 * 2; i++)
+	 MDFN_en16lsb(&buf[i * 2], MDFN_de16msb(&fd[i * 2]));
+	break;
+
+   case CHD_TF_MODE1:
+	memcpy(buf + 12 + 3 + 1, fd, 2048);
+	encode_mode1_sector(lba + 150, buf);
+	break;
+
+   case CHD_TF_MODE1_RAW:
+   case CHD_TF_MODE2_RAW:
+	memcpy(buf, fd, 2352);
+	break;
+
+   case CHD_TF_MODE2:
+	memcpy(buf + 16, fd, 2336);
+	encode_mode2_sector(lba + 150, buf);
+	break;
+
+   case CHD_TF_MODE2_FORM1:
+	memcpy(buf + 24, fd, 2048);
+	break;
+
+   case CHD_TF_MODE2_FORM2:
+	memcpy(buf + 24, fd, 2324);
+	break;
+  }
+
+  if(ct->subtype == CHD_SUB_RW_RAW)
+   memcpy(buf + 2352, fd + 2352, 96);
+  else if(ct->subtype == CHD_SUB_RW)
+  {
+   uint8 tmp[96];
+
+   subpw_interleave(fd + 2352, tmp);
+   memcpy(buf + 2352, tmp, 96);
+  }
+ }
+}
+
+bool CDAccess_CHD::Fast_Read_Raw_PW_TSRE(uint8* pwbuf, int32 lba) const noexcept
+{
+ int32 track;
+
+ if(lba >= total_sectors)
+ {
+  subpw_synth_leadout_lba(toc, lba, pwbuf);
+  return(true);
+ }
+
+ memset(pwbuf, 0, 96);
+ try
+ {
+  track = MakeSubPQ(lba, pwbuf);
+ }
+ catch(...)
+ {
+  return(false);
+ }
+
+ //
+ // Stored subchannel data has to go through the (non-thread-safe) hunk cache.
+ //
+ if(Tracks[track].subtype != CHD_SUB_NONE && lba >= (Tracks[track].LBA - Tracks[track].pregap_dv) && (lba < Tracks[track].LBA + Tracks[track].sectors))
+  return(false);
+
+ return(true);
+}
+
+//
+// Note: this function makes use of the current contents(as in |=) in SubPWBuf.
+//
+int32 CDAccess_CHD::MakeSubPQ(int32 lba, uint8 *SubPWBuf) const
+{
+ uint8 buf[0xC];
+ int32 track;
+ uint32 lba_relative;
+ uint8 pause_or = 0x00;
+ bool track_found = false;
+
+ for(track = FirstTrack; track < (FirstTrack + NumTracks); track++)
+ {
+  if(lba >= (Tracks[track].LBA - Tracks[track].pregap_dv - Tracks[track].pregap) && lba < (Tracks[track].LBA + Tracks[track].sectors + Tracks[track].postgap))
+  {
+   track_found = true;
+   break;
+  }
+ }
+
+ if(!track_found)
+  throw(MDFN_Error(0, _("Could not find track for sector %u!"), lba));
+
+ if(lba < Tracks[track].LBA)
+  lba_relative = Tracks[track].LBA - 1 - lba;
+ else
+  lba_relative = lba - Tracks[track].LBA;
+
+ uint8 adr = 0x1; // Q channel data encodes position
+ uint8 control = Tracks[track].subq_control;
+
+ // Handle pause(D7 of interleaved subchannel byte) bit, should be set to 1 when in pregap or postgap.
+ if((lba < Tracks[track].LBA) || (lba >= Tracks[track].LBA + Tracks[track].sectors))
+  pause_or = 0x80;
+
+ // Handle pregap between audio->data track
+ {
+  int32 pg_offset = (int32)lba - Tracks[track].LBA;
+
+  if(pg_offset < -150)
+  {
+   if((Tracks[track].subq_control & SUBQ_CTRLF_DATA) && (FirstTrack < track) && !(Tracks[track - 1].subq_control & SUBQ_CTRLF_DATA))
+    control = Tracks[track - 1].subq_control;
+  }
+ }
+
+ memset(buf, 0, 0xC);
+ buf[0] = (adr << 0) | (control << 4);
+ buf[1] = U8_to_BCD(track);
+ buf[2] = U8_to_BCD(lba < Tracks[track].LBA ? 0 : 1);
+
+ //
+ // Track relative MSF address
+ //
+ ABA_to_AMSF_BCD(lba_relative, &buf[3], &buf[4], &buf[5]);
+
+ buf[6] = 0;
+
+ //
+ // Absolute MSF address
+ //
+ ABA_to_AMSF_BCD(LBA_to_ABA(lba), &buf[7], &buf[8], &buf[9]);
+
+ subq_generate_checksum(buf);
+
+ for(int i = 0; i < 96; i++)
+  SubPWBuf[i] |= (((buf[i >> 3] >> (7 - (i & 0x7))) & 1) ? 0x40 : 0x00) | pause_or;
+
+ return track;
+}
+
+void CDAccess_CHD::Read_TOC(TOC *rtoc)
+{
+ *rtoc = toc;
+}
+
+void CDAccess_CHD::GenerateTOC(void)
+{
+ toc.Clear();
+
+ toc.first_track = FirstTrack;
+ toc.last_track = FirstTrack + NumTracks - 1;
+ toc.disc_type = disc_type;
+
+ for(int i = FirstTrack; i < FirstTrack + NumTracks; i++)
+ {
+  toc.tracks[i].lba = Tracks[i].LBA;
+  toc.tracks[i].adr = ADR_CURPOS;
+  toc.tracks[i].control = Tracks[i].subq_control;
+  toc.tracks[i].valid = true;
+ }
+
+ toc.tracks[100].lba = total_sectors;
+ toc.tracks[100].adr = ADR_CURPOS;
+ toc.tracks[100].control = Tracks[FirstTrack + NumTracks - 1].subq_control;
+ toc.tracks[100].valid = true;
+}
+
+}
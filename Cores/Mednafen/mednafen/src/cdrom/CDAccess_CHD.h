@@ -0,0 +1,121 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* CDAccess_CHD.h:
+**  Copyright (C) 2026 Provenance Team
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "CDAccess.h"
+
+struct _chd_file;
+
+namespace Mednafen
+{
+
+class CDAccess_CHD : public CDAccess
+{
+ public:
+
+ CDAccess_CHD(VirtualFS* vfs, const std::string& path, bool image_memcache);
+ virtual ~CDAccess_CHD();
+
+ virtual void Read_Raw_Sector(uint8 *buf, int32 lba);
+
+ virtual bool Fast_Read_Raw_PW_TSRE(uint8* pwbuf, int32 lba) const noexcept;
+
+ virtual void Read_TOC(CDUtility::TOC *toc);
+
+ virtual bool Prefetch(int32 lba);
+
+ private:
+
+ enum
+ {
+  CHD_TF_AUDIO = 0,
+  CHD_TF_MODE1,
+  CHD_TF_MODE1_RAW,
+  CHD_TF_MODE2,
+  CHD_TF_MODE2_FORM1,
+  CHD_TF_MODE2_FORM2,
+  CHD_TF_MODE2_RAW
+ };
+
+ enum
+ {
+  CHD_SUB_NONE = 0,
+  CHD_SUB_RW,		// Deinterleaved("cooked") R-W
+  CHD_SUB_RW_RAW	// Interleaved P-W, as it comes off the disc
+ };
+
+ struct CHD_Track
+ {
+  int32 LBA;		// LBA of INDEX 01
+  int32 sectors;	// Not including pregap sectors!
+  int32 pregap;		// Pregap not stored in the CHD.
+  int32 pregap_dv;	// Pregap stored in the CHD, preceding INDEX 01.
+  int32 postgap;
+
+  uint32 format;
+  uint32 subtype;
+  uint8 subq_control;
+
+  uint32 frame_offset;	// CHD frame number of the first stored(pregap_dv or INDEX 01) sector.
+ };
+
+ struct HunkCacheEntry
+ {
+  uint32 hunknum;
+  uint64 last_use;
+  std::unique_ptr<uint8[]> data;
+ };
+
+ void Load(const std::string& path, bool image_memcache);
+ void Cleanup(void);
+
+ void ParseTrackMetadata(void);
+ const uint8* GetHunk(uint32 hunknum);
+ bool LBA_to_Frame(int32 lba, uint32* frame) const;
+
+ int32 MakeSubPQ(int32 lba, uint8 *SubPWBuf) const;
+ void GenerateTOC(void);
+
+ _chd_file* chd;
+
+ uint32 hunk_bytes;
+ uint32 frames_per_hunk;
+ uint32 total_hunks;
+
+ //
+ // LRU cache of decompressed hunks(unbounded with image memcache); a hunk typically holds 8 sectors, so sequential reads
+ // only hit the decompressor once every few sectors, and Prefetch() lets an idle read thread
+ // decompress the next hunks before they're needed.
+ //
+ std::vector<HunkCacheEntry> hunk_cache;
+ std::vector<int32> hunk_cache_slot;	// Indexed by hunk number; -1 if not cached.
+ size_t hunk_cache_max;
+ uint64 hunk_cache_counter;
+
+ int32 FirstTrack;
+ int32 NumTracks;
+ int32 total_sectors;
+ uint8 disc_type;
+ CHD_Track Tracks[100];
+
+ CDUtility::TOC toc;
+};
+
+}
@@ -37,6 +37,7 @@
 #include <mednafen/general.h>
 #include <mednafen/string/string.h>
 #include <mednafen/MemoryStream.h>
+#include <mednafen/compress/ZLIndexedInflateFilter.h>
 
 #include "CDAccess.h"
 #include "CDAccess_Image.h"
@@ -186,6 +187,19 @@ uint32 CDAccess_Image::GetSectorCount(CDRFILE_TRACK_INFO *track)
  return size / div;
 }
 
+//
+// Opens a track file; gzip-compressed ones(".gz" extension) are decompressed on demand.
+//
+static Stream* OpenTrackFile(VirtualFS* vfs, const std::string& efn)
+{
+ std::unique_ptr<Stream> ret(vfs->open(efn, VirtualFS::MODE_READ));
+
+ if(efn.size() >= 3 && !MDFN_strazicmp(efn.c_str() + efn.size() - 3, ".gz"))
+  ret.reset(new ZLIndexedInflateFilter(std::move(ret), MDFN_sprintf(_("opened file \"%s\""), efn.c_str()), ZLIndexedInflateFilter::FORMAT::GZIP));
+
+ return ret.release();
+}
+
 void CDAccess_Image::ParseTOCFileLineInfo(VirtualFS* vfs, CDRFILE_TRACK_INFO *track, const int tracknum, const std::string &filename, const char *binoffset, const char *msfoffset, const char *length, bool image_memcache, std::map<std::string, Stream*> &toc_streamcache)
 {
  long offset = 0; // In bytes!
@@ -212,10 +226,10 @@ void CDAccess_Image::ParseTOCFileLineInfo(VirtualFS* vfs, CDRFILE_TRACK_INFO *tr
   efn = vfs->eval_fip(base_dir, filename);
 
   if(image_memcache)
-   track->fp = new MemoryStream(vfs->open(efn, VirtualFS::MODE_READ));
+   track->fp = new MemoryStream(OpenTrackFile(vfs, efn));
   else
   {
-   track->fp = vfs->open(efn, VirtualFS::MODE_READ);
+   track->fp = OpenTrackFile(vfs, efn);
    track->fp->require_fast_seekable();
   }
 
@@ -646,7 +660,7 @@ void CDAccess_Image::ImageOpen(VirtualFS* vfs, const std::string& path, bool ima
      }
 
      std::string efn = vfs->eval_fip(base_dir, args[0]);
-     TmpTrack.fp = vfs->open(efn, VirtualFS::MODE_READ);
+     TmpTrack.fp = OpenTrackFile(vfs, efn);
      TmpTrack.FirstFileInstance = 1;
 
      if(image_memcache)
@@ -130,6 +130,7 @@ static int ReadThreadStart_C(void* arg)
 int CDInterface_MT::ReadThreadStart()
 {
  bool Running = true;
+ bool PrefetchPending = false;
 
  SBWritePos = 0;
  ra_lba = 0;
@@ -165,8 +166,8 @@ int CDInterface_MT::ReadThreadStart()
 
   //printf("%d %d %d\n", last_read_lba, ra_lba, ra_count);
 
-  // Only do a blocking-wait for a message if we don't have any sectors to read-ahead.
-  if(ReadThreadQueue.Read(&msg, ra_count ? false : true))
+  // Only do a blocking-wait for a message if we don't have any sectors to read-ahead or prefetch.
+  if(ReadThreadQueue.Read(&msg, (ra_count || PrefetchPending) ? false : true))
   {
    if(msg.message == CDInterface_MSG_DIEDIEDIE)
     Running = false;
@@ -242,6 +243,15 @@ int CDInterface_MT::ReadThreadStart()
 
    ra_lba++;
    ra_count--;
+
+   PrefetchPending = !ra_count;
+  }
+  else if(PrefetchPending)
+  {
+   //
+   // Let the disc image reader do work(e.g. decompression) ahead of the read-ahead position while we're otherwise idle.
+   //
+   PrefetchPending = disc_cdaccess->Prefetch(ra_lba);
   }
  }
 
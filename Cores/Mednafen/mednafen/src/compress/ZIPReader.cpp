@@ -24,7 +24,7 @@
 
 #include <mednafen/mednafen.h>
 #include "ZIPReader.h"
-#include "ZLInflateFilter.h"
+#include "ZLIndexedInflateFilter.h"
 
 namespace Mednafen
 {
@@ -33,7 +33,9 @@ class StreamViewFilter : public Stream
 {
  public:
 
- StreamViewFilter(Stream* source_stream, const std::string& vfc, uint64 sp, uint64 bp, uint64 expcrc32 = ~(uint64)0);
+ // 'source_mutex', if not null, is held while 'source_stream' is accessed, so views of the same stream
+ // may be used from different threads.
+ StreamViewFilter(Stream* source_stream, const std::string& vfc, uint64 sp, uint64 bp, uint64 expcrc32 = ~(uint64)0, MThreading::Mutex* source_mutex = nullptr);
  virtual ~StreamViewFilter() override;
  virtual uint64 read(void *data, uint64 count, bool error_on_eos = true) override;
  virtual void write(const void *data, uint64 count) override;
@@ -47,6 +49,7 @@ class StreamViewFilter : public Stream
 
  private:
  Stream* ss;
+ MThreading::Mutex* ss_mutex;
  uint64 ss_start_pos;
  uint64 ss_bound_pos;
 
@@ -58,7 +61,7 @@ class StreamViewFilter : public Stream
  const std::string vfcontext;
 };
 
-StreamViewFilter::StreamViewFilter(Stream* source_stream, const std::string& vfc, uint64 sp, uint64 bp, uint64 expcrc32) : ss(source_stream), ss_start_pos(sp), ss_bound_pos(bp), pos(0), running_crc32(0), running_crc32_posreached(0), expected_crc32(expcrc32), vfcontext(vfc)
+StreamViewFilter::StreamViewFilter(Stream* source_stream, const std::string& vfc, uint64 sp, uint64 bp, uint64 expcrc32, MThreading::Mutex* source_mutex) : ss(source_stream), ss_mutex(source_mutex), ss_start_pos(sp), ss_bound_pos(bp), pos(0), running_crc32(0), running_crc32_posreached(0), expected_crc32(expcrc32), vfcontext(vfc)
 {
  if(ss_bound_pos < ss_start_pos)
   throw MDFN_Error(0, _("StreamViewFilter() bound_pos < start_pos"));
@@ -84,10 +87,27 @@ uint64 StreamViewFilter::read(void *data, uint64 count, bool error_on_eos)
  if(cc < count && error_on_eos)
   throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("Unexpected EOF"));
 
- if(ss->tell() != (ss_start_pos + pos))
-  ss->seek(ss_start_pos + pos, SEEK_SET);
+ if(ss_mutex)
+  MThreading::Mutex_Lock(ss_mutex);
+
+ try
+ {
+  if(ss->tell() != (ss_start_pos + pos))
+   ss->seek(ss_start_pos + pos, SEEK_SET);
+
+  ret = ss->read(data, cc, error_on_eos);
+ }
+ catch(...)
+ {
+  if(ss_mutex)
+   MThreading::Mutex_Unlock(ss_mutex);
+
+  throw;
+ }
+
+ if(ss_mutex)
+  MThreading::Mutex_Unlock(ss_mutex);
 
- ret = ss->read(data, cc, error_on_eos);
  pos += ret;
 
  if(expected_crc32 != ~(uint64)0)
@@ -202,7 +222,40 @@ void StreamViewFilter::flush(void)
 Stream* ZIPReader::open(size_t which)
 {
  const auto& e = entries[which];
+ uint64 start_pos;
+
+ // Streams already opened may be in use from other threads(e.g. CD image track files).
+ MThreading::Mutex_Lock(zs_mutex);
+
+ try
+ {
+  start_pos = read_local_header(e);
+ }
+ catch(...)
+ {
+  MThreading::Mutex_Unlock(zs_mutex);
+  throw;
+ }
+
+ MThreading::Mutex_Unlock(zs_mutex);
+
+ std::string vfcontext = MDFN_sprintf(_("opened file \"%s\" in ZIP archive"), e.name.c_str());
 
+ if(e.method == 0)
+  return new StreamViewFilter(zs.get(), vfcontext, start_pos, start_pos + e.uncomp_size, e.crc32, zs_mutex);
+ else if(e.method == 8)
+ {
+  std::unique_ptr<Stream> cs(new StreamViewFilter(zs.get(), vfcontext, start_pos, start_pos + e.comp_size, ~(uint64)0, zs_mutex));
+
+  return new ZLIndexedInflateFilter(std::move(cs), vfcontext, ZLIndexedInflateFilter::FORMAT::RAW, e.uncomp_size, e.crc32);
+ }
+ else
+  throw MDFN_Error(0, _("ZIP compression method %u not implemented."), e.method);
+}
+
+// Returns the position of the entry's data; call with zs_mutex held.
+uint64 ZIPReader::read_local_header(const FileDesc& e)
+{
  zs->seek(e.lh_reloffs, SEEK_SET);
 
  struct
@@ -250,28 +303,20 @@ Stream* ZIPReader::open(size_t which)
 
  zs->seek(lfh.name_len + lfh.extra_len, SEEK_CUR);
 
- std::string vfcontext = MDFN_sprintf(_("opened file \"%s\" in ZIP archive"), e.name.c_str());
-
- if(e.method == 0)
- {
-  uint64 start_pos = zs->tell();
-  uint64 bound_pos = start_pos + e.uncomp_size;
-
-  return new StreamViewFilter(zs.get(), vfcontext, start_pos, bound_pos, e.crc32);
- }
- else if(e.method == 8)
-  return new ZLInflateFilter(zs.get(), vfcontext, ZLInflateFilter::FORMAT::RAW, e.comp_size, e.uncomp_size, e.crc32);
- else
-  throw MDFN_Error(0, _("ZIP compression method %u not implemented."), lfh.method);
+ return zs->tell();
 }
 
 ZIPReader::~ZIPReader()
 {
-
+ if(zs_mutex)
+ {
+  MThreading::Mutex_Destroy(zs_mutex);
+  zs_mutex = nullptr;
+ }
 }
 
 
-ZIPReader::ZIPReader(std::unique_ptr<Stream> s) : VirtualFS('/', "/")
+ZIPReader::ZIPReader(std::unique_ptr<Stream> s) : VirtualFS('/', "/"), zs_mutex(nullptr)
 {
  const uint64 size = s->size();
 
@@ -374,6 +419,7 @@ ZIPReader::ZIPReader(std::unique_ptr<Stream> s) : VirtualFS('/', "/")
  }
 
  zs = std::move(s);
+ zs_mutex = MThreading::Mutex_Create();
 }
 
 
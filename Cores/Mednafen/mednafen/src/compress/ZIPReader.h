@@ -22,6 +22,8 @@
 #ifndef __MDFN_COMPRESS_ZIPREADER_H
 #define __MDFN_COMPRESS_ZIPREADER_H
 
+#include <mednafen/MThreading.h>
+
 namespace Mednafen
 {
 
@@ -73,8 +75,10 @@ class ZIPReader : public VirtualFS
  };
 
  size_t find_by_path(const std::string& path);
+ uint64 read_local_header(const FileDesc& e);
 
  std::unique_ptr<Stream> zs;
+ MThreading::Mutex* zs_mutex;	// Held while zs is accessed.
  std::vector<FileDesc> entries;
 };
 
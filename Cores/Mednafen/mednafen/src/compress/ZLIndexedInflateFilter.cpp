@@ -0,0 +1,517 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* ZLIndexedInflateFilter.cpp:
+**  Copyright (C) 2026 Provenance Team
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include <mednafen/types.h>
+#include "ZLIndexedInflateFilter.h"
+#include <mednafen/mednafen.h>
+
+#include <atomic>
+
+namespace Mednafen
+{
+
+// Number of cache blocks allocated by all instances.
+static std::atomic<unsigned> CacheBlocksInUse(0);
+
+ZLIndexedInflateFilter::ZLIndexedInflateFilter(std::unique_ptr<Stream> source_stream, const std::string& vfc, FORMAT df, uint64 ucs, uint64 ucrc32)
+	: ss(std::move(source_stream)), ss_startpos(0), ss_boundpos(ss->size()), format(df), uc_size(ucs), expected_crc32(ucrc32), vfcontext(vfc)
+{
+ init(df);
+}
+
+void ZLIndexedInflateFilter::init(FORMAT df)
+{
+ int irc;
+ uint64 size_hint = uc_size;
+
+ zs_init = false;
+ dec_valid = false;
+ dec_end = false;
+ dec_upos = 0;
+ dec_cpos = 0;
+ use_counter = 0;
+ position = 0;
+ running_crc32 = 0;
+ running_crc32_posreached = 0;
+ member_crc32_cpos = 0;
+
+ if(df == FORMAT::GZIP)
+ {
+  uint8 trailer[8];
+
+  if((ss_boundpos - ss_startpos) < (10 + sizeof(trailer)))
+   throw MDFN_Error(0, _("Error opening %s: %s"), vfcontext.c_str(), _("too small to be a gzip file"));
+
+  // Only good for the size of the index; the last member's ISIZE is all of the data only if there's one member, and
+  // only modulo 2^32.
+  ss->seek(ss_boundpos - sizeof(trailer), SEEK_SET);
+  ss->read(trailer, sizeof(trailer));
+  size_hint = std::max<uint64>(MDFN_de32lsb(&trailer[4]), ss_boundpos);
+
+  ss_startpos = parse_gzip_header(ss_startpos);
+ }
+ else if(df != FORMAT::RAW)
+  abort();
+ else if(uc_size == ~(uint64)0)
+  throw MDFN_Error(0, _("Error opening %s: %s"), vfcontext.c_str(), _("uncompressed size is unknown"));
+
+ memset(&zs, 0, sizeof(zs));
+ irc = inflateInit2(&zs, 0 - 15);
+
+ if(MDFN_UNLIKELY(irc < 0))
+  throw MDFN_Error(0, _("zlib inflateInit2() failed: %d"), irc);
+
+ zs_init = true;
+
+ index.emplace_back(Checkpoint({ 0, ss_startpos, 0, 0, nullptr }));
+ index_span = std::max<uint64>(1U << 20, size_hint / 256);
+
+ if(df == FORMAT::GZIP)
+  scan_gzip();
+}
+
+//
+// Decompresses the whole gzip stream once, to get its size; each member's CRC32 gets checked, and the checkpoint index
+// built, along the way.
+//
+void ZLIndexedInflateFilter::scan_gzip(void)
+{
+ std::unique_ptr<uint8[]> buf(new uint8[BlockSize]);
+
+ decoder_restore(index[0]);
+
+ while(!dec_end)
+  decode(buf.get(), BlockSize);
+
+ uc_size = dec_upos;
+}
+
+//
+// Parses the gzip member header at 'pos', returning the position of its deflate data.
+//
+uint64 ZLIndexedInflateFilter::parse_gzip_header(uint64 pos)
+{
+ uint8 header[10];
+
+ if((ss_boundpos - pos) < sizeof(header))
+  throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("bad gzip header"));
+
+ ss->seek(pos, SEEK_SET);
+ ss->read(header, sizeof(header));
+ pos += sizeof(header);
+
+ if(header[0] != 0x1F || header[1] != 0x8B || header[2] != 0x08)
+  throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("bad gzip header"));
+
+ // FEXTRA
+ if(header[3] & 0x04)
+ {
+  uint8 xlen[2];
+
+  ss->read(xlen, sizeof(xlen));
+  pos += sizeof(xlen) + MDFN_de16lsb(xlen);
+  ss->seek(pos, SEEK_SET);
+ }
+
+ // FNAME, FCOMMENT
+ for(unsigned flag = 0x08; flag <= 0x10; flag <<= 1)
+ {
+  if(header[3] & flag)
+  {
+   uint8 c;
+
+   do
+   {
+    ss->read(&c, 1);
+    pos++;
+   } while(c);
+  }
+ }
+
+ // FHCRC
+ if(header[3] & 0x02)
+  pos += 2;
+
+ if(pos > ss_boundpos)
+  throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("bad gzip header"));
+
+ return pos;
+}
+
+//
+// Called at the end of a gzip member's deflate data: checks the member's CRC32 the first time through, and moves on
+// to the next member, if any.  Like gzread(), anything after the last member that isn't another member is ignored.
+//
+void ZLIndexedInflateFilter::next_gzip_member(void)
+{
+ const uint64 tpos = dec_cpos - zs.avail_in;
+ uint8 trailer[8];
+ uint8 magic[2];
+ int irc;
+
+ zs.avail_in = 0;
+
+ if(MDFN_UNLIKELY((ss_boundpos - tpos) < sizeof(trailer)))
+  throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("Unexpected end of compressed data"));
+
+ ss->seek(tpos, SEEK_SET);
+ ss->read(trailer, sizeof(trailer));
+
+ if(tpos > member_crc32_cpos && running_crc32_posreached == dec_upos)
+ {
+  if(MDFN_UNLIKELY(running_crc32 != MDFN_de32lsb(&trailer[0])))
+   throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("decompressed data fails CRC32 check"));
+
+  running_crc32 = 0;
+  member_crc32_cpos = tpos;
+ }
+
+ if((ss_boundpos - (tpos + sizeof(trailer))) < sizeof(magic) || ss->read(magic, sizeof(magic)) != sizeof(magic) || magic[0] != 0x1F || magic[1] != 0x8B)
+ {
+  dec_end = true;
+  return;
+ }
+
+ dec_cpos = parse_gzip_header(tpos + sizeof(trailer));
+
+ if(MDFN_UNLIKELY((irc = inflateReset(&zs)) < 0))
+  throw MDFN_Error(0, _("Error reading from %s: inflateReset() failed: %d"), vfcontext.c_str(), irc);
+}
+
+ZLIndexedInflateFilter::~ZLIndexedInflateFilter()
+{
+ try
+ {
+  close();
+ }
+ catch(std::exception &e)
+ {
+  MDFND_OutputNotice(MDFN_NOTICE_ERROR, e.what());
+ }
+}
+
+void ZLIndexedInflateFilter::decoder_restore(const Checkpoint& cp)
+{
+ int irc;
+
+ zs.avail_in = 0;
+ dec_valid = false;
+
+ if(MDFN_UNLIKELY((irc = inflateReset(&zs)) < 0))
+  throw MDFN_Error(0, _("Error reading from %s: inflateReset() failed: %d"), vfcontext.c_str(), irc);
+
+ if(cp.bits)
+ {
+  uint8 b;
+
+  ss->seek(cp.cpos - 1, SEEK_SET);
+  ss->read(&b, 1);
+
+  if(MDFN_UNLIKELY((irc = inflatePrime(&zs, cp.bits, b >> (8 - cp.bits))) < 0))
+   throw MDFN_Error(0, _("Error reading from %s: inflatePrime() failed: %d"), vfcontext.c_str(), irc);
+ }
+
+ if(cp.win_len)
+ {
+  if(MDFN_UNLIKELY((irc = inflateSetDictionary(&zs, cp.win.get(), cp.win_len)) < 0))
+   throw MDFN_Error(0, _("Error reading from %s: inflateSetDictionary() failed: %d"), vfcontext.c_str(), irc);
+ }
+
+ dec_upos = cp.upos;
+ dec_cpos = cp.cpos;
+ dec_end = false;
+ dec_valid = true;
+}
+
+void ZLIndexedInflateFilter::add_checkpoint(void)
+{
+ Checkpoint cp;
+ int irc;
+
+ cp.upos = dec_upos;
+ cp.cpos = dec_cpos - zs.avail_in;
+ cp.bits = zs.data_type & 0x7;
+ cp.win_len = WindowSize;
+ cp.win.reset(new uint8[WindowSize]);
+
+ if(MDFN_UNLIKELY((irc = inflateGetDictionary(&zs, cp.win.get(), &cp.win_len)) < 0))
+  throw MDFN_Error(0, _("Error reading from %s: inflateGetDictionary() failed: %d"), vfcontext.c_str(), irc);
+
+ index.push_back(std::move(cp));
+}
+
+void ZLIndexedInflateFilter::update_crc32(const uint8* data, uint32 len)
+{
+ if(format == FORMAT::RAW && expected_crc32 == ~(uint64)0)
+  return;
+
+ // Decompression always restarts at a checkpoint at or before running_crc32_posreached, so all data gets checked once.
+ if((dec_upos + len) > running_crc32_posreached && dec_upos <= running_crc32_posreached)
+ {
+  running_crc32 = crc32(running_crc32, data + (running_crc32_posreached - dec_upos), (dec_upos + len) - running_crc32_posreached);
+  running_crc32_posreached = dec_upos + len;
+
+  if(format == FORMAT::RAW && running_crc32_posreached == uc_size && running_crc32 != expected_crc32)
+   throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("decompressed data fails CRC32 check"));
+ }
+}
+
+//
+// Decompresses up to 'len' bytes at dec_upos, adding checkpoints when past the last one by index_span.
+//
+uint32 ZLIndexedInflateFilter::decode(uint8* out, uint32 len)
+{
+ zs.next_out = (Bytef*)out;
+ zs.avail_out = len;
+
+ while(zs.avail_out && !dec_end)
+ {
+  if(!zs.avail_in)
+  {
+   const uint64 toread = std::min<uint64>(sizeof(inbuf), ss_boundpos - dec_cpos);
+
+   if(MDFN_UNLIKELY(!toread))
+    throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("Unexpected end of compressed data"));
+
+   if(ss->tell() != dec_cpos)
+    ss->seek(dec_cpos, SEEK_SET);
+
+   const uint64 rc = ss->read(inbuf, toread, false);
+
+   if(MDFN_UNLIKELY(!rc))
+    throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("Unexpected end of compressed data"));
+
+   dec_cpos += rc;
+   zs.next_in = inbuf;
+   zs.avail_in = rc;
+  }
+
+  uint8* const prev_out = zs.next_out;
+  int irc = inflate(&zs, Z_BLOCK);
+
+  if(MDFN_UNLIKELY(irc < 0))
+  {
+   dec_valid = false;
+
+   if(irc == Z_DATA_ERROR)
+    throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), zs.msg);
+   else if(irc == Z_MEM_ERROR)
+    throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("insufficient memory"));
+   else
+    throw MDFN_Error(0, _("Error reading from %s: zlib error %d"), vfcontext.c_str(), irc);
+  }
+
+  const uint32 produced = zs.next_out - prev_out;
+
+  update_crc32(prev_out, produced);
+  dec_upos += produced;
+
+  if(irc == Z_STREAM_END)
+  {
+   if(format == FORMAT::GZIP)
+    next_gzip_member();
+   else
+    dec_end = true;
+  }
+  else if((zs.data_type & 0xC0) == 0x80 && dec_upos >= (index.back().upos + index_span))
+   add_checkpoint();
+ }
+
+ return len - zs.avail_out;
+}
+
+// Takes a block from the shared budget, if any is left.
+bool ZLIndexedInflateFilter::cache_grow(void)
+{
+ if(cache.size() < MinCacheBlocks)
+  CacheBlocksInUse++;
+ else
+ {
+  unsigned cur = CacheBlocksInUse.load();
+
+  do
+  {
+   if(cur >= CacheBlockCount)
+    return false;
+  } while(!CacheBlocksInUse.compare_exchange_weak(cur, cur + 1));
+ }
+
+ cache.emplace_back();
+ cache.back().data.reset(new uint8[BlockSize]);
+
+ return true;
+}
+
+void ZLIndexedInflateFilter::cache_free(void)
+{
+ CacheBlocksInUse -= cache.size();
+ cache.clear();
+}
+
+ZLIndexedInflateFilter::CacheBlock& ZLIndexedInflateFilter::load_block(uint64 bi)
+{
+ CacheBlock* victim = nullptr;
+
+ for(auto& cb : cache)
+ {
+  if(cb.index == bi)
+  {
+   cb.last_use = ++use_counter;
+   return cb;
+  }
+
+  if(!victim || cb.last_use < victim->last_use)
+   victim = &cb;
+ }
+ //
+ //
+ const uint64 bstart = bi * BlockSize;
+ const uint32 blen = std::min<uint64>(BlockSize, uc_size - bstart);
+
+ if(cache_grow())
+  victim = &cache.back();
+
+ victim->index = ~(uint64)0;
+ victim->last_use = 0;
+
+ {
+  // Last checkpoint at or before the block; if it isn't indexed yet, that's the last one, and decoding
+  // forward from it will add more.
+  auto cpi = std::upper_bound(index.begin(), index.end(), bstart, [](const uint64 v, const Checkpoint& cp) { return v < cp.upos; }) - 1;
+
+  if(!dec_valid || dec_upos > bstart || cpi->upos > dec_upos)
+   decoder_restore(*cpi);
+ }
+
+ while(dec_upos < bstart)
+ {
+  const uint32 toskip = std::min<uint64>(BlockSize, bstart - dec_upos);
+
+  if(MDFN_UNLIKELY(decode(victim->data.get(), toskip) != toskip))
+   throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("decompressed data is shorter than expected"));
+ }
+
+ if(MDFN_UNLIKELY(decode(victim->data.get(), blen) != blen))
+  throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("decompressed data is shorter than expected"));
+
+ victim->index = bi;
+ victim->len = blen;
+ victim->last_use = ++use_counter;
+
+ return *victim;
+}
+
+uint64 ZLIndexedInflateFilter::read(void *data, uint64 count, bool error_on_eos)
+{
+ const uint64 count_limited = std::min<uint64>(count, uc_size - std::min<uint64>(uc_size, position));
+ uint64 ret = 0;
+
+ while(ret < count_limited)
+ {
+  CacheBlock& cb = load_block(position / BlockSize);
+  const uint32 offs = position % BlockSize;
+  const uint32 cc = std::min<uint64>(cb.len - offs, count_limited - ret);
+
+  memcpy((uint8*)data + ret, &cb.data[offs], cc);
+  position += cc;
+  ret += cc;
+ }
+
+ if(MDFN_UNLIKELY(ret < count && error_on_eos))
+  throw MDFN_Error(0, _("Error reading from %s: %s"), vfcontext.c_str(), _("Unexpected EOF"));
+
+ return ret;
+}
+
+void ZLIndexedInflateFilter::write(const void *data, uint64 count)
+{
+ throw MDFN_Error(ErrnoHolder(EINVAL));
+}
+
+void ZLIndexedInflateFilter::seek(int64 offset, int whence)
+{
+ uint64 new_position;
+
+ switch(whence)
+ {
+   default:
+	throw MDFN_Error(ErrnoHolder(EINVAL));
+	break;
+
+   case SEEK_SET:
+	new_position = offset;
+	break;
+
+   case SEEK_CUR:
+	new_position = position + offset;
+	break;
+
+   case SEEK_END:
+	new_position = uc_size + offset;
+	break;
+ }
+
+ if(MDFN_UNLIKELY((int64)new_position < 0))
+  throw MDFN_Error(EINVAL, _("Error seeking in %s: Attempted to seek to out-of-bounds position %llu in deflate-compressed stream."), vfcontext.c_str(), (unsigned long long)new_position);
+
+ position = new_position;
+}
+
+uint64 ZLIndexedInflateFilter::tell(void)
+{
+ return position;
+}
+
+uint64 ZLIndexedInflateFilter::size(void)
+{
+ return uc_size;
+}
+
+void ZLIndexedInflateFilter::close(void)
+{
+ if(zs_init)
+ {
+  inflateEnd(&zs);
+  memset(&zs, 0, sizeof(zs));
+  zs_init = false;
+ }
+
+ dec_valid = false;
+ index.clear();
+ cache_free();
+}
+
+uint64 ZLIndexedInflateFilter::attributes(void)
+{
+ return ss->attributes() & (ATTRIBUTE_READABLE | ATTRIBUTE_SEEKABLE);
+}
+
+void ZLIndexedInflateFilter::truncate(uint64 length)
+{
+ throw MDFN_Error(EINVAL, _("Error truncating %s: %s"), vfcontext.c_str(), _("ZLIndexedInflateFilter::truncate() not implemented"));
+}
+
+void ZLIndexedInflateFilter::flush(void)
+{
+ throw MDFN_Error(EINVAL, _("Error flushing %s: %s"), vfcontext.c_str(), _("ZLIndexedInflateFilter::flush() not implemented"));
+}
+
+}
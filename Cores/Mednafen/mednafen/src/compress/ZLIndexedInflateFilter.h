@@ -0,0 +1,133 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* ZLIndexedInflateFilter.h:
+**  Copyright (C) 2026 Provenance Team
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef __MDFN_COMPRESS_ZLINDEXEDINFLATEFILTER_H
+#define __MDFN_COMPRESS_ZLINDEXEDINFLATEFILTER_H
+
+#include <mednafen/Stream.h>
+
+#include <zlib.h>
+
+namespace Mednafen
+{
+
+//
+// Random-access inflate stream.  Decompression state(input bit position and 32KiB window) is saved at deflate
+// block boundaries about every 1/256th of the data(1MiB minimum) as the stream is decompressed the first time, so
+// a seek only has to decompress from the nearest such checkpoint.  Decompressed data is kept in a bounded
+// block cache, so memory usage doesn't depend on the size of the stream beyond the checkpoint index.  The cache
+// budget is shared by all instances(e.g. every track file of a CD image in a ZIP archive).
+//
+// An instance is not thread-safe, but different instances may be used from different threads.  The source stream
+// must not be shared; give each instance its own view of shared data(see ZIPReader).
+//
+class ZLIndexedInflateFilter : public Stream
+{
+ public:
+
+ enum class FORMAT
+ {
+  RAW = 0,	// Raw inflate; uncompressed size must be known.
+  GZIP = 2	// gzip, any number of members; decompressed once when opened, to get the uncompressed size.
+ };
+
+ // Compressed data is the whole of 'source_stream'.  'ucs' and 'ucrc32' are ignored for GZIP.
+ ZLIndexedInflateFilter(std::unique_ptr<Stream> source_stream, const std::string& vfcontext, FORMAT df, uint64 ucs = ~(uint64)0, uint64 ucrc32 = ~(uint64)0);
+
+ virtual ~ZLIndexedInflateFilter() override;
+ virtual uint64 read(void *data, uint64 count, bool error_on_eos = true) override;
+ virtual void write(const void *data, uint64 count) override;
+ virtual void seek(int64 offset, int whence) override;
+ virtual uint64 tell(void) override;
+ virtual uint64 size(void) override;
+ virtual void close(void) override;
+ virtual uint64 attributes(void) override;
+ virtual void truncate(uint64 length) override;
+ virtual void flush(void) override;
+
+ private:
+
+ enum : uint32 { BlockSize = 65536 };
+ enum : unsigned { CacheBlockCount = 128 };	// 8MiB, for all instances together.
+ enum : unsigned { MinCacheBlocks = 2 };		// Per instance, regardless of the above.
+ enum : uint32 { WindowSize = 32768 };
+
+ struct Checkpoint
+ {
+  uint64 upos;		// Uncompressed position.
+  uint64 cpos;		// Position in source stream of the first byte not fully consumed.
+  unsigned bits;	// Number of bits of the byte at cpos - 1 not yet consumed.
+  uInt win_len;
+  std::unique_ptr<uint8[]> win;
+ };
+
+ struct CacheBlock
+ {
+  uint64 index;
+  uint64 last_use;
+  uint32 len;
+  std::unique_ptr<uint8[]> data;
+ };
+
+ void init(FORMAT df);
+ uint64 parse_gzip_header(uint64 pos);
+ void next_gzip_member(void);
+ void scan_gzip(void);
+ void decoder_restore(const Checkpoint& cp);
+ uint32 decode(uint8* out, uint32 len);
+ void add_checkpoint(void);
+ void update_crc32(const uint8* data, uint32 len);
+ CacheBlock& load_block(uint64 bi);
+ bool cache_grow(void);
+ void cache_free(void);
+
+ std::unique_ptr<Stream> ss;
+ uint64 ss_startpos;
+ uint64 ss_boundpos;
+ FORMAT format;
+
+ z_stream zs;
+ bool zs_init;
+ bool dec_valid;
+ bool dec_end;
+ uint64 dec_upos;
+ uint64 dec_cpos;
+ uint8 inbuf[16384];
+
+ std::vector<Checkpoint> index;
+ uint64 index_span;
+
+ std::vector<CacheBlock> cache;
+ uint64 use_counter;
+
+ uint64 position;
+ uint64 uc_size;
+
+ uint32 running_crc32;
+ uint64 running_crc32_posreached;
+ uint64 expected_crc32;
+ uint64 member_crc32_cpos;	// Position of the last gzip member trailer checked.
+
+ std::string vfcontext;
+};
+
+}
+#endif
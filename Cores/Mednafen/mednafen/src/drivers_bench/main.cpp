@@ -0,0 +1,655 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* main.cpp - Headless benchmark driver
+**  Copyright (C) 2026 Provenance Team
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+/*
+ Runs a game for a fixed number of frames through MDFNI_Emulate(), with video rendered to an off-screen surface and
+ sound rendered to a scratch buffer, both discarded, and reports emulation speed.  Optionally plays back an input movie
+ (as recorded by the regular driver) so that runs are repeatable.
+
+ With -lockstep, it instead checks that two values of a setting(e.g. an interpreter and a recompiler) produce the
+ same emulation:  every frame is run once with each value from the same save state, and the resulting save states and
+ debugger register values are compared.  Sound output is compared too when -soundrate is given; output resampler
+ state isn't part of save states, so that needs a rate the module outputs without resampling(44100 for psx, or 0 to
+ skip sound).  -audiohash reports a CRC32 of the sound output over the measured frames, for comparing runs against
+ each other or against a previously recorded value.
+
+ -runahead emulates each frame the way the run-ahead option of the frontend does: after the frame, the state is saved,
+ the given number of frames are emulated with MDFNI_EmulateHidden(), and the state is loaded again.  Only the sound of
+ the real frames is kept, so -audiohash must report the same value as without it.
+
+ Per-section times come from MDFN_BenchScope hooks(see bench.h); modules without hooks report all of their time as
+ "other".
+*/
+
+#include <mednafen/driver.h>
+#include <mednafen/movie.h>
+#include <mednafen/state.h>
+#include <mednafen/MemoryStream.h>
+#include <mednafen/Time.h>
+#include <mednafen/bench.h>
+#include <mednafen/video/surface.h>
+
+#include <trio/trio.h>
+#include <zlib.h>
+
+#include <algorithm>
+
+using namespace Mednafen;
+
+static bool Verbose = false;
+
+void Mednafen::MDFND_OutputNotice(MDFN_NoticeType t, const char* s) noexcept
+{
+ if(t == MDFN_NOTICE_STATUS && !Verbose)
+  return;
+
+ fprintf(stderr, "%s\n", s);
+}
+
+void Mednafen::MDFND_OutputInfo(const char* s) noexcept
+{
+ if(Verbose)
+  fputs(s, stderr);
+}
+
+void Mednafen::MDFND_MidSync(EmulateSpecStruct* espec, const unsigned flags)
+{
+
+}
+
+bool Mednafen::MDFND_CheckNeedExit(void)
+{
+ return false;
+}
+
+void Mednafen::MDFND_MediaSetNotification(uint32 drive_idx, uint32 state_idx, uint32 media_idx, uint32 orientation_idx)
+{
+
+}
+
+void Mednafen::MDFND_NetplayText(const char* text, bool NetEcho)
+{
+
+}
+
+void Mednafen::MDFND_NetplaySetHints(bool active, bool behind, uint32 local_players_mask)
+{
+
+}
+
+void Mednafen::MDFND_SetStateStatus(StateStatusStruct* status) noexcept
+{
+ delete status;
+}
+
+void Mednafen::MDFND_SetMovieStatus(StateStatusStruct* status) noexcept
+{
+ delete status;
+}
+
+static std::string GetBaseDirectory(void)
+{
+ const char* ol;
+
+ ol = getenv("MEDNAFEN_HOME");
+ if(ol != NULL && ol[0] != 0)
+  return std::string(ol);
+
+ ol = getenv("HOME");
+ if(ol)
+  return std::string(ol) + PSS + ".mednafen";
+
+ return std::string(".");
+}
+
+static std::string JSONString(const std::string& s)
+{
+ std::string ret = "\"";
+
+ for(unsigned char c : s)
+ {
+  if(c == '"' || c == '\\')
+  {
+   ret += '\\';
+   ret += c;
+  }
+  else if(c < 0x20)
+  {
+   char tmp[8];
+
+   trio_snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+   ret += tmp;
+  }
+  else
+   ret += c;
+ }
+
+ ret += "\"";
+
+ return ret;
+}
+
+struct BenchResult
+{
+ uint32 frames = 0;
+ int64 total_ns = 0;
+ double emu_seconds = 0;	// Emulated time, from MasterCycles.
+ int64 section_ns[MDFN_BENCH_COUNT] = { 0 };
+ std::vector<int64> frame_ns;
+ bool movie = false;
+ bool movie_ended = false;
+ bool audio_hash = false;
+ uint32 audio_crc = 0;		// CRC32 of the sound output, as little-endian 16-bit samples.
+ uint64 audio_samples = 0;	// Sample frames hashed.
+};
+
+static double Percentile(const std::vector<int64>& sorted, double p)
+{
+ if(!sorted.size())
+  return 0;
+
+ const size_t i = std::min<size_t>(sorted.size() - 1, (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5));
+
+ return sorted[i] / 1000000.0;
+}
+
+static void PrintResult(const MDFNGI* gi, const char* path, const BenchResult& r, uint32 warmup, bool json)
+{
+ std::vector<int64> sorted = r.frame_ns;
+ const double secs = r.total_ns / 1000000000.0;
+ const double fps = secs > 0 ? r.frames / secs : 0;
+ const double speed = secs > 0 ? r.emu_seconds / secs : 0;
+ const double mean_ms = r.frames ? (r.total_ns / 1000000.0) / r.frames : 0;
+ int64 other_ns = r.total_ns;
+ static const char* section_names[MDFN_BENCH_COUNT] = { "video", "sound" };
+
+ std::sort(sorted.begin(), sorted.end());
+
+ for(unsigned i = 0; i < MDFN_BENCH_COUNT; i++)
+  other_ns -= r.section_ns[i];
+
+ if(json)
+ {
+  printf("{\"module\": %s, \"name\": %s, \"path\": %s, ", JSONString(gi->shortname).c_str(), JSONString(gi->name).c_str(), JSONString(path).c_str());
+  printf("\"frames\": %u, \"warmup_frames\": %u, \"movie\": %s, \"movie_ended\": %s, ", r.frames, warmup, r.movie ? "true" : "false", r.movie_ended ? "true" : "false");
+  printf("\"seconds\": %.6f, \"fps\": %.3f, \"speed\": %.4f, ", secs, fps, speed);
+  printf("\"frame_ms\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}, ",
+	Percentile(sorted, 0), mean_ms, Percentile(sorted, 50), Percentile(sorted, 90), Percentile(sorted, 95), Percentile(sorted, 99), Percentile(sorted, 100));
+  if(r.audio_hash)
+   printf("\"audio_crc32\": \"%08x\", \"audio_samples\": %llu, ", r.audio_crc, (unsigned long long)r.audio_samples);
+  printf("\"sections_seconds\": {");
+  for(unsigned i = 0; i < MDFN_BENCH_COUNT; i++)
+   printf("\"%s\": %.6f, ", section_names[i], r.section_ns[i] / 1000000000.0);
+  printf("\"other\": %.6f}}\n", other_ns / 1000000000.0);
+ }
+ else
+ {
+  printf("Module: %s (%s)\n", gi->shortname, gi->fullname);
+  printf("Game: %s\n", path);
+  printf("Frames: %u (after %u warm-up frames)%s\n", r.frames, warmup, r.movie ? (r.movie_ended ? ", movie ended early" : ", movie playback") : "");
+  printf("Time: %.3f s, %.2f frames/s, %.2fx realtime\n", secs, fps, speed);
+  printf("Frame time (ms): min %.3f, mean %.3f, p50 %.3f, p90 %.3f, p95 %.3f, p99 %.3f, max %.3f\n",
+	Percentile(sorted, 0), mean_ms, Percentile(sorted, 50), Percentile(sorted, 90), Percentile(sorted, 95), Percentile(sorted, 99), Percentile(sorted, 100));
+
+  printf("Sections:");
+  for(unsigned i = 0; i < MDFN_BENCH_COUNT; i++)
+   printf(" %s %.3f s (%.1f%%),", section_names[i], r.section_ns[i] / 1000000000.0, r.total_ns ? 100.0 * r.section_ns[i] / r.total_ns : 0.0);
+  printf(" cpu/other %.3f s (%.1f%%)\n", other_ns / 1000000000.0, r.total_ns ? 100.0 * other_ns / r.total_ns : 0.0);
+
+  if(r.audio_hash)
+   printf("Audio CRC32: %08x (%llu sample frames)\n", r.audio_crc, (unsigned long long)r.audio_samples);
+ }
+}
+
+static void SetInputDevices(const MDFNGI* gi)
+{
+ for(unsigned port = 0; port < gi->PortInfo.size(); port++)
+ {
+  const char* want = (gi->DesiredInput.size() > port && gi->DesiredInput[port].device_name) ? gi->DesiredInput[port].device_name : gi->PortInfo[port].DefaultDevice;
+  uint32 device = 0;
+
+  if(want)
+  {
+   for(uint32 i = 0; i < gi->PortInfo[port].DeviceInfo.size(); i++)
+   {
+    if(!MDFN_strazicmp(gi->PortInfo[port].DeviceInfo[i].ShortName, want))
+    {
+     device = i;
+     break;
+    }
+   }
+  }
+
+  MDFNI_SetInput(port, device);
+ }
+}
+
+static uint32 HashSound(uint32 crc, const int16* buf, const size_t count)
+{
+ uint8 tmp[256];
+
+ for(size_t i = 0; i < count; i += sizeof(tmp) / 2)
+ {
+  const size_t n = std::min<size_t>(count - i, sizeof(tmp) / 2);
+
+  for(size_t j = 0; j < n; j++)
+   MDFN_en16lsb(&tmp[j * 2], buf[i + j]);
+
+  crc = crc32(crc, tmp, n * 2);
+ }
+
+ return crc;
+}
+
+struct LockstepSnapshot
+{
+ std::vector<uint8> state;
+ std::vector<std::pair<std::string, uint32>> regs;
+ std::vector<int16> sound;
+};
+
+static void LockstepCapture(const MDFNGI* gi, const EmulateSpecStruct& espec, LockstepSnapshot* ls)
+{
+ MemoryStream ms(1 << 20);
+
+ if(espec.SoundBuf)
+  ls->sound.assign(espec.SoundBuf, espec.SoundBuf + espec.SoundBufSize * gi->soundchan);
+ else
+  ls->sound.clear();
+
+ MDFNSS_SaveSM(&ms, true);
+ ls->state.assign(ms.map(), ms.map() + ms.map_size());
+ ls->regs.clear();
+
+#ifdef WANT_DEBUGGER
+ if(gi->Debugger && gi->Debugger->RegGroups)
+ {
+  for(const RegGroupType* rg : *gi->Debugger->RegGroups)
+  {
+   const std::string prefix = rg->name ? std::string(rg->name) + "." : std::string();
+
+   for(const RegType* rt = rg->Regs; rt->bsize; rt++)
+   {
+    if(rt->bsize == 0xFFFF)	// Separator
+     continue;
+
+    ls->regs.push_back({ prefix + rt->name, rg->GetRegister(rt->id, NULL, 0) });
+   }
+  }
+ }
+#endif
+}
+
+// Returns false and prints the differences if the snapshots don't match.
+static bool LockstepCompare(uint32 frame, const char* setting, const char* a, const char* b, const LockstepSnapshot& sa, const LockstepSnapshot& sb, bool compare_sound)
+{
+ bool match = true;
+
+ for(size_t i = 0; i < std::min(sa.regs.size(), sb.regs.size()); i++)
+ {
+  if(sa.regs[i].second != sb.regs[i].second)
+  {
+   if(match)
+    printf("Lockstep divergence at frame %u(%s %s vs %s):\n", frame, setting, a, b);
+
+   printf(" %-24s 0x%08x 0x%08x\n", sa.regs[i].first.c_str(), sa.regs[i].second, sb.regs[i].second);
+   match = false;
+  }
+ }
+
+ if(sa.state != sb.state)
+ {
+  size_t i = 0;
+
+  while(i < sa.state.size() && i < sb.state.size() && sa.state[i] == sb.state[i])
+   i++;
+
+  if(match)
+   printf("Lockstep divergence at frame %u(%s %s vs %s):\n", frame, setting, a, b);
+
+  printf(" Save states differ, first at byte offset %zu(sizes %zu and %zu).\n", i, sa.state.size(), sb.state.size());
+  match = false;
+ }
+
+ if(compare_sound && sa.sound != sb.sound)
+ {
+  size_t i = 0;
+
+  while(i < sa.sound.size() && i < sb.sound.size() && sa.sound[i] == sb.sound[i])
+   i++;
+
+  if(match)
+   printf("Lockstep divergence at frame %u(%s %s vs %s):\n", frame, setting, a, b);
+
+  printf(" Sound output differs, first at sample %zu(sizes %zu and %zu).\n", i, sa.sound.size(), sb.sound.size());
+  match = false;
+ }
+
+ return match;
+}
+
+static void Usage(const char* argv0)
+{
+ fprintf(stderr, "Usage: %s [options] <game path>\n\n", argv0);
+ fprintf(stderr, "Options:\n");
+ fprintf(stderr, " -frames <n>             Number of measured frames(default: 3600).\n");
+ fprintf(stderr, " -warmup <n>             Number of frames to run before measuring(default: 60).\n");
+ fprintf(stderr, " -module <name>          Force the emulation module(e.g. psx, ss, md, pce, nes, snes, gba, lynx).\n");
+ fprintf(stderr, " -movie <path>           Play back an input movie; it starts from the state saved in the movie.\n");
+ fprintf(stderr, " -soundrate <hz>         Sound output rate; 0 disables sound output(default: 48000).\n");
+ fprintf(stderr, " -skip                   Don't render video(sets the frame skip flag on every frame).\n");
+ fprintf(stderr, " -nosections             Don't time video/sound sections.\n");
+ fprintf(stderr, " -set <setting> <value>  Override a setting; may be repeated.\n");
+ fprintf(stderr, " -json                   Print results as a single JSON object.\n");
+ fprintf(stderr, " -lockstep <setting> <a> <b>\n");
+ fprintf(stderr, "                         Run each measured frame with <setting> set to <a> and then to <b>, from the same\n");
+ fprintf(stderr, "                         save state, and stop at the first frame where the results differ.  Sound output\n");
+ fprintf(stderr, "                         is only compared if -soundrate is given.\n");
+ fprintf(stderr, " -audiohash              Print a CRC32 of the sound output over the measured frames.\n");
+ fprintf(stderr, " -runahead <n>           Emulate <n> frames ahead after each frame and roll them back, as the frontend's\n");
+ fprintf(stderr, "                         run-ahead option does; video is only rendered for the last one.\n");
+ fprintf(stderr, " -verbose                Print informational messages from the emulator.\n");
+ fprintf(stderr, " -kernels                Have the emulation module time its SIMD kernels against the scalar versions while\n");
+ fprintf(stderr, "                         loading the game; implies -verbose.\n");
+ fprintf(stderr, "\nSettings are read from mednafen.cfg in $MEDNAFEN_HOME(or ~/.mednafen), and are never written back.\n");
+}
+
+int main(int argc, char* argv[])
+{
+ const char* path = nullptr;
+ const char* force_module = nullptr;
+ const char* movie_path = nullptr;
+ uint32 frames = 3600;
+ uint32 warmup = 60;
+ uint32 sound_rate = 48000;
+ uint32 runahead = 0;
+ bool sound_rate_set = false;
+ bool skip = false;
+ bool sections = true;
+ bool json = false;
+ bool audio_hash = false;
+ std::vector<std::pair<std::string, std::string>> overrides;
+ const char* lockstep[3] = { nullptr, nullptr, nullptr };
+
+ for(int i = 1; i < argc; i++)
+ {
+  const char* a = argv[i];
+  const bool has_arg = (i + 1) < argc;
+
+  if(!strcmp(a, "-frames") && has_arg)
+   frames = strtoul(argv[++i], nullptr, 10);
+  else if(!strcmp(a, "-warmup") && has_arg)
+   warmup = strtoul(argv[++i], nullptr, 10);
+  else if(!strcmp(a, "-module") && has_arg)
+   force_module = argv[++i];
+  else if(!strcmp(a, "-movie") && has_arg)
+   movie_path = argv[++i];
+  else if(!strcmp(a, "-soundrate") && has_arg)
+  {
+   sound_rate = strtoul(argv[++i], nullptr, 10);
+   sound_rate_set = true;
+  }
+  else if(!strcmp(a, "-runahead") && has_arg)
+   runahead = strtoul(argv[++i], nullptr, 10);
+  else if(!strcmp(a, "-set") && (i + 2) < argc)
+  {
+   overrides.push_back({ argv[i + 1], argv[i + 2] });
+   i += 2;
+  }
+  else if(!strcmp(a, "-lockstep") && (i + 3) < argc)
+  {
+   lockstep[0] = argv[i + 1];
+   lockstep[1] = argv[i + 2];
+   lockstep[2] = argv[i + 3];
+   i += 3;
+  }
+  else if(!strcmp(a, "-skip"))
+   skip = true;
+  else if(!strcmp(a, "-nosections"))
+   sections = false;
+  else if(!strcmp(a, "-json"))
+   json = true;
+  else if(!strcmp(a, "-audiohash"))
+   audio_hash = true;
+  else if(!strcmp(a, "-verbose"))
+   Verbose = true;
+  else if(!strcmp(a, "-kernels"))
+   MDFNBench.Kernels = Verbose = true;
+  else if(a[0] != '-' && !path)
+   path = a;
+  else
+  {
+   Usage(argv[0]);
+   return -1;
+  }
+ }
+
+ if(!path || !frames || (lockstep[0] && (movie_path || runahead)))
+ {
+  Usage(argv[0]);
+  return -1;
+ }
+ //
+ //
+ //
+ const std::string basedir = GetBaseDirectory();
+
+ if(!MDFNI_InitializeModules())
+  return -1;
+
+ if(!MDFNI_Initialize(basedir.c_str(), std::vector<MDFNSetting>()))
+  return -1;
+
+ if(!MDFNI_LoadSettings((basedir + PSS + "mednafen.cfg").c_str()))
+ {
+  MDFNI_Kill();
+  return -1;
+ }
+
+ for(auto const& o : overrides)
+ {
+  if(!MDFNI_SetSetting(o.first, o.second))
+  {
+   MDFNI_Kill();
+   return -1;
+  }
+ }
+
+ MDFNGI* gi = MDFNI_LoadGame(force_module, &NVFS, path);
+
+ if(!gi)
+ {
+  MDFNI_Kill();
+  return -1;
+ }
+
+ SetInputDevices(gi);
+
+ if(runahead && (!gi->StateAction || !gi->SoundOutputStateAction))
+ {
+  fprintf(stderr, "Module \"%s\" can't restore its state and sound output state, so it can't run ahead.\n", gi->shortname);
+  MDFNI_CloseGame();
+  MDFNI_Kill();
+  return -1;
+ }
+ //
+ //
+ //
+ std::unique_ptr<MDFN_Surface> surface(new MDFN_Surface(NULL, gi->fb_width, gi->fb_height, gi->fb_width, MDFN_PixelFormat::ARGB32_8888));
+ std::unique_ptr<int32[]> line_widths(new int32[gi->fb_height]);
+ std::unique_ptr<int16[]> sound_buf;
+ std::unique_ptr<int16[]> hidden_sound_buf;
+ std::unique_ptr<StateIncremental, void (*)(StateIncremental*)> runahead_state(runahead ? MDFNSS_Incremental_Create() : nullptr, MDFNSS_Incremental_Destroy);
+ MemoryStream runahead_stream(65536, false);
+ const int32 sound_buf_max = sound_rate / 2;	// 500ms, per EmulateSpecStruct requirements.
+ EmulateSpecStruct espec;
+ BenchResult r;
+
+ if(sound_rate)
+ {
+  sound_buf.reset(new int16[sound_buf_max * gi->soundchan]);
+  hidden_sound_buf.reset(new int16[sound_buf_max * gi->soundchan]);
+ }
+
+ if(movie_path)
+ {
+  MDFNI_LoadMovie((char*)movie_path);
+
+  if(!MDFNMOV_IsPlaying())
+  {
+   MDFNI_CloseGame();
+   MDFNI_Kill();
+   return -1;
+  }
+  r.movie = true;
+ }
+
+ auto EmulateFrame = [&]()
+ {
+  espec.surface = surface.get();
+  espec.LineWidths = line_widths.get();
+  espec.skip = skip || runahead;
+  espec.SoundRate = sound_rate;
+  espec.SoundBuf = sound_buf.get();
+  espec.SoundBufMaxSize = sound_rate ? sound_buf_max : 0;
+  espec.SoundVolume = 1.0;
+  espec.soundmultiplier = 1.0;
+  espec.MasterCycles = 0;
+  espec.MasterCycles_DriverProcessed = 0;
+  espec.SoundBufSize_DriverProcessed = 0;
+
+  MDFNI_Emulate(&espec);
+
+  espec.VideoFormatChanged = false;
+  espec.SoundFormatChanged = false;
+
+  if(runahead)
+  {
+   EmulateSpecStruct hspec = espec;
+
+   runahead_stream.truncate(0);
+   runahead_stream.rewind();
+   MDFNSS_SaveSMIncremental(&runahead_stream, runahead_state.get());
+
+   MDFNI_BeginHidden();
+
+   for(uint32 i = 0; i < runahead; i++)
+   {
+    hspec.skip = skip || i < (runahead - 1);
+    hspec.SoundBuf = hidden_sound_buf.get();
+    MDFNI_EmulateHidden(&hspec);
+   }
+
+   runahead_stream.rewind();
+   MDFNSS_LoadSMIncremental(&runahead_stream, runahead_state.get());
+   MDFNI_EndHidden();
+  }
+ };
+
+ if(lockstep[0])
+ {
+  LockstepSnapshot sa, sb;
+  int ret = 0;
+
+  for(uint32 i = 0; i < warmup; i++)
+   EmulateFrame();
+
+  for(uint32 i = 0; i < frames; i++)
+  {
+   MemoryStream start(1 << 20);
+
+   MDFNSS_SaveSM(&start, true);
+
+   MDFNI_SetSetting(lockstep[0], lockstep[1]);
+   EmulateFrame();
+   LockstepCapture(gi, espec, &sa);
+
+   start.rewind();
+   MDFNSS_LoadSM(&start, true);
+
+   MDFNI_SetSetting(lockstep[0], lockstep[2]);
+   EmulateFrame();
+   LockstepCapture(gi, espec, &sb);
+
+   if(!LockstepCompare(warmup + i, lockstep[0], lockstep[1], lockstep[2], sa, sb, sound_rate_set))
+   {
+    ret = 1;
+    break;
+   }
+  }
+
+  if(!ret)
+   printf("Lockstep: %u frames identical(%s %s vs %s, %zu registers compared).\n", frames, lockstep[0], lockstep[1], lockstep[2], sa.regs.size());
+
+  MDFNI_CloseGame();
+  MDFNI_Kill();
+
+  return ret;
+ }
+
+ r.frame_ns.reserve(frames);
+ r.audio_hash = audio_hash;
+
+ for(uint32 i = 0; i < (warmup + frames); i++)
+ {
+  const bool measured = i >= warmup;
+
+  if(i == warmup)
+  {
+   memset(MDFNBench.Time, 0, sizeof(MDFNBench.Time));
+   memset(MDFNBench.Hits, 0, sizeof(MDFNBench.Hits));
+   MDFNBench.Enabled = sections;
+  }
+
+  const int64 st = Time::MonoNS();
+  EmulateFrame();
+  const int64 et = Time::MonoNS();
+
+  if(measured)
+  {
+   r.frame_ns.push_back(et - st);
+   r.total_ns += et - st;
+   r.emu_seconds += (double)espec.MasterCycles * (1LL << 32) / gi->MasterClock;
+   r.frames++;
+
+   if(audio_hash && sound_buf)
+   {
+    r.audio_crc = HashSound(r.audio_crc, sound_buf.get(), espec.SoundBufSize * gi->soundchan);
+    r.audio_samples += espec.SoundBufSize;
+   }
+
+   if(r.movie && !r.movie_ended && !MDFNMOV_IsPlaying())
+    r.movie_ended = true;
+  }
+ }
+
+ MDFNBench.Enabled = false;
+
+ for(unsigned i = 0; i < MDFN_BENCH_COUNT; i++)
+  r.section_ns[i] = MDFNBench.Time[i];
+
+ PrintResult(gi, path, r, warmup, json);
+
+ MDFNI_CloseGame();
+ MDFNI_Kill();
+
+ return 0;
+}
@@ -2930,4 +2930,6 @@ MDFN_HIDE extern const MDFNGI EmulatedGB =
  144,	// Framebuffer height
 
  2,     // Number of output sound channels
+
+ SOUND_SoundOutputStateAction,
 };
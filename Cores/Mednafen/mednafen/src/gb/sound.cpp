@@ -28,11 +28,12 @@ namespace MDFN_IEN_GB
 {
 
 static Gb_Apu gb_apu;
+static Gb_Apu::mode_t gbmode = Gb_Apu::mode_cgb;
 static Stereo_Buffer *gb_buf = NULL;
 
 void SOUND_Reset(void)
 {
-	Gb_Apu::mode_t gbmode = Gb_Apu::mode_cgb;
+	gbmode = Gb_Apu::mode_cgb;
 
 	if(gbEmulatorType == 4)
 	 gbmode = Gb_Apu::mode_agb;
@@ -117,13 +118,33 @@ void SOUND_StateAction(StateMem *sm, int load, int data_only)
 
  if(load)
  {
-  // TODO: set hardware mode to mode_dmg, mode_cgb, or mode_agb
-  // (latter if you're running classic GB game on Game Boy Advance)
-  gb_apu.reset();
+  // Hardware mode isn't part of the state; it's the one SOUND_Reset() chose for this game.
+  gb_apu.reset(gbmode);
   gb_apu.load_state(gb_state);
  }
 }
 
+void SOUND_SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ int last_amps[Gb_Apu::osc_count];
+
+ gb_apu.get_output_amps(last_amps);
+
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(last_amps),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, "SNDOUT");
+
+ if(load)
+  gb_apu.set_output_amps(last_amps);
+
+ if(gb_buf)
+  gb_buf->StateAction(sm, load, true, "SNDOUT_BUF");
+}
+
 void SOUND_Init(void)
 {
         gb_apu.volume(0.5);
@@ -12,6 +12,7 @@ void SOUND_Init(void) MDFN_COLD;
 void SOUND_Kill(void) MDFN_COLD;
 void SOUND_Reset(void) MDFN_COLD;
 void SOUND_StateAction(StateMem *sm, int load, int data_only);
+void SOUND_SoundOutputStateAction(StateMem *sm, const unsigned load);
 
 bool MDFNGB_SetSoundRate(uint32 rate);
 
@@ -702,6 +702,11 @@ struct MDFNGI
  int fb_height;		// Height of the framebuffer passed to the Emulate() function(not necessarily height of the image)
 
  int soundchan; 	// Number of output sound channels.  Only values of 1 and 2 are currently supported.
+
+ // Saves or loads(load is nonzero) the sound output state that save states leave out, such as resampler history and
+ // samples buffered for the next frame, so that frames emulated and then rolled back with a state load(run-ahead) don't
+ // disturb the sound output; see MDFNI_BeginHidden().  Always data-only.  NULL if not supported.
+ void (*SoundOutputStateAction)(StateMem *sm, const unsigned load);
  //
  //
  //
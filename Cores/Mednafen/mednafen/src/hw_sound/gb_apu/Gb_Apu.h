@@ -87,6 +87,12 @@ public:
 	
 	// Loads state. You should call reset() BEFORE this.
 	blargg_err_t load_state( gb_apu_state_t const& in );
+	
+	// Gets/sets the amplitudes last written to the output buffers, which aren't
+	// part of the state; load_state() recalculates them without writing anything.
+	// Setting them back is only useful along with restoring the output buffers.
+	void get_output_amps( int out [osc_count] ) const;
+	void set_output_amps( int const in [osc_count] );
 
 public:
 	Gb_Apu();
@@ -116,3 +116,15 @@ blargg_err_t Gb_Apu::load_state( gb_apu_state_t const& in )
 	
 	return 0;
 }
+
+void Gb_Apu::get_output_amps( int out [osc_count] ) const
+{
+	for ( int i = 0; i < osc_count; i++ )
+		out [i] = oscs [i]->last_amp;
+}
+
+void Gb_Apu::set_output_amps( int const in [osc_count] )
+{
+	for ( int i = 0; i < osc_count; i++ )
+		oscs [i]->last_amp = in [i];
+}
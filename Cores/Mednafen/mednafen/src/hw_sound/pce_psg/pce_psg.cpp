@@ -820,6 +820,18 @@ void PCE_PSG::Power(const int32 timestamp)
  vol_update_which = 0;
 }
 
+// Amplitudes last added to the HR buffers; see MDFNGI::SoundOutputStateAction.
+void PCE_PSG::SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(channel->blip_prev_samp, 6, sizeof(*channel), channel),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, "SNDOUT_PSG");
+}
+
 void PCE_PSG::StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
  for(int ch = 0; ch < 6; ch++)
@@ -846,12 +858,17 @@ void PCE_PSG::StateAction(StateMem *sm, const unsigned load, const bool data_onl
   MDFNSS_StateAction(sm, load, data_only, CH_StateRegs, tmpstr);
  }
 
+ // With the LFO on, channel 0's frequency is latched from channel 1's output when channel 0 steps, so it can't always be
+ // recalculated from the current output.  0 when loading a state without it.
+ uint32 lfo_freq_cache = load ? 0 : channel[0].freq_cache;
+
  SFORMAT PSG_StateRegs[] =
  {
   SFVAR(select),
   SFVAR(globalbalance),
   SFVAR(lfofreq),
   SFVAR(lfoctrl),
+  SFVAR(lfo_freq_cache),
 
   SFVAR(vol_update_counter),
   SFVAR(vol_update_which),
@@ -905,6 +922,12 @@ void PCE_PSG::StateAction(StateMem *sm, const unsigned load, const bool data_onl
    RecalcFreqCache(ch);
    RecalcUOFunc(ch);
   }
+
+  if((lfoctrl & 0x03) && lfo_freq_cache >= 2 && lfo_freq_cache <= 8192)
+  {
+   channel[0].freq_cache = lfo_freq_cache & ~1;
+   RecalcUOFunc(0);
+  }
  }
 }
 
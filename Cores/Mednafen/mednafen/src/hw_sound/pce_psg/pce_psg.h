@@ -132,6 +132,7 @@ class PCE_PSG
         ~PCE_PSG() MDFN_COLD;
 
 	void StateAction(StateMem *sm, const unsigned load, const bool data_only);
+	void SoundOutputStateAction(StateMem *sm, const unsigned load);
 
         void Power(const int32 timestamp) MDFN_COLD;
         void Write(int32 timestamp, uint8 A, uint8 V);
@@ -80,6 +80,9 @@ CMikie::CMikie(CSystem& parent)
 	for(loop=0;loop<16;loop++) mPalette[loop].Index=loop;
 	for(loop=0;loop<4096;loop++) mColourMap[loop]=0;
 
+	mLastLSample = 0;
+	mLastRSample = 0;
+
 	Reset();
 }
 
@@ -1795,12 +1798,23 @@ void CMikie::StateAction(StateMem *sm, const unsigned load, const bool data_only
 	}
 }
 
+void CMikie::SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+	SFORMAT SoundOutputRegs[] =
+	{
+		SFVAR(mLastLSample),
+		SFVAR(mLastRSample),
+		SFEND
+	};
+
+	MDFNSS_StateAction(sm, load, true, SoundOutputRegs, "SNDOUT");
+	mikbuf.StateAction(sm, load, true, "SNDOUT_BUF");
+}
+
 void CMikie::CombobulateSound(uint32 teatime)
 {
                                 int cur_lsample = 0;
                                 int cur_rsample = 0;
-                                static int last_lsample = 0;
-                                static int last_rsample = 0;
                                 int x;
 
                                 teatime >>= 2;
@@ -1828,13 +1842,13 @@ void CMikie::CombobulateSound(uint32 teatime)
                                       cur_rsample += mAUDIO_OUTPUT[x];
                                  }
                                 }
-                                if(cur_lsample != last_lsample){
-                                  miksynth.offset_inline(teatime, cur_lsample - last_lsample, mikbuf.left());
-                                  last_lsample = cur_lsample;
+                                if(cur_lsample != mLastLSample){
+                                  miksynth.offset_inline(teatime, cur_lsample - mLastLSample, mikbuf.left());
+                                  mLastLSample = cur_lsample;
                                 }
-                                if(cur_rsample != last_rsample){
-                                  miksynth.offset_inline(teatime, cur_rsample - last_rsample, mikbuf.right());
-                                  last_rsample = cur_rsample;
+                                if(cur_rsample != mLastRSample){
+                                  miksynth.offset_inline(teatime, cur_rsample - mLastRSample, mikbuf.right());
+                                  mLastRSample = cur_rsample;
                                 }
 }
 
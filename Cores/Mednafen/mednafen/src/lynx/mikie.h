@@ -209,6 +209,7 @@ class CMikie : public CLynxBase
 		uint32	DisplayEndOfFrame(void);
 
 		void StateAction(StateMem *sm, const unsigned load, const bool data_only);
+		void SoundOutputStateAction(StateMem *sm, const unsigned load);
 
 		inline void SetCPUSleep(void) {gSystemCPUSleep=true;};
 		inline void ClearCPUSleep(void) {gSystemCPUSleep=false;};
@@ -358,6 +359,9 @@ class CMikie : public CLynxBase
 		uint32		mSTEREO;
 		uint32		mPAN;
 
+		int		mLastLSample;	// Last amplitudes added to mikbuf
+		int		mLastRSample;
+
 		//
 		// Serial related variables
 		//
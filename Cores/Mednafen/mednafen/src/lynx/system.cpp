@@ -380,6 +380,11 @@ static void StateAction(StateMem *sm, const unsigned load, const bool data_only)
  lynxie->mCpu->StateAction(sm, load, data_only);
 }
 
+static void SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ lynxie->mMikie->SoundOutputStateAction(sm, load);
+}
+
 static void SetLayerEnableMask(uint64 mask)
 {
 
@@ -499,5 +504,7 @@ MDFN_HIDE extern const MDFNGI EmulatedLynx =
  102,	// Framebuffer height
 
  2,     // Number of output sound channels
+
+ SoundOutputStateAction,
 };
 
@@ -8,6 +8,7 @@
 #include <mednafen/hw_sound/sms_apu/Sms_Apu.h>
 #include <mednafen/sound/Blip_Buffer.h>
 #include <mednafen/sound/Stereo_Buffer.h>
+#include <mednafen/bench.h>
 
 namespace MDFN_IEN_MD
 {
@@ -26,6 +27,7 @@ static bool FMReset;
 
 static void UpdateFM(void)
 {
+ MDFN_BenchScope bs(MDFN_BENCH_SOUND);
  int32 cycles = md_timestamp - fm_last_timestamp;
 
  fm_div -= cycles;
@@ -122,14 +124,19 @@ int32 MDSound_Flush(int16 *SoundBuf, const int32 MaxSoundFrames)
  int32 FrameCount = 0;
 
  UpdateFM();
- apu.end_frame(md_timestamp / 15);
 
- zebuf.end_frame(md_timestamp / 15);
+ {
+  MDFN_BenchScope bs(MDFN_BENCH_SOUND);
 
- if(SoundBuf)
-  FrameCount = zebuf.read_samples(SoundBuf, MaxSoundFrames * 2) / 2;
- else
-  zebuf.clear();
+  apu.end_frame(md_timestamp / 15);
+
+  zebuf.end_frame(md_timestamp / 15);
+
+  if(SoundBuf)
+   FrameCount = zebuf.read_samples(SoundBuf, MaxSoundFrames * 2) / 2;
+  else
+   zebuf.clear();
+ }
 
  fm_last_timestamp = 0;
 
@@ -27,6 +27,8 @@
 #include "vcnt.h"
 #include "hvc.h"
 
+#include <mednafen/bench.h>
+
 namespace MDFN_IEN_MD
 {
 
@@ -908,6 +910,8 @@ void MDVDP::make_name_lut(void)
 
 void MDVDP::render_line(int line)
 {
+    MDFN_BenchScope bs(MDFN_BENCH_VIDEO);
+
     /* Line buffers */
     alignas(8) uint8 tmp_buf[0x400];                   /* Temporary buffer */
     alignas(8) uint8 bg_buf[0x400];                    /* Merged background buffer */
@@ -89,6 +89,17 @@ int MDFNI_Initialize(const char *basedir, const std::vector<MDFNSetting> &Driver
 /* Emulates a frame. */
 void MDFNI_Emulate(EmulateSpecStruct *espec);
 
+/* Emulates a frame that will be discarded by a state load(run-ahead), bypassing input transformation, movies,
+   netplay, state rewinding, and audio post-processing.  Call only after MDFNI_Emulate() with the same espec. */
+void MDFNI_EmulateHidden(EmulateSpecStruct *espec);
+
+/* Bracket the MDFNI_EmulateHidden() calls: MDFNI_BeginHidden() after saving the state that will be loaded to roll them
+   back, MDFNI_EndHidden() after loading it.  Together they keep the hidden frames from disturbing the sound output
+   state(resamplers etc.) that save states don't cover.  MDFNI_BeginHidden() returns false, and hidden frames shouldn't
+   be emulated, if the module can't do that. */
+bool MDFNI_BeginHidden(void);
+void MDFNI_EndHidden(void);
+
 #if 0
 /* Support function for scaling multiple-horizontal-resolution frames to a single width; mostly intended for unofficial ports.
    The driver code really ought to handle multi-horizontal-resolution frames natively and properly itself, however.
@@ -43,6 +43,7 @@
 #include "state.h"
 #include "movie.h"
 #include "state_rewind.h"
+#include "bench.h"
 #include "video.h"
 #include "video/Deinterlacer.h"
 #include "file.h"
@@ -101,6 +102,8 @@ static const MDFNSetting MednafenSettings[] =
 
   { "srwframes", MDFNSF_NOFLAGS, gettext_noop("Number of frames to keep states for when state rewinding is enabled."), 
 	gettext_noop("WARNING: Setting this to a large value may cause excessive RAM usage in some circumstances, such as with games that stream large volumes of data off of CDs."), MDFNST_UINT, "600", "10", "99999" },
+  { "srwmemory", MDFNSF_NOFLAGS, gettext_noop("Maximum amount of memory, in MiB, to use for compressed states when state rewinding is enabled."),
+	gettext_noop("When the limit is reached, the oldest states are discarded, even if fewer than \"srwframes\" frames' worth are stored.  Set to 0 for no limit."), MDFNST_UINT, "256", "0", "65536" },
 
   { "cd.image_memcache", MDFNSF_NOFLAGS, gettext_noop("Cache entire CD images in memory."), gettext_noop("Reads the entire CD image(s) into memory at startup(which will cause a small delay).  Can help obviate emulation hiccups due to emulated CD access.  May cause more harm than good on low memory systems, systems with swap enabled, and/or when the disc images in question are on a fast SSD."), MDFNST_BOOL, "0" },
 
@@ -213,6 +216,8 @@ static uint32 PortDataLen[16];
 
 MDFNGI* MDFNGameInfo = NULL;
 
+MDFN_BenchStats MDFNBench = { false, false, { 0 }, { 0 } };
+
 //static QTRecord *qtrecorder = NULL;
 static WAVRecord *wavrecorder = NULL;
 static Fir_Resampler<16> ff_resampler;
@@ -225,6 +230,7 @@ static std::unique_ptr<Deinterlacer> deint;
 static bool FFDiscard = false; // TODO:  Setting to discard sound samples instead of increasing pitch
 
 static std::vector<CDInterface *> CDInterfaces;
+static std::unique_ptr<VirtualFS> GameArchiveVFS;	// Archive a CD image was loaded from.
 
 struct DriveMediaStatus
 {
@@ -352,6 +358,7 @@ static MDFN_COLD void Cleanup(void)
   }
  }
  CDInterfaces.clear();
+ GameArchiveVFS.reset();
 
  if(MDFNGameInfo != NULL)
  {
@@ -1169,31 +1176,28 @@ MDFNGI *MDFNI_LoadGame(const char *force_module, VirtualFS* vfs, const char* pat
          }
 	}
 
-/*
         //
 	// CD format extensions; refer to git.h for priorities.
         //
-	valid_iae.push_back(FileExtensionSpecStruct({ "m3u", -40, "M3U" }));
-	valid_iae.push_back(FileExtensionSpecStruct({ "ccd", -50, "CloneCD" }));
-	valid_iae.push_back(FileExtensionSpecStruct({ "cue", -60, "CUE" }));
-	valid_iae.push_back(FileExtensionSpecStruct({ "toc", -70, "CDRDAO TOC" }));
-*/
+	valid_iae.push_back(FileExtensionSpecStruct({ ".m3u", -40, "M3U" }));
+	valid_iae.push_back(FileExtensionSpecStruct({ ".ccd", -50, "CloneCD" }));
+	valid_iae.push_back(FileExtensionSpecStruct({ ".cue", -60, "CUE" }));
+	valid_iae.push_back(FileExtensionSpecStruct({ ".toc", -70, "CDRDAO TOC" }));
 
 	MDFNFILE mfgf(vfs, path, valid_iae, _("game"));
 
-/*
+        //
+        // CD image in an archive; deflate-compressed files in it are decompressed on demand, so the archive
+        // needs to stay open until the game is closed.
+        //
         if(mfgf.active_vfs() != vfs && (mfgf.ext == "m3u" || mfgf.ext == "ccd" || mfgf.ext == "cue" || mfgf.ext == "toc"))
 	{
-         static std::unique_ptr<VirtualFS> vfs_save;
-
-         vfs_save = mfgf.steal_archive_vfs();
+         const std::string archive_path = mfgf.active_path();
 
-	 if(!MDFN_GetSettingB("cd.image_memcache"))
-          throw MDFN_Error(0, _("Setting \"cd.image_memcache\" must be set to \"1\" to allow loading a CD image from a ZIP archive."));
+         GameArchiveVFS = mfgf.steal_archive_vfs();
 
-	 return LoadCD(force_module, vfs_save.get(), mfgf.active_path().c_str());
+	 return LoadCD(force_module, GameArchiveVFS.get(), archive_path.c_str());
 	}
-*/
 	//printf("FBASE=%s,EXT=%s\n", GameFile.fbase, GameFile.ext);
 	//
 	//
@@ -1844,6 +1848,8 @@ void MDFNI_Emulate(EmulateSpecStruct *espec)
 
  if(espec->InterlaceOn)
  {
+  MDFN_BenchScope bs(MDFN_BENCH_VIDEO);
+
   if(!PrevInterlaced)
    deint->ClearState();
 
@@ -1853,7 +1859,11 @@ void MDFNI_Emulate(EmulateSpecStruct *espec)
  else
   PrevInterlaced = false;
 
- ProcessAudio(espec);
+ {
+  MDFN_BenchScope bs(MDFN_BENCH_SOUND);
+
+  ProcessAudio(espec);
+ }
 
 // if(qtrecorder)
 // {
@@ -1887,6 +1897,58 @@ void MDFNI_Emulate(EmulateSpecStruct *espec)
   TBlur_Run(espec);
 }
 
+void MDFNI_EmulateHidden(EmulateSpecStruct *espec)
+{
+ //
+ // For frames that will be rolled back(e.g. run-ahead), after a regular MDFNI_Emulate() call with the same espec.  Input
+ // has already been transformed and recorded for this frame, so skip that along with netplay, movie, state rewinding, and
+ // audio post-processing, none of which may observe a frame that never "happened".
+ //
+ espec->DisplayRect.x = 0;
+ espec->DisplayRect.w = 0;
+ espec->DisplayRect.y = 0;
+ espec->DisplayRect.h = 0;
+
+ espec->SoundBufSize = 0;
+ espec->VideoFormatChanged = false;
+ espec->SoundFormatChanged = false;
+ espec->NeedRewind = false;
+ espec->NeedSoundReverse = false;
+
+ MDFNGameInfo->Emulate(espec);
+
+ if(espec->InterlaceOn)
+ {
+  if(!PrevInterlaced)
+   deint->ClearState();
+
+  deint->Process(espec->surface, espec->DisplayRect, espec->LineWidths, espec->InterlaceField);
+  PrevInterlaced = true;
+ }
+ else
+  PrevInterlaced = false;
+}
+
+static MemoryStream HiddenSoundOutput(4096, false);
+
+bool MDFNI_BeginHidden(void)
+{
+ if(!MDFNGameInfo->SoundOutputStateAction)
+  return false;
+
+ HiddenSoundOutput.truncate(0);
+ HiddenSoundOutput.rewind();
+ MDFNSS_SaveSoundOutput(&HiddenSoundOutput);
+
+ return true;
+}
+
+void MDFNI_EndHidden(void)
+{
+ HiddenSoundOutput.rewind();
+ MDFNSS_LoadSoundOutput(&HiddenSoundOutput);
+}
+
 static void StateAction_RINP(StateMem* sm, const unsigned load, const bool data_only)
 {
  char namebuf[16][2 + 8 + 1];
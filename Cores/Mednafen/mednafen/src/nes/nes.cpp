@@ -791,4 +791,6 @@ MDFN_HIDE extern const MDFNGI EmulatedNES =
  240,	// Framebuffer height
 
  1,     // Number of output sound channels
+
+ MDFNSND_SoundOutputStateAction,
 };
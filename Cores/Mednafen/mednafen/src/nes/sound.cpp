@@ -990,6 +990,52 @@ int MDFNSND_Init(bool IsPAL)
  return(1);
 }
 
+//
+// The resampler position, the input samples it left over, and where the channels resume writing into WaveHi; see
+// MDFNGI::SoundOutputStateAction.  Only valid between frames, where everything past the leftover samples is zero.
+//
+void MDFNSND_SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ uint32 left = soundtsoffs;
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(left),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, "SNDOUT");
+
+ if(load && left > SwiftResampler::MaxLeftover)
+  left = SwiftResampler::MaxLeftover;
+
+ SFORMAT StateRegs_Wave[] =
+ {
+  SFPTR16N(WaveHi, left, "WaveHi"),
+  SFPTR16N(WaveHiEx, left, "WaveHiEx"),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs_Wave, "SNDOUT_WAVE");
+
+ if(ff)
+  ff->StateAction(sm, load, true, "SNDOUT_RESAMP");
+
+ if(load)
+ {
+  memset(WaveHi + left, 0, sizeof(WaveHi) - left * sizeof(int16));
+  memset(WaveHiEx + left, 0, sizeof(WaveHiEx) - left * sizeof(int16));
+
+  for(std::vector<EXPSOUND>::iterator ep = GameExpSound.begin(); ep != GameExpSound.end(); ep++)
+   if(ep->HiSync)
+    ep->HiSync(left);
+
+  for(int x = 0; x < 5; x++)
+   ChannelBC[x] = left;
+
+  soundtsoffs = left;
+ }
+}
+
 void MDFNSND_StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
  SFORMAT MDFNSND_STATEINFO[]=
@@ -27,6 +27,7 @@ void MDFNSND_Reset(void) MDFN_COLD;
 
 void MDFN_FASTCALL MDFN_SoundCPUHook(int);
 void MDFNSND_StateAction(StateMem *sm, const unsigned load, const bool data_only);
+void MDFNSND_SoundOutputStateAction(StateMem *sm, const unsigned load);
 void MDFNNES_SetSoundVolume(uint32 volume) MDFN_COLD;
 void MDFNNES_SetSoundMultiplier(double multiplier) MDFN_COLD;
 bool MDFNNES_SetSoundRate(double Rate) MDFN_COLD;
@@ -995,12 +995,36 @@ static void Emulate(EmulateSpecStruct *espec)
   HES_Update(espec, INPUT_HESHack());	//Draw(espec->skip ? NULL : espec->surface, espec->skip ? NULL : &espec->DisplayRect, espec->SoundBuf, espec->SoundBufSize, INPUT_HESHack());
 }
 
+static void SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ psg->SoundOutputStateAction(sm, load);
+
+ if(ADPCMBuf)
+ {
+  PCECD_SoundOutputStateAction(sm, load);
+  ADPCMBuf->StateAction(sm, load, true, "SNDOUT_ADPCMBUF");
+ }
+
+ if(CDDABufs[0])
+ {
+  CDDABufs[0]->StateAction(sm, load, true, "SNDOUT_CDDABUF_L");
+  CDDABufs[1]->StateAction(sm, load, true, "SNDOUT_CDDABUF_R");
+ }
+
+ HRBufs[0]->StateAction(sm, load, true, "SNDOUT_HRBUF_L", 0);
+ HRBufs[1]->StateAction(sm, load, true, "SNDOUT_HRBUF_R", 0);
+}
+
 static void StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
+ // The part of the last frame's end timestamp carried over into the next frame; left as is when loading a state without it.
+ uint32 ts_carry = HuCPU.Timestamp();
+
  SFORMAT StateRegs[] =
  {
   SFPTR8(BaseRAM, IsSGX? 32768 : 8192),
   SFVAR(PCE_TimestampBase),
+  SFVAR(ts_carry),
 
   SFEND
  };
@@ -1019,7 +1043,19 @@ static void StateAction(StateMem *sm, const unsigned load, const bool data_only)
 
  if(load)
  {
+  ts_carry %= 12;
+
+  if(ts_carry != HuCPU.Timestamp())
+  {
+   psg->ResetTS(ts_carry / 3);
+   HuC_ResetTS(ts_carry);
+
+   if(PCE_IsCD)
+    PCECD_ResetTS(ts_carry);
 
+   vce->ResetTS(ts_carry);
+   HuCPU.SyncAndResetTimestamp(ts_carry);
+  }
  }
 }
 
@@ -1264,5 +1300,7 @@ MDFN_HIDE extern const MDFNGI EmulatedPCE =
  270,	// Framebuffer height(TODO: decrease to 264(263 + spillover line))
 
  2,     // Number of output sound channels
+
+ SoundOutputStateAction,
 };
 
@@ -1312,6 +1312,21 @@ static void ADPCM_StateAction(StateMem *sm, const unsigned load, const bool data
  }
 }
 
+// The ADPCM output filter's state; see MDFNGI::SoundOutputStateAction.
+void PCECD_SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(ADPCM.last_pcm),
+  SFVAR(ADPCM.integrate_accum),
+  SFVAR(ADPCM.lp1p_fstate),
+  SFVAR(ADPCM.lp2p_fstate),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, "SNDOUT_APCM");
+}
+
 void PCECD_StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
 	SFORMAT StateRegs[] =
@@ -55,6 +55,7 @@ MDFN_FASTCALL int32 PCECD_Write(uint32 timestamp, uint32, uint8 data) MDFN_WARN_
 bool PCECD_IsBRAMEnabled();
 
 void PCECD_StateAction(StateMem *sm, const unsigned load, const bool data_only);
+void PCECD_SoundOutputStateAction(StateMem *sm, const unsigned load);
 
 void ADPCM_PeekRAM(uint32 Address, uint32 Length, uint8 *Buffer);
 void ADPCM_PokeRAM(uint32 Address, uint32 Length, const uint8 *Buffer);
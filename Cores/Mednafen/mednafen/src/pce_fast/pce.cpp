@@ -556,6 +556,17 @@ static void Emulate(EmulateSpecStruct *espec)
   HES_Draw(espec->surface, &espec->DisplayRect, espec->SoundBuf, espec->SoundBufSize);
 }
 
+static void SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ psg->SoundOutputStateAction(sm, load);
+
+ if(PCE_IsCD)
+  PCECD_SoundOutputStateAction(sm, load);
+
+ sbuf[0].StateAction(sm, load, true, "SNDOUT_BUF_L");
+ sbuf[1].StateAction(sm, load, true, "SNDOUT_BUF_R");
+}
+
 static void StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
  SFORMAT StateRegs[] =
@@ -741,5 +752,7 @@ MDFN_HIDE extern const MDFNGI EmulatedPCE_Fast =
  242,	// Framebuffer height
 
  2,     // Number of output sound channels
+
+ SoundOutputStateAction,
 };
 
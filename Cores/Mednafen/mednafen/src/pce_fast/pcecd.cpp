@@ -963,6 +963,18 @@ static int ADPCM_StateAction(StateMem *sm, int load, int data_only)
  return(ret);
 }
 
+void PCECD_SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(ADPCM.last_pcm),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, "SNDOUT_APCM");
+ PCECD_Drive_SoundOutputStateAction(sm, load, "SNDOUT_CDRM");
+}
+
 void PCECD_StateAction(StateMem *sm, int load, int data_only)
 {
 	SFORMAT StateRegs[] =
@@ -31,6 +31,7 @@ MDFN_FASTCALL void PCECD_Write(uint32 timestamp, uint32, uint8 data);
 bool PCECD_IsBRAMEnabled(void);
 
 void PCECD_StateAction(StateMem *sm, int load, int data_only);
+void PCECD_SoundOutputStateAction(StateMem *sm, const unsigned load);
 
 }
 #endif
@@ -1246,6 +1246,17 @@ void PCECD_Drive_SetCDDAVolume(unsigned vol)
  cdda.CDDAVolume = vol;
 }
 
+void PCECD_Drive_SoundOutputStateAction(StateMem *sm, const unsigned load, const char *sname)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(cdda.last_sample),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, sname);
+}
+
 void PCECD_Drive_StateAction(StateMem * sm, int load, int data_only, const char *sname)
 {
  SFORMAT StateRegs[] = 
@@ -80,6 +80,7 @@ void PCECD_Drive_Close(void) MDFN_COLD;
 void PCECD_Drive_SetTransferRate(uint32 TransferRate);
 void PCECD_Drive_SetCDDAVolume(unsigned vol); // vol of 65536 = 1.0 = maximum.
 void PCECD_Drive_StateAction(StateMem *sm, int load, int data_only, const char *sname);
+void PCECD_Drive_SoundOutputStateAction(StateMem *sm, const unsigned load, const char *sname);
 
 void PCECD_Drive_SetDisc(bool tray_open, CDInterface* cdif, bool no_emu_side_effects = false) MDFN_COLD;
 
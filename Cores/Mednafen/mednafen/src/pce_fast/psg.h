@@ -43,6 +43,7 @@ class PCEFast_PSG
         ~PCEFast_PSG() MDFN_COLD;
 
 	void StateAction(StateMem *sm, int load, int data_only) MDFN_COLD;
+	void SoundOutputStateAction(StateMem *sm, const unsigned load);
 
         void Power(const int32 timestamp) MDFN_COLD;
         void Write(int32 timestamp, uint8 A, uint8 V);
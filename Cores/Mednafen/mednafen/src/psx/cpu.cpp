@@ -24,6 +24,10 @@
 #include "psx.h"
 #include "cpu.h"
 
+#ifdef PSX_CPU_DYNAREC
+ #include <sys/mman.h>
+#endif
+
 #if 0
  #define EXP_ILL_CHECK(n) {n;}
 #else
@@ -49,8 +53,16 @@ PS_CPU::PS_CPU()
  //printf("%zu\n", (size_t)((uintptr_t)ICache - (uintptr_t)this));
 
  Halted = false;
+ CachedInterp = false;
+
+ DR_Code = NULL;
+ DR_CodeSize = 0;
+ DR_CodeUsed = 0;
+ DR_Enabled = false;
+ DR_Timestamp = 0;
 
  memset(FastMap, 0, sizeof(FastMap));
+ memset(DecodeMap, 0, sizeof(DecodeMap));
  memset(DummyPage, 0xFF, sizeof(DummyPage));	// 0xFF to trigger an illegal instruction exception, so we'll know what's up when debugging.
 
  for(uint64 a = 0x00000000; a < (1ULL << 32); a += FAST_MAP_PSIZE)
@@ -77,7 +89,13 @@ PS_CPU::PS_CPU()
 
 PS_CPU::~PS_CPU()
 {
-
+#ifdef PSX_CPU_DYNAREC
+ if(DR_Code)
+ {
+  munmap(DR_Code, DR_CodeSize);
+  DR_Code = NULL;
+ }
+#endif
 
 }
 
@@ -86,9 +104,91 @@ void PS_CPU::SetFastMap(void *region_mem, uint32 region_address, uint32 region_s
  // FAST_MAP_SHIFT
  // FAST_MAP_PSIZE
 
+ DecodeRegion* dr = nullptr;
+
+ for(auto& r : DecodeRegions)
+ {
+  if(r.mem == region_mem && r.size >= region_size)
+  {
+   dr = &r;
+   break;
+  }
+ }
+
+ if(!dr)
+ {
+  DecodeRegions.emplace_back();
+  dr = &DecodeRegions.back();
+  dr->mem = region_mem;
+  dr->size = region_size;
+  dr->ops.reset(new DecodedOp[region_size / 4]());
+ }
+
  for(uint64 A = region_address; A < (uint64)region_address + region_size; A += FAST_MAP_PSIZE)
  {
   FastMap[A >> FAST_MAP_SHIFT] = ((uintptr_t)region_mem - region_address);
+  DecodeMap[A >> FAST_MAP_SHIFT] = (uintptr_t)dr->ops.get() - (region_address >> 2) * sizeof(DecodedOp);
+ }
+}
+
+void PS_CPU::DecodeOp(DecodedOp* dop, uint32 instr)
+{
+ uint32 opf = instr & 0x3F;
+
+ if(instr & (0x3F << 26))
+  opf = 0x40 | (instr >> 26);
+
+ dop->instr = instr;
+ dop->opf = opf;
+ dop->rs = (instr >> 21) & 0x1F;
+ dop->rt = (instr >> 16) & 0x1F;
+ dop->rd = (instr >> 11) & 0x1F;
+
+ if(!(opf & 0x40))
+  dop->immediate = (instr >> 6) & 0x1F;	// SPECIAL: shift amount
+ else if(opf == 0x42 || opf == 0x43)
+  dop->immediate = instr & ((1 << 26) - 1);	// J, JAL
+ else if(opf >= 0x4C && opf <= 0x4F)
+  dop->immediate = instr & 0xFFFF;		// ANDI, ORI, XORI, LUI
+ else
+  dop->immediate = (int32)(int16)(instr & 0xFFFF);
+}
+
+//
+// Decodes the instruction word just fetched at PC, then the rest of its basic block from memory(which may
+// differ from what the I-cache will return, in which case those records just won't match when reached).
+//
+void PS_CPU::DecodeBlock(uint32 PC, uint32 instr, DecodedOp* dop)
+{
+ uint32 A = PC;
+ bool in_delay_slot = false;
+
+ for(unsigned count = 0; count < 64; count++)
+ {
+  DecodeOp(dop, instr);
+
+  const uint32 opf = dop->opf;
+
+  if(in_delay_slot)
+   break;
+
+  // J, JAL, BCOND, BEQ, BNE, BLEZ, BGTZ; JR, JALR
+  if((opf >= 0x41 && opf <= 0x47) || opf == 0x08 || opf == 0x09)
+   in_delay_slot = true;
+  // SYSCALL, BREAK
+  else if(opf == 0x0C || opf == 0x0D)
+   break;
+
+  A += 4;
+
+  if(!(A & (FAST_MAP_PSIZE - 1)))
+   break;
+
+  dop++;
+  instr = MDFN_de32lsb<true>((uint8*)(FastMap[A >> FAST_MAP_SHIFT] + A));
+
+  if(dop->instr == instr)
+   break;
  }
 }
 
@@ -594,7 +694,7 @@ uint32 NO_INLINE PS_CPU::Exception(uint32 code, uint32 PC, const uint32 NP, cons
 #define GPR_RES(n) { unsigned tn = (n); ReadAbsorb[tn] = 0; }
 #define GPR_DEPRES_END ReadAbsorb[0] = back; }
 
-template<bool DebugMode, bool BIOSPrintMode, bool ILHMode>
+template<bool DebugMode, bool BIOSPrintMode, bool ILHMode, bool CachedMode, bool DynarecMode>
 pscpu_timestamp_t PS_CPU::RunReal(pscpu_timestamp_t timestamp_in)
 {
  pscpu_timestamp_t timestamp = timestamp_in;
@@ -618,6 +718,22 @@ pscpu_timestamp_t PS_CPU::RunReal(pscpu_timestamp_t timestamp_in)
   {
    uint32 instr;
    uint32 opf;
+   const DecodedOp* dop MDFN_NOWARN_UNUSED;
+
+#ifdef PSX_CPU_DYNAREC
+   if(DynarecMode)
+   {
+    //
+    // Run compiled code for as long as it can go; the instruction it stopped at(if any) is executed below.
+    //
+    ACTIVE_TO_BACKING;
+    timestamp = DR_Run(timestamp);
+    BACKING_TO_ACTIVE;
+
+    if(MDFN_UNLIKELY(timestamp >= next_event_ts))
+     continue;
+   }
+#endif
 
    // Zero must be zero...until the Master Plan is enacted.
    GPR[0] = 0;
@@ -668,10 +784,23 @@ pscpu_timestamp_t PS_CPU::RunReal(pscpu_timestamp_t timestamp_in)
    // 
    // Instruction decode
    //
-   opf = instr & 0x3F;
+   if(CachedMode)
+   {
+    DecodedOp* const cdop = (DecodedOp*)(DecodeMap[PC >> FAST_MAP_SHIFT] + (PC >> 2) * sizeof(DecodedOp));
 
-   if(instr & (0x3F << 26))
-    opf = 0x40 | (instr >> 26);
+    if(MDFN_UNLIKELY(cdop->instr != instr))
+     DecodeBlock(PC, instr, cdop);
+
+    dop = cdop;
+    opf = dop->opf;
+   }
+   else
+   {
+    opf = instr & 0x3F;
+
+    if(instr & (0x3F << 26))
+     opf = 0x40 | (instr >> 26);
+   }
 
    opf |= IPCache;
 
@@ -728,10 +857,10 @@ pscpu_timestamp_t PS_CPU::RunReal(pscpu_timestamp_t timestamp_in)
 	 goto SkipNPCStuff;					\
 	}
 
-   #define ITYPE uint32 rs MDFN_NOWARN_UNUSED = (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = (instr >> 16) & 0x1F; uint32 immediate = (int32)(int16)(instr & 0xFFFF); /*printf(" rs=%02x(%08x), rt=%02x(%08x), immediate=(%08x) ", rs, GPR[rs], rt, GPR[rt], immediate);*/
-   #define ITYPE_ZE uint32 rs MDFN_NOWARN_UNUSED = (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = (instr >> 16) & 0x1F; uint32 immediate = instr & 0xFFFF; /*printf(" rs=%02x(%08x), rt=%02x(%08x), immediate=(%08x) ", rs, GPR[rs], rt, GPR[rt], immediate);*/
-   #define JTYPE uint32 target = instr & ((1 << 26) - 1); /*printf(" target=(%08x) ", target);*/
-   #define RTYPE uint32 rs MDFN_NOWARN_UNUSED = (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = (instr >> 16) & 0x1F; uint32 rd MDFN_NOWARN_UNUSED = (instr >> 11) & 0x1F; uint32 shamt MDFN_NOWARN_UNUSED = (instr >> 6) & 0x1F; /*printf(" rs=%02x(%08x), rt=%02x(%08x), rd=%02x(%08x) ", rs, GPR[rs], rt, GPR[rt], rd, GPR[rd]);*/
+   #define ITYPE uint32 rs MDFN_NOWARN_UNUSED = CachedMode ? dop->rs : (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = CachedMode ? dop->rt : (instr >> 16) & 0x1F; uint32 immediate = CachedMode ? dop->immediate : (int32)(int16)(instr & 0xFFFF); /*printf(" rs=%02x(%08x), rt=%02x(%08x), immediate=(%08x) ", rs, GPR[rs], rt, GPR[rt], immediate);*/
+   #define ITYPE_ZE uint32 rs MDFN_NOWARN_UNUSED = CachedMode ? dop->rs : (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = CachedMode ? dop->rt : (instr >> 16) & 0x1F; uint32 immediate = CachedMode ? dop->immediate : instr & 0xFFFF; /*printf(" rs=%02x(%08x), rt=%02x(%08x), immediate=(%08x) ", rs, GPR[rs], rt, GPR[rt], immediate);*/
+   #define JTYPE uint32 target = CachedMode ? dop->immediate : instr & ((1 << 26) - 1); /*printf(" target=(%08x) ", target);*/
+   #define RTYPE uint32 rs MDFN_NOWARN_UNUSED = CachedMode ? dop->rs : (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = CachedMode ? dop->rt : (instr >> 16) & 0x1F; uint32 rd MDFN_NOWARN_UNUSED = CachedMode ? dop->rd : (instr >> 11) & 0x1F; uint32 shamt MDFN_NOWARN_UNUSED = CachedMode ? dop->immediate : (instr >> 6) & 0x1F; /*printf(" rs=%02x(%08x), rt=%02x(%08x), rd=%02x(%08x) ", rs, GPR[rs], rt, GPR[rt], rd, GPR[rd]);*/
 
 #if HAVE_COMPUTED_GOTO
    #if 0
@@ -2440,17 +2569,28 @@ pscpu_timestamp_t PS_CPU::RunReal(pscpu_timestamp_t timestamp_in)
 pscpu_timestamp_t PS_CPU::Run(pscpu_timestamp_t timestamp_in, bool BIOSPrintMode, bool ILHMode)
 {
  if(CPUHook || ADDBT)
-  return(RunReal<true, true, false>(timestamp_in));
+  return(RunReal<true, true, false, false, false>(timestamp_in));
  else
  {
   if(ILHMode)
-   return(RunReal<false, false, true>(timestamp_in));
+  {
+   if(CachedInterp)
+    return(RunReal<false, false, true, true, false>(timestamp_in));
+   else
+    return(RunReal<false, false, true, false, false>(timestamp_in));
+  }
   else
   {
    if(BIOSPrintMode)
-    return(RunReal<false, true, false>(timestamp_in));
+    return(RunReal<false, true, false, false, false>(timestamp_in));
+#ifdef PSX_CPU_DYNAREC
+   else if(DR_Enabled)
+    return(RunReal<false, false, false, true, true>(timestamp_in));
+#endif
+   else if(CachedInterp)
+    return(RunReal<false, false, false, true, false>(timestamp_in));
    else
-    return(RunReal<false, false, false>(timestamp_in));
+    return(RunReal<false, false, false, false, false>(timestamp_in));
   }
  }
 }
@@ -2629,6 +2769,12 @@ void PS_CPU::PokeMem32(uint32 A, uint32 V)
 #undef BEGIN_OPF
 #undef END_OPF
 #undef MK_OPF
+#undef ITYPE
+#undef ITYPE_ZE
+#undef JTYPE
+#undef RTYPE
+
+#define ITYPE uint32 rs MDFN_NOWARN_UNUSED = (instr >> 21) & 0x1F; uint32 rt MDFN_NOWARN_UNUSED = (instr >> 16) & 0x1F; uint32 immediate = (int32)(int16)(instr & 0xFFFF);
 
 #define MK_OPF(op, funct)	((op) ? (0x40 | (op)) : (funct))
 #define BEGIN_OPF(op, funct) case MK_OPF(op, funct): {
@@ -2811,4 +2957,13 @@ void PS_CPU::CheckBreakpoints(void (*callback)(bool write, uint32 address, unsig
 }
 
 
+#ifdef PSX_CPU_DYNAREC
+#include "cpu_dynarec.inc"
+#else
+bool PS_CPU::SetDynarec(bool enabled)
+{
+ return !enabled;
+}
+#endif
+
 }
@@ -61,6 +61,12 @@
 
 #include "gte.h"
 
+// The AArch64 backend is experimental(not yet verified with the bench driver's -lockstep mode on real hardware),
+// and is only built when PSX_CPU_DYNAREC_ARM64 is defined(configure --enable-psx-dynarec-arm64).
+#if defined(HAVE_MMAP) && !defined(WIN32) && (defined(__x86_64__) || (defined(__aarch64__) && defined(PSX_CPU_DYNAREC_ARM64)))
+ #define PSX_CPU_DYNAREC 1
+#endif
+
 namespace MDFN_IEN_PSX
 {
 
@@ -78,6 +84,19 @@ class PS_CPU
 
  void SetFastMap(void *region_mem, uint32 region_address, uint32 region_size);
 
+ // Cached interpreter: executes from predecoded instruction records instead of decoding
+ // every instruction word as it's fetched.  Instruction fetch(and so I-cache and timing
+ // emulation) is unchanged.
+ INLINE void SetCachedInterpreter(bool enabled)
+ {
+  CachedInterp = enabled;
+ }
+
+ // Dynamic recompiler: runs MIPS basic blocks compiled to native x86-64 or AArch64 code, with the same
+ // instruction timing and I-cache behavior as the interpreter.  Returns false if it isn't available on
+ // this platform or the code buffer couldn't be allocated, in which case the interpreter is used.
+ bool SetDynarec(bool enabled);
+
  INLINE void SetEventNT(const pscpu_timestamp_t next_event_ts_arg)
  {
   next_event_ts = next_event_ts_arg;
@@ -127,6 +146,8 @@ class PS_CPU
  pscpu_timestamp_t gte_ts_done;
  pscpu_timestamp_t muldiv_ts_done;
 
+ pscpu_timestamp_t DR_Timestamp;	// Current timestamp while in compiled code.
+
  uint32 BIU;
 
  const uint32 addr_mask[8] = { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x7FFFFFFF, 0x1FFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF };
@@ -201,6 +222,41 @@ class PS_CPU
  uintptr_t FastMap[1 << (32 - FAST_MAP_SHIFT)];
  uint8 DummyPage[FAST_MAP_PSIZE];
 
+ //
+ // Predecoded instruction records, one per instruction word of each memory region
+ // passed to SetFastMap(), and indexed through DecodeMap the same way as FastMap.
+ //
+ // A record is only used if its "instr" matches the instruction word actually fetched,
+ // so there's nothing to invalidate explicitly when RAM is written by the CPU or DMA,
+ // or when the I-cache is loaded with other data while isolated(SR.IsC); a mismatch
+ // just causes that instruction(and the rest of its basic block) to be decoded again.
+ //
+ // An all-zero record is the correct decoding of instruction word 0.
+ //
+ struct DecodedOp
+ {
+  uint32 instr;
+  uint8 opf;	// Handler index, without IPCache.
+  uint8 rs;
+  uint8 rt;
+  uint8 rd;
+  uint32 immediate;	// Sign- or zero-extended immediate, shift amount, or jump target, depending on the instruction.
+ };
+
+ struct DecodeRegion
+ {
+  const void* mem;
+  uint32 size;
+  std::unique_ptr<DecodedOp[]> ops;
+ };
+
+ static void DecodeOp(DecodedOp* dop, uint32 instr);
+ NO_INLINE void DecodeBlock(uint32 PC, uint32 instr, DecodedOp* dop);
+
+ bool CachedInterp;
+ uintptr_t DecodeMap[1 << (32 - FAST_MAP_SHIFT)];
+ std::vector<DecodeRegion> DecodeRegions;
+
  enum
  {
   EXCEPTION_INT = 0,
@@ -220,7 +276,48 @@ class PS_CPU
 
  uint32 Exception(uint32 code, uint32 PC, const uint32 NP, const uint32 instr) MDFN_WARN_UNUSED_RESULT;
 
- template<bool DebugMode, bool BIOSPrintMode, bool ILHMode> NO_INLINE pscpu_timestamp_t RunReal(pscpu_timestamp_t timestamp_in);
+ template<bool DebugMode, bool BIOSPrintMode, bool ILHMode, bool CachedMode, bool DynarecMode> NO_INLINE pscpu_timestamp_t RunReal(pscpu_timestamp_t timestamp_in);
+
+ //
+ // Dynarec(cpu_dynarec.inc).  Compiled code works directly on the BACKED_* copies of PC and the load delay state, and
+ // on DR_Timestamp, and returns one of DR_EXIT_*.  Loads, stores, multiply/divide, and GTE instructions call out to
+ // DR_Op<>(), which implements them exactly as the interpreter does; anything else(COP0, SYSCALL, BREAK, etc.) ends the
+ // block and is left to the interpreter.
+ //
+ // Every compiled instruction checks that the fetched instruction word is still the one it was compiled from, so as
+ // with the cached interpreter there's nothing to invalidate on RAM or I-cache writes.
+ //
+ enum
+ {
+  DR_EXIT_CONTINUE = 0,	// Look up the next block.
+  DR_EXIT_INTERP = 1,	// Interpreter must run the instruction at BACKED_PC(or handle the pending event/interrupt).
+  DR_EXIT_STALE = 2	// Instruction word changed; block must be recompiled.
+ };
+
+ typedef uint32 (*DR_BlockFn)(PS_CPU* cpu);
+
+ struct DR_Block
+ {
+  uint32 pc;
+  DR_BlockFn fn;
+ };
+
+ enum { DR_BLOCK_TABLE_SIZE = 1 << 16 };
+
+ uint8* DR_Code;
+ size_t DR_CodeSize;
+ size_t DR_CodeUsed;
+ std::unique_ptr<DR_Block[]> DR_Blocks;
+ bool DR_Enabled;
+
+ pscpu_timestamp_t DR_Run(pscpu_timestamp_t timestamp);
+ DR_BlockFn DR_Compile(uint32 pc);
+ void DR_Flush(void);
+ uint32 DR_PeekInstruction(uint32 pc);
+ static uint32 DR_FetchMiss(PS_CPU* cpu, uint32 pc, uint32 instr);
+ static unsigned DR_Classify(uint32 instr, uint32 opf, const void** helper);
+ template<uint32 opf> uint32 DR_Op(uint32 instr, uint32 pc);
+ template<uint32 opf> static uint32 DR_OpThunk(PS_CPU* cpu, uint32 instr, uint32 pc);
 
  template<typename T> T PeekMemory(uint32 address) MDFN_COLD;
  template<typename T> void PokeMemory(uint32 address, T value) MDFN_COLD;
@@ -24,6 +24,10 @@
 #include "psx.h"
 #include "timer.h"
 
+#include <atomic>
+#include <mednafen/MThreading.h>
+#include <mednafen/bench.h>
+
 /* FIXME: Respect horizontal timing register values in relation to hsync/hblank/hretrace/whatever signal sent to the timers */
 
 /*
@@ -74,7 +78,160 @@ namespace PS_GPU_INTERNAL
 }
 using namespace PS_GPU_INTERNAL;
 
-void GPU_Init(bool pal_clock_and_tv)
+//
+// Multi-threaded renderer interface.  GP0 data words are queued, in order, for the render thread, which runs the
+// same command processing code(WriteCB(), ProcessFIFO(), and the rasterizers) as the single-threaded renderer.
+//
+// Draw timing is not emulated in this mode(commands execute as soon as they're complete, and DMA to the GPU is never
+// stalled), and display readout does not wait on the render thread.
+//
+enum
+{
+ COMMAND_GP0 = 0,
+ COMMAND_LINESKIP,
+ COMMAND_EXIT
+};
+
+struct WQ_Entry
+{
+ uint32 Command;
+ uint32 Arg;
+};
+
+struct ITC_S
+{
+ uint8 padding0[64];
+ std::array<WQ_Entry, 65536> WQ;
+ uint8 padding1[64];
+ size_t WritePos;
+ size_t ReadPos;
+ //
+ uint8 padding2[64 - sizeof(WritePos) - sizeof(ReadPos)];
+ std::atomic_int_least32_t TMP_WritePos;
+ std::atomic_int_least32_t TMP_ReadPos;
+ std::atomic_bool IRQSignal;	// Set by the render thread on GP0 0x1F.
+
+ MThreading::Sem* RT_WakeupSem;
+ MThreading::Sem* WakeupSem;
+ MThreading::Thread* RThread;
+};
+
+alignas(64) static ITC_S ITC;
+
+static void MTIF_Wakeup(bool wait_until_empty = false)
+{
+ ITC.TMP_WritePos.store(ITC.WritePos, std::memory_order_release);
+ ITC.ReadPos = ITC.TMP_ReadPos.load(std::memory_order_acquire);
+
+ if(ITC.ReadPos != ITC.WritePos)
+ {
+  MThreading::Sem_Post(ITC.RT_WakeupSem);
+
+  if(wait_until_empty)
+  {
+   do
+   {
+    MThreading::Sem_TimedWait(ITC.WakeupSem, 1);
+    ITC.ReadPos = ITC.TMP_ReadPos.load(std::memory_order_acquire);
+   } while(ITC.ReadPos != ITC.WritePos);
+  }
+ }
+}
+
+static MDFN_HOT void WWQ(uint32 Command, uint32 Arg = 0)
+{
+ WQ_Entry* e = &ITC.WQ[ITC.WritePos];
+
+ e->Command = Command;
+ e->Arg = Arg;
+ //
+ size_t nwp = (ITC.WritePos + 1) % ITC.WQ.size();
+
+ if(MDFN_UNLIKELY(nwp == ITC.ReadPos))
+ {
+  ITC.ReadPos = ITC.TMP_ReadPos.load(std::memory_order_acquire);
+
+  if(nwp == ITC.ReadPos)
+  {
+   PSX_DBG(PSX_DBG_SPARSE, "[GPU] MT command queue full\n");
+   MTIF_Wakeup(true);
+  }
+ }
+ //
+ ITC.WritePos = nwp;
+}
+
+static INLINE void MTIF_CheckIRQ(void)
+{
+ // IRQ latency relative to the GP0 0x1F command is nondeterministic with the multi-threaded renderer.
+ if(MDFN_UNLIKELY(ITC.IRQSignal.load(std::memory_order_relaxed)) && ITC.IRQSignal.exchange(false, std::memory_order_acquire))
+  IRQ_Assert(IRQ_GPU, true);
+}
+
+void GPU_MTSync(void)
+{
+ if(!MTRender)
+  return;
+
+ MTIF_Wakeup(true);
+ MTIF_CheckIRQ();
+}
+
+static void UpdateLineSkip(void)
+{
+ uint8 lsp = 0xFF;
+
+ if((DisplayMode & 0x24) == 0x24)
+  lsp = (DisplayFB_YStart + field_ram_readout) & 1;
+
+ if(MTRender)
+  WWQ(COMMAND_LINESKIP, lsp);
+ else
+  LineSkipParity = lsp;
+}
+
+static int RThreadEntry(void* data);
+
+static void MTIF_Init(const uint64 affinity)
+{
+ ITC.WritePos = 0;
+ ITC.ReadPos = 0;
+ ITC.TMP_WritePos = 0;
+ ITC.TMP_ReadPos = 0;
+ ITC.IRQSignal = false;
+ //
+ ITC.RT_WakeupSem = MThreading::Sem_Create();
+ ITC.WakeupSem = MThreading::Sem_Create();
+ //
+ ITC.RThread = MThreading::Thread_Create(RThreadEntry, NULL, "PSX GPU Render");
+ if(affinity)
+  MThreading::Thread_SetAffinity(ITC.RThread, affinity);
+}
+
+static void MTIF_Kill(void)
+{
+ if(ITC.RThread)
+ {
+  WWQ(COMMAND_EXIT);
+  MTIF_Wakeup(false);
+  MThreading::Thread_Wait(ITC.RThread, NULL);
+  ITC.RThread = NULL;
+ }
+
+ if(ITC.RT_WakeupSem)
+ {
+  MThreading::Sem_Destroy(ITC.RT_WakeupSem);
+  ITC.RT_WakeupSem = NULL;
+ }
+
+ if(ITC.WakeupSem)
+ {
+  MThreading::Sem_Destroy(ITC.WakeupSem);
+  ITC.WakeupSem = NULL;
+ }
+}
+
+void GPU_Init(bool pal_clock_and_tv, unsigned renderer, uint64 affinity)
 {
  static const int8 dither_table[4][4] =
  {
@@ -122,11 +279,21 @@ void GPU_Init(bool pal_clock_and_tv)
  memcpy(&Commands[0x40], Commands_40_5F, sizeof(Commands_40_5F));
  memcpy(&Commands[0x60], Commands_60_7F, sizeof(Commands_60_7F));
  memcpy(&Commands[0x80], Commands_80_FF, sizeof(Commands_80_FF));
+
+ LineSkipParity = 0xFF;
+ MTRender = (renderer == GPU_RENDERER_MT);
+
+ if(MTRender)
+  MTIF_Init(affinity);
 }
 
 void GPU_Kill(void)
 {
-
+ if(MTRender)
+ {
+  MTIF_Kill();
+  MTRender = false;
+ }
 }
 
 /*
@@ -287,10 +454,14 @@ static void SoftReset(void) // Control command 0x00
 
  TexDisable = false;
  TexDisableAllowChange = false;
+
+ UpdateLineSkip();
 }
 
 void GPU_Power(void)
 {
+ GPU_MTSync();
+
  memset(GPURAM, 0, sizeof(GPURAM));
 
  memset(CLUT_Cache, 0, sizeof(CLUT_Cache));
@@ -634,7 +805,11 @@ static void Command_ClearCache(const uint32 *cb)
 static void Command_IRQ(const uint32 *cb)
 {
  IRQPending = true;
- IRQ_Assert(IRQ_GPU, IRQPending);
+
+ if(MTRender)	// Render thread; IRQ_Assert() is called from the emulation thread in MTIF_CheckIRQ().
+  ITC.IRQSignal.store(true, std::memory_order_release);
+ else
+  IRQ_Assert(IRQ_GPU, IRQPending);
 }
 
 namespace PS_GPU_INTERNAL
@@ -743,6 +918,8 @@ static void ProcessFIFO(void)
 
 	if(BlitterFIFO.CanRead() >= vl)
 	{
+	 MDFN_BenchScope bs(MDFN_BENCH_VIDEO, !MTRender);
+
 	 for(unsigned i = 0; i < vl; i++)
 	 {
 	  CB[i] = BlitterFIFO.Read();
@@ -773,6 +950,8 @@ static void ProcessFIFO(void)
 
 	if(BlitterFIFO.CanRead() >= vl)
 	{
+	 MDFN_BenchScope bs(MDFN_BENCH_VIDEO, !MTRender);
+
 	 for(unsigned i = 0; i < vl; i++)
 	 {
 	  CB[i] = BlitterFIFO.Read();
@@ -827,6 +1006,8 @@ static void ProcessFIFO(void)
   }
   else
   {
+   MDFN_BenchScope bs(MDFN_BENCH_VIDEO, !MTRender);
+
    command->func[abr][TexMode | (MaskEvalAND ? 0x4 : 0x0)](CB);
   }
  }
@@ -844,6 +1025,65 @@ static void WriteCB(uint32 InData)
  ProcessFIFO();
 }
 
+//
+// Executes everything executable in the FIFO, ignoring draw timing.  Called from the render thread, or from the emulation
+// thread after GPU_MTSync().
+//
+static void MT_DrainFIFO(void)
+{
+ for(;;)
+ {
+  const uint32 prev_count = BlitterFIFO.CanRead();
+
+  DrawTimeAvail = 0;
+  ProcessFIFO();
+
+  if(BlitterFIFO.CanRead() == prev_count)
+   break;
+ }
+ DrawTimeAvail = 0;
+}
+
+static MDFN_HOT int RThreadEntry(void* data)
+{
+ bool Running = true;
+ size_t WritePos = 0;
+ size_t ReadPos = 0;
+
+ while(MDFN_LIKELY(Running))
+ {
+  ITC.TMP_ReadPos.store(ReadPos, std::memory_order_release);
+  WritePos = ITC.TMP_WritePos.load(std::memory_order_acquire);
+
+  while(ReadPos == WritePos)
+  {
+   MThreading::Sem_Post(ITC.WakeupSem);
+   MThreading::Sem_TimedWait(ITC.RT_WakeupSem, 1);
+   WritePos = ITC.TMP_WritePos.load(std::memory_order_acquire);
+  }
+
+  while(ReadPos != WritePos)
+  {
+   const WQ_Entry e = ITC.WQ[ReadPos];
+
+   ReadPos = (ReadPos + 1) % ITC.WQ.size();
+   //
+   if(MDFN_LIKELY(e.Command == COMMAND_GP0))
+   {
+    DrawTimeAvail = 0;
+    WriteCB(e.Arg);
+    MT_DrainFIFO();
+   }
+   else if(e.Command == COMMAND_LINESKIP)
+    LineSkipParity = e.Arg;
+   else if(e.Command == COMMAND_EXIT)
+    Running = false;
+  }
+ }
+
+ return 0;
+}
+
 MDFN_FASTCALL void GPU_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32 V)
 {
  V <<= (A & 3) * 8;
@@ -856,6 +1096,10 @@ MDFN_FASTCALL void GPU_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32
 
   //PSX_WARNING("[GPU] Control command: %02x %06x %d", command, V, scanline);
 
+  // Commands that touch render thread state.
+  if(command <= 0x02 || command == 0x09 || command == 0x10)
+   GPU_MTSync();
+
   switch(command)
   {
    /*
@@ -892,6 +1136,7 @@ MDFN_FASTCALL void GPU_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32
    case 0x05:	// Start of display area in framebuffer
 	DisplayFB_XStart = V & 0x3FE; // Lower bit is apparently ignored.
 	DisplayFB_YStart = (V >> 10) & 0x1FF;
+	UpdateLineSkip();
 	break;
 
    case 0x06:	// Horizontal display range
@@ -907,6 +1152,7 @@ MDFN_FASTCALL void GPU_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32
    case 0x08:
 	//printf("\n\nDISPLAYMODE SET: 0x%02x, %u *************************\n\n\n", V & 0xFF, scanline);
 	DisplayMode = V & 0xFF;
+	UpdateLineSkip();
 	break;
 
    case 0x09:
@@ -957,14 +1203,20 @@ MDFN_FASTCALL void GPU_Write(const pscpu_timestamp_t timestamp, uint32 A, uint32
   //uint32 command = V >> 24;
   //printf("Meow command: %02x\n", command);
   //assert(!(DMAControl & 2));
-  WriteCB(V);
+  if(MTRender)
+   WWQ(COMMAND_GP0, V);
+  else
+   WriteCB(V);
  }
 }
 
 
 MDFN_FASTCALL void GPU_WriteDMA(uint32 V)
 {
- WriteCB(V);
+ if(MTRender)
+  WWQ(COMMAND_GP0, V);
+ else
+  WriteCB(V);
 }
 
 static INLINE uint32 ReadData(void)
@@ -999,6 +1251,8 @@ static INLINE uint32 ReadData(void)
 
 uint32 GPU_ReadDMA(void)
 {
+ GPU_MTSync();
+
  return ReadData();
 }
 
@@ -1006,6 +1260,8 @@ MDFN_FASTCALL uint32 GPU_Read(const pscpu_timestamp_t timestamp, uint32 A)
 {
  uint32 ret = 0;
 
+ GPU_MTSync();
+
  if(A & 4)	// Status
  {
   ret = (((DisplayMode << 1) & 0x7F) | ((DisplayMode >> 6) & 1)) << 16;
@@ -1131,12 +1387,20 @@ MDFN_FASTCALL pscpu_timestamp_t GPU_Update(const pscpu_timestamp_t sys_timestamp
  if(!sys_clocks)
   goto TheEnd;
 
- DrawTimeAvail += sys_clocks << 1;
+ if(MTRender)
+ {
+  ITC.TMP_WritePos.store(ITC.WritePos, std::memory_order_release);
+  MTIF_CheckIRQ();
+ }
+ else
+ {
+  DrawTimeAvail += sys_clocks << 1;
 
- if(DrawTimeAvail > 256)
-  DrawTimeAvail = 256;
+  if(DrawTimeAvail > 256)
+   DrawTimeAvail = 256;
 
- ProcessFIFO();
+  ProcessFIFO();
+ }
 
  //puts("GPU Update Start");
 
@@ -1193,6 +1457,9 @@ MDFN_FASTCALL pscpu_timestamp_t GPU_Update(const pscpu_timestamp_t sys_timestamp
     scanline = (scanline + 1) % LinesPerField;
     PhaseChange = !PhaseChange;
 
+    if(MTRender && !(scanline & 0x3))
+     MTIF_Wakeup();
+
 #ifdef WANT_DEBUGGER
     DBG_GPUScanlineHook(scanline);
 #endif
@@ -1336,6 +1603,8 @@ MDFN_FASTCALL pscpu_timestamp_t GPU_Update(const pscpu_timestamp_t sys_timestamp
       field_ram_readout = !field;
      else
       field_ram_readout = 0;
+
+     UpdateLineSkip();
     }
 
     if(scanline == VertStart && InVBlank)
@@ -1409,6 +1678,7 @@ MDFN_FASTCALL pscpu_timestamp_t GPU_Update(const pscpu_timestamp_t sys_timestamp
      }
 
      {
+      MDFN_BenchScope bs(MDFN_BENCH_VIDEO);
       const uint16 *src = GPURAM[DisplayFB_CurLineYReadout];
 
       for(int32 x = 0; x < dx_start; x++)
@@ -1539,6 +1809,8 @@ void GPU_StartFrame(EmulateSpecStruct *espec_arg)
 
 void GPU_StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
+ GPU_MTSync();
+
  uint32 TexCache_Tag[256];
  uint16 TexCache_Data[256][4];
 
@@ -1691,6 +1963,12 @@ void GPU_StateAction(StateMem *sm, const unsigned load, const bool data_only)
   OffsX = sign_x_to_s32(11, OffsX);
   OffsY = sign_x_to_s32(11, OffsY);
 
+  // Commands left stalled on draw timing by the single-threaded renderer would otherwise sit in the FIFO until more data is written.
+  if(MTRender)
+   MT_DrainFIFO();
+
+  UpdateLineSkip();
+
   IRQ_Assert(IRQ_GPU, IRQPending);
  }
 }
@@ -21,6 +21,9 @@
 
 // WARNING WARNING WARNING:  ONLY use CanRead() method of BlitterFIFO, and NOT CanWrite(), since the FIFO is larger than the actual PS1 GPU FIFO to accommodate
 // our lack of fancy superscalarish command sequencer.
+//
+// When the multi-threaded renderer is enabled, everything touched by GP0 command execution(drawing environment, BlitterFIFO, InCmd, FBRW_*, caches,
+// GPURAM, DrawTimeAvail, IRQPending) is owned by the render thread, and may only be accessed from the emulation thread after GPU_MTSync().
 
 #ifndef __MDFN_PSX_GPU_H
 #define __MDFN_PSX_GPU_H
@@ -114,6 +117,12 @@ struct PS_GPU
  uint32 DataReadBufferEx;
 
  bool IRQPending;
+
+ // Derived from DisplayMode, DisplayFB_YStart, and field_ram_readout; 0 or 1 to skip drawing to lines of that parity, 0xFF to not skip any lines.
+ // Latched separately so that the render thread never needs to look at display state.
+ uint8 LineSkipParity;
+
+ bool MTRender;
  //
  //
  //
@@ -212,7 +221,13 @@ struct PS_GPU
 
  MDFN_HIDE extern PS_GPU GPU;
 
- void GPU_Init(bool pal_clock_and_tv) MDFN_COLD;
+ enum
+ {
+  GPU_RENDERER_ST = 0,
+  GPU_RENDERER_MT = 1
+ };
+
+ void GPU_Init(bool pal_clock_and_tv, unsigned renderer, uint64 affinity) MDFN_COLD;
  void GPU_Kill(void) MDFN_COLD;
 
  void GPU_SetGetVideoParams(MDFNGI* gi, const bool caspect, const int sls, const int sle, const bool show_h_overscan) MDFN_COLD;
@@ -248,8 +263,17 @@ struct PS_GPU
   return true;
  }
 
+ //
+ // Waits for the render thread to finish executing all queued commands; no-op with the single-threaded renderer.
+ //
+ void GPU_MTSync(void);
+
  static INLINE bool GPU_DMACanWrite(void)
  {
+  // The render thread's command queue is much deeper than the GPU FIFO, and blocks when full.
+  if(GPU.MTRender)
+   return true;
+
   return GPU_CalcFIFOReadyBit();
  }
 
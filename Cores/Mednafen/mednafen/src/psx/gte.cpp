@@ -24,6 +24,19 @@
 #ifndef PSXDEV_GTE_TESTING
 #include "psx.h"
 #include "gte.h"
+
+#include <mednafen/cputest/cputest.h>
+#include <mednafen/bench.h>
+
+#if defined(__GNUC__) && (defined(__SSE2__) || (defined(ARCH_X86) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+ #define GTE_HAVE_SIMD 1
+ #define GTE_SIMD_AVX2 1
+ #include <immintrin.h>
+#elif defined(HAVE_NEON_INTRINSICS) && defined(__aarch64__)
+ #define GTE_HAVE_SIMD 1
+ #define GTE_SIMD_NEON 1
+ #include <arm_neon.h>
+#endif
 #endif
 
 /* Notes:
@@ -144,6 +157,11 @@ static uint32 LZCR;
 static uint32 Reg23;
 // end DR
 
+#if defined(GTE_HAVE_SIMD)
+static bool SIMDEnabled = false;	// Use the SIMD versions of RTPT, NCT, NCCT, and DPCT; set by InitSIMD().
+static void InitSIMD(void) MDFN_COLD;
+#endif
+
 static INLINE uint8 Sat5(int16 cc)
 {
  if(cc < 0)
@@ -184,6 +202,10 @@ void GTE_Init(void)
  //
  // To avoid a bounds limiting if statement in the emulation code:
  DivTable[0x100] = DivTable[0xFF];
+
+#if defined(GTE_HAVE_SIMD)
+ InitSIMD();
+#endif
 }
 
 void GTE_Power(void)
@@ -1060,6 +1082,10 @@ static INLINE void TransformDQ(int64 h_div_sz)
  IR0 = Lm_H(((int64)DQB + DQA * h_div_sz) >> 12);
 }
 
+#if defined(GTE_HAVE_SIMD)
+#include "gte_simd.inc"
+#endif
+
 static INLINE int32 RTPS(uint32 instr)
 {
  DECODE_FIELDS;
@@ -1079,6 +1105,14 @@ static INLINE int32 RTPT(uint32 instr)
  DECODE_FIELDS;
  int i;
 
+#if defined(GTE_HAVE_SIMD)
+ if(MDFN_LIKELY(SIMDEnabled))
+ {
+  RTPT_SIMD(sf, lm);
+  return(23);
+ }
+#endif
+
  for(i = 0; i < 3; i++)
  {
   int64 h_div_sz;
@@ -1121,6 +1155,14 @@ static int32 NCT(uint32 instr)
  DECODE_FIELDS;
  int i;
 
+#if defined(GTE_HAVE_SIMD)
+ if(MDFN_LIKELY(SIMDEnabled))
+ {
+  NormColor_SIMD<false>(sf, lm);
+  return(30);
+ }
+#endif
+
  for(i = 0; i < 3; i++)
   NormColor(sf, lm, i);
 
@@ -1159,6 +1201,14 @@ static INLINE int32 NCCT(uint32 instr)
  int i;
  DECODE_FIELDS;
 
+#if defined(GTE_HAVE_SIMD)
+ if(MDFN_LIKELY(SIMDEnabled))
+ {
+  NormColor_SIMD<true>(sf, lm);
+  return(39);
+ }
+#endif
+
  for(i = 0; i < 3; i++)
   NormColorColor(i, sf, lm);
 
@@ -1233,6 +1283,14 @@ static INLINE int32 DPCT(uint32 instr)
  int i;
  DECODE_FIELDS;
 
+#if defined(GTE_HAVE_SIMD)
+ if(MDFN_LIKELY(SIMDEnabled))
+ {
+  DPCT_SIMD(sf, lm);
+  return(17);
+ }
+#endif
+
  for(i = 0; i < 3; i++)
  {
   DepthCue(false, true, sf, lm);
@@ -1690,6 +1748,155 @@ int32 GTE_Instruction(uint32 instr)
  return(ret - 1);
 }
 
+#if defined(GTE_HAVE_SIMD)
+#define GTE_TEST_STATE(X) X(CR) X(FLAGS) X(Matrices) X(CRVectors) X(OFX) X(OFY) X(H) X(DQA) X(DQB) X(ZSF3) X(ZSF4)	\
+			  X(Vectors) X(RGB) X(OTZ) X(IR) X(XY_FIFO) X(Z_FIFO) X(RGB_FIFO) X(MAC) X(LZCS) X(LZCR) X(Reg23)
+
+#define GTE_TEST_SIZE(v) + sizeof(v)
+enum : size_t { TestStateSize = 0 GTE_TEST_STATE(GTE_TEST_SIZE) };
+#undef GTE_TEST_SIZE
+
+static void SaveTestState(uint8* p)
+{
+ #define GTE_TEST_SAVE(v) memcpy(p, &v, sizeof(v)); p += sizeof(v);
+ GTE_TEST_STATE(GTE_TEST_SAVE)
+ #undef GTE_TEST_SAVE
+}
+
+static void LoadTestState(const uint8* p)
+{
+ #define GTE_TEST_LOAD(v) memcpy(&v, p, sizeof(v)); p += sizeof(v);
+ GTE_TEST_STATE(GTE_TEST_LOAD)
+ #undef GTE_TEST_LOAD
+}
+
+//
+// Compares the SIMD versions of RTPT, NCT, NCCT, and DPCT against the scalar ones on randomized register state(all of it,
+// FLAGS included), and when running under the benchmark driver, also reports the time per instruction for both.
+//
+static MDFN_COLD bool TestSIMD(void)
+{
+ static const struct
+ {
+  const char* name;
+  uint8 code;
+ } ops[4] = { { "RTPT", 0x30 }, { "NCT", 0x20 }, { "NCCT", 0x3F }, { "DPCT", 0x2A } };
+ uint8 init[TestStateSize], a[TestStateSize], b[TestStateSize];
+ uint64 lcg = 0x2545F4914F6CDD1DULL;
+ auto rnd = [&]() { lcg = (lcg * 6364136223846793005ULL) + 1442695040888963407ULL; return (uint32)(lcg >> 32); };
+ // Mostly small values, so that results land on both sides of the saturation limits.
+ auto rnd16 = [&]() { return (int16)((int16)rnd() >> (rnd() & 0xF)); };
+ auto rnd32 = [&]() { return (int32)rnd() >> (rnd() & 0x1F); };
+
+ for(unsigned iter = 0; iter < 4096; iter++)
+ {
+  const uint32 instr = (rnd() & 0x1FFFFC0) | ops[iter & 3].code;
+  int32 ra, rb;
+
+  for(auto& e : CR) e = rnd();
+  FLAGS = rnd();
+  for(auto& r : Matrices.Raw16) for(auto& e : r) e = rnd16();
+  for(auto& r : CRVectors.All) for(auto& e : r) e = rnd32();
+  OFX = rnd32();
+  OFY = rnd32();
+  H = rnd();
+  DQA = rnd16();
+  DQB = rnd32();
+  ZSF3 = rnd16();
+  ZSF4 = rnd16();
+  for(auto& r : Vectors) for(auto& e : r) e = rnd16();
+  for(auto& e : RGB.Raw8) e = rnd();
+  OTZ = rnd();
+  for(auto& e : IR) e = rnd16();
+  for(auto& e : XY_FIFO) { e.X = rnd16(); e.Y = rnd16(); }
+  for(auto& e : Z_FIFO) e = (uint16)rnd() >> (rnd() & 0xF);
+  for(auto& r : RGB_FIFO) for(auto& e : r.Raw8) e = rnd();
+  for(auto& e : MAC) e = rnd32();
+  LZCS = rnd();
+  LZCR = rnd();
+  Reg23 = rnd();
+  //
+  //
+  SaveTestState(init);
+
+  SIMDEnabled = false;
+  ra = GTE_Instruction(instr);
+  SaveTestState(a);
+
+  LoadTestState(init);
+  SIMDEnabled = true;
+  rb = GTE_Instruction(instr);
+  SaveTestState(b);
+
+  if(ra != rb || memcmp(a, b, TestStateSize))
+   return false;
+ }
+
+ if(MDFNBench.Kernels)
+ {
+  const unsigned count = 16384;
+  double ns[4][2];
+
+  // Alternate between the two and keep the best of several runs, to reduce the effect of noise.
+  for(unsigned i = 0; i < 4; i++)
+  {
+   ns[i][0] = ns[i][1] = 1e9;
+
+   for(unsigned run = 0; run < 16; run++)
+   {
+    const unsigned k = run & 1;
+    const int64 st = Time::MonoNS();
+
+    LoadTestState(init);
+    SIMDEnabled = k;
+    for(unsigned n = 0; n < count; n++)
+    {
+     Vectors[n % 3][n & 1] ^= MAC[1] & 0x7;	// Feed the output back in, so the compiler can't hoist anything.
+     GTE_Instruction(ops[i].code | (1 << 19));
+    }
+    ns[i][k] = std::min<double>(ns[i][k], (double)(Time::MonoNS() - st) / count);
+   }
+  }
+
+  MDFN_printf(_("GTE %s: %s %.1f ns(scalar %.1f), %s %.1f ns(scalar %.1f), %s %.1f ns(scalar %.1f), %s %.1f ns(scalar %.1f)\n"), GTE_SIMD_NAME,
+	ops[0].name, ns[0][1], ns[0][0], ops[1].name, ns[1][1], ns[1][0], ops[2].name, ns[2][1], ns[2][0], ops[3].name, ns[3][1], ns[3][0]);
+ }
+
+ return true;
+}
+
+static void InitSIMD(void)
+{
+ uint8 saved[TestStateSize];
+ bool avail = true;
+
+#if defined(GTE_SIMD_AVX2)
+ avail = (bool)(cputest_get_flags() & CPUTEST_FLAG_AVX2);
+#else
+ // cputest doesn't detect NEON; HAVE_NEON_INTRINSICS means the compiler was told it's always available.
+#endif
+
+ SIMDEnabled = false;
+
+ if(avail)
+ {
+  SaveTestState(saved);
+
+  if(TestSIMD())
+   SIMDEnabled = true;
+  else
+  {
+   SIMDEnabled = false;
+   MDFN_printf(_("WARNING: GTE %s paths don't match the scalar paths; not using them.\n"), GTE_SIMD_NAME);
+  }
+
+  LoadTestState(saved);
+ }
+
+ MDFN_printf(_("GTE SIMD: %s\n"), SIMDEnabled ? GTE_SIMD_NAME : "None");
+}
+#endif
+
 #ifndef PSXDEV_GTE_TESTING
 }
 #endif
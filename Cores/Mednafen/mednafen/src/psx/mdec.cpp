@@ -63,13 +63,21 @@
 #include "mdec.h"
 #include "FastFIFO.h"
 
+#include <mednafen/cputest/cputest.h>
+#include <mednafen/bench.h>
+
 #if defined(__SSE2__) || (defined(ARCH_X86) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
-#include <xmmintrin.h>
-#include <emmintrin.h>
+ #define MDEC_HAVE_SSE2 1
+ #include <immintrin.h>
+
+ #if defined(__GNUC__)
+  #define MDEC_HAVE_AVX2 1
+ #endif
 #endif
 
-#if 0 //defined(HAVE_NEON_INTRINSICS)
-#include <arm_neon.h>
+#if defined(HAVE_NEON_INTRINSICS) && defined(LSB_FIRST)
+ #define MDEC_HAVE_NEON 1
+ #include <arm_neon.h>
 #endif
 
 #if defined(HAVE_ALTIVEC_INTRINSICS) && defined(HAVE_ALTIVEC_H)
@@ -246,88 +254,8 @@ static INLINE int8 Mask9ClampS8(int32 v)
 ////////////////////////
 //
 //
-#pragma GCC push_options
-
-#if defined(__SSE2__) || (defined(ARCH_X86) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
-//
-//
-//
-#pragma GCC target("sse2")
-template<typename T>
-static INLINE void IDCT_1D_Multi(int16 *in_coeff, T *out_coeff)
-{
- for(unsigned col = 0; col < 8; col++)
- {
-  __m128i c =  _mm_load_si128((__m128i *)&in_coeff[(col * 8)]);
-
-  for(unsigned x = 0; x < 8; x++)
-  {
-   __m128i sum;
-   __m128i m;
-   alignas(16) int32 tmp[4];
-
-   m = _mm_load_si128((__m128i *)&IDCTMatrix[(x * 8)]);
-   sum = _mm_madd_epi16(m, c);
-   sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, (3 << 0) | (2 << 2) | (1 << 4) | (0 << 6)));
-   sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, (1 << 0) | (0 << 2)));
-
-   //_mm_store_ss((float *)&tmp[0], (__m128)sum);
-   _mm_store_si128((__m128i*)tmp, sum);
-
-   if(sizeof(T) == 1)
-    out_coeff[(col * 8) + x] = Mask9ClampS8((tmp[0] + 0x4000) >> 15);
-   else
-    out_coeff[(x * 8) + col] = (tmp[0] + 0x4000) >> 15;
-  }
- }
-}
-//
-//
-//
-#elif 0 //defined(HAVE_NEON_INTRINSICS)
-//
-//
-//
-template<typename T>
-static INLINE void IDCT_1D_Multi(int16 *in_coeff, T *out_coeff)
-{
- for(unsigned col = 0; col < 8; col++)
- {
-  register int16x4_t c0 = vld1_s16(MDFN_ASSUME_ALIGNED(in_coeff + col * 8 + 0, sizeof(int16x4_t)));
-  register int16x4_t c1 = vld1_s16(MDFN_ASSUME_ALIGNED(in_coeff + col * 8 + 4, sizeof(int16x4_t)));
-  int32 buf[8];
-
-  for(unsigned x = 0; x < 8; x++)
-  {
-   register int32x4_t accum;
-   register int32x2_t sum2;
-
-   accum = vdupq_n_s32(0);
-   accum = vmlal_s16(accum, c0, vld1_s16(MDFN_ASSUME_ALIGNED(IDCTMatrix + x * 8 + 0, sizeof(int16x4_t))));
-   accum = vmlal_s16(accum, c1, vld1_s16(MDFN_ASSUME_ALIGNED(IDCTMatrix + x * 8 + 4, sizeof(int16x4_t))));
-   sum2 = vadd_s32(vget_high_s32(accum), vget_low_s32(accum));
-   sum2 = vpadd_s32(sum2, sum2);
-   vst1_lane_s32(buf + x, sum2, 0);
-  }
-
-  for(unsigned x = 0; x < 8; x++)
-  {
-   if(sizeof(T) == 1)
-    out_coeff[(col * 8) + x] = Mask9ClampS8((buf[x] + 0x4000) >> 15);
-   else
-    out_coeff[(x * 8) + col] = (buf[x] + 0x4000) >> 15;
-  }
- }
-}
-//
-//
-//
-#else
-//
-//
-//
 template<typename T>
-static INLINE void IDCT_1D_Multi(int16 *in_coeff, T *out_coeff)
+static INLINE void IDCT_1D_Multi(const int16* matrix, const int16 *in_coeff, T *out_coeff)
 {
  for(unsigned col = 0; col < 8; col++)
  {
@@ -337,7 +265,7 @@ static INLINE void IDCT_1D_Multi(int16 *in_coeff, T *out_coeff)
 
    for(unsigned u = 0; u < 8; u++)
    {
-    sum += (in_coeff[(col * 8) + u] * IDCTMatrix[(x * 8) + u]);
+    sum += (in_coeff[(col * 8) + u] * matrix[(x * 8) + u]);
    }
 
    if(sizeof(T) == 1)
@@ -347,19 +275,14 @@ static INLINE void IDCT_1D_Multi(int16 *in_coeff, T *out_coeff)
   }
  }
 }
-//
-//
-//
-#endif
 
-static NO_INLINE void IDCT(int16 *in_coeff, int8 *out_coeff)
+static NO_INLINE void IDCT_C(const int16* matrix, const int16 *in_coeff, int8 *out_coeff)
 {
  alignas(16) int16 tmpbuf[64];
 
- IDCT_1D_Multi<int16>(in_coeff, tmpbuf);
- IDCT_1D_Multi<int8>(tmpbuf, out_coeff);
+ IDCT_1D_Multi<int16>(matrix, in_coeff, tmpbuf);
+ IDCT_1D_Multi<int8>(matrix, tmpbuf, out_coeff);
 }
-#pragma GCC pop_options
 //
 //
 ///////////////////////
@@ -398,6 +321,233 @@ static INLINE uint16 RGB_to_RGB555(uint8 r, uint8 g, uint8 b)
  return((r << 0) | (g << 5) | (b << 10));
 }
 
+//
+// 'by' points to an 8x8 luma block, and 'cb' and 'cr' to the corner of the matching 4x4 area in the 8x8 chroma blocks(so
+// the row stride of all three is 8).
+//
+static NO_INLINE void EncodeRGB24_C(const int8* by, const int8* cb, const int8* cr, uint8* pix_out, const uint8 rgb_xor)
+{
+ for(int y = 0; y < 8; y++)
+ {
+  for(int x = 0; x < 8; x++)
+  {
+   int r, g, b;
+
+   YCbCr_to_RGB(by[x], cb[x >> 1], cr[x >> 1], r, g, b);
+
+   pix_out[0] = r ^ rgb_xor;
+   pix_out[1] = g ^ rgb_xor;
+   pix_out[2] = b ^ rgb_xor;
+   pix_out += 3;
+  }
+  by += 8;
+  cb += (y & 1) << 3;
+  cr += (y & 1) << 3;
+ }
+}
+
+static NO_INLINE void EncodeRGB15_C(const int8* by, const int8* cb, const int8* cr, uint16* pix_out, const uint16 pixel_xor)
+{
+ for(int y = 0; y < 8; y++)
+ {
+  for(int x = 0; x < 8; x++)
+  {
+   int r, g, b;
+
+   YCbCr_to_RGB(by[x], cb[x >> 1], cr[x >> 1], r, g, b);
+
+   MDFN_en16lsb<true>(pix_out, pixel_xor ^ RGB_to_RGB555(r, g, b));
+   pix_out++;
+  }
+  by += 8;
+  cb += (y & 1) << 3;
+  cr += (y & 1) << 3;
+ }
+}
+
+//
+// The SIMD kernels must match the scalar kernels above bit-for-bit; MDEC_Init() checks that before using them.
+//
+#if defined(MDEC_HAVE_SSE2)
+ #pragma GCC push_options
+ #pragma GCC target("sse2")
+ #include "mdec_sse2.inc"
+ #pragma GCC pop_options
+
+ #if defined(MDEC_HAVE_AVX2)
+  #include "mdec_avx2.inc"
+ #endif
+#endif
+
+#if defined(MDEC_HAVE_NEON)
+ #include "mdec_neon.inc"
+#endif
+
+struct MDECKernels
+{
+ const char* name;
+ void (*IDCT)(const int16* matrix, const int16* in_coeff, int8* out_coeff);
+ void (*EncodeRGB24)(const int8* by, const int8* cb, const int8* cr, uint8* pix_out, const uint8 rgb_xor);
+ void (*EncodeRGB15)(const int8* by, const int8* cb, const int8* cr, uint16* pix_out, const uint16 pixel_xor);
+};
+
+static const MDECKernels Kernels_C = { "None", IDCT_C, EncodeRGB24_C, EncodeRGB15_C };
+#if defined(MDEC_HAVE_SSE2)
+static const MDECKernels Kernels_SSE2 = { "SSE2", IDCT_SSE2, EncodeRGB24_SSE2, EncodeRGB15_SSE2 };
+ #if defined(MDEC_HAVE_AVX2)
+static const MDECKernels Kernels_AVX2 = { "AVX2", IDCT_AVX2, EncodeRGB24_AVX2, EncodeRGB15_AVX2 };
+ #endif
+#endif
+#if defined(MDEC_HAVE_NEON)
+static const MDECKernels Kernels_NEON = { "NEON", IDCT_NEON, EncodeRGB24_NEON, EncodeRGB15_NEON };
+#endif
+
+static const MDECKernels* Kernels = &Kernels_C;
+
+static INLINE void IDCT(const int16 *in_coeff, int8 *out_coeff)
+{
+ Kernels->IDCT(IDCTMatrix, in_coeff, out_coeff);
+}
+
+//
+// Compares a kernel set against the scalar kernels on randomized blocks, and when the benchmark driver asks for it, also
+// reports the time per block for both.
+//
+static MDFN_COLD bool TestKernels(const MDECKernels* ks)
+{
+ alignas(16) int16 matrix[64];
+ alignas(16) int16 coeff[64];
+ int8 ycc[3][64];
+ uint64 lcg = 0x2545F4914F6CDD1DULL;
+ auto rnd = [&]() { lcg = (lcg * 6364136223846793005ULL) + 1442695040888963407ULL; return (uint32)(lcg >> 32); };
+
+ for(unsigned iter = 0; iter < 1024; iter++)
+ {
+  // The first few iterations use the extremes of the coefficient and matrix ranges, the rest progressively denser random
+  // coefficients.
+  for(unsigned i = 0; i < 64; i++)
+  {
+   if(iter < 4)
+   {
+    matrix[i] = (iter & 2) ? 0x0FFF : -0x1000;
+    coeff[i] = (iter & 1) ? 0x3FFF : -0x4000;
+   }
+   else
+   {
+    matrix[i] = (int16)rnd() >> 3;
+    coeff[i] = ((rnd() & 0x3F) <= (iter & 0x3F)) ? (int32)(rnd() & 0x7FFF) - 0x4000 : 0;
+   }
+  }
+
+  for(unsigned i = 0; i < 3; i++)
+  {
+   for(unsigned j = 0; j < 64; j += 4)
+    MDFN_en32lsb(&ycc[i][j], rnd());
+  }
+  //
+  //
+  {
+   int8 a[64], b[64];
+
+   Kernels_C.IDCT(matrix, coeff, a);
+   ks->IDCT(matrix, coeff, b);
+
+   if(memcmp(a, b, sizeof(a)))
+    return false;
+  }
+
+  for(unsigned ybn = 0; ybn < 4; ybn++)
+  {
+   const int8* cb = &ycc[1][(((ybn & 2) << 1) << 3) + ((ybn & 1) << 2)];
+   const int8* cr = &ycc[2][(((ybn & 2) << 1) << 3) + ((ybn & 1) << 2)];
+   const uint8 rgb_xor = (iter & 1) ? 0x80 : 0x00;
+   const uint16 pixel_xor = ((iter & 2) ? 0x8000 : 0x0000) | ((iter & 4) ? 0x4210 : 0x0000);
+   uint8 a24[192], b24[192];
+   uint16 a15[64], b15[64];
+
+   Kernels_C.EncodeRGB24(ycc[0], cb, cr, a24, rgb_xor);
+   ks->EncodeRGB24(ycc[0], cb, cr, b24, rgb_xor);
+
+   Kernels_C.EncodeRGB15(ycc[0], cb, cr, a15, pixel_xor);
+   ks->EncodeRGB15(ycc[0], cb, cr, b15, pixel_xor);
+
+   if(memcmp(a24, b24, sizeof(a24)) || memcmp(a15, b15, sizeof(a15)))
+    return false;
+  }
+ }
+
+ if(MDFNBench.Kernels)
+ {
+  const unsigned count = 65536;
+  double ns[2][2];
+
+  for(unsigned k = 0; k < 2; k++)
+  {
+   const MDECKernels* bks = k ? ks : &Kernels_C;
+   int8 out[64] = { 0 };
+   uint16 out15[64] = { 0 };
+   int64 st;
+
+   st = Time::MonoNS();
+   for(unsigned i = 0; i < count; i++)
+   {
+    coeff[i & 0x3F] += out[i & 0x3F] & 0x7;	// Feed the output back in, so the compiler can't hoist anything.
+    bks->IDCT(matrix, coeff, out);
+   }
+   ns[k][0] = (double)(Time::MonoNS() - st) / count;
+
+   st = Time::MonoNS();
+   for(unsigned i = 0; i < count; i++)
+   {
+    ycc[0][i & 0x3F] += out15[i & 0x3F] & 0x7;
+    bks->EncodeRGB15(ycc[0], ycc[1], ycc[2], out15, 0);
+   }
+   ns[k][1] = (double)(Time::MonoNS() - st) / count;
+  }
+
+  MDFN_printf(_("MDEC %s kernels: IDCT %.1f ns/block(scalar %.1f), 15-bit colour conversion %.1f ns/block(scalar %.1f)\n"), ks->name, ns[1][0], ns[0][0], ns[1][1], ns[0][1]);
+ }
+
+ return true;
+}
+
+void MDEC_Init(void)
+{
+ const MDECKernels* candidates[3];
+ unsigned count = 0;
+#if defined(MDEC_HAVE_SSE2)
+ const uint32 cpuext = cputest_get_flags();
+
+ #if defined(MDEC_HAVE_AVX2)
+ if(cpuext & CPUTEST_FLAG_AVX2)
+  candidates[count++] = &Kernels_AVX2;
+ #endif
+
+ if(cpuext & CPUTEST_FLAG_SSE2)
+  candidates[count++] = &Kernels_SSE2;
+#endif
+
+#if defined(MDEC_HAVE_NEON)
+ // cputest doesn't detect NEON; HAVE_NEON_INTRINSICS means the compiler was told it's always available.
+ candidates[count++] = &Kernels_NEON;
+#endif
+
+ Kernels = &Kernels_C;
+
+ for(unsigned i = 0; i < count; i++)
+ {
+  if(TestKernels(candidates[i]))
+  {
+   Kernels = candidates[i];
+   break;
+  }
+
+  MDFN_printf(_("WARNING: MDEC %s kernels don't match the scalar kernels; not using them.\n"), candidates[i]->name);
+ }
+
+ MDFN_printf(_("MDEC SIMD: %s\n"), Kernels->name);
+}
+
 static void EncodeImage(const unsigned ybn)
 {
  //printf("ENCODE, %d\n", (Command & 0x08000000) ? 256 : 384);
@@ -447,26 +597,7 @@ static void EncodeImage(const unsigned ybn)
   case 2:	// 24bpp
   {
    const uint8 rgb_xor = (Command & (1U << 26)) ? 0x80 : 0x00;
-   uint8* pix_out = PixelBuffer.pix8;
-
-   for(int y = 0; y < 8; y++)
-   {
-    const int8* by = &block_y[y][0];
-    const int8* cb = &block_cb[(y >> 1) | ((ybn & 2) << 1)][(ybn & 1) << 2];
-    const int8* cr = &block_cr[(y >> 1) | ((ybn & 2) << 1)][(ybn & 1) << 2];
-    
-    for(int x = 0; x < 8; x++)
-    {
-     int r, g, b;
-
-     YCbCr_to_RGB(by[x], cb[x >> 1], cr[x >> 1], r, g, b);
-
-     pix_out[0] = r ^ rgb_xor;
-     pix_out[1] = g ^ rgb_xor;
-     pix_out[2] = b ^ rgb_xor;
-     pix_out += 3;
-    }
-   }
+   Kernels->EncodeRGB24(&block_y[0][0], &block_cb[(ybn & 2) << 1][(ybn & 1) << 2], &block_cr[(ybn & 2) << 1][(ybn & 1) << 2], PixelBuffer.pix8, rgb_xor);
    PixelBufferCount32 = 48;
   }
   break;
@@ -474,24 +605,7 @@ static void EncodeImage(const unsigned ybn)
   case 3:	// 16bpp
   {
    uint16 pixel_xor = ((Command & 0x02000000) ? 0x8000 : 0x0000) | ((Command & (1U << 26)) ? 0x4210 : 0x0000);
-   uint16* pix_out = PixelBuffer.pix16;
-
-   for(int y = 0; y < 8; y++)
-   {
-    const int8* by = &block_y[y][0];
-    const int8* cb = &block_cb[(y >> 1) | ((ybn & 2) << 1)][(ybn & 1) << 2];
-    const int8* cr = &block_cr[(y >> 1) | ((ybn & 2) << 1)][(ybn & 1) << 2];
-
-    for(int x = 0; x < 8; x++)
-    {
-     int r, g, b;
-
-     YCbCr_to_RGB(by[x], cb[x >> 1], cr[x >> 1], r, g, b);
-
-     MDFN_en16lsb<true>(pix_out, pixel_xor ^ RGB_to_RGB555(r, g, b));
-     pix_out++;
-    }
-   }
+   Kernels->EncodeRGB15(&block_y[0][0], &block_cb[(ybn & 2) << 1][(ybn & 1) << 2], &block_cr[(ybn & 2) << 1][(ybn & 1) << 2], PixelBuffer.pix16, pixel_xor);
    PixelBufferCount32 = 32;
   }
   break;
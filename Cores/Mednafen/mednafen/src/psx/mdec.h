@@ -33,6 +33,7 @@ MDFN_FASTCALL void MDEC_Write(const pscpu_timestamp_t timestamp, uint32 A, uint3
 MDFN_FASTCALL uint32 MDEC_Read(const pscpu_timestamp_t timestamp, uint32 A);
 
 
+void MDEC_Init(void) MDFN_COLD;
 void MDEC_Power(void) MDFN_COLD;
 
 bool MDEC_DMACanWrite(void);
@@ -1624,8 +1624,11 @@ static MDFN_COLD void InitCommon(std::vector<CDInterface*> *CDInterfaces, const
  }
 
  CPU = new PS_CPU();
+ CPU->SetCachedInterpreter(MDFN_GetSettingB("psx.cpu_cached_interp"));
+ CPU->SetDynarec(MDFN_GetSettingB("psx.cpu_dynarec"));
  SPU = new PS_SPU();
- GPU_Init(region == REGION_EU);
+ SPU->SetSIMD(MDFN_GetSettingB("psx.spu.simd"));
+ GPU_Init(region == REGION_EU, MDFN_GetSettingUI("psx.renderer"), MDFN_GetSettingUI("psx.affinity.gpu"));
  CDC = new PS_CDC();
  FIO = new FrontIO();
 
@@ -1662,6 +1665,7 @@ static MDFN_COLD void InitCommon(std::vector<CDInterface*> *CDInterfaces, const
  }
 
  DMA_Init();
+ MDEC_Init();
 
  GPU_SetGetVideoParams(MDFNGameInfo, correct_aspect, sls, sle, MDFN_GetSettingB("psx.h_overscan"));
 
@@ -2237,6 +2241,33 @@ static const FileExtensionSpecStruct KnownExtensions[] =
  { NULL, 0, NULL }
 };
 
+static const MDFNSetting_EnumList Renderer_List[] =
+{
+ { "st", GPU_RENDERER_ST, gettext_noop("Single-threaded"), gettext_noop("GPU commands are executed in the main emulation thread.") },
+ { "mt", GPU_RENDERER_MT, gettext_noop("Multi-threaded"), gettext_noop("GPU commands are executed in a dedicated thread, and GPU draw timing is not emulated.  VRAM readback, GPU status register reads, and save states wait for the rendering thread to catch up.") },
+
+ { NULL, 0 }
+};
+
+static void CPUSettingChanged(const char* name)
+{
+ if(!CPU)
+  return;
+
+ if(!strcmp(name, "psx.cpu_cached_interp"))
+  CPU->SetCachedInterpreter(MDFN_GetSettingB("psx.cpu_cached_interp"));
+ else if(!strcmp(name, "psx.cpu_dynarec"))
+  CPU->SetDynarec(MDFN_GetSettingB("psx.cpu_dynarec"));
+}
+
+static void SPUSettingChanged(const char* name)
+{
+ if(!SPU)
+  return;
+
+ SPU->SetSIMD(MDFN_GetSettingB("psx.spu.simd"));
+}
+
 static const MDFNSetting PSXSettings[] =
 {
  { "psx.input.mouse_sensitivity", MDFNSF_NOFLAGS, gettext_noop("Emulated mouse sensitivity."), NULL, MDFNST_FLOAT, "1.00", NULL, NULL },
@@ -2278,6 +2309,7 @@ static const MDFNSetting PSXSettings[] =
 
  { "psx.spu.resamp_quality", MDFNSF_NOFLAGS, gettext_noop("SPU output resampler quality."),
 	gettext_noop("0 is lowest quality and CPU usage, 10 is highest quality and CPU usage.  The resampler that this setting refers to is used for converting from 44.1KHz to the sampling rate of the host audio device Mednafen is using.  Changing Mednafen's output rate, via the \"sound.rate\" setting, to \"44100\" may bypass the resampler, which can decrease CPU usage by Mednafen, and can increase or decrease audio quality, depending on various operating system and hardware factors."), MDFNST_UINT, "5", "0", "10" },
+ { "psx.spu.simd", MDFNSF_NOFLAGS, gettext_noop("Use SIMD SPU voice mixing and reverb resampling."), gettext_noop("Uses SSE2 or NEON kernels for the per-sample voice interpolation, envelope, and volume, and for the reverb resampling filters.  Output is the same either way; disabling this is only useful for comparing the two."), MDFNST_BOOL, "1", NULL, NULL, NULL, SPUSettingChanged },
 
  { "psx.correct_aspect", MDFNSF_NOFLAGS, gettext_noop("Correct aspect ratio."), gettext_noop("Disabling aspect ratio correction with this setting should be considered a hack.\n\nIf disabling it to allow for sharper pixels by also separately disabling interpolation(though using Mednafen's \"autoipsharper\" OpenGL shader is usually a better option), remember to use scale factors that are multiples of 2, or else games that use high-resolution and interlaced modes will have distorted pixels.\n\nDisabling aspect ratio correction with this setting will allow for the QuickTime movie recording feature to produce much smaller files using much less CPU time."), MDFNST_BOOL, "1" },
 
@@ -2289,6 +2321,11 @@ static const MDFNSetting PSXSettings[] =
 
  { "psx.h_overscan", MDFNSF_NOFLAGS, gettext_noop("Show horizontal overscan area."), NULL, MDFNST_BOOL, "1" },
 
+ { "psx.renderer", MDFNSF_NOFLAGS, gettext_noop("GPU renderer."), gettext_noop("If you have only one CPU with one physical CPU core, select the single-threaded renderer for better performance.  The multi-threaded renderer doesn't emulate GPU draw timing, so a few timing-sensitive games may misbehave with it."), MDFNST_ENUM, "st", NULL, NULL, NULL, NULL, Renderer_List },
+ { "psx.affinity.gpu", MDFNSF_NOFLAGS, gettext_noop("GPU rendering thread CPU affinity mask."), gettext_noop("Set to 0 to disable changing affinity."), MDFNST_UINT, "0", "0x0000000000000000", "0xFFFFFFFFFFFFFFFF" },
+ { "psx.cpu_cached_interp", MDFNSF_NOFLAGS, gettext_noop("Use the cached CPU interpreter."), gettext_noop("Executes from predecoded instruction records instead of decoding each instruction as it's fetched.  Emulated CPU timing is the same either way."), MDFNST_BOOL, "1", NULL, NULL, NULL, CPUSettingChanged },
+ { "psx.cpu_dynarec", MDFNSF_NOFLAGS, gettext_noop("Use the CPU dynamic recompiler."), gettext_noop("Compiles CPU code to native x86-64 code(or AArch64 code, in builds with the experimental AArch64 backend).  Emulated CPU timing is the same as with the interpreter, which is still used when debugging, during PSF playback, and on host systems the recompiler doesn't support."), MDFNST_BOOL, "0", NULL, NULL, NULL, CPUSettingChanged },
+
 #if PSX_DBGPRINT_ENABLE
  { "psx.dbg_level", MDFNSF_NOFLAGS, gettext_noop("Debug printf verbosity level."), NULL, MDFNST_UINT, "0", "0", "4" },
 #endif
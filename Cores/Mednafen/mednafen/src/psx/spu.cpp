@@ -82,6 +82,19 @@
 #include "cdc.h"
 #include "spu.h"
 
+#include <mednafen/cputest/cputest.h>
+#include <mednafen/bench.h>
+
+#if defined(__SSE2__) || (defined(ARCH_X86) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+ #define SPU_HAVE_SSE2 1
+ #include <immintrin.h>
+#endif
+
+#if defined(HAVE_NEON_INTRINSICS) && defined(__aarch64__)
+ #define SPU_HAVE_NEON 1
+ #include <arm_neon.h>
+#endif
+
 namespace MDFN_IEN_PSX
 {
 
@@ -90,8 +103,42 @@ static const int16 FIR_Table[256][4] =
  #include "spu_fir_table.inc"
 };
 
+// Stands in for the FIR_Table row of a voice in noise mode, with the noise sample in the first two taps' positions; the
+// dot product is then noise * 0x8000, which >> 15 leaves unchanged.
+static const int16 Noise_FIR[4] = { 0x4000, 0x4000, 0, 0 };
+
+//
+// Per-tick voice data for the mixing kernels, in SoA form.  Everything here is captured after the voice's decoder has run,
+// and before its sweep and envelope are clocked.
+//
+struct SPU_MixBatch
+{
+ alignas(16) int16 Samples[24][4];	// DecodeBuffer[DecodeReadPos + 0...3], or the noise sample twice.
+ alignas(16) int16 FIR[24][4];		// FIR_Table[] row for the voice's phase, or Noise_FIR.
+ alignas(16) int16 Env[24];		// (int16)ADSR.EnvLevel
+ alignas(16) int16 Vol[2][24];		// Sweep[].ReadVolume()
+ alignas(16) int16 ReverbMask[24];	// -1 if the voice is enabled in Reverb_Mode, 0 otherwise.
+};
+
+//
+// MixVoices() computes each voice's PreLRSample into pre[], and into mix[] the sums of the voices' left and right outputs, and
+// of those of the voices with reverb enabled.  Reverb4422() and Reverb2244() are the reverb input downsampler and output
+// upsampler filters(the latter for even output samples only).
+//
+struct SPU_Kernels
+{
+ const char* name;
+ void (*MixVoices)(const SPU_MixBatch* b, int32* pre, int32* mix);
+ int32 (*Reverb4422)(const int16* src);
+ int32 (*Reverb2244)(const int16* src);
+};
+
+static const SPU_Kernels* Kernels;
+
 PS_SPU::PS_SPU()
 {
+ SetSIMD(false);
+
  last_rate = -1;
  last_quality = ~0U;
 
@@ -586,6 +633,209 @@ INLINE uint16 PS_SPU::ReadSPURAM(uint32 addr)
 
 #include "spu_reverb.inc"
 
+static INLINE int32 MixVoice(const SPU_MixBatch* b, const unsigned v)
+{
+ const int16* s = b->Samples[v];
+ const int16* f = b->FIR[v];
+ const int32 pvs = ((s[0] * f[0]) + (s[1] * f[1]) + (s[2] * f[2]) + (s[3] * f[3])) >> 15;
+
+ return (pvs * b->Env[v]) >> 15;
+}
+
+static void MixVoices_C(const SPU_MixBatch* b, int32* pre, int32* mix)
+{
+ mix[0] = mix[1] = mix[2] = mix[3] = 0;
+
+ for(unsigned v = 0; v < 24; v++)
+ {
+  const int32 p = MixVoice(b, v);
+  const int32 l = (p * b->Vol[0][v]) >> 15;
+  const int32 r = (p * b->Vol[1][v]) >> 15;
+
+  pre[v] = p;
+  mix[0] += l;
+  mix[1] += r;
+  mix[2] += l & b->ReverbMask[v];
+  mix[3] += r & b->ReverbMask[v];
+ }
+}
+
+//
+// ResampTable laid out for the SIMD kernels: Reverb4422()'s taps on every other sample with the 0x4000 middle tap at 19, and
+// Reverb2244()'s taps padded to 24 with zeroes(the upsampler's source window is always at least 4 samples from the end of
+// RUSB[], so reading the padding is safe).
+//
+alignas(16) static const int16 ResampTable4422[40] =
+{
+ -1, 0, 2, 0, -10, 0, 35, 0, -103, 0, 266, 0, -616, 0, 1332, 0, -2960, 0, 10246, 0x4000,
+ 10246, 0, -2960, 0, 1332, 0, -616, 0, 266, 0, -103, 0, 35, 0, -10, 0, 2, 0, -1, 0
+};
+
+alignas(16) static const int16 ResampTable2244[24] =
+{
+ -1, 2, -10, 35, -103, 266, -616, 1332, -2960, 10246, 10246, -2960, 1332, -616, 266, -103, 35, -10, 2, -1,
+ 0, 0, 0, 0
+};
+
+//
+// The SIMD kernels must match the scalar kernels above bit-for-bit; SetSIMD() checks that before using them.
+//
+#if defined(SPU_HAVE_SSE2)
+ #pragma GCC push_options
+ #pragma GCC target("sse2")
+ #include "spu_sse2.inc"
+ #pragma GCC pop_options
+#endif
+
+#if defined(SPU_HAVE_NEON)
+ #include "spu_neon.inc"
+#endif
+
+static const SPU_Kernels Kernels_C = { "None", MixVoices_C, Reverb4422, Reverb2244<false> };
+#if defined(SPU_HAVE_SSE2)
+static const SPU_Kernels Kernels_SSE2 = { "SSE2", MixVoices_SSE2, Reverb4422_SSE2, Reverb2244_SSE2 };
+#endif
+#if defined(SPU_HAVE_NEON)
+static const SPU_Kernels Kernels_NEON = { "NEON", MixVoices_NEON, Reverb4422_NEON, Reverb2244_NEON };
+#endif
+
+static const SPU_Kernels* SIMDKernels = nullptr;	// Chosen by SetSIMD() the first time SIMD is enabled.
+
+//
+// Compares a kernel set against the scalar kernels on randomized voice batches and reverb buffers, and when the benchmark
+// driver asks for it, also reports the time per sample for both.
+//
+static MDFN_COLD bool TestKernels(const SPU_Kernels* ks)
+{
+ alignas(16) SPU_MixBatch batch;
+ alignas(16) int16 rbuf[128];
+ uint64 lcg = 0x2545F4914F6CDD1DULL;
+ auto rnd = [&]() { lcg = (lcg * 6364136223846793005ULL) + 1442695040888963407ULL; return (uint32)(lcg >> 32); };
+
+ for(unsigned iter = 0; iter < 4096; iter++)
+ {
+  // The first few iterations use the extremes of the sample, envelope, and volume ranges.
+  auto rs = [&]() -> int16 { return (iter < 4) ? ((iter & 1) ? 32767 : -32768) : (int16)rnd(); };
+
+  for(unsigned v = 0; v < 24; v++)
+  {
+   if((rnd() & 0x7) == 0)
+   {
+    batch.Samples[v][0] = batch.Samples[v][1] = rs();
+    batch.Samples[v][2] = batch.Samples[v][3] = 0;
+    memcpy(batch.FIR[v], Noise_FIR, sizeof(Noise_FIR));
+   }
+   else
+   {
+    for(unsigned i = 0; i < 4; i++)
+     batch.Samples[v][i] = (iter < 4) ? (((iter >> 1) ^ i) & 1 ? 32767 : -32768) : (int16)rnd();
+
+    memcpy(batch.FIR[v], FIR_Table[rnd() & 0xFF], sizeof(FIR_Table[0]));
+   }
+
+   batch.Env[v] = rs();
+   batch.Vol[0][v] = rs();
+   batch.Vol[1][v] = rs();
+   batch.ReverbMask[v] = (rnd() & 1) ? -1 : 0;
+  }
+
+  for(unsigned i = 0; i < 128; i++)
+   rbuf[i] = rs();
+  //
+  //
+  {
+   int32 pre[2][24];
+   int32 mix[2][4];
+
+   Kernels_C.MixVoices(&batch, pre[0], mix[0]);
+   ks->MixVoices(&batch, pre[1], mix[1]);
+
+   if(memcmp(pre[0], pre[1], sizeof(pre[0])) || memcmp(mix[0], mix[1], sizeof(mix[0])))
+    return false;
+  }
+
+  for(unsigned o = 0; o < 64; o++)
+  {
+   if(Kernels_C.Reverb4422(&rbuf[o]) != ks->Reverb4422(&rbuf[o]))
+    return false;
+
+   if(o < 32 && Kernels_C.Reverb2244(&rbuf[o]) != ks->Reverb2244(&rbuf[o]))
+    return false;
+  }
+ }
+
+ if(MDFNBench.Kernels)
+ {
+  const unsigned count = 65536;
+  double ns[2][2];
+
+  for(unsigned k = 0; k < 2; k++)
+  {
+   const SPU_Kernels* bks = k ? ks : &Kernels_C;
+   int32 pre[24] = { 0 };
+   int32 mix[4] = { 0 };
+   int32 out = 0;
+   int64 st;
+
+   st = Time::MonoNS();
+   for(unsigned i = 0; i < count; i++)
+   {
+    batch.Env[i % 24] += pre[i % 24] & 0x7;	// Feed the output back in, so the compiler can't hoist anything.
+    bks->MixVoices(&batch, pre, mix);
+   }
+   ns[k][0] = (double)(Time::MonoNS() - st) / count;
+
+   st = Time::MonoNS();
+   for(unsigned i = 0; i < count; i++)
+   {
+    rbuf[i & 0x3F] += out & 0x7;
+    out = bks->Reverb4422(&rbuf[i & 0x3F]) + bks->Reverb2244(&rbuf[i & 0x1F]);
+   }
+   ns[k][1] = (double)(Time::MonoNS() - st) / count;
+  }
+
+  MDFN_printf(_("SPU %s kernels: voice mixing %.1f ns/sample(scalar %.1f), reverb resampling %.1f ns/sample(scalar %.1f)\n"), ks->name, ns[1][0], ns[0][0], ns[1][1], ns[0][1]);
+ }
+
+ return true;
+}
+
+void PS_SPU::SetSIMD(const bool enable)
+{
+ if(enable && !SIMDKernels)
+ {
+  const SPU_Kernels* candidates[2];
+  unsigned count = 0;
+
+#if defined(SPU_HAVE_SSE2)
+  if(cputest_get_flags() & CPUTEST_FLAG_SSE2)
+   candidates[count++] = &Kernels_SSE2;
+#endif
+
+#if defined(SPU_HAVE_NEON)
+  // cputest doesn't detect NEON; HAVE_NEON_INTRINSICS means the compiler was told it's always available.
+  candidates[count++] = &Kernels_NEON;
+#endif
+
+  SIMDKernels = &Kernels_C;
+
+  for(unsigned i = 0; i < count; i++)
+  {
+   if(TestKernels(candidates[i]))
+   {
+    SIMDKernels = candidates[i];
+    break;
+   }
+
+   MDFN_printf(_("WARNING: SPU %s kernels don't match the scalar kernels; not using them.\n"), candidates[i]->name);
+  }
+
+  MDFN_printf(_("SPU SIMD: %s\n"), SIMDKernels->name);
+ }
+
+ Kernels = enable ? SIMDKernels : &Kernels_C;
+}
+
 INLINE void PS_SPU::RunNoise(void)
 {
  const unsigned rf = ((SPUControl >> 8) & 0x3F);
@@ -627,6 +877,8 @@ int32 PS_SPU::UpdateFromCDC(int32 clocks)
   sample_clocks++;
  }
 
+ MDFN_BenchScope bs(MDFN_BENCH_SOUND, sample_clocks > 0);
+
  while(sample_clocks > 0)
  {
   // xxx[0] = left, xxx[1] = right
@@ -643,6 +895,10 @@ int32 PS_SPU::UpdateFromCDC(int32 clocks)
   // Final output.
   int32 output[2] = { 0, 0 };
 
+  alignas(16) SPU_MixBatch batch;
+  int32 pre[24];
+  int32 mix[4];
+
   const uint32 PhaseModCache = FM_Mode & ~ 1;
 /*
 **
@@ -676,12 +932,13 @@ int32 PS_SPU::UpdateFromCDC(int32 clocks)
   if(Regs[0xD6] == 0x4)	// TODO: Investigate more(case 0x2C in global regs r/w handler)
    SPUStatus |= (CWA & 0x100) ? 0x800 : 0x000;
 
+  //
+  // Run the decoders in voice order first, since voices 1 and 3 write their output to SPU RAM where a later voice's decoder
+  // could read it.  Interpolation, enveloping, and volume for all 24 voices then run as one batch.
+  //
   for(int voice_num = 0; voice_num < 24; voice_num++)
   {
    SPU_Voice *voice = &Voices[voice_num];
-   int32 voice_pvs;
-
-   voice->PreLRSample = 0;
 
    //PSX_WARNING("[SPU] Voice %d CurPhase=%08x, pitch=%04x, CurAddr=%08x", voice_num, voice->CurPhase, voice->Pitch, voice->CurAddr);
 
@@ -699,43 +956,48 @@ int32 PS_SPU::UpdateFromCDC(int32 clocks)
    //
    //
    //
-   int l, r;
-
    if(Noise_Mode & (1 << voice_num))
-    voice_pvs = (int16)LFSR;
+   {
+    batch.Samples[voice_num][0] = batch.Samples[voice_num][1] = (int16)LFSR;
+    batch.Samples[voice_num][2] = batch.Samples[voice_num][3] = 0;
+    memcpy(batch.FIR[voice_num], Noise_FIR, sizeof(Noise_FIR));
+   }
    else
    {
     const int si = voice->DecodeReadPos;
     const int pi = ((voice->CurPhase & 0xFFF) >> 4);
 
-    voice_pvs = ((voice->DecodeBuffer[(si + 0) & 0x1F] * FIR_Table[pi][0]) +
-	         (voice->DecodeBuffer[(si + 1) & 0x1F] * FIR_Table[pi][1]) +
-	         (voice->DecodeBuffer[(si + 2) & 0x1F] * FIR_Table[pi][2]) +   
- 	         (voice->DecodeBuffer[(si + 3) & 0x1F] * FIR_Table[pi][3])) >> 15;
+    for(unsigned i = 0; i < 4; i++)
+     batch.Samples[voice_num][i] = voice->DecodeBuffer[(si + i) & 0x1F];
+
+    memcpy(batch.FIR[voice_num], FIR_Table[pi], sizeof(FIR_Table[pi]));
    }
 
-   voice_pvs = (voice_pvs * (int16)voice->ADSR.EnvLevel) >> 15;
-   voice->PreLRSample = voice_pvs;
+   batch.Env[voice_num] = (int16)voice->ADSR.EnvLevel;
+   batch.Vol[0][voice_num] = voice->Sweep[0].ReadVolume();
+   batch.Vol[1][voice_num] = voice->Sweep[1].ReadVolume();
+   batch.ReverbMask[voice_num] = (Reverb_Mode & (1 << voice_num)) ? -1 : 0;
 
    if(voice_num == 1 || voice_num == 3)
    {
     int index = voice_num >> 1;
 
-    WriteSPURAM(0x400 | (index * 0x200) | CWA, voice_pvs);
+    WriteSPURAM(0x400 | (index * 0x200) | CWA, MixVoice(&batch, voice_num));
    }
+  }
 
+  Kernels->MixVoices(&batch, pre, mix);
 
-   l = (voice_pvs * voice->Sweep[0].ReadVolume()) >> 15;
-   r = (voice_pvs * voice->Sweep[1].ReadVolume()) >> 15;
+  accum[0] = mix[0];
+  accum[1] = mix[1];
+  accum_fv[0] = mix[2];
+  accum_fv[1] = mix[3];
 
-   accum[0] += l;
-   accum[1] += r;
+  for(int voice_num = 0; voice_num < 24; voice_num++)
+  {
+   SPU_Voice *voice = &Voices[voice_num];
 
-   if(Reverb_Mode & (1 << voice_num))
-   {
-    accum_fv[0] += l;
-    accum_fv[1] += r;
-   }
+   voice->PreLRSample = pre[voice_num];
 
    // Run sweep
    for(int lr = 0; lr < 2; lr++)
@@ -125,6 +125,11 @@ class PS_SPU
  void StateAction(StateMem *sm, const unsigned load, const bool data_only);
 
  void Power(void) MDFN_COLD;
+
+ // Mixes voices and runs the reverb resampling filters with SSE2 or NEON kernels, if available and if they pass a check
+ // against the scalar kernels the first time this is called with enable = true.  Output is the same either way.
+ void SetSIMD(const bool enable) MDFN_COLD;
+
  void Write(pscpu_timestamp_t timestamp, uint32 A, uint16 V);
  uint16 Read(pscpu_timestamp_t timestamp, uint32 A);
 
@@ -1138,6 +1138,15 @@ EXPORT int speex_resampler_reset_mem(SpeexResamplerState *st)
    return RESAMPLER_ERR_SUCCESS;
 }
 
+EXPORT void speex_resampler_get_stream_state(SpeexResamplerState *st, void **mem, spx_uint32_t *mem_size, spx_int32_t **last_sample, spx_uint32_t **samp_frac_num, spx_uint32_t **magic_samples)
+{
+   *mem = st->mem;
+   *mem_size = st->nb_channels*st->mem_alloc_size*sizeof(spx_word16_t);
+   *last_sample = st->last_sample;
+   *samp_frac_num = st->samp_frac_num;
+   *magic_samples = st->magic_samples;
+}
+
 EXPORT const char *speex_resampler_strerror(int err)
 {
    switch (err)
@@ -82,6 +82,7 @@
 #define speex_resampler_get_output_latency CAT_PREFIX(RANDOM_PREFIX,_resampler_get_output_latency)
 #define speex_resampler_skip_zeros CAT_PREFIX(RANDOM_PREFIX,_resampler_skip_zeros)
 #define speex_resampler_reset_mem CAT_PREFIX(RANDOM_PREFIX,_resampler_reset_mem)
+#define speex_resampler_get_stream_state CAT_PREFIX(RANDOM_PREFIX,_resampler_get_stream_state)
 #define speex_resampler_strerror CAT_PREFIX(RANDOM_PREFIX,_resampler_strerror)
 
 #define spx_int16_t short
@@ -334,6 +335,15 @@ int speex_resampler_skip_zeros(SpeexResamplerState *st);
  */
 int speex_resampler_reset_mem(SpeexResamplerState *st);
 
+/** Get the resampler's stream state(filter memory and per-channel position), e.g. to save and later restore it.
+ * The pointers stay valid until the rate or quality is changed.
+ * @param st Resampler state
+ * @param mem Filter memory
+ * @param mem_size Size of the filter memory, in bytes
+ * @param last_sample, samp_frac_num, magic_samples Per-channel position(nb_channels elements each)
+ */
+void speex_resampler_get_stream_state(SpeexResamplerState *st, void **mem, spx_uint32_t *mem_size, spx_int32_t **last_sample, spx_uint32_t **samp_frac_num, spx_uint32_t **magic_samples);
+
 /** Returns the English meaning for an error code
  * @param err Error code
  * @return English string
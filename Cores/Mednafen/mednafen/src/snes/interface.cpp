@@ -989,6 +989,56 @@ static void Emulate(EmulateSpecStruct *espec)
 #endif
 }
 
+// Samples not yet consumed by the output resampler, and the resampler's stream state; see MDFNGI::SoundOutputStateAction.
+static void SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(ResampInPos),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, StateRegs, "SNDOUT");
+
+ if(load)
+ {
+  if(ResampInPos < 0)
+   ResampInPos = 0;
+  else if(ResampInPos > 2048)
+   ResampInPos = 2048;
+ }
+
+ SFORMAT BufStateRegs[] =
+ {
+  SFPTR16(&ResampInBuffer[0][0], ResampInPos * 2),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, true, BufStateRegs, "SNDOUT_BUF");
+
+ if(resampler)
+ {
+  void* mem;
+  spx_uint32_t mem_size;
+  spx_int32_t* last_sample;
+  spx_uint32_t* samp_frac_num;
+  spx_uint32_t* magic_samples;
+
+  speex_resampler_get_stream_state(resampler, &mem, &mem_size, &last_sample, &samp_frac_num, &magic_samples);
+
+  SFORMAT ResampStateRegs[] =
+  {
+   SFPTR8N((uint8*)mem, mem_size, "mem"),
+   SFPTR32N((uint32*)last_sample, 2, "last_sample"),
+   SFPTR32N(samp_frac_num, 2, "samp_frac_num"),
+   SFPTR32N(magic_samples, 2, "magic_samples"),
+   SFEND
+  };
+
+  MDFNSS_StateAction(sm, load, true, ResampStateRegs, "SNDOUT_RESAMP");
+ }
+}
+
 static void StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
  const uint32 length = bSNES_v059::system.serialize_size();
@@ -1402,6 +1452,8 @@ MDFN_HIDE extern const MDFNGI EmulatedSNES =
  512,	// Framebuffer height
 
  2,     // Number of output sound channels
+
+ SoundOutputStateAction,
 };
 
 
@@ -637,6 +637,11 @@ void APU_Kill(void)
  DSP_Kill();
 }
 
+void APU_SoundOutputStateAction(StateMem* sm, const unsigned load)
+{
+ DSP_SoundOutputStateAction(sm, load);
+}
+
 void APU_StateAction(StateMem* sm, const unsigned load, const bool data_only)
 {
  SFORMAT StateRegs[] =
@@ -37,6 +37,7 @@ uint32 APU_UpdateGetResampBufPos(uint32 master_timestamp);	// for MSU1
 void APU_SetSPC(SPCReader* s) MDFN_COLD;	// Call after APU_Reset()
 
 void APU_StateAction(StateMem* sm, const unsigned load, const bool data_only);
+void APU_SoundOutputStateAction(StateMem* sm, const unsigned load);
 //
 //
 //
@@ -685,6 +685,16 @@ void MSU1_Reset(bool powering_up)
 
 }
 
+// Output resampler state, between frames; see MDFNGI::SoundOutputStateAction.
+void MSU1_SoundOutputStateAction(StateMem* sm, const unsigned load)
+{
+ if(!Active)
+  return;
+
+ ResampBuf[0].StateAction(sm, load, true, "SNDOUT_MSU1_L", 0);
+ ResampBuf[1].StateAction(sm, load, true, "SNDOUT_MSU1_R", 0);
+}
+
 void MSU1_StateAction(StateMem* sm, const unsigned load, const bool data_only)
 {
  if(!Active)
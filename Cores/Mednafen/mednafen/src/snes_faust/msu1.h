@@ -31,6 +31,7 @@ namespace MDFN_IEN_SNES_FAUST
  void MSU1_Kill(void) MDFN_COLD;
  void MSU1_Reset(bool powering_up) MDFN_COLD;
  void MSU1_StateAction(StateMem* sm, const unsigned load, const bool data_only);
+ void MSU1_SoundOutputStateAction(StateMem* sm, const unsigned load);
 
  void MSU1_StartFrame(double master_clock, double rate, int32 apu_clock_multiplier, int32 resamp_num, int32 resamp_denom, bool resamp_clear_buf);
  void MSU1_EndFrame(int16* SoundBuf, int32 SoundBufSize);
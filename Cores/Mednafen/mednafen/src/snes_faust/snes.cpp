@@ -1125,6 +1125,14 @@ static MDFN_COLD void DoSimpleCommand(int cmd)
  }
 }
 
+static void SoundOutputStateAction(StateMem *sm, const unsigned load)
+{
+ APU_SoundOutputStateAction(sm, load);
+
+ if(!spc_reader)
+  MSU1_SoundOutputStateAction(sm, load);
+}
+
 static void StateAction(StateMem *sm, const unsigned load, const bool data_only)
 {
  if(spc_reader)
@@ -1407,5 +1415,7 @@ MDFN_HIDE extern const MDFNGI EmulatedSNES_Faust =
  //
 
  2,     // Number of output sound channels
+
+ SoundOutputStateAction,
 };
 
@@ -1,5 +1,7 @@
 // Blip_Buffer 0.4.1. http://www.slack.net/~ant/
 
+#include <mednafen/mednafen.h>
+#include <mednafen/state.h>
 #include "Blip_Buffer.h"
 
 #include <assert.h>
@@ -164,6 +166,42 @@ void Blip_Buffer::remove_silence( long count )
 	offset_ -= (blip_resampled_time_t) count << BLIP_BUFFER_ACCURACY;
 }
 
+void Blip_Buffer::StateAction( Mednafen::StateMem* sm, unsigned load, bool data_only, const char* sname )
+{
+	using namespace Mednafen;
+	
+	// Everything past count is zero between time frames.
+	long const prev_count = buffer_ ? samples_avail() + blip_buffer_extra_ : 0;
+	
+	SFORMAT StateRegs [] =
+	{
+		SFVAR( offset_ ),
+		SFVAR( reader_accum_ ),
+		SFVAR( modified_ ),
+		SFEND
+	};
+	
+	MDFNSS_StateAction( sm, load, data_only, StateRegs, sname );
+	
+	if ( load && samples_avail() > buffer_size_ )
+		offset_ = (blip_resampled_time_t) buffer_size_ << BLIP_BUFFER_ACCURACY;
+	
+	long const count = buffer_ ? samples_avail() + blip_buffer_extra_ : 0;
+	char buf_sname [64];
+	snprintf( buf_sname, sizeof buf_sname, "%s_BUF", sname );
+	
+	SFORMAT StateRegs_Buf [] =
+	{
+		SFPTR32N( buffer_, count, "buffer" ),
+		SFEND
+	};
+	
+	MDFNSS_StateAction( sm, load, data_only, StateRegs_Buf, buf_sname );
+	
+	if ( load && count < prev_count )
+		memset( buffer_ + count, 0, (prev_count - count) * sizeof *buffer_ );
+}
+
 long Blip_Buffer::count_samples( blip_time_t t ) const
 {
 	unsigned long last_sample  = resampled_time( t ) >> BLIP_BUFFER_ACCURACY;
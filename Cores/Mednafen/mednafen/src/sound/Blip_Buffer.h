@@ -27,6 +27,8 @@ typedef blip_long blip_time_t;
 typedef short blip_sample_t;
 enum { blip_sample_max = 32767 };
 
+namespace Mednafen { struct StateMem; }
+
 class Blip_Buffer {
 public:
 	typedef const char* blargg_err_t;
@@ -98,6 +100,10 @@ public:
 	blip_resampled_time_t resampled_duration( int t ) const     { return t * factor_; }
 	blip_resampled_time_t resampled_time( blip_time_t t ) const { return t * factor_ + offset_; }
 	blip_resampled_time_t clock_rate_factor( long clock_rate ) const;
+	
+	// Save or load(load nonzero) the samples waiting to be read and those partly synthesized past them. Only valid
+	// between time frames, after end_frame() and before anything is added for the next one.
+	void StateAction( Mednafen::StateMem* sm, unsigned load, bool data_only, const char* sname );
 public:
 	Blip_Buffer();
 	~Blip_Buffer();
@@ -265,6 +265,20 @@ void RavenBuffer::Finish(unsigned count)
  memset(&BB[OwlBuffer::HRBUF_OVERFLOW_PADDING], 0, count * sizeof(BB[0]));
 }
 
+// Only valid between frames, after Finish(), when nothing but the deltas dangling off the end of the previous frame remains.
+void RavenBuffer::StateAction(StateMem* sm, const unsigned load, const bool data_only, const char* sname)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(accum),
+  SFVAR(filter_state),
+  SFPTR32(BB, OwlBuffer::HRBUF_OVERFLOW_PADDING),
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, data_only, StateRegs, sname);
+}
+
 static INLINE void DoMAC(float *wave, float *coeffs, int32 count, int32 *accum_output)
 {
  float acc[4] = { 0, 0, 0, 0 };
@@ -85,6 +85,8 @@ class RavenBuffer
  void Process(unsigned count, bool integrate = true, uint32 lp_shift = 0);
  void Finish(unsigned count);
 
+ void StateAction(StateMem* sm, const unsigned load, const bool data_only, const char* sname);
+
  friend class OwlBuffer;
 
  private:
@@ -1,6 +1,8 @@
 
 // Blip_Buffer 0.3.0. http://www.slack.net/~ant/nes-emu/
 
+#include <mednafen/mednafen.h>
+#include <mednafen/state.h>
 #include "Stereo_Buffer.h"
 
 /* Library Copyright (C) 2004 Shay Green. Blip_Buffer is free software;
@@ -100,6 +102,27 @@ long Stereo_Buffer::read_samples( blip_sample_t* out, long max_samples )
 	return count * 2;
 }
 
+void Stereo_Buffer::StateAction( Mednafen::StateMem* sm, unsigned load, bool data_only, const char* sname )
+{
+	using namespace Mednafen;
+	
+	SFORMAT StateRegs [] =
+	{
+		SFVAR( stereo_added ),
+		SFVAR( was_stereo ),
+		SFEND
+	};
+	
+	MDFNSS_StateAction( sm, load, data_only, StateRegs, sname );
+	
+	for ( int i = 0; i < buf_count; i++ )
+	{
+		char buf_sname [64];
+		snprintf( buf_sname, sizeof buf_sname, "%s_%d", sname, i );
+		bufs [i].StateAction( sm, load, data_only, buf_sname );
+	}
+}
+
 void Stereo_Buffer::mix_stereo( blip_sample_t* out, long count )
 {
 	Blip_Reader l_left; 
@@ -35,6 +35,9 @@ public:
 	long samples_avail() const;
 	long read_samples( blip_sample_t*, long );
 	
+	// Same as in Blip_Buffer
+	void StateAction( Mednafen::StateMem* sm, unsigned load, bool data_only, const char* sname );
+	
 private:
 	// noncopyable
 	Stereo_Buffer( const Stereo_Buffer& );
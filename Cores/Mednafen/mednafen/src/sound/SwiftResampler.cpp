@@ -41,6 +41,7 @@
 */
 
 #include <mednafen/mednafen.h>
+#include <mednafen/state.h>
 #include "DSPUtility.h"
 #include "SwiftResampler.h"
 #include <mednafen/cputest/cputest.h>
@@ -213,6 +214,28 @@ SwiftResampler::~SwiftResampler()
 
 }
 
+void SwiftResampler::StateAction(StateMem* sm, const unsigned load, const bool data_only, const char* sname)
+{
+ SFORMAT StateRegs[] =
+ {
+  SFVAR(InputIndex),
+  SFVAR(InputPhase),
+  SFVAR(debias),
+
+  SFEND
+ };
+
+ MDFNSS_StateAction(sm, load, data_only, StateRegs, sname);
+
+ if(load)
+ {
+  InputPhase %= NumPhases;
+
+  if(InputIndex > MaxLeftover)
+   InputIndex = 0;
+ }
+}
+
 void SwiftResampler::SetVolume(double newvolume)
 {
  SoundVolume = (int32)(newvolume * 256);
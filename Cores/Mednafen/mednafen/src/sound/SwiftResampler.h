@@ -30,6 +30,9 @@ class SwiftResampler
 	// Specify volume in percent amplitude(range 0 through 1.000..., inclusive).  Default: SetVolume(1.0);
 	void SetVolume(double newvolume);
 
+	// Saves/loads the filter position and DC bias state; the caller is responsible for the leftover input samples.
+	void StateAction(StateMem* sm, const unsigned load, const bool data_only, const char* sname);
+
 	// Resamples "inlen" samples from "in", writing the output "out", generating no more output samples than "maxoutlen".
 	// The int32 pointed to by leftover is set to the number of input samples left over from this filter iteration.
 	// "in" should be aligned to a 16-byte boundary, for the SIMD versions of the filter to work properly.  "out" doesn't have any
@@ -462,6 +462,36 @@ uint32 DB_LookupHH(const char* sgid, const uint8* fd_id)
  return 0;
 }
 
+//
+// Games that rely on tight master/slave SH-2 timing, and so must not run the slave SH-2 on a separate
+// thread(ss.slave_thread).
+//
+static const struct
+{
+ const char* sgid;
+ const char* game_name;
+ const char* purpose;
+ uint8 fd_id[16];
+} sltdb[] =
+{
+ { "GS-9126",	"Fighters Megamix (Japan)", gettext_noop("Avoids hang after watching or aborting FMV playback.") },
+ { "MK-81073",	"Fighters Megamix (Europe/USA)", gettext_noop("Avoids hang after watching or aborting FMV playback.") },
+
+ { "T-6006G",	"Thunderhawk II (Japan)", gettext_noop("Avoids hangs just before and during gameplay.") },
+ { "T-11501H00","Thunderstrike II (USA)", gettext_noop("Avoids hangs just before and during gameplay.") },
+};
+
+bool DB_LookupSlaveLockstep(const char* sgid, const uint8* fd_id)
+{
+ for(auto& slt : sltdb)
+ {
+  if((slt.sgid && !strcmp(slt.sgid, sgid)) || (!slt.sgid && !memcmp(slt.fd_id, fd_id, 16)))
+   return true;
+ }
+
+ return false;
+}
+
 static std::string FDIDToString(const uint8 (&fd_id)[16])
 {
  return MDFN_sprintf("%02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x %02x", fd_id[0], fd_id[1], fd_id[2], fd_id[3], fd_id[4], fd_id[5], fd_id[6], fd_id[7], fd_id[8], fd_id[9], fd_id[10], fd_id[11], fd_id[12], fd_id[13], fd_id[14], fd_id[15]);
@@ -632,6 +662,26 @@ void DB_GetInternalDB(std::vector<GameDB_Database>* databases)
   e.Setting = sv;
   e.Purpose = hh.purpose ? _(hh.purpose) : "";
 
+  databases->back().Entries.push_back(e);
+ }
+ //
+ //
+ //
+ databases->push_back({
+	"slavelockstep",
+	gettext_noop("Slave SH-2 Lockstep"),
+	gettext_noop("This database is used to keep the slave SH-2 in lockstep with the master SH-2, on the emulation thread, in games that are sensitive to inter-CPU timing, when the \"ss.slave_thread\" setting is enabled.")
+	});
+ for(auto& slt : sltdb)
+ {
+  GameDB_Entry e;
+
+  e.GameID = slt.sgid ? slt.sgid : FDIDToString(slt.fd_id);
+  e.GameIDIsHash = !slt.sgid;
+  e.Name = slt.game_name;
+  e.Setting = _("Lockstep");
+  e.Purpose = slt.purpose ? _(slt.purpose) : "";
+
   databases->back().Entries.push_back(e);
  }
 }
@@ -35,6 +35,7 @@ enum
 
 void DB_Lookup(const char* path, const char* sgid, const char* sgname, const char* sgarea, const uint8* fd_id, unsigned* const region, int* const cart_type, unsigned* const cpucache_emumode);
 uint32 DB_LookupHH(const char* sgid, const uint8* fd_id);
+bool DB_LookupSlaveLockstep(const char* sgid, const uint8* fd_id);
 void DB_GetInternalDB(std::vector<GameDB_Database>* databases) MDFN_COLD;
 std::string DB_GetHHDescriptions(const uint32 hhv) MDFN_COLD;
 
@@ -487,6 +487,13 @@ class SH7095 final
  template<bool SlavePenalty, typename T>
  INLINE void ExtBusWrite_INLINE(uint32 A, T V);
 
+ // High/low work RAM accesses by the slave CPU when running on its own thread.
+ template<typename T, bool BurstHax>
+ INLINE T ExtRAMRead_ST(uint32 A);
+
+ template<typename T>
+ INLINE void ExtRAMWrite_ST(uint32 A, T V);
+
  template<typename T>
  NO_INLINE void OnChipRegWrite(uint32 A, uint32 V) MDFN_HOT;
 
@@ -30,8 +30,11 @@
 #include <mednafen/hash/sha256.h>
 #include <mednafen/hash/md5.h>
 #include <mednafen/Time.h>
+#include <mednafen/MThreading.h>
 
 #include <bitset>
+#include <atomic>
+#include <thread>
 
 #include <trio/trio.h>
 
@@ -125,6 +128,49 @@ static uintptr_t SH7095_FastMap[1U << (32 - SH7095_EXT_MAP_GRAN_BITS)];
 int32 SH7095_mem_timestamp;
 static uint32 SH7095_BusLock;
 static uint32 SH7095_DB;
+
+//
+// Slave SH-2 thread(see slave_thread.inc).  SH7095_SlaveThreaded is only true while the slave CPU is executing on
+// its own host thread, during which its high/low work RAM accesses are timed against SH7095_SlaveMemTS instead of
+// SH7095_mem_timestamp.
+//
+static bool SH7095_SlaveThreaded;
+static int32 SH7095_SlaveMemTS;
+#define SH7095_MEMTS(w) (((w) && SH7095_SlaveThreaded) ? SH7095_SlaveMemTS : SH7095_mem_timestamp)
+
+static void SST_Park_Sub(void);
+static void SST_Lock(void);
+static void SST_Unlock(void);
+template<typename T, bool BurstHax> static T SST_ExtBusRead(uint32 A);
+template<typename T> static void SST_ExtBusWrite(uint32 A, T V);
+
+// Call before modifying slave CPU state, or anything else the slave CPU might access without the bus lock, from the
+// master thread.
+static INLINE void SST_Park(void)
+{
+ if(MDFN_UNLIKELY(SH7095_SlaveThreaded))
+  SST_Park_Sub();
+}
+
+// For instructions that must be atomic with respect to the other CPU(TAS.B), and slave SH-2 DMA register writes.
+template<unsigned which>
+static INLINE void SST_LockBus(void)
+{
+ if(MDFN_UNLIKELY(SH7095_SlaveThreaded))
+ {
+  if(which)
+   SST_Lock();
+  else
+   SST_Park_Sub();
+ }
+}
+
+template<unsigned which>
+static INLINE void SST_UnlockBus(void)
+{
+ if(which && MDFN_UNLIKELY(SH7095_SlaveThreaded))
+  SST_Unlock();
+}
 #include "scu.inc"
 
 #include "debug.inc"
@@ -280,6 +326,9 @@ static INLINE void BusRW_DB_CS0(const uint32 A, uint32& DB, const bool BurstHax,
    {
     const unsigned c = ((A >> 23) & 1) ^ 1;
 
+    if(c)
+     SST_Park();
+
     CPU[c].SetFTI(true);
     CPU[c].SetFTI(false);
    }
@@ -343,6 +392,8 @@ static MDFN_COLD void CheatMemWrite(uint32 A, uint8 V)
 
  if(FMIsWriteable[A >> SH7095_EXT_MAP_GRAN_BITS])
  {
+  SST_Park();
+  VDP1::Sync();
   ne16_wbo_be<uint8>(SH7095_FastMap[A >> SH7095_EXT_MAP_GRAN_BITS], A, V);
 
   for(unsigned c = 0; c < 2; c++)
@@ -412,6 +463,7 @@ void SS_SetPhysMemMap(uint32 Astart, uint32 Aend, uint16* ptr, uint32 length, bo
 }
 
 #include "sh7095.inc"
+#include "slave_thread.inc"
 
 //
 // Running is:
@@ -442,6 +494,9 @@ static sscpu_timestamp_t SH_DMA_EventHandler(sscpu_timestamp_t et)
  if(MDFN_UNLIKELY(SH7095_BusLock))
   return et + 1;
 
+ if(c)
+  SST_Park();
+
  return CPU[c].DMA_Update(et);
 }
 
@@ -628,6 +683,11 @@ void SS_RequestMLExit(void)
  next_event_ts = 0;
 }
 
+void SS_ParkSlaveThread(void)
+{
+ SST_Park();
+}
+
 #pragma GCC push_options
 #pragma GCC optimize("O2,no-unroll-loops,no-peel-loops,no-crossjumping")
 template<bool EmulateICache, bool DebugMode>
@@ -702,6 +762,48 @@ static NO_INLINE MDFN_COLD int32 RunLoop_Debug(EmulateSpecStruct* espec)
  return RunLoop_INLINE<EmulateICache, true>(espec);
 }
 
+//
+// Slave SH-2 on its own thread; see slave_thread.inc
+//
+static NO_INLINE MDFN_HOT int32 RunLoop_ST(EmulateSpecStruct* espec)
+{
+ sscpu_timestamp_t eff_ts = 0;
+
+ for(unsigned c = 0; c < 2; c++)
+  CPU[c].SetDebugMode(false);
+
+ do
+ {
+  SST_Stop();
+  SMPC_ProcessSlaveOffOn();
+  //
+  //
+  Running = true;
+  ForceEventUpdates(eff_ts);
+  SST_Start(eff_ts);
+  do
+  {
+   do
+   {
+    CPU[0].Step<0, false, false>();
+    CPU[0].DMA_BusTimingKludge();
+
+    SST_MasterSync(CPU[0].timestamp);
+
+    eff_ts = CPU[0].timestamp;
+    if(SH7095_mem_timestamp > eff_ts)
+     eff_ts = SH7095_mem_timestamp;
+    else
+     SH7095_mem_timestamp = eff_ts;
+   } while(MDFN_LIKELY(eff_ts < next_event_ts));
+  } while(MDFN_LIKELY(EventHandler(eff_ts)));
+ } while(MDFN_LIKELY(Running != 0));
+
+ SST_Stop();
+
+ return eff_ts;
+}
+
 #pragma GCC pop_options
 
 // Must not be called within an event or read/write handler.
@@ -811,7 +913,10 @@ static void Emulate(EmulateSpecStruct* espec_arg)
   { RunLoop<true>,  RLTDAT(true)  },	// EmulateICache=true
  };
 #undef RLTDAT
- end_ts = rltab[NeedEmuICache][DBG_NeedCPUHooks()](espec);
+ if(SST.Enabled && !DBG_NeedCPUHooks())
+  end_ts = RunLoop_ST(espec);
+ else
+  end_ts = rltab[NeedEmuICache][DBG_NeedCPUHooks()](espec);
  assert(end_ts >= 0);
  ForceEventUpdates(end_ts);
  //
@@ -900,6 +1005,7 @@ static void Emulate(EmulateSpecStruct* espec_arg)
 
 static MDFN_COLD void Cleanup(void)
 {
+ SST_Kill();
  CART_Kill();
 
  DBG_Kill();
@@ -1124,7 +1230,7 @@ static MDFN_COLD bool DetectRegionByFN(const std::string& fn, unsigned* const re
  return false;
 }
 #endif
-static void MDFN_COLD InitCommon(const unsigned cpucache_emumode, const unsigned horrible_hacks, const unsigned cart_type, const unsigned smpc_area, Stream* dbg_cart_rom_stream)
+static void MDFN_COLD InitCommon(const unsigned cpucache_emumode, const unsigned horrible_hacks, const bool slave_lockstep, const unsigned cart_type, const unsigned smpc_area, Stream* dbg_cart_rom_stream)
 {
  const char* cart_rom_path_sname = nullptr;
 
@@ -1223,6 +1329,27 @@ static void MDFN_COLD InitCommon(const unsigned cpucache_emumode, const unsigned
  SH7095_mem_timestamp = 0;
  SH7095_DB = 0;
 
+ {
+  bool sst_enable = false;
+
+  if(MDFN_GetSettingB("ss.slave_thread"))
+  {
+   if(cpucache_emumode != CPUCACHE_EMUMODE_DATA)
+    MDFN_printf(_("Slave SH-2 thread: Disabled due to CPU cache emulation mode.\n"));
+   else if(slave_lockstep)
+    MDFN_printf(_("Slave SH-2 thread: Disabled due to game database entry.\n"));
+   else if(std::thread::hardware_concurrency() == 1)
+    MDFN_printf(_("Slave SH-2 thread: Disabled due to only one host CPU being available.\n"));
+   else
+   {
+    sst_enable = true;
+    MDFN_printf(_("Slave SH-2 thread: Enabled, max lag %u cycles.\n"), (unsigned)MDFN_GetSettingUI("ss.slave_thread.max_lag"));
+   }
+  }
+
+  SST_Init(sst_enable, MDFN_GetSettingUI("ss.slave_thread.max_lag"), MDFN_GetSettingUI("ss.affinity.sh2s"));
+ }
+
  ss_horrible_hacks = horrible_hacks;
 
  //
@@ -1331,7 +1458,22 @@ static void MDFN_COLD InitCommon(const unsigned cpucache_emumode, const unsigned
 
  SCU_Init();
  SMPC_Init(smpc_area, MasterClock);
- VDP1::Init();
+ {
+  bool vdp1_thread = false;
+
+  if(MDFN_GetSettingB("ss.vdp1_thread"))
+  {
+   if(std::thread::hardware_concurrency() == 1)
+    MDFN_printf(_("VDP1 drawing thread: Disabled due to only one host CPU being available.\n"));
+   else
+   {
+    vdp1_thread = true;
+    MDFN_printf(_("VDP1 drawing thread: Enabled.\n"));
+   }
+  }
+
+  VDP1::Init(vdp1_thread, MDFN_GetSettingUI("ss.affinity.vdp1"));
+ }
  VDP2::Init(PAL, vdp2_affinity);
  CDB_Init();
  SOUND_Init();
@@ -1517,7 +1659,7 @@ static MDFN_COLD void Load(GameFile* gf)
     horrible_hacks |= dhhse;
   }
 
-  InitCommon(MDFN_GetSettingUI("ss.dbg_exe_cem"), horrible_hacks, CART_MDFN_DEBUG, MDFN_GetSettingUI("ss.region_default"), gf->stream);
+  InitCommon(MDFN_GetSettingUI("ss.dbg_exe_cem"), horrible_hacks, false, CART_MDFN_DEBUG, MDFN_GetSettingUI("ss.region_default"), gf->stream);
  }
  catch(...)
  {
@@ -1612,6 +1754,7 @@ static MDFN_COLD void LoadCD(std::vector<CDInterface*>* CDInterfaces)
   int cart_type;
   unsigned cpucache_emumode;
   unsigned horrible_hacks;
+  bool slave_lockstep;
   uint8 fd_id[16];
   char sgid[16 + 1] = { 0 };
   char sgname[0x70 + 1] = { 0 };
@@ -1630,6 +1773,7 @@ static MDFN_COLD void LoadCD(std::vector<CDInterface*>* CDInterfaces)
   DetectRegion(&region);
   DB_Lookup(nullptr, sgid, sgname, sgarea, fd_id, &region, &cart_type, &cpucache_emumode);
   horrible_hacks = DB_LookupHH(sgid, fd_id);
+  slave_lockstep = DB_LookupSlaveLockstep(sgid, fd_id);
   //
   if(!MDFN_GetSettingB("ss.region_autodetect"))
    region = region_default;
@@ -1644,7 +1788,7 @@ static MDFN_COLD void LoadCD(std::vector<CDInterface*>* CDInterfaces)
 
    // TODO: auth ID calc
 
-  InitCommon(cpucache_emumode, horrible_hacks, cart_type, region, nullptr);
+  InitCommon(cpucache_emumode, horrible_hacks, slave_lockstep, cart_type, region, nullptr);
  }
  catch(...)
  {
@@ -2182,6 +2326,13 @@ static const MDFNSetting SSSettings[] =
  { "ss.slendp", MDFNSF_NOFLAGS, gettext_noop("Last displayed scanline in PAL mode."), NULL, MDFNST_INT, "255", "-16", "271" },
 
  { "ss.affinity.vdp2", MDFNSF_NOFLAGS, gettext_noop("VDP2 rendering thread CPU affinity mask."), gettext_noop("Set to 0 to disable changing affinity."), MDFNST_UINT, "0", "0x0000000000000000", "0xFFFFFFFFFFFFFFFF" },
+ { "ss.affinity.vdp1", MDFNSF_NOFLAGS, gettext_noop("VDP1 drawing thread CPU affinity mask."), gettext_noop("Only used when \"ss.vdp1_thread\" is enabled.  Set to 0 to disable changing affinity."), MDFNST_UINT, "0", "0x0000000000000000", "0xFFFFFFFFFFFFFFFF" },
+ { "ss.affinity.sh2s", MDFNSF_NOFLAGS, gettext_noop("Slave SH-2 thread CPU affinity mask."), gettext_noop("Only used when \"ss.slave_thread\" is enabled.  Set to 0 to disable changing affinity."), MDFNST_UINT, "0", "0x0000000000000000", "0xFFFFFFFFFFFFFFFF" },
+
+ { "ss.slave_thread", MDFNSF_NOFLAGS, gettext_noop("Emulate the slave SH-2 on a separate thread."), gettext_noop("Allows Saturn emulation to use a second host CPU core.  The two SH-2s are kept within \"ss.slave_thread.max_lag\" cycles of each other, and synchronize on accesses to anything other than work RAM, so emulation is no longer deterministic; movies and netplay will desync.  Ignored for games that use full or data-bypass CPU cache emulation, for games in the internal slave lockstep database, and while the debugger is active."), MDFNST_BOOL, "0" },
+ { "ss.slave_thread.max_lag", MDFNSF_NOFLAGS, gettext_noop("Maximum timing skew between the master and slave SH-2s, in CPU cycles, when \"ss.slave_thread\" is enabled."), gettext_noop("Lower values are more accurate, higher values need less synchronization between threads."), MDFNST_UINT, "128", "8", "4096" },
+
+ { "ss.vdp1_thread", MDFNSF_NOFLAGS, gettext_noop("Run VDP1 command processing and drawing on a separate thread."), gettext_noop("Allows polygon-heavy games to use another host CPU core.  Emulation stays deterministic, but VDP1 timing differs slightly from the default mode(the end-of-drawing interrupt can be raised up to about 10 microseconds late), so movies and netplay need the same setting on both ends."), MDFNST_BOOL, "0" },
 
 #ifdef MDFN_ENABLE_DEV_BUILD
  { "ss.dbg_mask", MDFNSF_SUPPRESS_DOC, gettext_noop("Debug printf mask."), NULL, MDFNST_MULTI_ENUM, "none", NULL, NULL, NULL, NULL, DBGMask_List },
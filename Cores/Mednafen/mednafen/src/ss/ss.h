@@ -121,6 +121,7 @@ namespace MDFN_IEN_SS
 
  void SS_RequestMLExit(void);
  void SS_RequestEHLExit(void);
+ void SS_ParkSlaveThread(void);
  void ForceEventUpdates(const sscpu_timestamp_t timestamp);
 
  enum
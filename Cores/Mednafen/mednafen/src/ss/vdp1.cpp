@@ -41,11 +41,15 @@
 #include "ss.h"
 #include <mednafen/mednafen.h>
 #include <mednafen/FileStream.h>
+#include <mednafen/MThreading.h>
 #include "scu.h"
 #include "vdp1.h"
 #include "vdp2.h"
 #include "vdp1_common.h"
 
+#include <atomic>
+#include <thread>
+
 enum : int { VDP1_UpdateTimingGran = 263 };
 enum : int { VDP1_IdleTimingGran = 1019 };
 
@@ -74,6 +78,7 @@ uint16* FBDrawWhichPtr;
 static bool FBDrawWhich;
 
 static bool DrawingActive;
+static bool DrawEndIRQ;		// Set by DoDrawing() on an end command; the interrupt itself is raised by Update().
 static uint32 CurCommandAddr;
 static int32 RetCommandAddr;
 static uint16 LOPR;
@@ -209,9 +214,176 @@ static INLINE void VRAMUsageDrawRead(uint32 A) { }
 static INLINE void VRAMUsageEnd(void) { }
 #endif
 //
+// Drawing thread(ss.vdp1_thread)
+//
+// Command processing and drawing(DoDrawing()) can run on a separate host thread.  Update() still works out how many
+// cycles the VDP1 gets, as in single-threaded mode, but passes them to the drawing thread as a COMMAND_DRAW work
+// queue entry instead of calling DoDrawing() itself, and the SH-2s keep running in the meantime.
+//
+// While the queue isn't known to be empty(DThread.Busy), the drawing thread owns VRAM, the draw framebuffer, and all
+// drawing state.  CPU VRAM writes are queued, in order with the COMMAND_DRAW entries, so the drawing thread sees them
+// when it would have in single-threaded mode.  Everything else that touches drawing state(CPU VRAM and framebuffer
+// reads, framebuffer writes, register reads and writes, framebuffer swap, reset, save states, the debugger and cheats)
+// calls Sync() first, which waits for the queue to drain.  Update() syncs before handing over more cycles, so the
+// drawing thread is never more than one update(VDP1_UpdateTimingGran cycles) behind the emulation thread.
+//
+// Emulation stays deterministic, but differs from single-threaded mode in two small ways: updates during drawing
+// always happen every VDP1_UpdateTimingGran cycles, because the emulation thread doesn't know how far a command
+// overran its cycle budget, and the end-of-drawing interrupt is raised at the next sync after drawing finishes
+// instead of immediately.
+//
+enum
+{
+ COMMAND_DRAW = 0,
+ COMMAND_WRITE8,
+ COMMAND_WRITE16,
+ COMMAND_EXIT
+};
+
+struct DQ_Entry
+{
+ uint16 Command;
+ uint16 Arg16;
+ uint32 Arg32;
+};
+
+static struct
+{
+ std::array<DQ_Entry, 0x10000> Q;
+ alignas(64) std::atomic_int_least32_t InCount;
+ std::atomic_bool Sleeping;
+ //
+ // Emulation thread:
+ //
+ alignas(64) size_t WritePos;
+ bool Enabled;
+ bool Busy;
+ //
+ // Drawing thread:
+ //
+ alignas(64) size_t ReadPos;
+ //
+ //
+ //
+ MThreading::Thread* Thread;
+ MThreading::Sem* WakeupSem;
+} DThread;
+
+static INLINE void DThread_Relax(unsigned& spins)
+{
+ if(spins < 64)
+ {
+  spins++;
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+  asm volatile("yield");
+#endif
+ }
+ else
+  std::this_thread::yield();
+}
+
+static void WDQ(uint16 command, uint32 arg32 = 0, uint16 arg16 = 0)
+{
+ if(MDFN_UNLIKELY(DThread.InCount.load(std::memory_order_acquire) == (int32)DThread.Q.size()))
+ {
+  unsigned spins = 0;
+
+  while(DThread.InCount.load(std::memory_order_acquire) == (int32)DThread.Q.size())
+   DThread_Relax(spins);
+ }
+
+ DQ_Entry* e = &DThread.Q[DThread.WritePos];
+
+ e->Command = command;
+ e->Arg16 = arg16;
+ e->Arg32 = arg32;
+
+ DThread.WritePos = (DThread.WritePos + 1) % DThread.Q.size();
+ DThread.InCount.fetch_add(1, std::memory_order_seq_cst);
+ DThread.Busy = true;
+
+ if(DThread.Sleeping.load(std::memory_order_seq_cst))
+  MThreading::Sem_Post(DThread.WakeupSem);
+}
+
+void Sync(void)
+{
+ if(MDFN_LIKELY(!DThread.Busy))
+  return;
+
+ unsigned spins = 0;
+
+ while(DThread.InCount.load(std::memory_order_acquire) != 0)
+  DThread_Relax(spins);
+
+ DThread.Busy = false;
+}
+
+static void DoDrawing(void);
+
+static int DThreadEntry(void* data)
+{
+ bool Running = true;
+
+ while(MDFN_LIKELY(Running))
+ {
+  if(MDFN_UNLIKELY(DThread.InCount.load(std::memory_order_acquire) == 0))
+  {
+   unsigned spins = 0;
+   unsigned yields = 0;
+
+   // Spin between updates while drawing, sleep when idle(e.g. between frames).
+   while(DThread.InCount.load(std::memory_order_acquire) == 0)
+   {
+    if(spins < 64 || yields++ < 2048)
+     DThread_Relax(spins);
+    else
+    {
+     DThread.Sleeping.store(true, std::memory_order_seq_cst);
+
+     if(DThread.InCount.load(std::memory_order_seq_cst) == 0)
+      MThreading::Sem_TimedWait(DThread.WakeupSem, 2);
+
+     DThread.Sleeping.store(false, std::memory_order_relaxed);
+    }
+   }
+  }
+  //
+  //
+  //
+  DQ_Entry* e = &DThread.Q[DThread.ReadPos];
+
+  switch(e->Command)
+  {
+   case COMMAND_DRAW:
+	DoDrawing();
+	break;
+
+   case COMMAND_WRITE8:
+	ne16_wbo_be<uint8>(VRAM, e->Arg32, e->Arg16);
+	break;
+
+   case COMMAND_WRITE16:
+	VRAM[e->Arg32] = e->Arg16;
+	break;
+
+   case COMMAND_EXIT:
+	Running = false;
+	break;
+  }
+
+  DThread.ReadPos = (DThread.ReadPos + 1) % DThread.Q.size();
+  DThread.InCount.fetch_sub(1, std::memory_order_release);
+ }
+
+ return 0;
+}
+//
 //
 //
-void Init(void)
+void Init(const bool threaded, const uint64 affinity)
 {
  vbcdpending = false;
 
@@ -238,15 +410,49 @@ void Init(void)
  LastRWTS = 0;
 
  VRAMUsageInit();
+ //
+ //
+ //
+ DThread.Enabled = threaded;
+ DThread.Busy = false;
+ DThread.WritePos = 0;
+ DThread.ReadPos = 0;
+ DThread.InCount.store(0);
+ DThread.Sleeping.store(false);
+
+ if(threaded)
+ {
+  DThread.WakeupSem = MThreading::Sem_Create();
+  DThread.Thread = MThreading::Thread_Create(DThreadEntry, NULL, "MDFN SS VDP1 Draw");
+  if(affinity)
+   MThreading::Thread_SetAffinity(DThread.Thread, affinity);
+ }
 }
 
 void Kill(void)
 {
+ if(DThread.Thread != NULL)
+ {
+  WDQ(COMMAND_EXIT);
+  MThreading::Sem_Post(DThread.WakeupSem);
+  MThreading::Thread_Wait(DThread.Thread, NULL);
+  DThread.Thread = NULL;
+ }
 
+ if(DThread.WakeupSem != NULL)
+ {
+  MThreading::Sem_Destroy(DThread.WakeupSem);
+  DThread.WakeupSem = NULL;
+ }
+
+ DThread.Enabled = false;
+ DThread.Busy = false;
 }
 
 void Reset(bool powering_up)
 {
+ Sync();
+
  if(powering_up)
  {
   for(unsigned i = 0; i < 0x40000; i++)
@@ -302,6 +508,7 @@ void Reset(bool powering_up)
  CurCommandAddr = 0;
  RetCommandAddr = -1;
  DrawingActive = false;
+ DrawEndIRQ = false;
  CycleCounter = 0;
  CommandPhase = 0;
  memset(CommandData, 0, sizeof(CommandData));
@@ -712,7 +919,7 @@ enum : int { CommandPhaseBias = __COUNTER__ + 1 };
 		}										\
 
 
-static INLINE void DoDrawing(void)
+static void DoDrawing(void)
 {
 #if 1
  if(MDFN_UNLIKELY(ss_horrible_hacks & HORRIBLEHACK_VDP1INSTANT))
@@ -791,9 +998,7 @@ static INLINE void DoDrawing(void)
     VRAMUsageEnd();
 
     EDSR |= 0x2;	// TODO: Does EDSR reflect IRQ out status?
-
-    SCU_SetInt(SCU_INT_VDP1, true);
-    SCU_SetInt(SCU_INT_VDP1, false);
+    DrawEndIRQ = true;
     goto Breakout;
    }
 
@@ -835,8 +1040,22 @@ static INLINE void DoDrawing(void)
 #endif
 }
 
+static INLINE void CheckDrawEndIRQ(void)
+{
+ if(DrawEndIRQ)
+ {
+  DrawEndIRQ = false;
+
+  SCU_SetInt(SCU_INT_VDP1, true);
+  SCU_SetInt(SCU_INT_VDP1, false);
+ }
+}
+
 sscpu_timestamp_t Update(sscpu_timestamp_t timestamp)
 {
+ Sync();
+ CheckDrawEndIRQ();
+
  if(MDFN_UNLIKELY(timestamp < lastts))
  {
   // Don't else { } normal execution, since this bug condition miiight occur in the call from SetHBVB(),
@@ -861,7 +1080,16 @@ sscpu_timestamp_t Update(sscpu_timestamp_t timestamp)
   CycleCounter = 0;
  }
  else if(DrawingActive)
+ {
+  if(DThread.Enabled)
+  {
+   WDQ(COMMAND_DRAW);
+   return timestamp + VDP1_UpdateTimingGran;
+  }
+
   DoDrawing();
+  CheckDrawEndIRQ();
+ }
 
  return timestamp + (DrawingActive ? std::max<int32>(VDP1_UpdateTimingGran, 0 - CycleCounter) : VDP1_IdleTimingGran);
 }
@@ -918,6 +1146,7 @@ void SetHBVB(const sscpu_timestamp_t event_timestamp, const bool new_hb_status,
   }
   else // Leaving v-blank
   {
+   Sync();
    InstantDrawSanityLimit = 1000000;
 
    // Run vblank erase at end of vblank all at once(not strictly accurate, but should only have visible side effects wrt the debugger and reset).
@@ -1128,6 +1357,8 @@ static INLINE void WriteReg(const unsigned which, const uint16 value)
  SS_SetEventNT(&events[SS_EVENT_VDP2], VDP2::Update(SH7095_mem_timestamp));
  sscpu_timestamp_t nt = Update(SH7095_mem_timestamp);
 
+ Sync();
+
  SS_DBGTI(SS_DBG_VDP1_REGW, "[VDP1] Register write: 0x%02x: 0x%04x", which << 1, value);
 
  switch(which)
@@ -1185,6 +1416,9 @@ static INLINE void WriteReg(const unsigned which, const uint16 value)
 
 static INLINE uint16 ReadReg(const unsigned which)
 {
+ Sync();
+ CheckDrawEndIRQ();
+
  switch(which)
  {
   default:
@@ -1213,7 +1447,12 @@ static INLINE uint16 ReadReg(const unsigned which)
 //
 MDFN_FASTCALL void Write_CheckDrawSlowdown(uint32 A, sscpu_timestamp_t time_thing)
 {
- if(DrawingActive && time_thing > LastRWTS && (ss_horrible_hacks & HORRIBLEHACK_VDP1RWDRAWSLOWDOWN))
+ if(!(ss_horrible_hacks & HORRIBLEHACK_VDP1RWDRAWSLOWDOWN))
+  return;
+
+ Sync();
+
+ if(DrawingActive && time_thing > LastRWTS)
  {
   const int32 count = (A & 0x100000) ? 22 : 25;
   const uint32 a = std::min<uint32>(count, time_thing - LastRWTS);
@@ -1226,7 +1465,12 @@ MDFN_FASTCALL void Write_CheckDrawSlowdown(uint32 A, sscpu_timestamp_t time_thin
 MDFN_FASTCALL void Read_CheckDrawSlowdown(uint32 A, sscpu_timestamp_t time_thing)
 {
  //printf("%08x\n", A);
- if(!(A & 0x100000) && time_thing > LastRWTS && DrawingActive && (ss_horrible_hacks & HORRIBLEHACK_VDP1RWDRAWSLOWDOWN))
+ if(!(ss_horrible_hacks & HORRIBLEHACK_VDP1RWDRAWSLOWDOWN))
+  return;
+
+ Sync();
+
+ if(!(A & 0x100000) && time_thing > LastRWTS && DrawingActive)
  {
   const int32 count = (A & 0x80000) ? 44 : 41;
   const uint32 a = std::min<uint32>(count, time_thing - LastRWTS);
@@ -1244,7 +1488,10 @@ MDFN_FASTCALL void Write8_DB(uint32 A, uint16 DB)
  {
   VRAMUsageWrite(A >> 1);
   SS_DBGTI(SS_DBG_VDP1_VRAMW, "[VDP1] Write to VRAM: 0x%02x->VRAM[0x%05x]", (DB >> (((A & 1) ^ 1) << 3)) & 0xFF, A);
-  ne16_wbo_be<uint8>(VRAM, A, DB >> (((A & 1) ^ 1) << 3) );
+  if(DThread.Busy)
+   WDQ(COMMAND_WRITE8, A, (DB >> (((A & 1) ^ 1) << 3)) & 0xFF);
+  else
+   ne16_wbo_be<uint8>(VRAM, A, DB >> (((A & 1) ^ 1) << 3) );
   return;
  }
 
@@ -1252,6 +1499,8 @@ MDFN_FASTCALL void Write8_DB(uint32 A, uint16 DB)
  {
   uint32 FBA = A;
 
+  Sync();
+
   SS_DBGTI(SS_DBG_VDP1_FBW, "[VDP1] Write to FB: 0x%02x->FB[%d][0x%05x] CycleCounter=%d", (DB >> (((A & 1) ^ 1) << 3)) & 0xFF, FBDrawWhich, A & 0x3FFFF, CycleCounter);
 
   if((TVMR & (TVMR_8BPP | TVMR_ROTATE)) == (TVMR_8BPP | TVMR_ROTATE))
@@ -1273,7 +1522,10 @@ MDFN_FASTCALL void Write16_DB(uint32 A, uint16 DB)
  {
   VRAMUsageWrite(A >> 1);
   SS_DBGTI(SS_DBG_VDP1_VRAMW, "[VDP1] Write to VRAM: 0x%04x->VRAM[0x%05x]", DB, A);
-  VRAM[A >> 1] = DB;
+  if(DThread.Busy)
+   WDQ(COMMAND_WRITE16, A >> 1, DB);
+  else
+   VRAM[A >> 1] = DB;
   return;
  }
 
@@ -1281,6 +1533,8 @@ MDFN_FASTCALL void Write16_DB(uint32 A, uint16 DB)
  {
   uint32 FBA = A;
 
+  Sync();
+
   SS_DBGTI(SS_DBG_VDP1_FBW, "[VDP1] Write to FB: 0x%04x->FB[%d][0x%05x] CycleCounter=%d", DB, FBDrawWhich, A & 0x3FFFF, CycleCounter);
 
   if((TVMR & (TVMR_8BPP | TVMR_ROTATE)) == (TVMR_8BPP | TVMR_ROTATE))
@@ -1297,6 +1551,9 @@ MDFN_FASTCALL uint16 Read16_DB(uint32 A)
 {
  A &= 0x1FFFFE;
 
+ if(A < 0x100000)
+  Sync();
+
  if(A < 0x080000)
   return VRAM[A >> 1];
 
@@ -1315,6 +1572,11 @@ MDFN_FASTCALL uint16 Read16_DB(uint32 A)
 
 void StateAction(StateMem* sm, const unsigned load, const bool data_only)
 {
+ Sync();
+
+ if(load)
+  DrawEndIRQ = false;
+
  SFORMAT Prim_StateRegs[] =
  {
   SFVAR(PrimData.e->d_error, 0x2, sizeof(*PrimData.e), PrimData.e),
@@ -1426,6 +1688,7 @@ void StateAction(StateMem* sm, const unsigned load, const bool data_only)
   SFVAR(CurCommandAddr),
   SFVAR(RetCommandAddr),
   SFVAR(DrawingActive),
+  SFVAR(DrawEndIRQ),
 
   SFVAR(LOPR),
 
@@ -1499,6 +1762,8 @@ void StateAction(StateMem* sm, const unsigned load, const bool data_only)
 
 void MakeDump(const std::string& path)
 {
+ Sync();
+
  FileStream fp(path, FileStream::MODE_WRITE);
 
  for(unsigned i = 0; i < 0x40000; i++)
@@ -1511,6 +1776,8 @@ uint32 GetRegister(const unsigned id, char* const special, const uint32 special_
 {
  uint32 ret = 0xDEADBEEF;
 
+ Sync();
+
  switch(id)
  {
   case GSREG_SYSCLIPX:
@@ -1571,6 +1838,8 @@ uint32 GetRegister(const unsigned id, char* const special, const uint32 special_
 
 void SetRegister(const unsigned id, const uint32 value)
 {
+ Sync();
+
  // TODO
  switch(id)
  {
@@ -30,7 +30,7 @@ namespace MDFN_IEN_SS
 namespace VDP1
 {
 
-void Init(void) MDFN_COLD;
+void Init(const bool threaded, const uint64 affinity) MDFN_COLD;
 void Kill(void) MDFN_COLD;
 void StateAction(StateMem* sm, const unsigned load, const bool data_only) MDFN_COLD;
 
@@ -39,6 +39,9 @@ void Reset(bool powering_up) MDFN_COLD;
 sscpu_timestamp_t Update(sscpu_timestamp_t timestamp);
 void AdjustTS(const int32 delta);
 
+// Waits for the drawing thread(if enabled) to finish queued work, before touching VRAM or framebuffer memory directly.
+void Sync(void);
+
 MDFN_FASTCALL void Write_CheckDrawSlowdown(uint32 A, sscpu_timestamp_t time_thing) MDFN_HOT;
 MDFN_FASTCALL void Read_CheckDrawSlowdown(uint32 A, sscpu_timestamp_t time_thing) MDFN_HOT;
 MDFN_FASTCALL void Write8_DB(uint32 A, uint16 DB) MDFN_HOT;
@@ -57,6 +60,8 @@ INLINE uint8 PeekVRAM(const uint32 addr)
 {
  MDFN_HIDE extern uint16 VRAM[0x40000];
 
+ Sync();
+
  return ne16_rbo_be<uint8>(VRAM, addr & 0x7FFFF);
 }
 
@@ -64,6 +69,8 @@ INLINE void PokeVRAM(const uint32 addr, const uint8 val)
 {
  MDFN_HIDE extern uint16 VRAM[0x40000];
 
+ Sync();
+
  ne16_wbo_be<uint8>(VRAM, addr & 0x7FFFF, val);
 }
 
@@ -71,6 +78,8 @@ INLINE uint8 PeekFB(const bool which, const uint32 addr)
 {
  MDFN_HIDE extern uint16 FB[2][0x20000];
 
+ Sync();
+
  return ne16_rbo_be<uint8>(FB[which], addr & 0x3FFFF);
 }
 
@@ -78,6 +87,8 @@ INLINE void PokeFB(const bool which, const uint32 addr, const uint8 val)
 {
  MDFN_HIDE extern uint16 FB[2][0x20000];
 
+ Sync();
+
  ne16_wbo_be<uint8>(FB[which], addr & 0x3FFFF, val);
 }
 
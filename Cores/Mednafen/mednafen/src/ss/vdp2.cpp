@@ -376,6 +376,7 @@ static INLINE void IncVCounter(const sscpu_timestamp_t event_timestamp)
  {
   const bool s = (VCounter == (VTimings[PAL][VRes][VPHASE__COUNT - 1] - 1));
 
+  SS_ParkSlaveThread();
   for(size_t i = 0; i < 2; i++)
    CPU[i].SetExtHaltDMAKludgeFromVDP2(s);
  }
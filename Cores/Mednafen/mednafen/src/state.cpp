@@ -42,14 +42,33 @@ struct StateSectionMapEntry
  bool used;
 };
 
+//
+// Shadow copy of a large state variable, as of the last incremental snapshot.
+//
+struct StateIncrementalVar
+{
+ const void* data = nullptr;
+ uint32 size = 0;
+ std::unique_ptr<uint8[]> shadow;
+};
+
+struct StateIncremental
+{
+ std::vector<StateIncrementalVar> vars;	// In the order encountered while saving/loading.
+ size_t var_index = 0;
+ bool force_full = false;
+ bool wrote_partial = false;
+};
+
 struct StateMem
 {
- StateMem(Stream*s, bool svbe_ = false, int fuzz_ = MDFNSS_FUZZ_DISABLED) : st(s), svbe(svbe_), fuzz(fuzz_) { };
+ StateMem(Stream*s, bool svbe_ = false, int fuzz_ = MDFNSS_FUZZ_DISABLED, StateIncremental* inc_ = nullptr) : st(s), svbe(svbe_), fuzz(fuzz_), inc(inc_) { };
  ~StateMem();
 
  Stream* st = nullptr;
  bool svbe = false;	// State variable data is stored big-endian(for normal-path state loading only).
  int fuzz = MDFNSS_FUZZ_DISABLED;
+ StateIncremental* inc = nullptr;	// For incremental data-only saving/loading.
 
  std::map<std::string, StateSectionMapEntry> secmap; // For loads
 
@@ -350,6 +369,172 @@ static void FastRWChunk(Stream *st, const SFORMAT *sf)
  }
 }
 
+//
+// Incremental variant of FastRWChunk(); variables of at least IncrementalMinSize bytes are split into
+// IncrementalPageSize-byte pages, and only pages that differ from the shadow copy kept in 'inc' are written.
+//
+// Per large variable: 1 byte mode(0 = full, 1 = paged), and for paged, a bitmap of present pages followed by the pages.
+//
+enum : uint32 { IncrementalPageSize = 4096 };
+enum : uint32 { IncrementalMinSize = 65536 };
+
+template<bool load>
+static void IncRWVar(Stream* st, StateIncremental* inc, uint8* p, const uint32 bytesize)
+{
+ const uint32 num_pages = (bytesize + IncrementalPageSize - 1) / IncrementalPageSize;
+ StateIncrementalVar* v;
+ bool fresh = false;
+
+ if(inc->var_index >= inc->vars.size())
+  inc->vars.resize(inc->var_index + 1);
+
+ v = &inc->vars[inc->var_index++];
+
+ if(v->data != p || v->size != bytesize)
+ {
+  v->data = nullptr;
+  v->size = 0;
+  v->shadow.reset(nullptr);
+  v->shadow.reset(new uint8[bytesize]);
+  v->data = p;
+  v->size = bytesize;
+  fresh = true;
+
+  if(!load)
+   inc->force_full = true;	// Only for this variable, see below.
+ }
+
+ if(load)
+ {
+  const uint8 mode = st->get_u8();
+
+  if(mode == 0)
+  {
+   st->read(p, bytesize);
+   memcpy(v->shadow.get(), p, bytesize);
+  }
+  else if(mode == 1)
+  {
+   if(fresh)
+    throw MDFN_Error(0, _("Incremental save state loaded without the save state it's relative to."));
+
+   std::unique_ptr<uint8[]> bitmap(new uint8[(num_pages + 7) >> 3]);
+
+   st->read(bitmap.get(), (num_pages + 7) >> 3);
+
+   for(uint32 page = 0; page < num_pages; page++)
+   {
+    const uint32 offs = page * IncrementalPageSize;
+    const uint32 len = std::min<uint32>(IncrementalPageSize, bytesize - offs);
+
+    if((bitmap[page >> 3] >> (page & 0x7)) & 1)
+     st->read(v->shadow.get() + offs, len);
+
+    memcpy(p + offs, v->shadow.get() + offs, len);
+   }
+  }
+  else
+   throw MDFN_Error(0, _("Bad incremental state variable mode 0x%02x."), mode);
+ }
+ else
+ {
+  if(inc->force_full)
+  {
+   st->put_u8(0);
+   st->write(p, bytesize);
+   memcpy(v->shadow.get(), p, bytesize);
+  }
+  else
+  {
+   const uint32 bitmap_size = (num_pages + 7) >> 3;
+   const uint64 bitmap_pos = st->tell() + 1;
+   uint8 bitmap[256];	// Enough for 8MiB; larger variables use the heap.
+   std::unique_ptr<uint8[]> bitmap_heap;
+   uint8* bm = bitmap;
+
+   if(bitmap_size > sizeof(bitmap))
+   {
+    bitmap_heap.reset(new uint8[bitmap_size]);
+    bm = bitmap_heap.get();
+   }
+
+   memset(bm, 0, bitmap_size);
+
+   st->put_u8(1);
+   st->write(bm, bitmap_size);	// We'll come back and write this later.
+
+   for(uint32 page = 0; page < num_pages; page++)
+   {
+    const uint32 offs = page * IncrementalPageSize;
+    const uint32 len = std::min<uint32>(IncrementalPageSize, bytesize - offs);
+
+    if(memcmp(p + offs, v->shadow.get() + offs, len))
+    {
+     bm[page >> 3] |= 1 << (page & 0x7);
+     st->write(p + offs, len);
+     memcpy(v->shadow.get() + offs, p + offs, len);
+    }
+   }
+
+   const uint64 end_pos = st->tell();
+
+   st->seek(bitmap_pos, SEEK_SET);
+   st->write(bm, bitmap_size);
+   st->seek(end_pos, SEEK_SET);
+
+   inc->wrote_partial = true;
+  }
+ }
+}
+
+template<bool load>
+static void IncRWChunk(Stream *st, StateIncremental* inc, const SFORMAT *sf)
+{
+ while(sf->size || sf->name)	// Size can sometimes be zero, so also check for the text name.  These two should both be zero only at the end of a struct.
+ {
+  if(!sf->size || !sf->data)
+  {
+   sf++;
+   continue;
+  }
+
+  if(sf->size == ~0U)		/* Link to another struct.	*/
+  {
+   IncRWChunk<load>(st, inc, (const SFORMAT *)sf->data);
+
+   sf++;
+   continue;
+  }
+
+  if(sf->type && !sf->repcount && sf->size >= IncrementalMinSize)
+  {
+   const bool prev_force_full = inc->force_full;
+
+   IncRWVar<load>(st, inc, (uint8*)sf->data, sf->size);
+   inc->force_full = prev_force_full;
+  }
+  else
+  {
+   int32 bytesize = sf->size;
+   uintptr_t p = (uintptr_t)sf->data;
+   uint32 repcount = sf->repcount;
+   const size_t repstride = sf->repstride; 
+
+   if(!sf->type)
+    bytesize *= sizeof(bool);
+
+   do
+   {
+    if(load)
+     st->read((void*)p, bytesize);
+    else
+     st->write((void*)p, bytesize);
+   } while(p += repstride, repcount--);
+  }
+  sf++; 
+ }
+}
+
 //
 // When updating this function make sure to adhere to the guarantees in state.h.
 //
@@ -381,7 +566,10 @@ bool MDFNSS_StateAction(StateMem *sm, const unsigned load, const bool data_only,
     if(memcmp(sname_canary + 32, SSFastCanary, 8))
      throw MDFN_Error(0, _("Section canary is a zombie AAAAAAAAAAGH!"));
 
-    FastRWChunk<true>(st, sf);
+    if(sm->inc)
+     IncRWChunk<true>(st, sm->inc, sf);
+    else
+     FastRWChunk<true>(st, sf);
    }
    else
    {
@@ -390,7 +578,10 @@ bool MDFNSS_StateAction(StateMem *sm, const unsigned load, const bool data_only,
     memcpy(sname_canary + 32, SSFastCanary, 8);
     st->write(sname_canary, 32 + 8);
 
-    FastRWChunk<false>(st, sf);
+    if(sm->inc)
+     IncRWChunk<false>(st, sm->inc, sf);
+    else
+     FastRWChunk<false>(st, sf);
    }
   }
   else
@@ -644,6 +835,90 @@ void MDFNSS_LoadSM(Stream *st, bool data_only, const int fuzz)
 	}
 }
 
+StateIncremental* MDFNSS_Incremental_Create(void)
+{
+ return new StateIncremental();
+}
+
+void MDFNSS_Incremental_Destroy(StateIncremental* inc)
+{
+ delete inc;
+}
+
+bool MDFNSS_SaveSMIncremental(Stream *st, StateIncremental* inc, bool force_full)
+{
+ if(!MDFNGameInfo->StateAction)
+  throw MDFN_Error(0, _("Module \"%s\" doesn't support save states."), MDFNGameInfo->shortname);
+
+ StateMem sm(st, false, MDFNSS_FUZZ_DISABLED, inc);
+
+ inc->var_index = 0;
+ inc->force_full = force_full;
+ inc->wrote_partial = false;
+
+ try
+ {
+  MDFN_StateAction(&sm, 0, true);
+  sm.ThrowDeferred();
+ }
+ catch(...)
+ {
+  //
+  // The shadow copies may now be partially updated, so make sure the next snapshot is full.
+  //
+  inc->vars.clear();
+  throw;
+ }
+
+ if(inc->var_index != inc->vars.size())	// A large variable went away.
+  inc->vars.resize(inc->var_index);
+
+ return !inc->wrote_partial;
+}
+
+void MDFNSS_LoadSMIncremental(Stream *st, StateIncremental* inc)
+{
+ if(!MDFNGameInfo->StateAction)
+  throw MDFN_Error(0, _("Module \"%s\" doesn't support save states."), MDFNGameInfo->shortname);
+
+ StateMem sm(st, false, MDFNSS_FUZZ_DISABLED, inc);
+
+ inc->var_index = 0;
+
+ try
+ {
+  MDFN_StateAction(&sm, MEDNAFEN_VERSION_NUMERIC, true);
+  sm.ThrowDeferred();
+ }
+ catch(...)
+ {
+  inc->vars.clear();
+  throw;
+ }
+}
+
+void MDFNSS_SaveSoundOutput(Stream *st)
+{
+ if(!MDFNGameInfo->SoundOutputStateAction)
+  throw MDFN_Error(0, _("Module \"%s\" doesn't support saving its sound output state."), MDFNGameInfo->shortname);
+
+ StateMem sm(st);
+
+ MDFNGameInfo->SoundOutputStateAction(&sm, 0);
+ sm.ThrowDeferred();
+}
+
+void MDFNSS_LoadSoundOutput(Stream *st)
+{
+ if(!MDFNGameInfo->SoundOutputStateAction)
+  throw MDFN_Error(0, _("Module \"%s\" doesn't support saving its sound output state."), MDFNGameInfo->shortname);
+
+ StateMem sm(st);
+
+ MDFNGameInfo->SoundOutputStateAction(&sm, MEDNAFEN_VERSION_NUMERIC);
+ sm.ThrowDeferred();
+}
+
 //
 //
 //
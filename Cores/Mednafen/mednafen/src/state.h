@@ -61,6 +61,38 @@ void MDFNSS_LoadSM(Stream *st, bool data_only = false, const int fuzz = MDFNSS_F
 
 void MDFNSS_CheckStates(void);
 
+//
+// Incremental data-only save states.
+//
+// Large state variables(at least 64KiB, e.g. RAM and VRAM) are tracked in 4KiB pages against a shadow copy held in
+// the StateIncremental object, and only the pages that changed since the previous snapshot taken with the same object
+// are written; everything else is written in full, as with MDFNSS_SaveSM(st, true).
+//
+// MDFNSS_SaveSMIncremental() returns true if the snapshot it wrote is self-contained(full), which is the case for the
+// first snapshot, when 'force_full' is true, and after an error or a change in the set of state variables.
+//
+// Snapshots must be loaded with MDFNSS_LoadSMIncremental() using the same object, in the same order they were saved,
+// starting from a full one; loading a snapshot brings the shadow copy up to date with it, so subsequent snapshots
+// are relative to the loaded state.
+//
+// throws exceptions on errors; after an error, the next snapshot will be full.
+//
+struct StateIncremental;
+
+StateIncremental* MDFNSS_Incremental_Create(void);
+void MDFNSS_Incremental_Destroy(StateIncremental* inc);
+bool MDFNSS_SaveSMIncremental(Stream *st, StateIncremental* inc, bool force_full = false);
+void MDFNSS_LoadSMIncremental(Stream *st, StateIncremental* inc);
+
+//
+// Sound output state that regular save states leave out(see MDFNGI::SoundOutputStateAction).  Data-only, and only
+// valid for loading back into the same running game.
+//
+// throws exceptions on errors, including when the module doesn't support it.
+//
+void MDFNSS_SaveSoundOutput(Stream *st);
+void MDFNSS_LoadSoundOutput(Stream *st);
+
 struct SFORMAT
 {
 	//
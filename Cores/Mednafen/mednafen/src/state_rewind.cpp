@@ -2,7 +2,7 @@
 /* Mednafen - Multi-system Emulator                                           */
 /******************************************************************************/
 /* state_rewind.cpp:
-**  Copyright (C) 2014-2018 Mednafen Team
+**  Copyright (C) 2014-2021 Mednafen Team
 **
 ** This program is free software; you can redistribute it and/or
 ** modify it under the terms of the GNU General Public License
@@ -25,39 +25,286 @@
 #include "state_rewind.h"
 
 #include <mednafen/MemoryStream.h>
+#include <mednafen/MThreading.h>
 #include <mednafen/quicklz/quicklz.h>
 
 #if QLZ_COMPRESSION_LEVEL != 0
  #error "State rewinding code untested with QLZ_COMPRESSION_LEVEL != 0"
 #endif
 
+/*
+ Each frame, the current state is saved into a pooled MemoryStream on the emulation thread, and the previous state is
+ handed off to a worker thread, which XORs it against the current state and compresses the result into a fixed-size
+ ring of packets.  Every KeyframeInterval'th packet is instead a compressed full state, so reconstructing an older
+ state needs at most KeyframeInterval decompressions rather than one per frame between it and the present.
+
+ The most recent state is always kept uncompressed(ss_prev), and the ring is only touched by the emulation thread after
+ waiting for the worker to go idle.
+*/
+
 namespace Mednafen
 {
 
 struct StateMemPacket
 {
-	std::unique_ptr<MemoryStream> data;
+	std::unique_ptr<uint8[]> data;
+	uint32 data_alloced = 0;
+	uint32 compressed_len = 0;
 	uint32 uncompressed_len = 0;
+	bool keyframe = false;
+};
+
+struct RecordJob
+{
+	MemoryStream* prev;	// Owned by the job; returned to the pool when done.
+	MemoryStream* cur;	// Borrowed; the emulation thread keeps it as ss_prev.
+	bool keyframe;
 };
 
+static const uint32 KeyframeInterval = 64;
+static const unsigned JobQueueSize = 4;
+
 static bool Active = false;
 static bool Enabled = false;
+
 static std::vector<StateMemPacket> bcs;
-static size_t bcs_pos;
+static size_t bcs_pos;		// Index of the next packet to be written.
+static size_t bcs_count;	// Number of valid packets, ending at bcs_pos - 1.
+static uint64 bcs_mem_used;
+static uint64 bcs_mem_limit;
 
 static uint32 SRW_AllocHint;
+static uint32 RecordCounter;
 static std::unique_ptr<MemoryStream> ss_prev;
+static std::vector<MemoryStream*> ss_pool;
+
+static MThreading::Thread* WorkerThread = nullptr;
+static MThreading::Mutex* WorkerMutex = nullptr;
+static MThreading::Cond* JobCond = nullptr;
+static MThreading::Cond* DoneCond = nullptr;
+static RecordJob JobQueue[JobQueueSize];
+static unsigned JobQueueRP, JobQueueCount;
+static bool WorkerBusy;
+static bool WorkerExit;
+static std::string WorkerError;
+
+static std::unique_ptr<char[]> compress_buf;
+static size_t compress_buf_size;
+
+static char qlz_scratch_compress[QLZ_SCRATCH_COMPRESS];		// Worker thread only.
+static char qlz_scratch_decompress[QLZ_SCRATCH_DECOMPRESS];	// Emulation thread only.
+
+static INLINE void DoXORFilter(MemoryStream* prev, MemoryStream* cur) noexcept
+{
+ MDFN_FastMemXOR(prev->map(), cur->map(), std::min(prev->size(), cur->size()));
+}
+
+//
+// Pool of state buffers; called with WorkerMutex held.
+//
+static MemoryStream* PoolGet(void)
+{
+ MemoryStream* ret;
+
+ if(ss_pool.size())
+ {
+  ret = ss_pool.back();
+  ss_pool.pop_back();
+ }
+ else
+  ret = new MemoryStream(SRW_AllocHint);
+
+ return ret;
+}
+
+static void PoolPut(MemoryStream* ms) noexcept
+{
+ ss_pool.push_back(ms);
+}
+
+static INLINE StateMemPacket* PacketByAge(size_t age)
+{
+ return &bcs[(bcs_pos + bcs.size() - age) % bcs.size()];
+}
+
+static void ReleasePacket(StateMemPacket* smp) noexcept
+{
+ bcs_mem_used -= smp->data_alloced;
+ smp->data.reset(nullptr);
+ smp->data_alloced = 0;
+ smp->compressed_len = 0;
+ smp->uncompressed_len = 0;
+ smp->keyframe = false;
+}
+
+//
+// Worker thread only, while WorkerBusy.
+//
+static void DoCompress(const RecordJob& job)
+{
+ const uint32 uncompressed_len = job.prev->size();
+ const size_t max_compressed_len = (size_t)uncompressed_len + 400;
+ StateMemPacket* smp = &bcs[bcs_pos];
+ uint32 dst_len;
+
+ if(!job.keyframe)
+  DoXORFilter(job.prev, job.cur);
+
+ if(compress_buf_size < max_compressed_len)
+ {
+  compress_buf.reset(nullptr);
+  compress_buf.reset(new char[max_compressed_len]);
+  compress_buf_size = max_compressed_len;
+ }
+
+ dst_len = qlz_compress(job.prev->map(), compress_buf.get(), uncompressed_len, qlz_scratch_compress);
+
+ //
+ // Overwrite the oldest packet if the ring is full, reusing its buffer if it's not grossly oversized.
+ //
+ if(bcs_count == bcs.size())
+  bcs_count--;
+
+ if(smp->data_alloced < dst_len || smp->data_alloced > dst_len * 2)
+ {
+  bcs_mem_used -= smp->data_alloced;
+  smp->data.reset(nullptr);
+  smp->data_alloced = 0;
+  smp->data.reset(new uint8[dst_len]);
+  smp->data_alloced = dst_len;
+  bcs_mem_used += dst_len;
+ }
+
+ memcpy(smp->data.get(), compress_buf.get(), dst_len);
+ smp->compressed_len = dst_len;
+ smp->uncompressed_len = uncompressed_len;
+ smp->keyframe = job.keyframe;
+
+ bcs_pos = (bcs_pos + 1) % bcs.size();
+ bcs_count++;
+
+ //
+ // Enforce the memory budget by dropping the oldest packets; deltas only depend on newer states, so this is always safe.
+ //
+ while(bcs_mem_limit && bcs_mem_used > bcs_mem_limit && bcs_count > 1)
+ {
+  ReleasePacket(PacketByAge(bcs_count));
+  bcs_count--;
+ }
+}
+
+static int WorkerThreadEntry(void* data)
+{
+ MThreading::Mutex_Lock(WorkerMutex);
+
+ for(;;)
+ {
+  while(!JobQueueCount && !WorkerExit)
+   MThreading::Cond_Wait(JobCond, WorkerMutex);
+
+  if(WorkerExit)
+   break;
+
+  RecordJob job = JobQueue[JobQueueRP];
+
+  JobQueueRP = (JobQueueRP + 1) % JobQueueSize;
+  JobQueueCount--;
+  WorkerBusy = true;
+  MThreading::Mutex_Unlock(WorkerMutex);
+  //
+  //
+  std::string errmsg;
+
+  if(WorkerError.size())
+   errmsg = WorkerError;	// Don't bother compressing anything after an error; the emulation thread will shut us down.
+  else
+  {
+   try
+   {
+    DoCompress(job);
+   }
+   catch(std::exception& e)
+   {
+    errmsg = e.what();
+   }
+  }
+  //
+  //
+  MThreading::Mutex_Lock(WorkerMutex);
+  PoolPut(job.prev);
+  WorkerError = errmsg;
+  WorkerBusy = false;
+  MThreading::Cond_Signal(DoneCond);
+ }
+
+ MThreading::Mutex_Unlock(WorkerMutex);
+
+ return 0;
+}
 
-static union
+//
+// Waits for the worker to finish all queued jobs; after this, the emulation thread may access the ring.
+//
+static void SyncWorker(void)
 {
- char compress[QLZ_SCRATCH_COMPRESS];
- char decompress[QLZ_SCRATCH_DECOMPRESS];
-} qlz_scratch;
+ MThreading::Mutex_Lock(WorkerMutex);
+
+ while(JobQueueCount || WorkerBusy)
+  MThreading::Cond_Wait(DoneCond, WorkerMutex);
+
+ MThreading::Mutex_Unlock(WorkerMutex);
+}
 
 static void Cleanup(void)
 {
+ if(WorkerThread)
+ {
+  MThreading::Mutex_Lock(WorkerMutex);
+  WorkerExit = true;
+  MThreading::Cond_Signal(JobCond);
+  MThreading::Mutex_Unlock(WorkerMutex);
+
+  MThreading::Thread_Wait(WorkerThread, nullptr);
+  WorkerThread = nullptr;
+ }
+
+ for(unsigned i = 0; i < JobQueueCount; i++)
+  delete JobQueue[(JobQueueRP + i) % JobQueueSize].prev;
+
+ JobQueueRP = 0;
+ JobQueueCount = 0;
+ WorkerBusy = false;
+ WorkerExit = false;
+ WorkerError.clear();
+
+ if(DoneCond)
+ {
+  MThreading::Cond_Destroy(DoneCond);
+  DoneCond = nullptr;
+ }
+
+ if(JobCond)
+ {
+  MThreading::Cond_Destroy(JobCond);
+  JobCond = nullptr;
+ }
+
+ if(WorkerMutex)
+ {
+  MThreading::Mutex_Destroy(WorkerMutex);
+  WorkerMutex = nullptr;
+ }
+
+ for(MemoryStream* ms : ss_pool)
+  delete ms;
+
+ ss_pool.clear();
  bcs.clear();
+ bcs_count = 0;
+ bcs_mem_used = 0;
  ss_prev.reset(nullptr);
+ compress_buf.reset(nullptr);
+ compress_buf_size = 0;
 }
 
 void MDFNSRW_Begin(void) noexcept
@@ -71,9 +318,25 @@ void MDFNSRW_Begin(void) noexcept
   {
    bcs.resize(std::max<size_t>(3, MDFN_GetSettingUI("srwframes")) - 1);
    bcs_pos = 0;
-   memset(&qlz_scratch, 0, sizeof(qlz_scratch));
+   bcs_count = 0;
+   bcs_mem_used = 0;
+   bcs_mem_limit = (uint64)MDFN_GetSettingUI("srwmemory") << 20;
+   memset(qlz_scratch_compress, 0, sizeof(qlz_scratch_compress));
+   memset(qlz_scratch_decompress, 0, sizeof(qlz_scratch_decompress));
 
    SRW_AllocHint = 8192;
+   RecordCounter = 0;
+
+   JobQueueRP = 0;
+   JobQueueCount = 0;
+   WorkerBusy = false;
+   WorkerExit = false;
+   WorkerError.clear();
+
+   WorkerMutex = MThreading::Mutex_Create();
+   JobCond = MThreading::Cond_Create();
+   DoneCond = MThreading::Cond_Create();
+   WorkerThread = MThreading::Thread_Create(WorkerThreadEntry, nullptr, "MDFN State Rewind");
 
    Active = true;
   }
@@ -101,30 +364,58 @@ bool MDFNSRW_IsRunning(void) noexcept
  return Active;
 }
 
-static INLINE void DoXORFilter(MemoryStream* prev, MemoryStream* cur) noexcept
+static std::unique_ptr<MemoryStream> DoDecompress(const StateMemPacket* smp)
 {
- MDFN_FastMemXOR(prev->map(), cur->map(), std::min(prev->size(), cur->size()));
-}
+ std::unique_ptr<MemoryStream> ret(new MemoryStream(smp->uncompressed_len, -1));
 
+ qlz_decompress((const char*)smp->data.get(), ret->map(), qlz_scratch_decompress);
 
-static INLINE std::unique_ptr<MemoryStream> DoCompress(MemoryStream* data)
+ return ret;
+}
+
+//
+// Replaces ss_prev with the state from 'count' records ago, discarding the newer packets.  Starts from the newest
+// keyframe no older than the target state, if there is one, so that at most KeyframeInterval packets are decompressed.
+//
+static void StepBack(size_t count)
 {
- const uint32 uncompressed_len = data->size();
- const uint32 max_compressed_len = (uncompressed_len + 400);
- std::unique_ptr<MemoryStream> tmp_buf(new MemoryStream(max_compressed_len, -1));
- uint32 dst_len;
+ std::unique_ptr<MemoryStream> st;
+ size_t age;
+
+ count = std::min(count, bcs_count);
+
+ if(!count)
+  return;
+
+ for(age = count; age > 0 && !PacketByAge(age)->keyframe; age--);
+
+ if(age)
+  st = DoDecompress(PacketByAge(age));
+ else
+  st = std::move(ss_prev);
+
+ for(size_t a = age + 1; a <= count; a++)
+ {
+  std::unique_ptr<MemoryStream> tmp = DoDecompress(PacketByAge(a));
+
+  DoXORFilter(tmp.get(), st.get());
+
+  st = std::move(tmp);
+ }
+
+ for(size_t a = 1; a <= count; a++)
+  ReleasePacket(PacketByAge(a));
 
- dst_len = qlz_compress(data->map(), (char*)tmp_buf->map(), uncompressed_len, qlz_scratch.compress);
- tmp_buf->truncate(dst_len);
- tmp_buf->shrink_to_fit();
+ bcs_pos = (bcs_pos + bcs.size() - count) % bcs.size();
+ bcs_count -= count;
 
- return tmp_buf;
+ ss_prev = std::move(st);
 }
 
 //
 //
 //
-static bool DoRewind(void)
+static bool DoRewind(size_t count)
 {
  //
  // No save states available.
@@ -132,6 +423,14 @@ static bool DoRewind(void)
  if(!ss_prev)
   return false;
 
+ SyncWorker();
+
+ //
+ // Skip over all but the last of the states being rewound past.
+ //
+ if(count > 1)
+  StepBack(count - 1);
+
  //
  // Load most recent state.
  //
@@ -141,19 +440,7 @@ static bool DoRewind(void)
  //
  // If a compressed state exists, decompress it.
  //
- StateMemPacket* smp = &bcs[(bcs_pos + bcs.size() - 1) % bcs.size()];
-
- if(smp->data)
- {
-  std::unique_ptr<MemoryStream> tmp(new MemoryStream(smp->uncompressed_len, -1));
-  qlz_decompress((char*)smp->data->map(), tmp->map(), qlz_scratch.decompress);
-  smp->data.reset(nullptr);
-  bcs_pos = (bcs_pos + bcs.size() - 1) % bcs.size();
-  //
-  DoXORFilter(tmp.get(), ss_prev.get());
-  //
-  ss_prev = std::move(tmp);
- }
+ StepBack(1);
 
  return true;
 }
@@ -163,45 +450,94 @@ static bool DoRewind(void)
 //
 static void DoRecord(void)
 {
+ MemoryStream* ss_cur;
+
+ MThreading::Mutex_Lock(WorkerMutex);
+ try
+ {
+  ss_cur = PoolGet();
+ }
+ catch(...)
+ {
+  MThreading::Mutex_Unlock(WorkerMutex);
+  throw;
+ }
+ MThreading::Mutex_Unlock(WorkerMutex);
+
  //
  // Save current state
  //
- std::unique_ptr<MemoryStream> ss_cur(new MemoryStream(SRW_AllocHint));
-
- MDFNSS_SaveSM(ss_cur.get(), true);
+ try
+ {
+  ss_cur->truncate(0);
+  ss_cur->rewind();
+  MDFNSS_SaveSM(ss_cur, true);
+ }
+ catch(...)
+ {
+  delete ss_cur;
+  throw;
+ }
 
  SRW_AllocHint = std::max<uint32>(SRW_AllocHint, ss_cur->size());
 
  //
- // Compress previous state if it exists.
+ // Hand the previous state, if it exists, off to the worker thread to be compressed.
  //
  if(ss_prev)
  {
-  DoXORFilter(ss_prev.get(), ss_cur.get());
+  MThreading::Mutex_Lock(WorkerMutex);
+
+  while(JobQueueCount == JobQueueSize)
+   MThreading::Cond_Wait(DoneCond, WorkerMutex);
+
+  RecordJob* job = &JobQueue[(JobQueueRP + JobQueueCount) % JobQueueSize];
 
-  //printf("Compress: %zu\n", ss_prev->size());
+  job->prev = ss_prev.release();
+  job->cur = ss_cur;
+  job->keyframe = !(RecordCounter % KeyframeInterval);
+  JobQueueCount++;
+  RecordCounter++;
 
-  bcs[bcs_pos].data = DoCompress(ss_prev.get());
-  bcs[bcs_pos].uncompressed_len = ss_prev->size();
-  bcs_pos = (bcs_pos + 1) % bcs.size();
+  MThreading::Cond_Signal(JobCond);
+  MThreading::Mutex_Unlock(WorkerMutex);
  }
 
  //
  // Make current state previous for next time.
  //
- ss_prev = std::move(ss_cur);
+ ss_prev.reset(ss_cur);
+}
+
+static void CheckWorkerError(void)
+{
+ std::string errmsg;
+
+ MThreading::Mutex_Lock(WorkerMutex);
+ errmsg = WorkerError;
+ MThreading::Mutex_Unlock(WorkerMutex);
+
+ if(errmsg.size())
+  throw MDFN_Error(0, "%s", errmsg.c_str());
 }
 
 bool MDFNSRW_Frame(bool rewind) noexcept
+{
+ return MDFNSRW_Seek(rewind ? 1 : 0);
+}
+
+bool MDFNSRW_Seek(uint32 count) noexcept
 {
  if(!Active)
   return false;
 
  try
  {
-  if(rewind)
+  CheckWorkerError();
+
+  if(count)
   {
-   return DoRewind();
+   return DoRewind(count);
   }
   else
   {
@@ -28,6 +28,10 @@ bool MDFNSRW_IsRunning(void) noexcept;
 void MDFNSRW_Begin(void) noexcept;
 void MDFNSRW_End(void) noexcept;
 bool MDFNSRW_Frame(bool) noexcept;
+
+// Rewinds 'count' frames(loading the state from that many frames ago), or records the current state if 'count' is 0.
+// Returns true if a state was loaded.
+bool MDFNSRW_Seek(uint32 count) noexcept;
 }
 
 #endif
@@ -131,6 +131,25 @@ std::string StrTime(const char* format, const struct tm& tin)
  return ret;
 }
 
+int64 MonoNS(void)
+{
+ if(MDFN_UNLIKELY(!Initialized))
+  Time_Init();
+
+ {
+  struct timespec tp;
+
+  if(MDFN_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &tp) == -1))
+  {
+   ErrnoHolder ene(errno);
+
+   throw MDFN_Error(ene.Errno(), _("%s failed: %s"), "clock_gettime()", ene.StrError());
+  }
+
+  return (int64)(tp.tv_sec - cgt_base.tv_sec) * 1000 * 1000 * 1000 + (tp.tv_nsec - cgt_base.tv_nsec);
+ }
+}
+
 int64 MonoUS(void)
 {
  if(MDFN_UNLIKELY(!Initialized))
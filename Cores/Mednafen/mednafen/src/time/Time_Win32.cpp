@@ -32,17 +32,35 @@ namespace Time
 
 static bool Initialized = false;
 static uint32 tgt_base;
+static LARGE_INTEGER qpc_base, qpc_freq;
 static BOOL WINAPI (*p_GetTimeZoneInformationForYear)(USHORT, PDYNAMIC_TIME_ZONE_INFORMATION, LPTIME_ZONE_INFORMATION);
 
 void Time_Init(void)
 {
  tgt_base = timeGetTime();
 
+ QueryPerformanceFrequency(&qpc_freq);
+ QueryPerformanceCounter(&qpc_base);
+
  p_GetTimeZoneInformationForYear = (decltype(p_GetTimeZoneInformationForYear))Win32Common::GetProcAddress_TOE(Win32Common::GetModuleHandle_TOE(TEXT("kernel32.dll")), "GetTimeZoneInformationForYear");
  //
  Initialized = true;
 }
 
+int64 MonoNS(void)
+{
+ if(MDFN_UNLIKELY(!Initialized))
+  Time_Init();
+
+ LARGE_INTEGER qpc;
+ int64 t;
+
+ QueryPerformanceCounter(&qpc);
+ t = qpc.QuadPart - qpc_base.QuadPart;
+
+ return (t / qpc_freq.QuadPart) * 1000 * 1000 * 1000 + (t % qpc_freq.QuadPart) * 1000 * 1000 * 1000 / qpc_freq.QuadPart;
+}
+
 int64 MonoUS(void)
 {
  if(MDFN_UNLIKELY(!Initialized))
@@ -22,6 +22,15 @@
 #include <mednafen/mednafen.h>
 #include <mednafen/video/surface.h>
 #include <mednafen/video/convert.h>
+#include <mednafen/cputest/cputest.h>
+
+#if defined(HAVE_SSE2_INTRINSICS)
+ #include <immintrin.h>
+#endif
+
+#ifdef HAVE_NEON_INTRINSICS
+ #include <arm_neon.h>
+#endif
 
 namespace Mednafen
 {
@@ -136,18 +145,21 @@ static NO_INLINE void Convert_Fast(const void* src, void* dest, uint32 count, co
  }
 }
 
-template<bool src_equals_dest>
-static void Convert_xxxx8888(const void* src, void* dest, uint32 count, const MDFN_PixelFormatConverter::convert_context* ctx)
+//
+// sh[n] is the destination shift for source byte n.
+//
+static INLINE void CalcSwizzleShifts(const MDFN_PixelFormat& spf, const MDFN_PixelFormat& dpf, unsigned* sh)
 {
- const MDFN_PixelFormat spf = ctx->spf;
- const MDFN_PixelFormat dpf = ctx->dpf;
  const unsigned tmp = (0 << spf.Rshift) | (1 << spf.Gshift) | (2 << spf.Bshift) | (3 << spf.Ashift);
  const unsigned drs[4] = { dpf.Rshift, dpf.Gshift, dpf.Bshift, dpf.Ashift };
- const unsigned sh[4] = { (uint8)drs[(tmp >> 0) & 3], (uint8)drs[(tmp >> 8) & 3], (uint8)drs[(tmp >> 16) & 3], (uint8)drs[(tmp >> 24) & 3] };
- uint32* src_row = (uint32*)src;
- uint32* dest_row = src_equals_dest ? src_row : (uint32*)dest;
 
- for(unsigned x = 0; MDFN_LIKELY(x < count); x++)
+ for(unsigned i = 0; i < 4; i++)
+  sh[i] = (uint8)drs[(tmp >> (i * 8)) & 3];
+}
+
+static INLINE void Convert_xxxx8888_Tail(const uint32* src_row, uint32* dest_row, uint32 x, const uint32 count, const unsigned* sh)
+{
+ for(; MDFN_LIKELY(x < count); x++)
  {
   uint32 c = src_row[x];
 
@@ -155,9 +167,135 @@ static void Convert_xxxx8888(const void* src, void* dest, uint32 count, const MD
  }
 }
 
+template<bool src_equals_dest>
+static void Convert_xxxx8888(const void* src, void* dest, uint32 count, const MDFN_PixelFormatConverter::convert_context* ctx)
+{
+ unsigned sh[4];
+ uint32* src_row = (uint32*)src;
+ uint32* dest_row = src_equals_dest ? src_row : (uint32*)dest;
+
+ CalcSwizzleShifts(ctx->spf, ctx->dpf, sh);
+ Convert_xxxx8888_Tail(src_row, dest_row, 0, count, sh);
+}
+
+//
+// Scalar remainders for the SIMD kernels; same results as Convert_Fast<> for the corresponding formats.
+//
+static INLINE void Convert_8888_565_Tail(const uint32* src_row, uint16* dest_row, uint32 x, const uint32 count, const MDFN_PixelFormat& spf)
+{
+ for(; x < count; x++)
+ {
+  const uint32 c = src_row[x];
+
+  dest_row[x] = (MDFN_PixelFormat::LUT8to5[(uint8)(c >> spf.Rshift)] << 11) | (MDFN_PixelFormat::LUT8to6[(uint8)(c >> spf.Gshift)] << 5) | (MDFN_PixelFormat::LUT8to5[(uint8)(c >> spf.Bshift)] << 0);
+ }
+}
+
+static INLINE void Convert_565_8888_Tail(const uint16* src_row, uint32* dest_row, uint32 x, const uint32 count, const MDFN_PixelFormat& dpf)
+{
+ for(; x < count; x++)
+ {
+  const uint32 c = src_row[x];
+
+  dest_row[x] = (MDFN_PixelFormat::LUT5to8[(c >> 11) & 0x1F] << dpf.Rshift) | (MDFN_PixelFormat::LUT6to8[(c >> 5) & 0x3F] << dpf.Gshift) | (MDFN_PixelFormat::LUT5to8[(c >> 0) & 0x1F] << dpf.Bshift);
+ }
+}
+
+#if defined(HAVE_SSE2_INTRINSICS)
+ #include "convert_sse2.inc"
+ #if defined(__GNUC__)
+  #define HAVE_CONVERT_AVX2 1
+  #include "convert_avx2.inc"
+ #endif
+#endif
+
+#ifdef HAVE_NEON_INTRINSICS
+ #include "convert_neon.inc"
+#endif
+
+//
+// Returns nullptr if there's no SIMD kernel for the conversion, or the CPU doesn't support it.
+//
+template<bool src_equals_dest>
+static MDFN_PixelFormatConverter::convert_func CalcConversionFunction_SIMD(const MDFN_PixelFormat& spf, const MDFN_PixelFormat& dpf)
+{
+ if(spf.colorspace != MDFN_COLORSPACE_RGB || dpf.colorspace != MDFN_COLORSPACE_RGB)
+  return nullptr;
+
+ const bool s8888 = spf.opp == 4 && !((spf.Rshift | spf.Gshift | spf.Bshift | spf.Ashift) & 7);
+ const bool d8888 = dpf.opp == 4 && !((dpf.Rshift | dpf.Gshift | dpf.Bshift | dpf.Ashift) & 7);
+ const bool s565 = spf.tag == MDFN_PixelFormat::RGB16_565;
+ const bool d565 = dpf.tag == MDFN_PixelFormat::RGB16_565;
+ const bool spal = spf.opp == 1;
+#if defined(HAVE_SSE2_INTRINSICS) || defined(HAVE_NEON_INTRINSICS)
+ const uint32 cpuext = cputest_get_flags();
+#endif
+
+ (void)s8888; (void)d8888; (void)s565; (void)d565; (void)spal;
+
+#if defined(HAVE_CONVERT_AVX2)
+ if(cpuext & CPUTEST_FLAG_AVX2)
+ {
+  if(s8888 && d8888)
+   return Convert_xxxx8888_AVX2<src_equals_dest>;
+
+  if(!src_equals_dest)
+  {
+   if(s8888 && d565)
+    return Convert_8888_565_AVX2;
+
+   if(s565 && d8888)
+    return Convert_565_8888_AVX2;
+
+   if(spal && dpf.opp == 4)
+    return Convert_Pal8_8888_AVX2;
+  }
+ }
+#endif
+
+#if defined(HAVE_SSE2_INTRINSICS)
+ if(cpuext & CPUTEST_FLAG_SSE2)
+ {
+  if(s8888 && d8888)
+   return Convert_xxxx8888_SSE2<src_equals_dest>;
+
+  if(!src_equals_dest)
+  {
+   if(s8888 && d565)
+    return Convert_8888_565_SSE2;
+
+   if(s565 && d8888)
+    return Convert_565_8888_SSE2;
+  }
+ }
+#endif
+
+#if defined(HAVE_NEON_INTRINSICS)
+ // cputest doesn't detect NEON; HAVE_NEON_INTRINSICS means the compiler was told it's always available.
+ (void)cpuext;
+
+ if(s8888 && d8888)
+  return Convert_xxxx8888_NEON<src_equals_dest>;
+
+ if(!src_equals_dest)
+ {
+  if(s8888 && d565)
+   return Convert_8888_565_NEON;
+
+  if(s565 && d8888)
+   return Convert_565_8888_NEON;
+ }
+#endif
+
+ return nullptr;
+}
+
 template<bool src_equals_dest>
 static MDFN_PixelFormatConverter::convert_func CalcConversionFunction(const MDFN_PixelFormat& spf, const MDFN_PixelFormat& dpf)
 {
+ if(MDFN_PixelFormatConverter::convert_func f = CalcConversionFunction_SIMD<src_equals_dest>(spf, dpf))
+  return f;
+
 #if 1
  switch(spf.tag)
  {
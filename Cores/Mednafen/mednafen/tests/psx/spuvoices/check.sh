@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# Checks that the PSX SPU output for gen.py's workload is unchanged, with the SIMD voice mixing
+# and reverb kernels both off and on, and that the two agree frame by frame.
+#
+# Usage: check.sh <mednafen built with --enable-bench>
+#
+
+EXPECTED=38045116
+
+if [ $# -ne 1 ]; then
+	echo "Usage: $0 <mednafen built with --enable-bench>" >&2
+	exit 1
+fi
+
+BENCH="$1"
+DIR=`mktemp -d` || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+python3 "`dirname "$0"`/gen.py" "$DIR" || exit 1
+
+RESULT=0
+for SIMD in 0 1; do
+	CRC=`MEDNAFEN_HOME="$DIR/home" "$BENCH" -frames 600 -warmup 0 -audiohash -soundrate 44100 -set psx.bios_sanity 0 -set psx.spu.simd $SIMD "$DIR/test.exe" | sed -n 's/^Audio CRC32: \([0-9a-f]*\).*/\1/p'`
+	if [ "$CRC" = "$EXPECTED" ]; then
+		echo "psx.spu.simd $SIMD: $CRC OK"
+	else
+		echo "psx.spu.simd $SIMD: got '$CRC', expected $EXPECTED"
+		RESULT=1
+	fi
+done
+
+MEDNAFEN_HOME="$DIR/home" "$BENCH" -frames 300 -warmup 0 -soundrate 44100 -set psx.bios_sanity 0 -lockstep psx.spu.simd 0 1 "$DIR/test.exe" || RESULT=1
+
+exit $RESULT
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+#
+# Generates a synthetic SPU workload for the bench driver's -audiohash and -lockstep options.
+#
+# The program runs from the BIOS slot, so no real BIOS is needed.  It uploads four ADPCM samples
+# (random, short looping, sine, and high-shift noise-like), programs all 24 voices with assorted
+# volumes, volume sweeps, pitches and ADSR settings, sets up the "Room" reverb preset, and turns on
+# FM, noise and reverb for a mix of voices.  It then keys voices on and off and changes pitches in a
+# loop, forever.
+#
+# Usage: gen.py <dir>
+#
+# Writes <dir>/home/firmware/scph550[0-2].bin, an empty <dir>/home/mednafen.cfg, and a dummy
+# <dir>/test.exe.  See check.sh.
+#
+
+import math
+import os
+import random
+import struct
+import sys
+
+R = {'zero': 0, 'at': 1, 'v0': 2, 'v1': 3, 'a0': 4, 'a1': 5, 'a2': 6, 'a3': 7}
+for n in range(8):
+    R['t%d' % n] = 8 + n
+    R['s%d' % n] = 16 + n
+R.update({'t8': 24, 't9': 25, 'k0': 26, 'k1': 27, 'gp': 28, 'sp': 29, 'fp': 30, 'ra': 31})
+
+
+def rtype(rs, rt, rd, sh, fn):
+    return (R[rs] << 21) | (R[rt] << 16) | (R[rd] << 11) | (sh << 6) | fn
+
+
+def itype(op, rs, rt, imm):
+    return (op << 26) | (R[rs] << 21) | (R[rt] << 16) | (imm & 0xFFFF)
+
+
+# Just enough of an R3000A assembler for the program below.
+class Asm:
+    def __init__(s, base):
+        s.base = base
+        s.w = []
+        s.lab = {}
+        s.fix = []
+
+    def pc(s): return s.base + 4 * len(s.w)
+    def L(s, n): s.lab[n] = s.pc()
+    def e(s, x): s.w.append(x)
+
+    def addiu(s, t, a, im): s.e(itype(9, a, t, im))
+    def ori(s, t, a, im): s.e(itype(13, a, t, im))
+    def andi(s, t, a, im): s.e(itype(12, a, t, im))
+    def lui(s, t, im): s.e(itype(15, 'zero', t, im))
+    def lbu(s, t, o, b): s.e(itype(0x24, b, t, o))
+    def sh(s, t, o, b): s.e(itype(0x29, b, t, o))
+    def addu(s, d, a, b): s.e(rtype(a, b, d, 0, 0x21))
+    def or_(s, d, a, b): s.e(rtype(a, b, d, 0, 0x25))
+    def sll(s, d, a, sh): s.e(rtype('zero', a, d, sh, 0))
+    def srl(s, d, a, sh): s.e(rtype('zero', a, d, sh, 2))
+    def mult(s, a, b): s.e(rtype(a, b, 'zero', 0, 0x18))
+    def mflo(s, d): s.e(rtype('zero', 'zero', d, 0, 0x12))
+    def nop(s): s.e(0)
+    def bne(s, a, b, l): s.fix.append((len(s.w), 'b', l)); s.e(itype(5, a, b, 0))
+    def j(s, l): s.fix.append((len(s.w), 'j', l)); s.e(2 << 26)
+    def li(s, t, v): s.lui(t, v >> 16); s.ori(t, t, v & 0xFFFF)
+
+    def done(s):
+        for idx, k, l in s.fix:
+            t = s.lab[l]
+            if k == 'b':
+                s.w[idx] |= ((t - (s.base + 4 * idx + 4)) >> 2) & 0xFFFF
+            else:
+                s.w[idx] |= (t >> 2) & 0x3FFFFFF
+        return b''.join(struct.pack('<I', x) for x in s.w)
+
+
+if len(sys.argv) != 2:
+    sys.exit("Usage: gen.py <dir>")
+out = sys.argv[1]
+
+random.seed(7)
+
+
+def block(shift, filt, flags, nib=None):
+    b = bytearray(16)
+    b[0] = (filt << 4) | shift
+    b[1] = flags
+    for k in range(14):
+        b[2 + k] = random.randrange(256) if nib is None else nib[k]
+    return bytes(b)
+
+
+# ADPCM samples, uploaded to SPU RAM at 0x1000.
+samples = []
+data = bytearray()
+base = 0x1000
+
+
+def add(blocks):
+    global data
+    samples.append(base + len(data))
+    data += b''.join(blocks)
+
+
+add([block(random.randrange(0, 13), random.randrange(0, 5), (4 if q == 0 else 0) | (3 if q == 27 else 0)) for q in range(28)])
+add([block(random.randrange(0, 13), random.randrange(0, 5), 1 if q == 9 else 0) for q in range(10)])
+blk = []
+for q in range(16):
+    nib = []
+    for k in range(14):
+        v = [int(7 * math.sin((q * 28 + k * 2 + j) * 2 * math.pi / 56)) & 0xF for j in range(2)]
+        nib.append(v[0] | (v[1] << 4))
+    blk.append(block(8, 0, (4 if q == 0 else 0) | (3 if q == 15 else 0), nib))
+add(blk)
+add([block(13 + random.randrange(3), random.randrange(0, 16), (4 if q == 0 else 0) | (3 if q == 7 else 0)) for q in range(8)])
+if len(data) & 1:
+    data += b'\0'
+
+# Voice registers: volume L/R(fixed and sweeping), pitch, start address, ADSR, current volume, repeat.
+pitches = [0x1000, 0x0800, 0x2345, 0x3FFF, 0x7000, 0x0123, 0x1800, 0x0400]
+voices = []
+for q in range(24):
+    volL = random.choice([0x3FFF, 0x2000, 0x7FFF, 0x4000 | 0x1234 & 0x3FFF, 0x8000 | 0x0040 | random.randrange(0x7F), 0xC000 | random.randrange(0x7F), 0xA000 | random.randrange(0x7F)])
+    volR = random.choice([0x3FFF, 0x1000, 0x7FFF, 0x8000 | random.randrange(0x7F), 0xE000 | random.randrange(0x7F)])
+    a1 = (random.randrange(2) << 15) | (random.randrange(0x30, 0x7F) << 8) | (random.randrange(16) << 4) | random.randrange(16)
+    a2 = (random.randrange(2) << 15) | (random.randrange(2) << 14) | (random.randrange(0x7F) << 6) | (random.randrange(2) << 5) | random.randrange(0x20)
+    voices.append([volL, volR, pitches[q % 8] ^ (q * 0x111 & 0x3FF), samples[q % 4] // 8, a1, a2, 0, 0])
+
+# "Room" reverb preset, 0x1F801DC0-0x1F801DFF.
+room = [0x007D, 0x005B, 0x6D80, 0x54B8, 0xBED0, 0x0000, 0x0000, 0xBA80, 0x5800, 0x5300, 0x04D6, 0x0333, 0x03F0, 0x0227, 0x0374, 0x01EF,
+        0x0334, 0x01B5, 0, 0, 0, 0, 0, 0, 0, 0, 0x01B4, 0x0136, 0x00B8, 0x005C, 0x8000, 0x8000]
+
+b = Asm(0xBFC00000)
+b.li('t0', 0x1F801C00)
+b.sh('zero', 0x1AA, 't0')
+# Upload the samples through the data port.
+b.ori('t1', 'zero', base // 8)
+b.sh('t1', 0x1A6, 't0')
+b.li('a0', 0xBFC10000)
+b.ori('a2', 'zero', len(data) // 2)
+b.L('up')
+b.lbu('t2', 0, 'a0'); b.lbu('t3', 1, 'a0'); b.sll('t3', 't3', 8); b.or_('t2', 't2', 't3')
+b.sh('t2', 0x1A8, 't0')
+b.addiu('a0', 'a0', 2); b.addiu('a2', 'a2', -1); b.bne('a2', 'zero', 'up'); b.nop()
+# Voice registers, all 8 halfwords of each voice.
+b.li('a0', 0xBFC18000)
+b.or_('a1', 't0', 'zero')
+b.ori('a2', 'zero', 24 * 8)
+b.L('vc')
+b.lbu('t2', 0, 'a0'); b.lbu('t3', 1, 'a0'); b.sll('t3', 't3', 8); b.or_('t2', 't2', 't3')
+b.sh('t2', 0, 'a1')
+b.addiu('a0', 'a0', 2)
+b.ori('t4', 'zero', 0)
+b.addiu('a1', 'a1', 2)
+b.addiu('a2', 'a2', -1); b.bne('a2', 'zero', 'vc'); b.nop()
+# Reverb registers.
+b.li('a0', 0xBFC19000)
+b.addiu('a1', 't0', 0x1C0)
+b.ori('a2', 'zero', 32)
+b.L('rv')
+b.lbu('t2', 0, 'a0'); b.lbu('t3', 1, 'a0'); b.sll('t3', 't3', 8); b.or_('t2', 't2', 't3')
+b.sh('t2', 0, 'a1')
+b.addiu('a0', 'a0', 2); b.addiu('a2', 'a2', -1); b.bne('a2', 'zero', 'rv'); b.addiu('a1', 'a1', 2)
+
+
+def w(off, val):
+    b.ori('t1', 'zero', val)
+    b.sh('t1', off, 't0')
+
+
+w(0x180, 0x3FFF); w(0x182, 0x3FFF)     # main volume
+w(0x184, 0x3000); w(0x186, 0xD000)     # reverb output volume
+w(0x190, 0x0180)                       # FM
+w(0x194, 0x0020)                       # noise
+w(0x198, 0xFFFF); w(0x19A, 0x00F0)     # reverb enable
+w(0x1A2, 0xE000)                       # reverb work area
+w(0x1AA, 0xCA80)                       # SPUCNT: enable, unmute, reverb master, noise clock
+w(0x188, 0xFFFF); w(0x18A, 0x00FF)     # key on all voices
+b.ori('s0', 'zero', 0)
+b.L('main')
+b.li('t5', 12000)
+b.L('dl'); b.addiu('t5', 't5', -1); b.bne('t5', 'zero', 'dl'); b.nop()
+b.addiu('s0', 's0', 1)
+# Key off a pseudo-random set of voices...
+b.ori('t1', 'zero', 0x1357); b.mult('s0', 't1'); b.mflo('t2')
+b.andi('t3', 't2', 0xFFFF); b.sh('t3', 0x18C, 't0')
+b.li('t5', 6000)
+b.L('dl2'); b.addiu('t5', 't5', -1); b.bne('t5', 'zero', 'dl2'); b.nop()
+# ...key on another...
+b.srl('t3', 't2', 3); b.andi('t3', 't3', 0xFFFF); b.sh('t3', 0x188, 't0')
+b.andi('t4', 't2', 0xFF); b.sh('t4', 0x18A, 't0')
+# ...and change the pitch of voice s0 & 15.
+b.andi('t6', 's0', 15); b.sll('t6', 't6', 4); b.addu('t6', 't6', 't0')
+b.srl('t7', 't2', 2); b.andi('t7', 't7', 0x3FFF); b.sh('t7', 4, 't6')
+b.j('main'); b.nop()
+boot = b.done()
+
+bios = bytearray(512 * 1024)
+bios[0:len(boot)] = boot
+bios[0x10000:0x10000 + len(data)] = data
+vt = b''.join(struct.pack('<8H', *v) for v in voices)
+bios[0x18000:0x18000 + len(vt)] = vt
+bios[0x19000:0x19000 + 64] = struct.pack('<32H', *room)
+
+for d in ['firmware', 'mcm', 'mcs', 'sav']:
+    os.makedirs(os.path.join(out, 'home', d), exist_ok=True)
+for f in ['scph5500.bin', 'scph5501.bin', 'scph5502.bin']:
+    open(os.path.join(out, 'home', 'firmware', f), 'wb').write(bios)
+open(os.path.join(out, 'home', 'mednafen.cfg'), 'w').close()
+
+# Only there so the PSX module has something to load; the BIOS never boots it.
+hdr = bytearray(0x800)
+hdr[0:8] = b'PS-X EXE'
+struct.pack_into('<IIII', hdr, 0x10, 0x80010000, 0, 0x80010000, 0x800)
+struct.pack_into('<I', hdr, 0x30, 0x801FFF00)
+open(os.path.join(out, 'test.exe'), 'wb').write(hdr + bytes(0x800))
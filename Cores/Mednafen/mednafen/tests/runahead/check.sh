@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# Checks that run-ahead doesn't change the sound output: for each of gen.py's workloads, the sound of run-ahead 0, 1 and
+# 2 must match the expected hash.  A mismatch with run-ahead 1 or 2 only means that some sound output state(resampler
+# history, last output amplitudes, etc.) isn't covered by the module's SoundOutputStateAction, or that its save states
+# miss something.
+#
+# Usage: check.sh <mednafen built with --enable-bench>
+#
+
+if [ $# -ne 1 ]; then
+	echo "Usage: $0 <mednafen built with --enable-bench>" >&2
+	exit 1
+fi
+
+BENCH="$1"
+DIR=`mktemp -d` || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+python3 "`dirname "$0"`/gen.py" "$DIR" || exit 1
+
+RESULT=0
+while read MODULE FILE EXPECTED; do
+	for RA in 0 1 2; do
+		CRC=`MEDNAFEN_HOME="$DIR/home" "$BENCH" -module $MODULE -frames 300 -warmup 0 -audiohash -soundrate 48000 -runahead $RA "$DIR/$FILE" | sed -n 's/^Audio CRC32: \([0-9a-f]*\).*/\1/p'`
+		if [ "$CRC" = "$EXPECTED" ]; then
+			echo "$MODULE, run-ahead $RA: $CRC OK"
+		else
+			echo "$MODULE, run-ahead $RA: got '$CRC', expected $EXPECTED"
+			RESULT=1
+		fi
+	done
+done <<EOF
+nes nes.nes 85b2f663
+gb gb.gb eb7eefcd
+pce pce.pce 878db025
+pce_fast pce.pce 3d263e0b
+snes snes.sfc 08e41d82
+snes_faust snes.sfc 92c01ffc
+lynx lynx.o 9a211656
+EOF
+
+exit $RESULT
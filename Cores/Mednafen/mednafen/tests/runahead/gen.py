@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+#
+# Generates small sound workloads for checking run-ahead with the bench driver's -runahead and -audiohash options.
+#
+# Each program sets up the sound hardware of its system and then changes pitches, volumes and key-ons forever, with no
+# input and no video, so the sound output of a run depends only on how many frames were emulated.  Run-ahead must not
+# change it: the frames it emulates ahead are rolled back, so the sound of run-ahead 0, 1 and 2 has to be identical.
+#
+# Usage: gen.py <dir>
+#
+# Writes <dir>/nes.nes, <dir>/gb.gb, <dir>/pce.pce, <dir>/snes.sfc and <dir>/lynx.o, plus <dir>/home/mednafen.cfg(empty)
+# and a dummy <dir>/home/firmware/lynxboot.img(homebrew .o files run without the boot ROM, but it has to exist).
+# See check.sh.
+#
+
+import os
+import struct
+import sys
+
+
+# Just enough of a 6502 assembler(plus the few HuC6280 and 65816 opcodes needed) for the programs below.
+class Asm6502:
+    IMM = {'lda': 0xA9, 'ldx': 0xA2, 'ldy': 0xA0, 'cmp': 0xC9, 'and': 0x29, 'eor': 0x49, 'ora': 0x09, 'adc': 0x69,
+           'cpx': 0xE0, 'tam': 0x53}
+    ABS = {'lda': 0xAD, 'sta': 0x8D, 'stx': 0x8E, 'sty': 0x8C, 'inc': 0xEE, 'jmp': 0x4C, 'adc': 0x6D, 'cmp': 0xCD}
+    ABSX = {'lda': 0xBD, 'sta': 0x9D}
+    ZP = {'lda': 0xA5, 'sta': 0x85, 'inc': 0xE6, 'adc': 0x65, 'eor': 0x45, 'dec': 0xC6}
+    IMPL = {'sei': 0x78, 'cld': 0xD8, 'txs': 0x9A, 'dex': 0xCA, 'dey': 0x88, 'inx': 0xE8, 'iny': 0xC8, 'rti': 0x40,
+            'asl': 0x0A, 'lsr': 0x4A, 'clc': 0x18, 'tax': 0xAA, 'txa': 0x8A, 'tay': 0xA8, 'tya': 0x98, 'csh': 0xD4,
+            'xce': 0xFB}
+    REL = {'bne': 0xD0, 'beq': 0xF0, 'bpl': 0x10, 'bmi': 0x30, 'bcc': 0x90, 'bcs': 0xB0}
+
+    def __init__(s, base):
+        s.base = base
+        s.b = bytearray()
+        s.lab = {}
+        s.fix = []
+
+    def pc(s): return s.base + len(s.b)
+    def L(s, n): s.lab[n] = s.pc()
+
+    def imm(s, op, v): s.b += bytes([s.IMM[op], v & 0xFF])
+    def abs(s, op, a): s.b += bytes([s.ABS[op]]) + struct.pack('<H', a)
+    def absx(s, op, a): s.b += bytes([s.ABSX[op]]) + struct.pack('<H', a)
+    def zp(s, op, a): s.b += bytes([s.ZP[op], a])
+    def op(s, op): s.b.append(s.IMPL[op])
+    def rel(s, op, l): s.fix.append((len(s.b), l)); s.b += bytes([s.REL[op], 0])
+    def jmp(s, l): s.fix.append((len(s.b), l)); s.b += bytes([s.ABS['jmp'], 0, 0])
+
+    def w(s, addr, val):
+        s.imm('lda', val)
+        s.abs('sta', addr)
+
+    # Busy-waits for about 5 * 256 * count cycles.
+    def delay(s, count):
+        n = 'dl%d' % len(s.b)
+        s.imm('ldy', count)
+        s.L(n)
+        s.imm('ldx', 0)
+        s.L(n + 'x')
+        s.op('dex')
+        s.rel('bne', n + 'x')
+        s.op('dey')
+        s.rel('bne', n)
+
+    def done(s):
+        for idx, l in s.fix:
+            t = s.lab[l]
+            if s.b[idx] == s.ABS['jmp']:
+                s.b[idx + 1:idx + 3] = struct.pack('<H', t)
+            else:
+                d = t - (s.base + idx + 2)
+                assert -128 <= d < 128
+                s.b[idx + 1] = d & 0xFF
+        return bytes(s.b)
+
+
+def nes():
+    # NROM, 16KiB PRG at $C000.  Square, triangle and noise with sweeps and envelopes, DMC off.
+    a = Asm6502(0xC000)
+    a.L('reset')
+    a.op('sei'); a.op('cld'); a.imm('ldx', 0xFF); a.op('txs')
+    a.w(0x4017, 0x40)
+    a.w(0x4015, 0x0F)
+    a.w(0x4000, 0x8A); a.w(0x4001, 0x9B)
+    a.w(0x4004, 0x5F); a.w(0x4005, 0x00)
+    a.w(0x4008, 0xC0)
+    a.w(0x400C, 0x3C)
+    a.L('main')
+    a.zp('inc', 0)
+    a.zp('lda', 0); a.abs('sta', 0x4002); a.w(0x4003, 0x01)
+    a.zp('lda', 0); a.imm('eor', 0x5A); a.abs('sta', 0x4006); a.w(0x4007, 0x02)
+    a.zp('lda', 0); a.op('asl'); a.abs('sta', 0x400A); a.w(0x400B, 0x08)
+    a.zp('lda', 0); a.imm('and', 0x8F); a.abs('sta', 0x400E); a.w(0x400F, 0x18)
+    a.delay(0x13)
+    a.jmp('main')
+    a.L('irq')
+    a.op('rti')
+    prg = bytearray(a.done().ljust(0x4000 - 6, b'\xFF'))
+    prg += struct.pack('<HHH', a.lab['irq'], a.lab['reset'], a.lab['irq'])
+    return b'NES\x1A' + bytes([1, 0, 0, 0]) + bytes(8) + prg
+
+
+def pce():
+    # HuCard, bank 0 at $E000.  All six PSG channels with different waveforms, noise on channel 5 and the LFO on
+    # channel 1.
+    a = Asm6502(0xE000)
+    a.L('reset')
+    a.op('sei'); a.op('csh'); a.op('cld'); a.imm('ldx', 0xFF); a.op('txs')
+    a.imm('lda', 0xFF); a.imm('tam', 0x01)
+    a.imm('lda', 0xF8); a.imm('tam', 0x02)
+    a.w(0x0801, 0xFF)
+    a.imm('ldy', 0)
+    a.L('ch')
+    a.op('tya'); a.abs('sta', 0x0800)
+    a.w(0x0804, 0x00)
+    a.w(0x0805, 0xFF)
+    a.imm('ldx', 32)
+    a.L('wave')
+    a.op('txa'); a.zp('eor', 0x10); a.zp('adc', 0x10); a.imm('and', 0x1F); a.abs('sta', 0x0806)
+    a.zp('sta', 0x10)
+    a.op('dex')
+    a.rel('bne', 'wave')
+    a.w(0x0804, 0x9A)
+    a.op('iny'); a.op('tya'); a.imm('cmp', 6)
+    a.rel('bne', 'ch')
+    a.w(0x0800, 0x05); a.w(0x0807, 0x85)
+    a.w(0x0808, 0x10); a.w(0x0809, 0x01)
+    a.L('main')
+    a.zp('inc', 0)
+    a.imm('ldy', 0)
+    a.L('freq')
+    a.op('tya'); a.abs('sta', 0x0800)
+    a.zp('lda', 0); a.zp('adc', 0x10); a.abs('sta', 0x0802)
+    a.op('tya'); a.imm('and', 0x03); a.abs('sta', 0x0803)
+    a.zp('lda', 0); a.imm('and', 0x0F); a.imm('ora', 0x90); a.abs('sta', 0x0804)
+    a.op('iny'); a.op('tya'); a.imm('cmp', 6)
+    a.rel('bne', 'freq')
+    a.delay(0x40)
+    a.jmp('main')
+    a.L('irq')
+    a.op('rti')
+    bank = bytearray(a.done().ljust(0x2000 - 10, b'\xFF'))
+    bank += struct.pack('<HHHHH', a.lab['irq'], a.lab['irq'], a.lab['irq'], a.lab['irq'], a.lab['reset'])
+    return bytes(bank)
+
+
+def lynx():
+    # Homebrew .o file, run from $0200 without the boot ROM.  All four audio channels, two of them in integrate mode,
+    # with changing attenuation.
+    a = Asm6502(0x0200)
+    a.op('sei'); a.op('cld'); a.imm('ldx', 0xFF); a.op('txs')
+    a.w(0xFD50, 0x00)
+    a.w(0xFD44, 0xFF)
+    for ch in range(4):
+        r = 0xFD20 + ch * 8
+        a.w(r + 0, 0x30 + ch * 8)
+        a.w(r + 1, [0x01, 0x31, 0x0F, 0x83][ch])
+        a.w(r + 3, [0x01, 0x5A, 0x33, 0x01][ch])
+        a.w(r + 4, [0x20, 0x40, 0x13, 0x08][ch])
+        a.w(r + 7, [0x00, 0x00, 0x01, 0x00][ch])
+        a.w(r + 5, [0x18, 0x39, 0x1A, 0x19][ch])
+        a.w(0xFD40 + ch, [0xFF, 0x8F, 0xF8, 0x44][ch])
+    a.L('main')
+    a.zp('inc', 0x80)
+    a.zp('lda', 0x80); a.abs('sta', 0xFD24)
+    a.imm('eor', 0x37); a.abs('sta', 0xFD2C)
+    a.op('asl'); a.abs('sta', 0xFD34)
+    a.zp('lda', 0x80); a.imm('and', 0x3F); a.abs('sta', 0xFD38)
+    a.op('lsr'); a.op('lsr'); a.abs('sta', 0xFD40)
+    a.delay(0x40)
+    a.jmp('main')
+    code = a.done()
+    return struct.pack('>HHH', 0x0880, 0x0200 + 10, len(code)) + b'BS93' + code
+
+
+def gb():
+    # 32KiB ROM-only cartridge.  Both square channels(one with sweep), the wave channel and noise, retriggered with
+    # changing frequencies and envelopes.
+    c = bytearray()
+    lab = {}
+
+    def ldh(reg, val): c.extend([0x3E, val, 0xE0, reg])
+    ldh(0x26, 0x80); ldh(0x24, 0x77); ldh(0x25, 0xDE)
+    ldh(0x10, 0x27); ldh(0x11, 0x80); ldh(0x12, 0xF3)
+    ldh(0x16, 0x40); ldh(0x17, 0xA5)
+    ldh(0x1A, 0x00)
+    for i in range(16):
+        ldh(0x30 + i, (i * 0x37 + 0x19) & 0xFF)
+    ldh(0x1A, 0x80); ldh(0x1C, 0x40)
+    ldh(0x21, 0xF1)
+    c.extend([0x06, 0x00])                          # ld b, 0
+    lab['main'] = len(c)
+    c.extend([0x04])                                # inc b
+    c.extend([0x78, 0xE0, 0x13, 0x3E, 0x86, 0xE0, 0x14])    # ld a,b; ldh (13),a; ld a,$86; ldh (14),a
+    c.extend([0x78, 0xEE, 0x5A, 0xE0, 0x18, 0x3E, 0x85, 0xE0, 0x19])    # ld a,b; xor $5A; ldh (18),a; ...
+    c.extend([0x78, 0x07, 0xE0, 0x1D, 0x3E, 0x87, 0xE0, 0x1E])          # ld a,b; rlca; ldh (1D),a; ...
+    c.extend([0x78, 0xE6, 0x77, 0xE0, 0x22, 0x3E, 0x80, 0xE0, 0x23])    # ld a,b; and $77; ldh (22),a; ...
+    c.extend([0x11, 0x00, 0x0A])                    # ld de, $0A00
+    lab['delay'] = len(c)
+    c.extend([0x1B, 0x7A, 0xB3])                    # dec de; ld a,d; or e
+    c.extend([0x20, (lab['delay'] - (len(c) + 2)) & 0xFF])
+    c.extend([0x18, (lab['main'] - (len(c) + 2)) & 0xFF])
+
+    rom = bytearray(0x8000)
+    rom[0x100:0x104] = bytes([0x00, 0xC3, 0x50, 0x01])
+    rom[0x104:0x134] = bytes.fromhex('CEED6666CC0D000B03730083000C000D0008111F8889000EDCCC6EE6DDDDD999BBBB67636E0EECCCDDDC999FBBB9333E')
+    rom[0x134:0x143] = b'RUNAHEAD'.ljust(15, b'\0')
+    rom[0x14D] = (-sum(rom[0x134:0x14D]) - 0x19) & 0xFF
+    rom[0x150:0x150 + len(c)] = c
+    return bytes(rom)
+
+
+def snes():
+    # 32KiB LoROM.  Uploads an SPC700 program through the IPL ROM; it plays a looping BRR sample on four voices with
+    # noise, pitch modulation and echo, and keys them on and off with changing pitches.
+    s = bytearray()
+    lab = {}
+
+    def dsp(reg, val): s.extend([0x8F, reg, 0xF2, 0x8F, val, 0xF3])    # mov $F2,#reg; mov $F3,#val
+    s.extend([0x20, 0xCD, 0xEF, 0xBD])              # clrp; mov x,#$EF; mov sp,x
+    dsp(0x6C, 0x20); dsp(0x0C, 0x60); dsp(0x1C, 0x60); dsp(0x2C, 0x20); dsp(0x3C, 0xE0)
+    dsp(0x5D, 0x03); dsp(0x6D, 0x60); dsp(0x7D, 0x02); dsp(0x0D, 0x40)
+    for i, c in enumerate([0x7F, 0x20, 0x10, 0x08, 0x00, 0xF8, 0xF0, 0x00]):
+        dsp(0x0F + i * 0x10, c)
+    for v in range(4):
+        dsp(v * 0x10 + 0, 0x50 - v * 8); dsp(v * 0x10 + 1, 0x30 + v * 8)
+        dsp(v * 0x10 + 2, 0x00); dsp(v * 0x10 + 3, 0x08 + v * 4)
+        dsp(v * 0x10 + 4, 0x00); dsp(v * 0x10 + 5, 0xCA + v); dsp(v * 0x10 + 6, 0x2E)
+    dsp(0x2D, 0x04); dsp(0x3D, 0x08); dsp(0x4D, 0x03)
+    dsp(0x6C, 0x05)
+    lab['main'] = len(s)
+    s.extend([0xAB, 0x10])                                              # inc $10
+    s.extend([0x8F, 0x02, 0xF2, 0xE4, 0x10, 0xC4, 0xF3])                # V0 pitch = $10
+    s.extend([0x8F, 0x12, 0xF2, 0x48, 0x55, 0xC4, 0xF3])                # V1 pitch = $10 ^ $55
+    s.extend([0x8F, 0x5C, 0xF2, 0xE4, 0x10, 0x28, 0x05, 0xC4, 0xF3])    # KOFF = $10 & $05
+    s.extend([0x8F, 0x4C, 0xF2, 0xE4, 0x10, 0x48, 0x0F, 0xC4, 0xF3])    # KON = $10 ^ $0F
+    s.extend([0x8D, 0x30])                                              # mov y,#$30
+    lab['dy'] = len(s)
+    s.extend([0xCD, 0x00])                                              # mov x,#0
+    lab['dx'] = len(s)
+    s.extend([0x1D, 0xD0, (lab['dx'] - (len(s) + 3)) & 0xFF])           # dec x; bne
+    s.extend([0xDC, 0xD0, (lab['dy'] - (len(s) + 3)) & 0xFF])           # dec y; bne
+    s.extend([0x2F, (lab['main'] - (len(s) + 2)) & 0xFF])               # bra main
+
+    # Sample directory at $0300, the BRR sample(a looped ramp) at $0400, code at $0500; sent in blocks of at most 128
+    # bytes so the 8-bit transfer index never wraps.
+    brr = bytes([0xB0, 0x01, 0x23, 0x45, 0x67, 0x76, 0x54, 0x32, 0x10,
+                 0xB3, 0xFE, 0xDC, 0xBA, 0x98, 0x89, 0xAB, 0xCD, 0xEF])
+    upload = [(0x0300, struct.pack('<HH', 0x0400, 0x0400)), (0x0400, brr)]
+    for i in range(0, len(s), 128):
+        upload.append((0x0500 + i, bytes(s[i:i + 128])))
+
+    data_base = 0x9000
+    a = Asm6502(0x8000)
+    a.op('sei'); a.imm('ldx', 0xFF); a.op('txs')
+    a.L('ipl')
+    a.abs('lda', 0x2140); a.imm('cmp', 0xAA); a.rel('bne', 'ipl')
+    a.abs('lda', 0x2141); a.imm('cmp', 0xBB); a.rel('bne', 'ipl')
+    kick = 0xCC
+    blob = bytearray()
+    for n, (addr, data) in enumerate(upload + [(0x0500, b'')]):
+        a.w(0x2142, addr & 0xFF); a.w(0x2143, addr >> 8)
+        a.w(0x2141, 0x01 if data else 0x00)     # 0 starts the program at the address instead
+        a.w(0x2140, kick)
+        a.L('k%d' % n); a.abs('cmp', 0x2140); a.rel('bne', 'k%d' % n)
+        if not data:
+            break
+        a.imm('ldx', 0)
+        a.L('b%d' % n)
+        a.absx('lda', data_base + len(blob))
+        a.abs('sta', 0x2141)
+        a.op('txa'); a.abs('sta', 0x2140)
+        a.L('a%d' % n); a.abs('cmp', 0x2140); a.rel('bne', 'a%d' % n)
+        a.op('inx'); a.imm('cpx', len(data)); a.rel('bne', 'b%d' % n)
+        blob += data
+        kick = (len(data) + 1) & 0xFF or 1
+    a.L('forever')
+    a.jmp('forever')
+    a.L('nmi')
+    a.op('rti')
+    code = a.done()
+
+    rom = bytearray(b'\xFF' * 0x8000)
+    rom[0:len(code)] = code
+    rom[data_base - 0x8000:data_base - 0x8000 + len(blob)] = blob
+    rom[0x7FC0:0x7FD5] = b'RUNAHEAD'.ljust(21, b' ')
+    rom[0x7FD5:0x7FDC] = bytes([0x20, 0x00, 0x05, 0x00, 0x01, 0x33, 0x00])
+    rom[0x7FDC:0x7FE0] = struct.pack('<HH', 0xFFFF, 0x0000)
+    nmi = a.lab['nmi']
+    rom[0x7FE4:0x7FF0] = struct.pack('<HHHHHH', nmi, nmi, nmi, nmi, nmi, nmi)
+    rom[0x7FF4:0x8000] = struct.pack('<HHHHHH', nmi, nmi, nmi, nmi, 0x8000, nmi)
+    csum = sum(rom) & 0xFFFF
+    rom[0x7FDC:0x7FE0] = struct.pack('<HH', csum ^ 0xFFFF, csum)
+    return bytes(rom)
+
+
+if len(sys.argv) != 2:
+    sys.exit("Usage: gen.py <dir>")
+out = sys.argv[1]
+
+os.makedirs(os.path.join(out, 'home', 'firmware'), exist_ok=True)
+open(os.path.join(out, 'home', 'mednafen.cfg'), 'w').close()
+open(os.path.join(out, 'home', 'firmware', 'lynxboot.img'), 'wb').write(bytes(512))
+for name, data in [('nes.nes', nes()), ('gb.gb', gb()), ('pce.pce', pce()), ('snes.sfc', snes()), ('lynx.o', lynx())]:
+    open(os.path.join(out, name), 'wb').write(data)
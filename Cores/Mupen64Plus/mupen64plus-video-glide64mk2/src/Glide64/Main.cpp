@@ -379,7 +379,7 @@ void ReadSettings ()
   settings.ssformat = (BOOL)Config_ReadInt("ssformat", "TODO:ssformat", 0);
   //settings.fast_crc = (BOOL)Config_ReadInt ("fast_crc", "Fast CRC", 0);
 
-  settings.show_fps = (BYTE)Config_ReadInt ("show_fps", "Display performance stats (add together desired flags): 1=FPS counter, 2=VI/s counter, 4=% speed, 8=FPS transparent", 0, TRUE, FALSE);
+  settings.show_fps = (BYTE)Config_ReadInt ("show_fps", "Display performance stats (add together desired flags): 1=FPS counter, 2=VI/s counter, 4=% speed, 8=FPS transparent, 16=texture cache stats", 0, TRUE, FALSE);
   settings.clock = (BOOL)Config_ReadInt ("clock", "Clock enabled", 0);
   settings.clock_24_hr = (BOOL)Config_ReadInt ("clock_24_hr", "Clock is 24-hour", 0);
   // settings.advanced_options only good for GUI config
@@ -2073,12 +2073,19 @@ void newSwapBuffers()
     grDepthMask (FXFALSE);
     grCullMode (GR_CULL_DISABLE);
 
-    if ((settings.show_fps & 0xF) || settings.clock)
+    if ((settings.show_fps & 0x1F) || settings.clock)
       set_message_combiner ();
 #ifdef FPS
     float y = (float)settings.res_y;
-    if (settings.show_fps & 0x0F)
+    if (settings.show_fps & 0x1F)
     {
+      if (settings.show_fps & 16)
+      {
+        output (0, y, 0, "Tex: %u hashed (%uK), %u hits, %u evicted ",
+          texcache_stats_frame.hashes, texcache_stats_frame.bytes >> 10,
+          texcache_stats_frame.hits, texcache_stats_frame.evictions);
+        y -= 16;
+      }
       if (settings.show_fps & 4)
       {
         if (region)   // PAL
@@ -2400,6 +2407,7 @@ void newSwapBuffers()
     DrawWholeFrameBufferToScreen();
 
   frame_count ++;
+  TexCacheNewFrame ();
 
   // Open/close debugger?
   if (CheckKeyPressed(G64_VK_SCROLL, 0x0001))
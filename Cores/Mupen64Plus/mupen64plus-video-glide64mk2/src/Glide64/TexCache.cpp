@@ -69,6 +69,7 @@ typedef struct TEXINFO_t {
   int width, height;
   int wid_64, line;
   wxUint32 crc;
+  wxUint64 hash;
   wxUint32 flags;
   int splits, splitheight;
 #ifdef TEXTURE_FILTER
@@ -88,48 +89,55 @@ typedef struct HIRESTEX_t {
 #endif
 
 //****************************************************************
-// List functions
-
-typedef struct NODE_t {
-  wxUint32	crc;
-  wxUIntPtr	data;
+// Cache lookup table
+//
+// Open addressing with linear probing, keyed by the 64-bit texture hash.
+// Entries are only added between two ClearCache () calls, so there are no
+// deletions to handle, and a lookup has to go on until an empty slot since
+// textures with the same hash may differ in size, flags or modulation.
+
+typedef struct TEXHASH_t {
+  wxUint64	hash;
+  CACHE_LUT	*cache;	// NULL - empty slot
   int		tmu;
   int		number;
-  NODE_t	*pNext;
-} NODE;
+} TEXHASH;
+
+#define TEXHASH_SIZE (MAX_CACHE * MAX_TMU * 2)	// never more than half full
+#define TEXHASH_MASK (TEXHASH_SIZE - 1)
 
-NODE *cachelut[65536];
+TEXHASH texhash[TEXHASH_SIZE];
+TEXCACHE_STATS texcache_stats;
+TEXCACHE_STATS texcache_stats_frame;
 
-void AddToList (NODE **list, wxUint32 crc, wxUIntPtr data, int tmu, int number)
+void AddToCache (wxUint64 hash, CACHE_LUT *cache, int tmu, int number)
 {
-  NODE *node = new NODE;
-  node->crc = crc;
-  node->data = data;
-  node->tmu = tmu;
-  node->number = number;
-  node->pNext = *list;
-  *list = node;
+  wxUint32 i = (wxUint32)hash & TEXHASH_MASK;
+  while (texhash[i].cache)
+    i = (i + 1) & TEXHASH_MASK;
+  texhash[i].hash = hash;
+  texhash[i].cache = cache;
+  texhash[i].tmu = tmu;
+  texhash[i].number = number;
   rdp.n_cached[tmu] ++;
   if (voodoo.tex_UMA)
     rdp.n_cached[tmu^1] = rdp.n_cached[tmu];
 }
 
-void DeleteList (NODE **list)
+void TexCacheInit ()
 {
-  while (*list)
-  {
-    NODE *next = (*list)->pNext;
-    delete (*list);
-    *list = next;
-  }
+  memset (texhash, 0, sizeof(texhash));
+  memset (&texcache_stats, 0, sizeof(texcache_stats));
+  memset (&texcache_stats_frame, 0, sizeof(texcache_stats_frame));
 }
 
-void TexCacheInit ()
+//****************************************************************
+// TexCacheNewFrame - starts counting the statistics for a new frame
+
+void TexCacheNewFrame ()
 {
-  for (int i=0; i<65536; i++)
-  {
-    cachelut[i] = NULL;
-  }
+  texcache_stats_frame = texcache_stats;
+  memset (&texcache_stats, 0, sizeof(texcache_stats));
 }
 
 //****************************************************************
@@ -137,38 +145,152 @@ void TexCacheInit ()
 
 void ClearCache ()
 {
+  texcache_stats.evictions += rdp.n_cached[0];
+  if (!voodoo.tex_UMA)
+    texcache_stats.evictions += rdp.n_cached[1];
+
   voodoo.tmem_ptr[0] = offset_textures;
   rdp.n_cached[0] = 0;
   voodoo.tmem_ptr[1] = voodoo.tex_UMA ? offset_textures : offset_texbuf1;
   rdp.n_cached[1] = 0;
 
-  for (int i=0; i<65536; i++)
-  {
-    DeleteList (&cachelut[i]);
-  }
+  memset (texhash, 0, sizeof(texhash));
 }
 
 //****************************************************************
-uint32_t textureCRC(uint8_t *addr, int width, int height, int line)
+// textureHash - 64-bit hash of a texture in TMEM
+//
+// width is the row length in 64-bit words, line the gap between rows in
+// bytes. Works like the XXH3 accumulate loop: every pair of words is mixed
+// in as acc += swapped word + lo32(word ^ key) * hi32(word ^ key), with a
+// key that changes each step, and the accumulators are scrambled after each
+// row. The SSE2 and NEON versions give the same result as the C one, which
+// matters because the hash ends up in the GlideHQ cache files.
+
+#if !defined(NOSSE) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define TEXHASH_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TEXHASH_NEON
+#endif
+
+#define TH_PRIME32   0x9E3779B1U
+#define TH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define TH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+
+static const wxUint64 th_init[2] = { TH_PRIME64_2, TH_PRIME64_1 };
+static const wxUint64 th_key[2]  = { 0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL };
+static const wxUint64 th_step[2] = { 0xDB979083E96DD4DEULL, 0x1F67B3B7A4A44072ULL };
+static const wxUint64 th_row[2]  = { 0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL };
+static const wxUint32 th_prime[4] = { TH_PRIME32, TH_PRIME32, TH_PRIME32, TH_PRIME32 };
+
+static wxUint64 textureHashFinal (const wxUint64 *acc, wxUint32 len)
 {
-  uint32_t crc = 0;
-  uint32_t *pixelpos;
-  unsigned int i;
-  uint64_t twopixel_crc;
-
-  pixelpos = (uint32_t*)addr;
-  for (; height; height--) {
-    for (i = width; i; --i) {
-      twopixel_crc = i * (uint64_t)(pixelpos[1] + pixelpos[0] + crc);
-      crc = (uint32_t) ((twopixel_crc >> 32) + twopixel_crc);
-      pixelpos += 2;
+  wxUint64 h = len * TH_PRIME64_1;
+  h ^= acc[0];
+  h = ((h << 31) | (h >> 33)) * TH_PRIME64_2;
+  h ^= acc[1];
+  h = ((h << 31) | (h >> 33)) * TH_PRIME64_2;
+  h ^= h >> 37;
+  h *= 0x165667919E3779F9ULL;
+  h ^= h >> 32;
+  return h;
+}
+
+wxUint64 textureHash(wxUint8 *addr, int width, int height, int line)
+{
+  wxUint64 acc[2];
+  int i;
+
+  texcache_stats.hashes ++;
+  texcache_stats.bytes += (width * height) << 3;
+
+#if defined(TEXHASH_SSE2)
+  __m128i vacc = _mm_loadu_si128((const __m128i*)th_init);
+  __m128i vkey = _mm_loadu_si128((const __m128i*)th_key);
+  const __m128i vstep = _mm_loadu_si128((const __m128i*)th_step);
+  const __m128i vrow = _mm_loadu_si128((const __m128i*)th_row);
+  const __m128i vprime = _mm_loadu_si128((const __m128i*)th_prime);
+
+  for (int y = height; y; y--) {
+    for (i = width; i > 0; i -= 2) {
+      __m128i d;
+      if (i > 1) {
+        d = _mm_loadu_si128((const __m128i*)addr);
+        addr += 16;
+      } else {
+        d = _mm_loadl_epi64((const __m128i*)addr);
+        addr += 8;
+      }
+      const __m128i dk = _mm_xor_si128(d, vkey);
+      const __m128i p = _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32));
+      vacc = _mm_add_epi64(vacc, _mm_add_epi64(_mm_shuffle_epi32(d, _MM_SHUFFLE(1, 0, 3, 2)), p));
+      vkey = _mm_add_epi64(vkey, vstep);
+    }
+    vacc = _mm_xor_si128(vacc, _mm_srli_epi64(vacc, 47));
+    vacc = _mm_xor_si128(vacc, vrow);
+    vacc = _mm_add_epi64(_mm_mul_epu32(vacc, vprime), _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(vacc, 32), vprime), 32));
+    addr += line;
+  }
+  _mm_storeu_si128((__m128i*)acc, vacc);
+#elif defined(TEXHASH_NEON)
+  uint64x2_t vacc = vld1q_u64(th_init);
+  uint64x2_t vkey = vld1q_u64(th_key);
+  const uint64x2_t vstep = vld1q_u64(th_step);
+  const uint64x2_t vrow = vld1q_u64(th_row);
+  const uint32x2_t vprime = vld1_u32(th_prime);
+
+  for (int y = height; y; y--) {
+    for (i = width; i > 0; i -= 2) {
+      uint64x2_t d;
+      if (i > 1) {
+        d = vreinterpretq_u64_u8(vld1q_u8(addr));
+        addr += 16;
+      } else {
+        d = vcombine_u64(vreinterpret_u64_u8(vld1_u8(addr)), vdup_n_u64(0));
+        addr += 8;
+      }
+      const uint64x2_t dk = veorq_u64(d, vkey);
+      const uint64x2_t p = vmull_u32(vmovn_u64(dk), vshrn_n_u64(dk, 32));
+      vacc = vaddq_u64(vacc, vaddq_u64(vextq_u64(d, d, 1), p));
+      vkey = vaddq_u64(vkey, vstep);
+    }
+    vacc = veorq_u64(vacc, vshrq_n_u64(vacc, 47));
+    vacc = veorq_u64(vacc, vrow);
+    vacc = vaddq_u64(vmull_u32(vmovn_u64(vacc), vprime), vshlq_n_u64(vmull_u32(vshrn_n_u64(vacc, 32), vprime), 32));
+    addr += line;
+  }
+  vst1q_u64(acc, vacc);
+#else
+  wxUint64 key[2] = { th_key[0], th_key[1] };
+
+  acc[0] = th_init[0];
+  acc[1] = th_init[1];
+  for (int y = height; y; y--) {
+    for (i = width; i > 0; i -= 2) {
+      wxUint64 d[2] = { 0, 0 };
+      memcpy(d, addr, i > 1 ? 16 : 8);
+      addr += i > 1 ? 16 : 8;
+      for (int j = 0; j < 2; j++) {
+        const wxUint64 dk = d[j] ^ key[j];
+        acc[j] += d[j^1] + (dk & 0xFFFFFFFF) * (dk >> 32);
+        key[j] += th_step[j];
+      }
     }
-    crc = ((unsigned int)height * (uint64_t)crc >> 32) + height * crc;
-    pixelpos = (uint32_t *)((char *)pixelpos + line);
+    for (int j = 0; j < 2; j++) {
+      acc[j] ^= acc[j] >> 47;
+      acc[j] ^= th_row[j];
+      acc[j] *= TH_PRIME32;
+    }
+    addr += line;
   }
+#endif
 
-  return crc;
+  return textureHashFinal(acc, (width * height) << 3);
 }
+
+//****************************************************************
 // GetTexInfo - gets information for either t0 or t1, checks if in cache & fills tex_found
 
 void GetTexInfo (int id, int tile)
@@ -355,26 +477,29 @@ void GetTexInfo (int id, int tile)
   if (rdp.tiles[tile].size == 3)
     line <<= 1;
   wxUint32 crc = 0;
+  wxUint64 hash = 0;
   if (settings.fast_crc)
   {
     line = (line - wid_64) << 3;
     if (wid_64 < 1) wid_64 = 1;
-    uint8_t * addr = (((uint8_t*)rdp.tmem) + (rdp.tiles[tile].t_mem<<3));
+    wxUint8 * addr = (((wxUint8*)rdp.tmem) + (rdp.tiles[tile].t_mem<<3));
     if (crc_height > 0) // Check the CRC
     {
       if (rdp.tiles[tile].size < 3)
-        crc = textureCRC(addr, wid_64, crc_height, line);
+        hash = textureHash(addr, wid_64, crc_height, line);
       else //32b texture
       {
         int line_2 = line >> 1;
         int wid_64_2 = max(1, wid_64 >> 1);
-        crc = textureCRC(addr, wid_64_2, crc_height, line_2);
-        crc += textureCRC(addr+0x800, wid_64_2, crc_height, line_2);
+        hash = textureHash(addr, wid_64_2, crc_height, line_2);
+        hash += textureHash(addr+0x800, wid_64_2, crc_height, line_2);
       }
     }
   }
   else
   {
+    texcache_stats.hashes ++;
+    texcache_stats.bytes += crc_height * bpl;
     crc = 0xFFFFFFFF;
     wxUIntPtr addr = wxPtrToUInt(rdp.tmem) + (rdp.tiles[tile].t_mem<<3);
     wxUint32 line2 = max(line,1);
@@ -405,11 +530,15 @@ void GetTexInfo (int id, int tile)
   }
   if ((rdp.tiles[tile].size < 2) && (rdp.tlut_mode || rdp.tiles[tile].format == 2))
   {
-    if (rdp.tiles[tile].size == 0)
-      crc += rdp.pal_8_crc[rdp.tiles[tile].palette];
-    else
-      crc += rdp.pal_256_crc;
+    wxUint32 pal_crc = (rdp.tiles[tile].size == 0) ? rdp.pal_8_crc[rdp.tiles[tile].palette] : rdp.pal_256_crc;
+    crc += pal_crc;
+    hash += pal_crc;
   }
+  // the rest of the plugin and GlideHQ only get to see 32 bits
+  if (settings.fast_crc)
+    crc = (wxUint32)(hash ^ (hash >> 32));
+  else
+    hash = crc;
 
   FRDP ("Done.  CRC is: %08lx.\n", crc);
 
@@ -428,6 +557,7 @@ void GetTexInfo (int id, int tile)
   info->wid_64 = wid_64;
   info->line = line;
   info->crc = crc;
+  info->hash = hash;
   info->flags = flags;
 
   // Search the texture cache for this texture
@@ -456,13 +586,13 @@ void GetTexInfo (int id, int tile)
     modfactor = cmb.modfactor_1;
   }
 
-  NODE *node = cachelut[crc>>16];
   wxUint32 mod_mask = (rdp.tiles[tile].format == 2)?0xFFFFFFFF:0xF0F0F0F0;
-  while (node)
+  for (wxUint32 i = (wxUint32)hash & TEXHASH_MASK; texhash[i].cache; i = (i + 1) & TEXHASH_MASK)
   {
-    if (node->crc == crc)
+    TEXHASH *node = &texhash[i];
+    if (node->hash == hash)
     {
-      cache = (CACHE_LUT*)node->data;
+      cache = node->cache;
       if (/*tex_found[id][node->tmu] == -1 &&
           rdp.tiles[tile].palette == cache->palette &&
           rdp.tiles[tile].format == cache->format &&
@@ -482,12 +612,21 @@ void GetTexInfo (int id, int tile)
           if (voodoo.tex_UMA)
           {
             tex_found[id][node->tmu^1] = node->number;
+            texcache_stats.hits ++;
             return;
           }
         }
       }
     }
-    node = node->pNext;
+  }
+
+  for (t=0; t<MAX_TMU; t++)
+  {
+    if (tex_found[id][t] != -1)
+    {
+      texcache_stats.hits ++;
+      break;
+    }
   }
 
   LRDP(" | | | +- Done.\n | | +- GetTexInfo end\n");
@@ -1061,7 +1200,7 @@ void LoadTex (int id, int tmu)
 #endif
 
   // Add this cache to the list
-  AddToList (&cachelut[cache->crc>>16], cache->crc, wxPtrToUInt(cache), tmu, rdp.n_cached[tmu]);
+  AddToCache (texinfo[id].hash, cache, tmu, rdp.n_cached[tmu]);
 
   // temporary
   cache->t_info.format = GR_TEXFMT_ARGB_1555;
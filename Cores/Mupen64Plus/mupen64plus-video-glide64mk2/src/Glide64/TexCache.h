@@ -40,10 +40,20 @@
 #ifndef TEXCACHE_H
 #define TEXCACHE_H
 
+typedef struct TEXCACHE_STATS_t {
+  wxUint32 hashes;     // textures hashed
+  wxUint32 hits;       // textures found in the cache
+  wxUint32 evictions;  // textures dropped from the cache
+  wxUint32 bytes;      // bytes of TMEM hashed
+} TEXCACHE_STATS;
+
 void TexCacheInit ();
+void TexCacheNewFrame ();
 void TexCache ();
 void ClearCache ();
 
 extern wxUint8 * texture_buffer;
+extern TEXCACHE_STATS texcache_stats;        // current frame
+extern TEXCACHE_STATS texcache_stats_frame;  // last complete frame
 
 #endif //TEXCACHE_H
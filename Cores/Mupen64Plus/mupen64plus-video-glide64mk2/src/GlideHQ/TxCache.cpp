@@ -26,7 +26,9 @@
 #endif
 
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
 #include <zlib.h>
+#include <vector>
 #include "TxCache.h"
 #include "TxDbg.h"
 #include "../Glide64/m64p.h"
@@ -50,6 +52,8 @@ TxCache::TxCache(int options, int cachesize, const wchar_t *datapath,
   _cacheSize = cachesize;
   _callback = callback;
   _totalSize = 0;
+  _fileIndex = NULL;
+  _fileEntries = 0;
 
   /* save path name */
   if (datapath)
@@ -110,30 +114,7 @@ TxCache::add(uint64 checksum, GHQTexInfo *info, int dataSize)
   /* if cache size exceeds limit, remove old cache */
   if (_cacheSize > 0) {
     _totalSize += dataSize;
-    if ((_totalSize > _cacheSize) && !_cachelist.empty()) {
-      /* _cachelist is arranged so that frequently used textures are in the back */
-      std::list<uint64>::iterator itList = _cachelist.begin();
-      while (itList != _cachelist.end()) {
-        /* find it in _cache */
-        std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(*itList);
-        if (itMap != _cache.end()) {
-          /* yep we have it. remove it. */
-          _totalSize -= (*itMap).second->size;
-          free((*itMap).second->info.data);
-          delete (*itMap).second;
-          _cache.erase(itMap);
-        }
-        itList++;
-
-        /* check if memory cache has enough space */
-        if (_totalSize <= _cacheSize)
-          break;
-      }
-      /* remove from _cachelist */
-      _cachelist.erase(_cachelist.begin(), itList);
-
-      DBG_INFO(80, L"+++++++++\n");
-    }
+    evict();
     _totalSize -= dataSize;
   }
 
@@ -152,6 +133,8 @@ TxCache::add(uint64 checksum, GHQTexInfo *info, int dataSize)
       txCache->info.data = tmpdata;
       txCache->info.format = format;
       txCache->size = dataSize;
+      txCache->file = NULL;
+      txCache->fileSize = 0;
 
       /* add to cache */
       if (_cacheSize > 0) {
@@ -176,7 +159,7 @@ TxCache::add(uint64 checksum, GHQTexInfo *info, int dataSize)
       if (_cacheSize > 0) {
         DBG_INFO(80, L"cache max config:%.02fmb\n", (float)_cacheSize/1000000);
 
-        if (_cache.size() != _cachelist.size()) {
+        if (_cache.size() < _cachelist.size()) {
           DBG_INFO(80, L"Error: cache/cachelist mismatch! (%d/%d)\n", _cache.size(), _cachelist.size());
         }
       }
@@ -202,15 +185,41 @@ TxCache::get(uint64 checksum, GHQTexInfo *info)
   std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(checksum);
   if (itMap != _cache.end()) {
     /* yep, we've got it. */
-    memcpy(info, &(((*itMap).second)->info), sizeof(GHQTexInfo));
+    TXCACHE *txCache = (*itMap).second;
 
-    /* push it to the back of the list */
-    if (_cacheSize > 0) {
-      _cachelist.erase(((*itMap).second)->it);
+    /* first use of a texture from the cache file */
+    if (!txCache->info.data) {
+      /* make room for it */
+      if (_cacheSize > 0) {
+        _totalSize += txCache->size;
+        evict();
+        _totalSize -= txCache->size;
+      }
+
+      uLongf destLen = txCache->size;
+      uint8 *tmpdata = (uint8*)malloc(destLen);
+      if (!tmpdata || uncompress(tmpdata, &destLen, txCache->file, txCache->fileSize) != Z_OK ||
+          destLen != (uLongf)txCache->size) {
+        free(tmpdata);
+        DBG_INFO(80, L"Error: zlib decompression failed!\n");
+        return 0;
+      }
+      txCache->info.data = tmpdata;
+      _totalSize += txCache->size;
+
+      if (_cacheSize > 0) {
+        _cachelist.push_back(checksum);
+        txCache->it = --(_cachelist.end());
+      }
+    } else if (_cacheSize > 0 && txCache->it != _cachelist.end()) {
+      /* push it to the back of the list */
+      _cachelist.erase(txCache->it);
       _cachelist.push_back(checksum);
-      ((*itMap).second)->it = --(_cachelist.end());
+      txCache->it = --(_cachelist.end());
     }
 
+    memcpy(info, &(((*itMap).second)->info), sizeof(GHQTexInfo));
+
     /* zlib decompress it */
     if (info->format & GR_TEXFMT_GZ) {
       uLongf destLen = _gzdestLen;
@@ -233,7 +242,16 @@ TxCache::get(uint64 checksum, GHQTexInfo *info)
 boolean
 TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 {
-  if (!_cache.empty()) {
+  /* textures not in the cache file yet */
+  std::vector<std::map<uint64, TXCACHE*>::iterator> added;
+  std::map<uint64, TXCACHE*>::iterator itMap = _cache.begin();
+  while (itMap != _cache.end()) {
+    if (!(*itMap).second->file && (*itMap).second->info.data && (*itMap).second->size)
+      added.push_back(itMap);
+    itMap++;
+  }
+
+  if (!added.empty()) {
     /* dump cache to disk */
     char cbuf[MAX_PATH];
 
@@ -256,65 +274,119 @@ TxCache::save(const wchar_t *path, const wchar_t *filename, int config)
 
     wcstombs(cbuf, filename, MAX_PATH);
 
-    gzFile gzfp = gzopen(cbuf, "wb1");
-    DBG_INFO(80, L"gzfp:%x file:%ls\n", gzfp, filename);
-    if (gzfp) {
-      /* write header to determine config match */
-      gzwrite(gzfp, &config, 4);
-
-      std::map<uint64, TXCACHE*>::iterator itMap = _cache.begin();
-      while (itMap != _cache.end()) {
-        uint8 *dest    = (*itMap).second->info.data;
-        uint32 destLen = (*itMap).second->size;
-        uint16 format  = (*itMap).second->info.format;
-
-        /* to keep things simple, we save the texture data in a zlib uncompressed state. */
-        /* sigh... for those who cannot wait the extra few seconds. changed to keep
-         * texture data in a zlib compressed state. if the GZ_TEXCACHE or GZ_HIRESTEXCACHE
-         * option is toggled, the cache will need to be rebuilt.
+    /* append to the cache file we loaded from, otherwise start a new one.
+     * the header is written last so that an interrupted save leaves the
+     * previous index in effect.
+     */
+    TXCACHEFILEHEADER header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TXCACHE_MAGIC;
+    header.version = TXCACHE_VERSION;
+    header.config = config;
+
+    uint64 offset;
+    FILE *fp;
+    if (_fileIndex) {
+      offset = _mapped.get_size();
+      fp = fopen(cbuf, "r+b");
+      if (fp && fseek(fp, (long)offset, SEEK_SET) != 0) {
+        fclose(fp);
+        fp = NULL;
+      }
+    } else {
+      offset = sizeof(header);
+      fp = fopen(cbuf, "wb");
+      if (fp && fwrite(&header, sizeof(header), 1, fp) != 1) {
+        fclose(fp);
+        fp = NULL;
+      }
+    }
+    DBG_INFO(80, L"fp:%x file:%ls\n", fp, filename);
+
+    if (fp) {
+      std::vector<TXCACHEFILEENTRY> index;
+      std::vector<uint8> packbuf;
+      boolean ok = 1;
+
+      for (unsigned int i = 0; i < added.size() && ok; i++) {
+        TXCACHE *txCache = (*added[i]).second;
+        TXCACHEFILEENTRY entry;
+        memset(&entry, 0, sizeof(entry));
+
+        entry.checksum = (*added[i]).first;
+        entry.offset = offset;
+        entry.width = txCache->info.width;
+        entry.height = txCache->info.height;
+        entry.smallLodLog2 = txCache->info.smallLodLog2;
+        entry.largeLodLog2 = txCache->info.largeLodLog2;
+        entry.aspectRatioLog2 = txCache->info.aspectRatioLog2;
+        entry.tiles = txCache->info.tiles;
+        entry.untiled_width = txCache->info.untiled_width;
+        entry.untiled_height = txCache->info.untiled_height;
+        entry.format = txCache->info.format;
+        entry.is_hires_tex = txCache->info.is_hires_tex;
+
+        const uint8 *dest = txCache->info.data;
+        uint32 destLen = txCache->size;
+        entry.dataSize = destLen;
+
+        /* textures kept uncompressed in memory are compressed in the file
+         * and inflated on first use. GR_TEXFMT_GZ textures are already
+         * compressed and stored as they are.
          */
-        /*if (format & GR_TEXFMT_GZ) {
-          dest = _gzdest0;
-          destLen = _gzdestLen;
-          if (dest && destLen) {
-            if (uncompress(dest, &destLen, (*itMap).second->info.data, (*itMap).second->size) != Z_OK) {
-              dest = NULL;
-              destLen = 0;
-            }
-            format &= ~GR_TEXFMT_GZ;
+        if (!(txCache->info.format & GR_TEXFMT_GZ)) {
+          uLongf packLen = compressBound(destLen);
+          packbuf.resize(packLen);
+          if (compress2(&packbuf[0], &packLen, dest, destLen, 1) == Z_OK && packLen < destLen) {
+            dest = &packbuf[0];
+            destLen = packLen;
+            entry.packed = 1;
           }
-        }*/
-
-        if (dest && destLen) {
-          /* texture checksum */
-          gzwrite(gzfp, &((*itMap).first), 8);
+        }
+        entry.size = destLen;
 
-          /* other texture info */
-          gzwrite(gzfp, &((*itMap).second->info.width), 4);
-          gzwrite(gzfp, &((*itMap).second->info.height), 4);
-          gzwrite(gzfp, &format, 2);
+        ok = (fwrite(dest, 1, destLen, fp) == destLen);
+        offset += destLen;
+        index.push_back(entry);
+      }
 
-          gzwrite(gzfp, &((*itMap).second->info.smallLodLog2), 4);
-          gzwrite(gzfp, &((*itMap).second->info.largeLodLog2), 4);
-          gzwrite(gzfp, &((*itMap).second->info.aspectRatioLog2), 4);
+      /* merge with the index in the cache file. added textures replace
+       * older ones with the same checksum.
+       */
+      if (_fileIndex) {
+        std::vector<TXCACHEFILEENTRY> merged;
+        merged.reserve(index.size() + _fileEntries);
+        unsigned int i = 0, j = 0;
+        while (i < _fileEntries || j < index.size()) {
+          if (j == index.size() || (i < _fileEntries && _fileIndex[i].checksum < index[j].checksum)) {
+            merged.push_back(_fileIndex[i++]);
+          } else {
+            if (i < _fileEntries && _fileIndex[i].checksum == index[j].checksum) i++;
+            merged.push_back(index[j++]);
+          }
+        }
+        index.swap(merged);
+      }
 
-          gzwrite(gzfp, &((*itMap).second->info.tiles), 4);
-          gzwrite(gzfp, &((*itMap).second->info.untiled_width), 4);
-          gzwrite(gzfp, &((*itMap).second->info.untiled_height), 4);
+      /* keep the index 8 byte aligned for the mapping */
+      static const uint8 pad[8] = { 0 };
+      uint32 padLen = (uint32)(-offset & 7);
+      if (ok && padLen) ok = (fwrite(pad, 1, padLen, fp) == padLen);
+      offset += padLen;
 
-          gzwrite(gzfp, &((*itMap).second->info.is_hires_tex), 1);
+      header.entries = index.size();
+      header.index = offset;
 
-          gzwrite(gzfp, &destLen, 4);
-          gzwrite(gzfp, dest, destLen);
-        }
+      if (ok) ok = (fwrite(&index[0], sizeof(TXCACHEFILEENTRY), index.size(), fp) == index.size());
+      if (ok) ok = (fflush(fp) == 0 && fseek(fp, 0, SEEK_SET) == 0);
+      if (ok) ok = (fwrite(&header, sizeof(header), 1, fp) == 1);
+      if (fclose(fp) != 0) ok = 0;
 
-        itMap++;
+      if (!ok)
+        ERRLOG("Error while writing texture cache '%s'!", cbuf);
 
-        /* not ready yet */
-        /*if (_callback)
-          (*_callback)(L"Total textures saved to HDD: %d\n", std::distance(itMap, _cache.begin()));*/
-      }
-      gzclose(gzfp);
+      if (_callback)
+        (*_callback)(L"Total textures saved to HDD: %d\n", (int)added.size());
     }
 
     if (CHDIR(curpath) != 0)
@@ -347,57 +419,67 @@ TxCache::load(const wchar_t *path, const wchar_t *filename, int config)
 
   wcstombs(cbuf, filename, MAX_PATH);
 
-  gzFile gzfp = gzopen(cbuf, "rb");
-  DBG_INFO(80, L"gzfp:%x file:%ls\n", gzfp, filename);
-  if (gzfp) {
-    /* yep, we have it. load it into memory cache. */
-    int dataSize;
-    uint64 checksum;
-    GHQTexInfo tmpInfo;
-    int tmpconfig;
-    /* read header to determine config match */
-    gzread(gzfp, &tmpconfig, 4);
-
-    if (tmpconfig == config) {
-      do {
-        memset(&tmpInfo, 0, sizeof(GHQTexInfo));
-
-        gzread(gzfp, &checksum, 8);
-
-        gzread(gzfp, &tmpInfo.width, 4);
-        gzread(gzfp, &tmpInfo.height, 4);
-        gzread(gzfp, &tmpInfo.format, 2);
-
-        gzread(gzfp, &tmpInfo.smallLodLog2, 4);
-        gzread(gzfp, &tmpInfo.largeLodLog2, 4);
-        gzread(gzfp, &tmpInfo.aspectRatioLog2, 4);
-
-        gzread(gzfp, &tmpInfo.tiles, 4);
-        gzread(gzfp, &tmpInfo.untiled_width, 4);
-        gzread(gzfp, &tmpInfo.untiled_height, 4);
-
-        gzread(gzfp, &tmpInfo.is_hires_tex, 1);
-
-        gzread(gzfp, &dataSize, 4);
-
-        tmpInfo.data = (uint8*)malloc(dataSize);
-        if (tmpInfo.data) {
-          gzread(gzfp, tmpInfo.data, dataSize);
-
-          /* add to memory cache */
-          add(checksum, &tmpInfo, (tmpInfo.format & GR_TEXFMT_GZ) ? dataSize : 0);
+  /* cached textures point into the mapping */
+  clear();
 
-          free(tmpInfo.data);
-        } else {
-          gzseek(gzfp, dataSize, SEEK_CUR);
-        }
+  try {
+    boost::interprocess::file_mapping file(cbuf, boost::interprocess::read_only);
+    boost::interprocess::mapped_region(file, boost::interprocess::read_only).swap(_mapped);
+  } catch (boost::interprocess::interprocess_exception &) {
+    /* no cache file */
+  }
 
-        /* skip in between to prevent the loop from being tied down to vsync */
-        if (_callback && (!(_cache.size() % 100) || gzeof(gzfp)))
-          (*_callback)(L"[%d] total mem:%.02fmb - %ls\n", _cache.size(), (float)_totalSize/1000000, filename);
+  const uint8 *base = (const uint8*)_mapped.get_address();
+  uint64 fileSize = _mapped.get_size();
+  DBG_INFO(80, L"mapped:%x size:%d file:%ls\n", base, (int)fileSize, filename);
+  if (base && fileSize >= sizeof(TXCACHEFILEHEADER)) {
+    /* yep, we have it. index it into memory cache. texture data is
+     * read from the mapping as it is used.
+     */
+    const TXCACHEFILEHEADER *header = (const TXCACHEFILEHEADER*)base;
+    int tmpconfig = header->config;
+
+    if (header->magic != TXCACHE_MAGIC || header->version != TXCACHE_VERSION) {
+      WriteLog(M64MSG_WARNING, "Ignored texture cache in an older format. It will be rebuilt.");
+    } else if (header->index > fileSize || (header->index & 7) ||
+               header->entries > (fileSize - header->index) / sizeof(TXCACHEFILEENTRY)) {
+      WriteLog(M64MSG_WARNING, "Ignored damaged texture cache.");
+    } else if (tmpconfig == config) {
+      _fileIndex = (const TXCACHEFILEENTRY*)(base + header->index);
+      _fileEntries = header->entries;
+
+      for (unsigned int i = 0; i < _fileEntries; i++) {
+        const TXCACHEFILEENTRY *entry = &_fileIndex[i];
+
+        if (entry->offset > header->index || entry->size > header->index - entry->offset ||
+            (!entry->packed && entry->size != entry->dataSize))
+          continue;
+
+        TXCACHE *txCache = new TXCACHE;
+        memset(&txCache->info, 0, sizeof(GHQTexInfo));
+        txCache->info.width = entry->width;
+        txCache->info.height = entry->height;
+        txCache->info.smallLodLog2 = entry->smallLodLog2;
+        txCache->info.largeLodLog2 = entry->largeLodLog2;
+        txCache->info.aspectRatioLog2 = entry->aspectRatioLog2;
+        txCache->info.tiles = entry->tiles;
+        txCache->info.untiled_width = entry->untiled_width;
+        txCache->info.untiled_height = entry->untiled_height;
+        txCache->info.format = entry->format;
+        txCache->info.is_hires_tex = entry->is_hires_tex;
+        txCache->file = base + entry->offset;
+        txCache->fileSize = entry->size;
+        txCache->size = entry->dataSize;
+        txCache->info.data = entry->packed ? NULL : (uint8*)txCache->file;
+        /* not in _cachelist until it takes up memory */
+        txCache->it = _cachelist.end();
+
+        /* the index is sorted */
+        _cache.insert(_cache.end(), std::map<uint64, TXCACHE*>::value_type(entry->checksum, txCache));
+      }
 
-      } while (!gzeof(gzfp));
-      gzclose(gzfp);
+      if (_callback)
+        (*_callback)(L"[%d] total file:%.02fmb - %ls\n", (int)_cache.size(), (float)fileSize/1000000, filename);
     } else {
       if ((tmpconfig & HIRESTEXTURES_MASK) != (config & HIRESTEXTURES_MASK)) {
         const char *conf_str;
@@ -485,6 +567,9 @@ TxCache::load(const wchar_t *path, const wchar_t *filename, int config)
     }
   }
 
+  /* unmap it unless it is in use */
+  if (_cache.empty()) clear();
+
   if (CHDIR(curpath) != 0)
       ERRLOG("Error while changing current directory back to original path of '%s'!", curpath);
 
@@ -500,12 +585,11 @@ TxCache::del(uint64 checksum)
   if (itMap != _cache.end()) {
 
     /* for texture cache (not hi-res cache) */
-    if (!_cachelist.empty()) _cachelist.erase(((*itMap).second)->it);
+    if (_cacheSize > 0 && ((*itMap).second)->it != _cachelist.end())
+      _cachelist.erase(((*itMap).second)->it);
 
     /* remove from cache */
-    free((*itMap).second->info.data);
-    _totalSize -= (*itMap).second->size;
-    delete (*itMap).second;
+    _totalSize -= drop((*itMap).second);
     _cache.erase(itMap);
 
     DBG_INFO(80, L"removed from cache: checksum = %08X %08X\n", (uint32)(checksum & 0xffffffff), (uint32)(checksum >> 32));
@@ -531,8 +615,7 @@ TxCache::clear()
   if (!_cache.empty()) {
     std::map<uint64, TXCACHE*>::iterator itMap = _cache.begin();
     while (itMap != _cache.end()) {
-      free((*itMap).second->info.data);
-      delete (*itMap).second;
+      drop((*itMap).second);
       itMap++;
     }
     _cache.clear();
@@ -540,5 +623,59 @@ TxCache::clear()
 
   if (!_cachelist.empty()) _cachelist.clear();
 
+  /* nothing refers to the cache file anymore */
+  boost::interprocess::mapped_region().swap(_mapped);
+  _fileIndex = NULL;
+  _fileEntries = 0;
+
   _totalSize = 0;
 }
+
+int
+TxCache::drop(TXCACHE *txCache)
+{
+  /* returns the amount of memory released. data used in place from
+   * the cache file does not count.
+   */
+  int size = 0;
+
+  if (txCache->info.data && txCache->info.data != txCache->file) {
+    free(txCache->info.data);
+    size = txCache->size;
+  }
+  delete txCache;
+
+  return size;
+}
+
+void
+TxCache::evict()
+{
+  /* _cachelist is arranged so that frequently used textures are in the back.
+   * it only holds textures that take up memory, so each one removed frees
+   * some.
+   */
+  if (_totalSize <= _cacheSize || _cachelist.empty()) return;
+
+  std::list<uint64>::iterator itList = _cachelist.begin();
+  while (itList != _cachelist.end() && _totalSize > _cacheSize) {
+    /* find it in _cache */
+    std::map<uint64, TXCACHE*>::iterator itMap = _cache.find(*itList);
+    itList = _cachelist.erase(itList);
+    if (itMap == _cache.end()) continue;
+
+    TXCACHE *txCache = (*itMap).second;
+    if (txCache->file) {
+      /* keep it indexed. it is inflated from the cache file again when used. */
+      free(txCache->info.data);
+      txCache->info.data = NULL;
+      txCache->it = _cachelist.end();
+      _totalSize -= txCache->size;
+    } else {
+      _totalSize -= drop(txCache);
+      _cache.erase(itMap);
+    }
+  }
+
+  DBG_INFO(80, L"+++++++++\n");
+}
@@ -29,6 +29,44 @@
 #include <list>
 #include <map>
 #include <string>
+#include <boost/interprocess/mapped_region.hpp>
+
+/* cache file layout (native byte order):
+ *   TXCACHEFILEHEADER
+ *   texture data, one payload per texture
+ *   TXCACHEFILEENTRY[entries] sorted by checksum, at header.index
+ * new textures are appended after the last index, followed by a new
+ * index, and the header is rewritten last.
+ */
+#define TXCACHE_MAGIC   0x43514847 /* "GHQC" */
+#define TXCACHE_VERSION 1
+
+struct TXCACHEFILEHEADER {
+  uint32 magic;
+  uint32 version;
+  int config;
+  uint32 entries;
+  uint64 index;        /* file offset of the index */
+};
+
+struct TXCACHEFILEENTRY {
+  uint64 checksum;     /* checksum hi:palette low:texture */
+  uint64 offset;       /* file offset of the texture data */
+  uint32 size;         /* size of the texture data in the file */
+  uint32 dataSize;     /* size once inflated */
+  int width;
+  int height;
+  int smallLodLog2;
+  int largeLodLog2;
+  int aspectRatioLog2;
+  int tiles;
+  int untiled_width;
+  int untiled_height;
+  uint16 format;
+  uint8 is_hires_tex;
+  uint8 packed;        /* texture data is zlib compressed in the file */
+  uint32 reserved;
+};
 
 class TxCache
 {
@@ -37,6 +75,9 @@ private:
   uint8 *_gzdest0;
   uint8 *_gzdest1;
   uint32 _gzdestLen;
+  boost::interprocess::mapped_region _mapped; /* cache file */
+  const TXCACHEFILEENTRY *_fileIndex;
+  uint32 _fileEntries;
 protected:
   int _options;
   std::wstring _ident;
@@ -47,11 +88,16 @@ protected:
   struct TXCACHE {
     int size;
     GHQTexInfo info;
-    std::list<uint64>::iterator it;
+    std::list<uint64>::iterator it; /* _cachelist.end() if not listed */
+    const uint8 *file;   /* data in the cache file. if it is compressed
+                          * there, info.data stays NULL until first get */
+    int fileSize;
   };
   int _totalSize;
   int _cacheSize;
   std::map<uint64, TXCACHE*> _cache;
+  int drop(TXCACHE *txCache);
+  void evict();
   boolean save(const wchar_t *path, const wchar_t *filename, const int config);
   boolean load(const wchar_t *path, const wchar_t *filename, const int config);
   boolean del(uint64 checksum); /* checksum hi:palette low:texture */
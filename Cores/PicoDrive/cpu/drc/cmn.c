@@ -25,7 +25,7 @@ void drc_cmn_init(void)
   elprintf(EL_STATUS, "drc_cmn_init: %p, %zd bytes: %d",
     tcache, DRC_TCACHE_SIZE, ret);
 
-#ifdef __arm__
+#if defined(__arm__) || defined(__aarch64__)
   if (PicoIn.opt & POPT_EN_DRC)
   {
     static int test_done;
@@ -35,9 +35,15 @@ void drc_cmn_init(void)
       int (*testfunc)(void) = (void *)tcache;
 
       elprintf(EL_STATUS, "testing if we can run recompiled code..");
+#ifdef __aarch64__
+      *test_out++ = 0x52801ba0; // mov w0, 0xdd
+      *test_out++ = 0xd65f03c0; // ret
+      __builtin___clear_cache((char *)tcache, (char *)test_out);
+#else
       *test_out++ = 0xe3a000dd; // mov r0, 0xdd
       *test_out++ = 0xe12fff1e; // bx lr
       cache_flush_d_inval_i(tcache, test_out);
+#endif
 
       // we'll usually crash on broken platforms or bad ports,
       // but do a value check too just in case
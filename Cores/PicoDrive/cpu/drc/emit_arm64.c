@@ -0,0 +1,936 @@
+/*
+ * Basic macros to emit AArch64 instructions and some utils
+ *
+ * This work is licensed under the terms of MAME license.
+ * See COPYING file in the top-level directory.
+ *
+ * note:
+ *  SH2 values are kept in W registers, host pointers in X registers.
+ *  x16/x17 (IP0/IP1) are scratch for the macros here and must not be
+ *  in reg_temp[]. x18 is left alone (platform register on some OSes).
+ *  There is no conditional execution, so the _c ops select their result
+ *  with csel (or branch around themselves) and EMITH_SJMP* are no-ops,
+ *  same as with ARM.
+ */
+#define CONTEXT_REG 19
+#define RET_REG     0
+
+#define A64_TMP_REG  16 // scratch: _c results, far branch targets
+#define A64_TMP_REG2 17 // scratch: immediates that don't encode
+#define A64_LR       30
+#define A64_SP       31 // as a base register or for add/sub imm
+#define A64_ZR       31 // everywhere else
+
+#define EMIT_PTR(ptr, x) \
+	do { \
+		*(u32 *)ptr = x; \
+		ptr = (void *)((u8 *)ptr + sizeof(u32)); \
+		COUNT_OP; \
+	} while (0)
+
+#define EMIT(x) EMIT_PTR(tcache_ptr, x)
+
+#define A64_COND_EQ 0x0
+#define A64_COND_NE 0x1
+#define A64_COND_HS 0x2
+#define A64_COND_LO 0x3
+#define A64_COND_MI 0x4
+#define A64_COND_PL 0x5
+#define A64_COND_VS 0x6
+#define A64_COND_VC 0x7
+#define A64_COND_HI 0x8
+#define A64_COND_LS 0x9
+#define A64_COND_GE 0xa
+#define A64_COND_LT 0xb
+#define A64_COND_GT 0xc
+#define A64_COND_LE 0xd
+#define A64_COND_AL 0xe
+#define A64_COND_CS A64_COND_HS
+#define A64_COND_CC A64_COND_LO
+
+#define A64_COND_INV(cond) ((cond) ^ 1)
+
+/* unified conditions */
+#define DCOND_EQ A64_COND_EQ
+#define DCOND_NE A64_COND_NE
+#define DCOND_MI A64_COND_MI
+#define DCOND_PL A64_COND_PL
+#define DCOND_HI A64_COND_HI
+#define DCOND_HS A64_COND_HS
+#define DCOND_LO A64_COND_LO
+#define DCOND_GE A64_COND_GE
+#define DCOND_GT A64_COND_GT
+#define DCOND_LT A64_COND_LT
+#define DCOND_LS A64_COND_LS
+#define DCOND_LE A64_COND_LE
+#define DCOND_VS A64_COND_VS
+#define DCOND_VC A64_COND_VC
+
+/* shifts for register operands */
+#define A64_SH_LSL 0
+#define A64_SH_LSR 1
+#define A64_SH_ASR 2
+#define A64_SH_ROR 3
+
+/* data processing op, bits 29-30 (op:S) */
+#define A64_OP_ADD  0x0
+#define A64_OP_ADDS 0x1
+#define A64_OP_SUB  0x2
+#define A64_OP_SUBS 0x3
+
+#define A64_OP_AND  0x0
+#define A64_OP_ORR  0x1
+#define A64_OP_EOR  0x2
+#define A64_OP_ANDS 0x3
+
+/* move wide op */
+#define A64_MW_MOVN 0x0
+#define A64_MW_MOVZ 0x2
+#define A64_MW_MOVK 0x3
+
+/* bitfield op */
+#define A64_BF_SBFM 0x0
+#define A64_BF_BFM  0x1
+#define A64_BF_UBFM 0x2
+
+/* load/store sizes and extends */
+#define A64_SZ_B 0
+#define A64_SZ_H 1
+#define A64_SZ_W 2
+#define A64_SZ_X 3
+
+#define A64_EXT_UXTW 2
+#define A64_EXT_SXTW 6
+
+/* load/store pair addressing */
+#define A64_IDX_POST 1
+#define A64_IDX_OFFS 2
+#define A64_IDX_PRE  3
+
+#define EOP_ADDSUB_REG(sf,op,rd,rn,rm,shift,imm6) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x0b000000 | ((shift)<<22) | ((rm)<<16) | ((imm6)<<10) | ((rn)<<5) | (rd))
+
+#define EOP_ADDSUB_EXT(sf,op,rd,rn,rm,option,imm3) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x0b200000 | ((rm)<<16) | ((option)<<13) | ((imm3)<<10) | ((rn)<<5) | (rd))
+
+#define EOP_ADDSUB_IMM(sf,op,rd,rn,sh,imm12) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x11000000 | ((sh)<<22) | ((imm12)<<10) | ((rn)<<5) | (rd))
+
+#define EOP_ADCSBC(sf,op,rd,rn,rm) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x1a000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+
+#define EOP_LOGIC_REG(sf,op,n,rd,rn,rm,shift,imm6) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x0a000000 | ((shift)<<22) | ((n)<<21) | ((rm)<<16) | ((imm6)<<10) | ((rn)<<5) | (rd))
+
+/* nrs is N:immr:imms as returned by emith_log_imm() */
+#define EOP_LOGIC_IMM(sf,op,rd,rn,nrs) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x12000000 | ((nrs)<<10) | ((rn)<<5) | (rd))
+
+#define EOP_MOVE_WIDE(sf,op,rd,hw,imm16) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x12800000 | ((hw)<<21) | (((imm16)&0xffff)<<5) | (rd))
+
+#define EOP_BITFIELD(sf,op,rd,rn,immr,imms) \
+	EMIT(((sf)<<31) | ((op)<<29) | 0x13000000 | ((sf)<<22) | ((immr)<<16) | ((imms)<<10) | ((rn)<<5) | (rd))
+
+#define EOP_EXTR(sf,rd,rn,rm,lsb) \
+	EMIT(((sf)<<31) | 0x13800000 | ((sf)<<22) | ((rm)<<16) | ((lsb)<<10) | ((rn)<<5) | (rd))
+
+/* op:o2 - csel 0:0, csinc 0:1, csinv 1:0, csneg 1:1 */
+#define EOP_CSEL_X(sf,op,o2,rd,rn,rm,cond) \
+	EMIT(((sf)<<31) | ((op)<<30) | 0x1a800000 | ((rm)<<16) | ((cond)<<12) | ((o2)<<10) | ((rn)<<5) | (rd))
+
+#define EOP_MADD(sf,rd,rn,rm,ra) \
+	EMIT(((sf)<<31) | 0x1b000000 | ((rm)<<16) | ((ra)<<10) | ((rn)<<5) | (rd))
+
+/* smaddl/umaddl: xd = xa + wn * wm */
+#define EOP_XMADDL(u,rd,rn,rm,ra) \
+	EMIT(0x9b200000 | ((u)<<23) | ((rm)<<16) | ((ra)<<10) | ((rn)<<5) | (rd))
+
+/* ldr/str */
+#define EOP_LDST_UIMM(size,l,rt,rn,imm12) \
+	EMIT(((size)<<30) | 0x39000000 | ((l)<<22) | ((imm12)<<10) | ((rn)<<5) | (rt))
+
+/* idx: 0 - unscaled (ldur/stur), 1 - post-index, 3 - pre-index */
+#define EOP_LDST_SIMM9(size,l,idx,rt,rn,imm9) \
+	EMIT(((size)<<30) | 0x38000000 | ((l)<<22) | (((imm9)&0x1ff)<<12) | ((idx)<<10) | ((rn)<<5) | (rt))
+
+#define EOP_LDST_REG(size,l,rt,rn,rm,option,s) \
+	EMIT(((size)<<30) | 0x38200800 | ((l)<<22) | ((rm)<<16) | ((option)<<13) | ((s)<<12) | ((rn)<<5) | (rt))
+
+/* ldp/stp, imm7 is scaled by register size */
+#define EOP_LDSTP(sf,l,idx,rt,rt2,rn,imm7) \
+	EMIT(((sf)<<31) | 0x28000000 | ((idx)<<23) | ((l)<<22) | (((imm7)&0x7f)<<15) | ((rt2)<<10) | ((rn)<<5) | (rt))
+
+/* branches */
+#define EOP_B_PTR(ptr,l,imm26) \
+	EMIT_PTR(ptr, ((l)<<31) | 0x14000000 | ((imm26)&0x03ffffff))
+
+#define EOP_BCOND_PTR(ptr,cond,imm19) \
+	EMIT_PTR(ptr, 0x54000000 | (((imm19)&0x7ffff)<<5) | (cond))
+
+#define EOP_B(l,imm26)        EOP_B_PTR(tcache_ptr,l,imm26)
+#define EOP_BCOND(cond,imm19) EOP_BCOND_PTR(tcache_ptr,cond,imm19)
+
+#define EOP_BR(rn)  EMIT(0xd61f0000 | ((rn)<<5))
+#define EOP_BLR(rn) EMIT(0xd63f0000 | ((rn)<<5))
+#define EOP_RET(rn) EMIT(0xd65f0000 | ((rn)<<5))
+
+/* aliases */
+#define EOP_MOV_REG(sf,rd,rm)     EOP_LOGIC_REG(sf,A64_OP_ORR,0,rd,A64_ZR,rm,A64_SH_LSL,0)
+#define EOP_MOV_FROM_SP(rd)       EOP_ADDSUB_IMM(1,A64_OP_ADD,rd,A64_SP,0,0)
+#define EOP_LSL_IMM(sf,rd,rn,sh)  EOP_BITFIELD(sf,A64_BF_UBFM,rd,rn,(-(sh)) & ((sf) ? 63 : 31),((sf) ? 63 : 31) - (sh))
+#define EOP_LSR_IMM(sf,rd,rn,sh)  EOP_BITFIELD(sf,A64_BF_UBFM,rd,rn,sh,(sf) ? 63 : 31)
+#define EOP_ASR_IMM(rd,rn,sh)     EOP_BITFIELD(0,A64_BF_SBFM,rd,rn,sh,31)
+#define EOP_ROR_IMM(rd,rn,sh)     EOP_EXTR(0,rd,rn,rn,(sh) & 31)
+#define EOP_CSEL(rd,rn,rm,cond)   EOP_CSEL_X(0,0,0,rd,rn,rm,cond)
+#define EOP_CSET(rd,cond)         EOP_CSEL_X(0,0,1,rd,A64_ZR,A64_ZR,A64_COND_INV(cond))
+#define EOP_CMN_REG(rn,rm,sh,imm) EOP_ADDSUB_REG(0,A64_OP_ADDS,A64_ZR,rn,rm,sh,imm)
+#define EOP_TST_REG(sf,rn,rm)     EOP_LOGIC_REG(sf,A64_OP_ANDS,0,A64_ZR,rn,rm,A64_SH_LSL,0)
+
+// encode imm as a logical (bitmask) immediate, -1 if it can't be done
+static int emith_log_imm(u32 imm)
+{
+	u32 e, h, mask, v, t, ones, r;
+
+	if (imm == 0 || imm == ~0u)
+		return -1;
+
+	// find the element size the value repeats at
+	for (e = 32; e > 2; e >>= 1) {
+		h = e / 2;
+		mask = (1u << h) - 1;
+		if ((imm & mask) != ((imm >> h) & mask))
+			break;
+	}
+	mask = e == 32 ? ~0u : (1u << e) - 1;
+	v = imm & mask;
+	ones = __builtin_popcount(v);
+
+	// the element must be a rotated run of ones
+	for (r = 0, t = (1u << ones) - 1; r < e; r++) {
+		if (t == v)
+			return (r << 6) | ((-e << 1) & 0x3f) | (ones - 1);
+		t = ((t >> 1) | (t << (e - 1))) & mask;
+	}
+
+	return -1;
+}
+
+static void emith_move_imm(int rd, u32 imm)
+{
+	int nrs;
+
+	if (!(imm & 0xffff0000))
+		EOP_MOVE_WIDE(0, A64_MW_MOVZ, rd, 0, imm);
+	else if (!(imm & 0x0000ffff))
+		EOP_MOVE_WIDE(0, A64_MW_MOVZ, rd, 1, imm >> 16);
+	else if (!(~imm & 0xffff0000))
+		EOP_MOVE_WIDE(0, A64_MW_MOVN, rd, 0, ~imm);
+	else if (!(~imm & 0x0000ffff))
+		EOP_MOVE_WIDE(0, A64_MW_MOVN, rd, 1, ~imm >> 16);
+	else if ((nrs = emith_log_imm(imm)) >= 0)
+		EOP_LOGIC_IMM(0, A64_OP_ORR, rd, A64_ZR, nrs);
+	else {
+		EOP_MOVE_WIDE(0, A64_MW_MOVZ, rd, 0, imm);
+		EOP_MOVE_WIDE(0, A64_MW_MOVK, rd, 1, imm >> 16);
+	}
+}
+
+static void emith_move_imm_ptr(int rd, uintptr_t imm)
+{
+	int hw;
+
+	EOP_MOVE_WIDE(1, A64_MW_MOVZ, rd, 0, imm);
+	for (hw = 1; hw < 4; hw++)
+		if ((imm >> hw * 16) & 0xffff)
+			EOP_MOVE_WIDE(1, A64_MW_MOVK, rd, hw, imm >> hw * 16);
+}
+
+// note: flags are only valid for the S ops if 1 insn or the reg form is used;
+// negative imm turns add into sub and the other way around (C differs then)
+static void emith_arith_imm(int sf, int op, int rd, int rn, s32 imm)
+{
+	u32 uimm = imm;
+
+	if (imm < 0 && uimm != 0x80000000) {
+		uimm = -uimm;
+		op ^= A64_OP_SUB;
+	}
+
+	if (!(op & 1) && uimm == 0 && rd == rn)
+		return;
+
+	if (uimm < 0x1000)
+		EOP_ADDSUB_IMM(sf, op, rd, rn, 0, uimm);
+	else if (!(uimm & ~0xfff000))
+		EOP_ADDSUB_IMM(sf, op, rd, rn, 1, uimm >> 12);
+	else if (!(op & 1) && !(uimm & ~0xffffff)) {
+		EOP_ADDSUB_IMM(sf, op, rd, rn, 1, uimm >> 12);
+		EOP_ADDSUB_IMM(sf, op, rd, rd, 0, uimm & 0xfff);
+	}
+	else {
+		emith_move_imm(A64_TMP_REG2, uimm);
+		EOP_ADDSUB_REG(sf, op, rd, rn, A64_TMP_REG2, A64_SH_LSL, 0);
+	}
+}
+
+static void emith_logic_imm(int op, int rd, int rn, u32 imm)
+{
+	int nrs;
+
+	if ((op == A64_OP_ORR || op == A64_OP_EOR) && imm == 0) {
+		if (rd != rn)
+			EOP_MOV_REG(0, rd, rn);
+		return;
+	}
+	if (op == A64_OP_AND && imm == ~0u) {
+		if (rd != rn)
+			EOP_MOV_REG(0, rd, rn);
+		return;
+	}
+
+	nrs = emith_log_imm(imm);
+	if (nrs >= 0)
+		EOP_LOGIC_IMM(0, op, rd, rn, nrs);
+	else {
+		emith_move_imm(A64_TMP_REG2, imm);
+		EOP_LOGIC_REG(0, op, 0, rd, rn, A64_TMP_REG2, A64_SH_LSL, 0);
+	}
+}
+
+static void emith_ldst_offs(int size, int l, int rt, int rn, s32 offs)
+{
+	if (offs >= 0 && !(offs & ((1 << size) - 1)) && (offs >> size) < 0x1000)
+		EOP_LDST_UIMM(size, l, rt, rn, offs >> size);
+	else if (-0x100 <= offs && offs < 0x100)
+		EOP_LDST_SIMM9(size, l, 0, rt, rn, offs);
+	else {
+		emith_move_imm(A64_TMP_REG2, offs);
+		EOP_LDST_REG(size, l, rt, rn, A64_TMP_REG2, A64_EXT_SXTW, 0);
+	}
+}
+
+#define is_offset_19(val) \
+	((val) >= -0x40000 && (val) < 0x40000)
+
+#define is_offset_26(val) \
+	((val) >= -0x2000000 && (val) < 0x2000000)
+
+#define JMP_POS(ptr) \
+	ptr = tcache_ptr; \
+	tcache_ptr += sizeof(u32)
+
+#define JMP_EMIT(cond, ptr) { \
+	u32 val_ = (u32 *)tcache_ptr - (u32 *)(ptr); \
+	if ((cond) == A64_COND_AL) \
+		EOP_B_PTR(ptr, 0, val_); \
+	else \
+		EOP_BCOND_PTR(ptr, cond, val_); \
+}
+
+// b.cond only reaches +-1MB, so the far forms skip over an unconditional one
+static void emith_xbranch(int cond, void *target, int is_call)
+{
+	long val = (u32 *)target - (u32 *)tcache_ptr;
+	void *skip_ptr = NULL;
+
+	if (cond != A64_COND_AL) {
+		if (!is_call && is_offset_19(val)) {
+			EOP_BCOND(cond, val);			// b.cond target
+			return;
+		}
+		JMP_POS(skip_ptr);
+		val--;
+	}
+
+	if (is_offset_26(val))
+		EOP_B(is_call, val);				// b, bl target
+	else {
+		emith_move_imm_ptr(A64_TMP_REG, (uintptr_t)target);	// mov x16, =target
+		if (is_call)
+			EOP_BLR(A64_TMP_REG);
+		else
+			EOP_BR(A64_TMP_REG);
+	}
+
+	if (skip_ptr != NULL)
+		JMP_EMIT(A64_COND_INV(cond), skip_ptr);
+}
+
+// conditional ops that can't use csel skip themselves
+#define emith_skip_start(cond, ptr) { \
+	void *ptr; \
+	JMP_POS(ptr)
+
+#define emith_skip_end(cond, ptr) \
+	JMP_EMIT(A64_COND_INV(cond), ptr); \
+}
+
+#define EMITH_JMP_START(cond) { \
+	void *cond_ptr; \
+	JMP_POS(cond_ptr)
+
+#define EMITH_JMP_END(cond) \
+	JMP_EMIT(cond, cond_ptr); \
+}
+
+// fake "simple" or "short" jump - _c ops are conditional themselves
+#define EMITH_NOTHING1(cond) \
+	(void)(cond)
+
+#define EMITH_SJMP_DECL_()
+#define EMITH_SJMP_START_(cond)	EMITH_NOTHING1(cond)
+#define EMITH_SJMP_END_(cond)	EMITH_NOTHING1(cond)
+#define EMITH_SJMP_START(cond)	EMITH_NOTHING1(cond)
+#define EMITH_SJMP_END(cond)	EMITH_NOTHING1(cond)
+#define EMITH_SJMP3_START(cond)	EMITH_NOTHING1(cond)
+#define EMITH_SJMP3_MID(cond)	EMITH_NOTHING1(cond)
+#define EMITH_SJMP3_END()
+
+#define emith_move_r_r(d, s) \
+	EOP_MOV_REG(0, d, s)
+
+#define emith_move_r_r_ptr(d, s) \
+	EOP_MOV_REG(1, d, s)
+
+#define emith_mvn_r_r(d, s) \
+	EOP_LOGIC_REG(0,A64_OP_ORR,1,d,A64_ZR,s,A64_SH_LSL,0)
+
+#define emith_add_r_r_r_lsl(d, s1, s2, lslimm) \
+	EOP_ADDSUB_REG(0,A64_OP_ADD,d,s1,s2,A64_SH_LSL,lslimm)
+
+#define emith_or_r_r_r_lsl(d, s1, s2, lslimm) \
+	EOP_LOGIC_REG(0,A64_OP_ORR,0,d,s1,s2,A64_SH_LSL,lslimm)
+
+#define emith_eor_r_r_r_lsl(d, s1, s2, lslimm) \
+	EOP_LOGIC_REG(0,A64_OP_EOR,0,d,s1,s2,A64_SH_LSL,lslimm)
+
+#define emith_eor_r_r_r_lsr(d, s1, s2, lsrimm) \
+	EOP_LOGIC_REG(0,A64_OP_EOR,0,d,s1,s2,A64_SH_LSR,lsrimm)
+
+#define emith_or_r_r_lsl(d, s, lslimm) \
+	emith_or_r_r_r_lsl(d, d, s, lslimm)
+
+#define emith_eor_r_r_lsr(d, s, lsrimm) \
+	emith_eor_r_r_r_lsr(d, d, s, lsrimm)
+
+#define emith_add_r_r_r(d, s1, s2) \
+	emith_add_r_r_r_lsl(d, s1, s2, 0)
+
+#define emith_or_r_r_r(d, s1, s2) \
+	emith_or_r_r_r_lsl(d, s1, s2, 0)
+
+#define emith_eor_r_r_r(d, s1, s2) \
+	emith_eor_r_r_r_lsl(d, s1, s2, 0)
+
+#define emith_add_r_r(d, s) \
+	emith_add_r_r_r(d, d, s)
+
+#define emith_sub_r_r(d, s) \
+	EOP_ADDSUB_REG(0,A64_OP_SUB,d,d,s,A64_SH_LSL,0)
+
+#define emith_adc_r_r(d, s) \
+	EOP_ADCSBC(0,A64_OP_ADD,d,d,s)
+
+#define emith_and_r_r(d, s) \
+	EOP_LOGIC_REG(0,A64_OP_AND,0,d,d,s,A64_SH_LSL,0)
+
+#define emith_or_r_r(d, s) \
+	emith_or_r_r_r(d, d, s)
+
+#define emith_eor_r_r(d, s) \
+	emith_eor_r_r_r(d, d, s)
+
+#define emith_tst_r_r(d, s) \
+	EOP_TST_REG(0, d, s)
+
+#define emith_tst_r_r_ptr(d, s) \
+	EOP_TST_REG(1, d, s)
+
+// fake teq - test equivalence - get_flags(d ^ s)
+#define emith_teq_r_r(d, s) { \
+	EOP_LOGIC_REG(0,A64_OP_EOR,0,A64_TMP_REG,d,s,A64_SH_LSL,0); \
+	EOP_TST_REG(0, A64_TMP_REG, A64_TMP_REG); \
+}
+
+#define emith_cmp_r_r(d, s) \
+	EOP_ADDSUB_REG(0,A64_OP_SUBS,A64_ZR,d,s,A64_SH_LSL,0)
+
+#define emith_addf_r_r(d, s) \
+	EOP_ADDSUB_REG(0,A64_OP_ADDS,d,d,s,A64_SH_LSL,0)
+
+#define emith_subf_r_r(d, s) \
+	EOP_ADDSUB_REG(0,A64_OP_SUBS,d,d,s,A64_SH_LSL,0)
+
+#define emith_adcf_r_r(d, s) \
+	EOP_ADCSBC(0,A64_OP_ADDS,d,d,s)
+
+#define emith_sbcf_r_r(d, s) \
+	EOP_ADCSBC(0,A64_OP_SUBS,d,d,s)
+
+// note: only N and Z flags updated correctly
+#define emith_eorf_r_r(d, s) { \
+	emith_eor_r_r(d, s); \
+	EOP_TST_REG(0, d, d); \
+}
+
+#define emith_move_r_imm(r, imm) \
+	emith_move_imm(r, imm)
+
+#define emith_add_r_imm(r, imm) \
+	emith_arith_imm(0, A64_OP_ADD, r, r, imm)
+
+#define emith_adc_r_imm(r, imm) { \
+	emith_move_imm(A64_TMP_REG2, imm); \
+	emith_adc_r_r(r, A64_TMP_REG2); \
+}
+
+#define emith_sub_r_imm(r, imm) \
+	emith_arith_imm(0, A64_OP_SUB, r, r, imm)
+
+#define emith_bic_r_imm(r, imm) \
+	emith_logic_imm(A64_OP_AND, r, r, ~(u32)(imm))
+
+#define emith_and_r_imm(r, imm) \
+	emith_logic_imm(A64_OP_AND, r, r, imm)
+
+#define emith_or_r_imm(r, imm) \
+	emith_logic_imm(A64_OP_ORR, r, r, imm)
+
+#define emith_eor_r_imm(r, imm) \
+	emith_logic_imm(A64_OP_EOR, r, r, imm)
+
+#define emith_tst_r_imm(r, imm) \
+	emith_logic_imm(A64_OP_ANDS, A64_ZR, r, imm)
+
+#define emith_cmp_r_imm(r, imm) \
+	emith_arith_imm(0, A64_OP_SUBS, A64_ZR, r, imm)
+
+#define emith_subf_r_imm(r, imm) \
+	emith_arith_imm(0, A64_OP_SUBS, r, r, imm)
+
+// conditional ops: calculate into tmp, then select
+#define emith_op_imm_c(cond, r, op) { \
+	op; \
+	EOP_CSEL(r, A64_TMP_REG, r, cond); \
+}
+
+#define emith_move_r_imm_c(cond, r, imm) \
+	emith_op_imm_c(cond, r, emith_move_imm(A64_TMP_REG, imm))
+
+#define emith_add_r_imm_c(cond, r, imm) \
+	emith_op_imm_c(cond, r, emith_arith_imm(0, A64_OP_ADD, A64_TMP_REG, r, imm))
+
+#define emith_sub_r_imm_c(cond, r, imm) \
+	emith_op_imm_c(cond, r, emith_arith_imm(0, A64_OP_SUB, A64_TMP_REG, r, imm))
+
+#define emith_or_r_imm_c(cond, r, imm) \
+	emith_op_imm_c(cond, r, emith_logic_imm(A64_OP_ORR, A64_TMP_REG, r, imm))
+
+#define emith_eor_r_imm_c(cond, r, imm) \
+	emith_op_imm_c(cond, r, emith_logic_imm(A64_OP_EOR, A64_TMP_REG, r, imm))
+
+#define emith_bic_r_imm_c(cond, r, imm) \
+	emith_op_imm_c(cond, r, emith_logic_imm(A64_OP_AND, A64_TMP_REG, r, ~(u32)(imm)))
+
+#define emith_move_r_imm_s8(r, imm) \
+	emith_move_imm(r, (u32)(signed int)(signed char)(imm))
+
+#define emith_and_r_r_imm(d, s, imm) \
+	emith_logic_imm(A64_OP_AND, d, s, imm)
+
+#define emith_add_r_r_imm(d, s, imm) \
+	emith_arith_imm(0, A64_OP_ADD, d, s, imm)
+
+#define emith_add_r_r_ptr_imm(d, s, imm) \
+	emith_arith_imm(1, A64_OP_ADD, d, s, imm)
+
+#define emith_sub_r_r_imm(d, s, imm) \
+	emith_arith_imm(0, A64_OP_SUB, d, s, imm)
+
+#define emith_neg_r_r(d, s) \
+	EOP_ADDSUB_REG(0,A64_OP_SUB,d,A64_ZR,s,A64_SH_LSL,0)
+
+#define emith_lsl(d, s, cnt) \
+	EOP_LSL_IMM(0, d, s, cnt)
+
+#define emith_lsr(d, s, cnt) \
+	EOP_LSR_IMM(0, d, s, cnt)
+
+#define emith_asr(d, s, cnt) \
+	EOP_ASR_IMM(d, s, cnt)
+
+#define emith_ror(d, s, cnt) \
+	EOP_ROR_IMM(d, s, cnt)
+
+#define emith_ror_c(cond, d, s, cnt) \
+	emith_op_imm_c(cond, d, emith_ror(A64_TMP_REG, s, cnt))
+
+#define emith_rol(d, s, cnt) \
+	EOP_ROR_IMM(d, s, 32-(cnt))
+
+/*
+ * no flag setting shifts, so C is set with cmn tmp, tmp (C = tmp bit31),
+ * after moving the bit that gets shifted out there.
+ * note: only C flag updated correctly, except for emith_lslf
+ */
+#define emith_carry_from_bit(s, bit) { \
+	if ((bit) == 31) \
+		EOP_CMN_REG(s, s, A64_SH_LSL, 0); \
+	else { \
+		emith_lsl(A64_TMP_REG, s, 31 - (bit)); \
+		EOP_CMN_REG(A64_TMP_REG, A64_TMP_REG, A64_SH_LSL, 0); \
+	} \
+}
+
+#define emith_lslf(d, s, cnt) { \
+	int s_ = s; \
+	if ((cnt) > 1) { \
+		emith_lsl(A64_TMP_REG, s, (cnt) - 1); \
+		s_ = A64_TMP_REG; \
+	} \
+	EOP_ADDSUB_REG(0,A64_OP_ADDS,d,s_,s_,A64_SH_LSL,0); \
+}
+
+#define emith_lsrf(d, s, cnt) { \
+	emith_carry_from_bit(s, (cnt) - 1); \
+	emith_lsr(d, s, cnt); \
+}
+
+#define emith_asrf(d, s, cnt) { \
+	emith_carry_from_bit(s, (cnt) - 1); \
+	emith_asr(d, s, cnt); \
+}
+
+#define emith_rolf(d, s, cnt) { \
+	emith_carry_from_bit(s, 32 - (cnt)); \
+	emith_rol(d, s, cnt); \
+}
+
+#define emith_rorf(d, s, cnt) { \
+	emith_ror(d, s, cnt); \
+	EOP_CMN_REG(d, d, A64_SH_LSL, 0); \
+}
+
+#define emith_rolcf(d) \
+	emith_adcf_r_r(d, d)
+
+// d = (C << 31) | (d >> 1), C = old d & 1
+#define emith_rorcf(d) { \
+	EOP_CSET(A64_TMP_REG, A64_COND_CS); \
+	emith_lsl(A64_TMP_REG2, d, 31); \
+	EOP_EXTR(0, d, A64_TMP_REG, d, 1); \
+	EOP_CMN_REG(A64_TMP_REG2, A64_TMP_REG2, A64_SH_LSL, 0); \
+}
+
+#define emith_negcf_r_r(d, s) \
+	EOP_ADCSBC(0,A64_OP_SUBS,d,A64_ZR,s)
+
+#define emith_mul(d, s1, s2) \
+	EOP_MADD(0,d,s1,s2,A64_ZR)
+
+// 64bit result goes through x16, dlo/dhi may overlap with s1/s2
+#define emith_mul_64(u, dlo, dhi, s1, s2) { \
+	EOP_XMADDL(u,A64_TMP_REG,s1,s2,A64_ZR); \
+	emith_move_r_r(dlo, A64_TMP_REG); \
+	EOP_LSR_IMM(1,dhi,A64_TMP_REG,32); \
+}
+
+#define emith_mul_u64(dlo, dhi, s1, s2) \
+	emith_mul_64(1, dlo, dhi, s1, s2)
+
+#define emith_mul_s64(dlo, dhi, s1, s2) \
+	emith_mul_64(0, dlo, dhi, s1, s2)
+
+// (dlo,dhi) += signed(s1) * signed(s2)
+#define emith_mula_s64(dlo, dhi, s1, s2) { \
+	EOP_LSL_IMM(1,A64_TMP_REG,dhi,32); \
+	EOP_ADDSUB_EXT(1,A64_OP_ADD,A64_TMP_REG,A64_TMP_REG,dlo,A64_EXT_UXTW,0); \
+	EOP_XMADDL(0,A64_TMP_REG,s1,s2,A64_TMP_REG); \
+	emith_move_r_r(dlo, A64_TMP_REG); \
+	EOP_LSR_IMM(1,dhi,A64_TMP_REG,32); \
+}
+
+// misc
+#define emith_read_r_r_offs(r, rs, offs) \
+	emith_ldst_offs(A64_SZ_W, 1, r, rs, offs)
+
+#define emith_read8_r_r_offs(r, rs, offs) \
+	emith_ldst_offs(A64_SZ_B, 1, r, rs, offs)
+
+#define emith_read16_r_r_offs(r, rs, offs) \
+	emith_ldst_offs(A64_SZ_H, 1, r, rs, offs)
+
+#define emith_read_r_r_offs_c(cond, r, rs, offs) \
+	emith_skip_start(cond, skip_ptr_); \
+	emith_read_r_r_offs(r, rs, offs); \
+	emith_skip_end(cond, skip_ptr_)
+
+#define emith_read8_r_r_offs_c(cond, r, rs, offs) \
+	emith_skip_start(cond, skip_ptr_); \
+	emith_read8_r_r_offs(r, rs, offs); \
+	emith_skip_end(cond, skip_ptr_)
+
+#define emith_read16_r_r_offs_c(cond, r, rs, offs) \
+	emith_skip_start(cond, skip_ptr_); \
+	emith_read16_r_r_offs(r, rs, offs); \
+	emith_skip_end(cond, skip_ptr_)
+
+#define emith_ctx_read(r, offs) \
+	emith_read_r_r_offs(r, CONTEXT_REG, offs)
+
+#define emith_ctx_read_ptr(r, offs) \
+	emith_ldst_offs(A64_SZ_X, 1, r, CONTEXT_REG, offs)
+
+#define emith_ctx_write(r, offs) \
+	emith_ldst_offs(A64_SZ_W, 0, r, CONTEXT_REG, offs)
+
+// ldp/stp for register pairs while the offset fits, tmpr is not needed
+#define emith_ctx_do_multiple(l, r, offs, count) do { \
+	int r_ = r, offs_ = offs, c_ = count;                    \
+	for (; c_ >= 2 && offs_ <= 0xfc; r_ += 2, offs_ += 8, c_ -= 2) \
+		EOP_LDSTP(0,l,A64_IDX_OFFS,r_,r_+1,CONTEXT_REG,offs_>>2); \
+	for (; c_ > 0; r_++, offs_ += 4, c_--)                   \
+		emith_ldst_offs(A64_SZ_W, l, r_, CONTEXT_REG, offs_); \
+} while (0)
+
+#define emith_ctx_read_multiple(r, offs, count, tmpr) \
+	emith_ctx_do_multiple(1, r, offs, count)
+
+#define emith_ctx_write_multiple(r, offs, count, tmpr) \
+	emith_ctx_do_multiple(0, r, offs, count)
+
+#define emith_clear_msb(d, s, count) \
+	EOP_BITFIELD(0,A64_BF_UBFM,d,s,0,31-(count))
+
+#define emith_clear_msb_c(cond, d, s, count) \
+	emith_op_imm_c(cond, d, emith_clear_msb(A64_TMP_REG, s, count))
+
+#define emith_sext(d, s, bits) \
+	EOP_BITFIELD(0,A64_BF_SBFM,d,s,0,(bits)-1)
+
+// x0-x15 may be in reg_temp[], pushed in pairs to keep sp 16 byte aligned
+#define emith_save_caller_regs(mask) do { \
+	int r_, p_ = -1; \
+	for (r_ = 0; r_ < 16; r_++) { \
+		if (!((mask) & (1 << r_))) \
+			continue; \
+		if (p_ < 0) { \
+			p_ = r_; \
+			continue; \
+		} \
+		EOP_LDSTP(1,0,A64_IDX_PRE,p_,r_,A64_SP,-2); /* stp */ \
+		p_ = -1; \
+	} \
+	if (p_ >= 0) \
+		EOP_LDST_SIMM9(A64_SZ_X,0,3,p_,A64_SP,-16); /* str */ \
+} while (0)
+
+#define emith_restore_caller_regs(mask) do { \
+	int r_, p_ = -1, odd_ = __builtin_parity((mask) & 0xffff); \
+	for (r_ = 15; r_ >= 0; r_--) { \
+		if (!((mask) & (1 << r_))) \
+			continue; \
+		if (odd_) { \
+			EOP_LDST_SIMM9(A64_SZ_X,1,1,r_,A64_SP,16); /* ldr */ \
+			odd_ = 0; \
+		} \
+		else if (p_ < 0) \
+			p_ = r_; \
+		else { \
+			EOP_LDSTP(1,1,A64_IDX_POST,r_,p_,A64_SP,2); /* ldp */ \
+			p_ = -1; \
+		} \
+	} \
+} while (0)
+
+// upto 8 args
+#define emith_pass_arg_r(arg, reg) \
+	emith_move_r_r_ptr(arg, reg)
+
+#define emith_pass_arg_imm(arg, imm) \
+	emith_move_r_imm(arg, imm)
+
+#define emith_jump(target) \
+	emith_jump_cond(A64_COND_AL, target)
+
+// patchable jumps are always a single b, or b.!cond +8 + b for conditional
+// ones, as link targets can end up anywhere in the tcache
+#define emith_jump_patchable(target) { \
+	long val_ = (u32 *)(target) - (u32 *)tcache_ptr; \
+	EOP_B(0, val_); \
+}
+
+#define emith_jump_cond(cond, target) \
+	emith_xbranch(cond, target, 0)
+
+#define emith_jump_cond_patchable(cond, target) { \
+	EOP_BCOND(A64_COND_INV(cond), 2); \
+	emith_jump_patchable(target); \
+}
+
+// the tcache may be patched after it was synced, so sync here too
+#define emith_jump_patch(ptr, target) do { \
+	u32 *ptr_ = ptr; \
+	if ((*ptr_ & 0xff000010) == 0x54000000) /* b.cond */ \
+		ptr_++; \
+	*ptr_ = 0x14000000 | (((u32 *)(target) - ptr_) & 0x03ffffff); \
+	host_instructions_updated(ptr_, ptr_ + 1); \
+} while (0)
+
+#define emith_jump_at(ptr, target) { \
+	u32 val_ = (u32 *)(target) - (u32 *)(ptr); \
+	EOP_B_PTR(ptr, 0, val_); \
+}
+
+#define emith_jump_reg(r) \
+	EOP_BR(r)
+
+#define emith_jump_reg_c(cond, r) \
+	emith_skip_start(cond, skip_ptr_); \
+	emith_jump_reg(r); \
+	emith_skip_end(cond, skip_ptr_)
+
+#define emith_jump_ctx(offs) { \
+	emith_ldst_offs(A64_SZ_X, 1, A64_TMP_REG, CONTEXT_REG, offs); \
+	EOP_BR(A64_TMP_REG); \
+}
+
+#define emith_jump_ctx_c(cond, offs) \
+	emith_skip_start(cond, skip_ptr_); \
+	emith_jump_ctx(offs); \
+	emith_skip_end(cond, skip_ptr_)
+
+#define emith_call_cond(cond, target) \
+	emith_xbranch(cond, target, 1)
+
+#define emith_call(target) \
+	emith_call_cond(A64_COND_AL, target)
+
+#define emith_call_reg(r) \
+	EOP_BLR(r)
+
+#define emith_call_ctx(offs) { \
+	emith_ldst_offs(A64_SZ_X, 1, A64_TMP_REG, CONTEXT_REG, offs); \
+	EOP_BLR(A64_TMP_REG); \
+}
+
+#define emith_ret() \
+	EOP_RET(A64_LR)
+
+#define emith_ret_c(cond) \
+	emith_skip_start(cond, skip_ptr_); \
+	emith_ret(); \
+	emith_skip_end(cond, skip_ptr_)
+
+// note: needs a pointer sized slot
+#define emith_ret_to_ctx(offs) \
+	emith_ldst_offs(A64_SZ_X, 0, A64_LR, CONTEXT_REG, offs)
+
+#define emith_push_ret() \
+	EOP_LDST_SIMM9(A64_SZ_X,0,3,A64_LR,A64_SP,-16) /* str x30, [sp, #-16]! */
+
+#define emith_pop_and_ret() { \
+	EOP_LDST_SIMM9(A64_SZ_X,1,1,A64_LR,A64_SP,16); /* ldr x30, [sp], #16 */ \
+	emith_ret(); \
+}
+
+#define host_instructions_updated(base, end) \
+	__builtin___clear_cache((char *)(base), (char *)(end))
+
+#define host_arg2reg(rd, arg) \
+	rd = arg
+
+/* SH2 drc specific */
+/* x19-x28 are callee saved, x29/x30 go along for a proper frame record */
+#define emith_sh2_drc_entry() { \
+	EOP_LDSTP(1,0,A64_IDX_PRE, 29,30,A64_SP,-12); /* stp x29, x30, [sp, #-96]! */ \
+	EOP_MOV_FROM_SP(29); \
+	EOP_LDSTP(1,0,A64_IDX_OFFS,19,20,A64_SP,2); \
+	EOP_LDSTP(1,0,A64_IDX_OFFS,21,22,A64_SP,4); \
+	EOP_LDSTP(1,0,A64_IDX_OFFS,23,24,A64_SP,6); \
+	EOP_LDSTP(1,0,A64_IDX_OFFS,25,26,A64_SP,8); \
+	EOP_LDSTP(1,0,A64_IDX_OFFS,27,28,A64_SP,10); \
+}
+
+#define emith_sh2_drc_exit() { \
+	EOP_LDSTP(1,1,A64_IDX_OFFS,19,20,A64_SP,2); \
+	EOP_LDSTP(1,1,A64_IDX_OFFS,21,22,A64_SP,4); \
+	EOP_LDSTP(1,1,A64_IDX_OFFS,23,24,A64_SP,6); \
+	EOP_LDSTP(1,1,A64_IDX_OFFS,25,26,A64_SP,8); \
+	EOP_LDSTP(1,1,A64_IDX_OFFS,27,28,A64_SP,10); \
+	EOP_LDSTP(1,1,A64_IDX_POST,29,30,A64_SP,12); /* ldp x29, x30, [sp], #96 */ \
+	emith_ret(); \
+}
+
+#define emith_sh2_wcall(a, tab) { \
+	emith_lsr(A64_TMP_REG2, a, SH2_WRITE_SHIFT); \
+	EOP_LDST_REG(A64_SZ_X,1,A64_TMP_REG,tab,A64_TMP_REG2,A64_EXT_UXTW,1); \
+	emith_move_r_r_ptr(2, CONTEXT_REG); \
+	emith_jump_reg(A64_TMP_REG); \
+}
+
+#define emith_sh2_dtbf_loop() { \
+	void *jmp0; /* unsigned overflow check */                           \
+	int cr, rn;                                                          \
+	int tmp_ = rcache_get_tmp();                                         \
+	cr = rcache_get_reg(SHR_SR, RC_GR_RMW);                              \
+	rn = rcache_get_reg((op >> 8) & 0x0f, RC_GR_RMW);                    \
+	emith_sub_r_imm(rn, 1);                /* sub rn, #1 */              \
+	emith_bic_r_imm(cr, 1);                /* bic cr, #1 */              \
+	emith_sub_r_imm(cr, (cycles+1) << 12); /* sub cr, #(cycles+1)<<12 */ \
+	cycles = 0;                                                          \
+	emith_asr(tmp_, cr, 2+12);             /* asr tmp_, cr, #2+12 */     \
+	emith_cmp_r_imm(tmp_, 0);                                            \
+	EOP_CSEL(tmp_, tmp_, A64_ZR, A64_COND_GE); /* no negative cycles */  \
+	emith_clear_msb(cr, cr, 20);           /* and cr, #0xfff */          \
+	emith_subf_r_r(rn, tmp_);              /* subs rn, tmp_ */           \
+	JMP_POS(jmp0);                         /* b.hi done */               \
+	emith_neg_r_r(tmp_, rn);               /* neg tmp_, rn */            \
+	emith_or_r_r_lsl(cr, tmp_, 12+2);      /* orr cr, tmp_, lsl #12+2 */ \
+	emith_or_r_imm(cr, 1);                 /* orr cr, #1 */              \
+	emith_move_r_imm(rn, 0);               /* mov rn, #0 */              \
+	JMP_EMIT(A64_COND_HI, jmp0);           /* done: */                   \
+	rcache_free_tmp(tmp_);                                               \
+}
+
+#define emith_write_sr(sr, srcr) \
+	EOP_BITFIELD(0,A64_BF_BFM,sr,srcr,0,9) /* bfi sr, srcr, #0, #10 */
+
+#define emith_carry_to_t(srr, is_sub) { \
+	EOP_CSET(A64_TMP_REG, (is_sub) ? A64_COND_CC : A64_COND_CS); \
+	EOP_BITFIELD(0,A64_BF_BFM,srr,A64_TMP_REG,0,0); /* bfi srr, tmp, #0, #1 */ \
+}
+
+// C = T, inverted for subtraction like on ARM (C = !borrow)
+#define emith_tpop_carry(sr, is_sub) { \
+	emith_and_r_r_imm(A64_TMP_REG, sr, 1); \
+	if (is_sub) /* cmp wzr, tmp */ \
+		EOP_ADDSUB_REG(0,A64_OP_SUBS,A64_ZR,A64_ZR,A64_TMP_REG,A64_SH_LSL,0); \
+	else \
+		emith_cmp_r_imm(A64_TMP_REG, 1); \
+}
+
+#define emith_tpush_carry(sr, is_sub) \
+	emith_carry_to_t(sr, is_sub)
+
+/*
+ * if Q
+ *   t = carry(Rn += Rm)
+ * else
+ *   t = carry(Rn -= Rm)
+ * T ^= t
+ */
+#define emith_sh2_div1_step(rn, rm, sr) {         \
+	void *jmp0, *jmp1;                        \
+	emith_tst_r_imm(sr, Q);  /* if (Q ^ M) */ \
+	JMP_POS(jmp0);           /* b.eq do_sub */\
+	emith_addf_r_r(rn, rm);                   \
+	EOP_CSET(A64_TMP_REG, A64_COND_CS);       \
+	JMP_POS(jmp1);           /* b done */     \
+	JMP_EMIT(A64_COND_EQ, jmp0); /* do_sub: */\
+	emith_subf_r_r(rn, rm);                   \
+	EOP_CSET(A64_TMP_REG, A64_COND_CC);       \
+	JMP_EMIT(A64_COND_AL, jmp1); /* done: */  \
+	emith_eor_r_r(sr, A64_TMP_REG);           \
+}
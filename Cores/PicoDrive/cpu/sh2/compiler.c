@@ -306,6 +306,39 @@ static temp_reg_t reg_temp[] = {
   {  3, },
 };
 
+#elif defined(__aarch64__)
+#include "../drc/emit_arm64.c"
+
+// x19 is CONTEXT_REG, x20-x28 are callee saved
+static const int reg_map_g2h[] = {
+  20, 21, 22, 23,
+  24, 25, 26, -1,
+  -1, -1, -1, -1,
+  -1, -1, -1, 27, // r12 .. sp
+  -1, -1, -1, 28, // SHR_PC,  SHR_PPC, SHR_PR,   SHR_SR,
+  -1, -1, -1, -1, // SHR_GBR, SHR_VBR, SHR_MACH, SHR_MACL,
+};
+
+// x16, x17 are used by the emitter
+static temp_reg_t reg_temp[] = {
+  {  0, },
+  {  1, },
+  {  2, },
+  {  3, },
+  {  4, },
+  {  5, },
+  {  6, },
+  {  7, },
+  {  8, },
+  {  9, },
+  { 10, },
+  { 11, },
+  { 12, },
+  { 13, },
+  { 14, },
+  { 15, },
+};
+
 #elif defined(__i386__)
 #include "../drc/emit_x86.c"
 
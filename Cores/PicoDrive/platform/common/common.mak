@@ -36,6 +36,9 @@ else
 DEFINES += CPU_CMP_R
 endif # cpu_cmp_w
 endif
+ifeq "$(drc_cmp)" "1"
+DEFINES += DRC_CMP
+endif
 ifeq "$(pprof)" "1"
 DEFINES += PPROF
 SRCS_COMMON += $(R)platform/linux/pprof.c
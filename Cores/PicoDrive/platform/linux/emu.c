@@ -29,7 +29,8 @@ void pemu_prep_defconfig(void)
 
 void pemu_validate_config(void)
 {
-#if !defined(__arm__) && !defined(__i386__) && !defined(__x86_64__)
+#if !defined(__arm__) && !defined(__i386__) && !defined(__x86_64__) \
+ && !(defined(__aarch64__) && defined(DRC_SH2))
 	PicoIn.opt &= ~POPT_EN_DRC;
 #endif
 }
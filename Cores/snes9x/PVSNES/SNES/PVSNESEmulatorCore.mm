@@ -169,6 +169,7 @@ NSString *SNESEmulatorKeys[] = { @"Up", @"Down", @"Left", @"Right", @"A", @"B",
     Settings.DynamicRateControl         =  false;
     Settings.DynamicRateLimit           =  5;
     Settings.InterpolationMethod        =  2;
+    Settings.ThreadedAPU                =  false;
 
     // Display
 
@@ -178,6 +179,7 @@ NSString *SNESEmulatorKeys[] = { @"Up", @"Down", @"Left", @"Right", @"A", @"B",
     Settings.DisplayPressedKeys         = false;
     Settings.AutoDisplayMessages        = true;
     Settings.InitialInfoStringTimeout   = 120;
+    Settings.ThreadedRendering          = false;
     
     // Timings
 //    Settings.SkipFrames                 =  AUTO_FRAMERATE;
@@ -5,6 +5,11 @@
 \*****************************************************************************/
 
 #include <cmath>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include "../snes9x.h"
 #include "apu.h"
 #include "../msu1.h"
@@ -54,6 +59,50 @@ static uint32 ratio_denominator = APU_DENOMINATOR_NTSC;
 static double dynamic_rate_multiplier = 1.0;
 } // namespace spc
 
+// With Settings.ThreadedAPU, the SMP and DSP run on a thread of their own. The
+// CPU thread posts commands to a mailbox, each one a number of SMP clocks to run
+// followed by an optional port write or DSP catch-up, and the APU thread works
+// through them in order. The SMP is only ever run up to a time the CPU has
+// already reached, so it sees every port write at the same point it would have
+// inline, the output is identical, and nothing ever needs rolling back. Port
+// reads, landing samples and anything else that looks at APU state wait for the
+// mailbox to drain first; when a game reads the ports so often that those waits
+// cost more than the thread saves, we go back to running inline for a while.
+namespace spc_thread {
+struct Command
+{
+    int32 clocks;
+    int16 port; // -1 for none
+    uint8 data;
+    bool8 dsp_sync;
+};
+
+static const uint32 QUEUE_SIZE = 1024; // Power of 2
+static const int SPIN_COUNT = 64;
+static const int MAX_READS_PER_FRAME = 32;
+static const int MIN_INLINE_FRAMES = 60;
+static const int MAX_INLINE_FRAMES = 60 * 64;
+
+static Command queue[QUEUE_SIZE];
+static std::atomic<uint32> head(0); // Written by the CPU thread
+static std::atomic<uint32> tail(0); // Written by the APU thread
+static std::atomic<bool> apu_waiting(false);
+static std::atomic<bool> cpu_waiting(false);
+static std::atomic<bool> quit(false);
+static std::mutex mutex;
+static std::condition_variable work_cond;
+static std::condition_variable idle_cond;
+static std::thread thread;
+static std::thread::id thread_id;
+
+// Only touched by the CPU thread
+static bool8 running = FALSE;
+static bool8 active = FALSE;
+static int port_reads = 0;
+static int inline_frames = 0;
+static int backoff_frames = MIN_INLINE_FRAMES;
+} // namespace spc_thread
+
 namespace msu {
 // Always 16-bit, Stereo; 1.5x dsp buffer to never overflow
 static Resampler *resampler = NULL;
@@ -66,10 +115,166 @@ static void SPCSnapshotCallback(void);
 static inline int S9xAPUGetClock(int32);
 static inline int S9xAPUGetClockRemainder(int32);
 
+namespace spc_thread {
+static void Loop(void)
+{
+    for (;;)
+    {
+        uint32 t = tail.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < SPIN_COUNT && t == head.load(std::memory_order_acquire); i++)
+            std::this_thread::yield();
+
+        if (t == head.load(std::memory_order_acquire))
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+
+            apu_waiting = true;
+            work_cond.wait(lock, [t] { return quit || t != head; });
+            apu_waiting = false;
+
+            if (quit)
+                break;
+        }
+
+        const Command &cmd = queue[t & (QUEUE_SIZE - 1)];
+
+        SNES::smp.clock -= cmd.clocks;
+        SNES::smp.enter();
+
+        if (cmd.port >= 0)
+            SNES::cpu.port_write(cmd.port, cmd.data);
+
+        if (cmd.dsp_sync)
+            SNES::dsp.synchronize();
+
+        tail = t + 1;
+
+        if (cpu_waiting)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle_cond.notify_one();
+        }
+    }
+}
+
+// Waits until the APU thread has worked through every posted command, after
+// which the CPU thread may look at or change APU state directly.
+static void Sync(void)
+{
+    if (!running || std::this_thread::get_id() == thread_id)
+        return;
+
+    const uint32 h = head.load(std::memory_order_relaxed);
+
+    for (int i = 0; i < SPIN_COUNT && tail.load(std::memory_order_acquire) != h; i++)
+        std::this_thread::yield();
+
+    if (tail.load(std::memory_order_acquire) != h)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        cpu_waiting = true;
+        idle_cond.wait(lock, [h] { return tail == h; });
+        cpu_waiting = false;
+    }
+}
+
+static void Post(int32 clocks, int port, uint8 data, bool8 dsp_sync)
+{
+    const uint32 h = head.load(std::memory_order_relaxed);
+
+    if (h - tail.load(std::memory_order_acquire) == QUEUE_SIZE)
+        Sync();
+
+    Command &cmd = queue[h & (QUEUE_SIZE - 1)];
+    cmd.clocks = clocks;
+    cmd.port = port;
+    cmd.data = data;
+    cmd.dsp_sync = dsp_sync;
+
+    head = h + 1;
+
+    if (apu_waiting)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        work_cond.notify_one();
+    }
+}
+
+// Drains the mailbox and goes back to running inline; EndFrame() decides when
+// to resume.
+static void Suspend(void)
+{
+    Sync();
+    active = FALSE;
+}
+
+static void Stop(void)
+{
+    if (!running)
+        return;
+
+    Sync();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        work_cond.notify_one();
+    }
+    thread.join();
+
+    quit = false;
+    running = FALSE;
+    active = FALSE;
+}
+
+static void EndFrame(void)
+{
+    // MSU-1 audio is generated from inside the DSP but its state belongs to the
+    // CPU thread, so it has to stay inline.
+    const bool8 wanted = Settings.ThreadedAPU && !Settings.MSU1;
+
+    if (active)
+    {
+        Sync();
+
+        if (!wanted)
+            active = FALSE;
+        else if (port_reads > MAX_READS_PER_FRAME)
+        {
+            active = FALSE;
+            inline_frames = backoff_frames;
+            backoff_frames = std::min(backoff_frames * 2, MAX_INLINE_FRAMES);
+        }
+        else
+            backoff_frames = MIN_INLINE_FRAMES;
+    }
+    else if (wanted)
+    {
+        if (inline_frames > 0)
+            inline_frames--;
+        else
+        {
+            if (!running)
+            {
+                thread = std::thread(Loop);
+                thread_id = thread.get_id();
+                running = TRUE;
+            }
+            active = TRUE;
+        }
+    }
+
+    port_reads = 0;
+}
+} // namespace spc_thread
+
 bool8 S9xMixSamples(uint8 *dest, int sample_count)
 {
     int16 *out = (int16 *)dest;
 
+    spc_thread::Sync();
+
     if (Settings.Mute)
     {
         memset(out, 0, sample_count << 1);
@@ -122,11 +327,14 @@ bool8 S9xMixSamples(uint8 *dest, int sample_count)
 
 int S9xGetSampleCount(void)
 {
+    spc_thread::Sync();
     return spc::resampler->avail();
 }
 
 void S9xLandSamples(void)
 {
+    spc_thread::Sync();
+
     if (spc::callback != NULL)
         spc::callback(spc::callback_data);
 
@@ -139,6 +347,7 @@ void S9xLandSamples(void)
 
 void S9xClearSamples(void)
 {
+    spc_thread::Sync();
     spc::resampler->clear();
     if (Settings.MSU1)
         msu::resampler->clear();
@@ -170,6 +379,8 @@ void S9xUpdateDynamicRate(int avail, int buffer_size)
 
 static void UpdatePlaybackRate(void)
 {
+    spc_thread::Sync();
+
     if (Settings.SoundInputRate == 0)
         Settings.SoundInputRate = APU_DEFAULT_INPUT_RATE;
 
@@ -195,6 +406,8 @@ bool8 S9xInitSound(int buffer_ms)
     int buffer_size_samples = MINIMUM_BUFFER_SIZE;
     int requested_buffer_size_samples = Settings.SoundPlaybackRate * buffer_ms * 2 / 1000;
 
+    spc_thread::Sync();
+
     if (requested_buffer_size_samples > buffer_size_samples)
         buffer_size_samples = requested_buffer_size_samples;
 
@@ -229,6 +442,7 @@ bool8 S9xInitSound(int buffer_ms)
 
 void S9xSetSoundControl(uint8 voice_switch)
 {
+    spc_thread::Sync();
     SNES::dsp.spc_dsp.set_stereo_switch(voice_switch << 8 | voice_switch);
 }
 
@@ -241,6 +455,7 @@ void S9xSetSoundMute(bool8 mute)
 
 void S9xDumpSPCSnapshot(void)
 {
+    spc_thread::Sync();
     SNES::dsp.spc_dsp.dump_spc_snapshot();
 }
 
@@ -260,6 +475,8 @@ bool8 S9xInitAPU(void)
 
 void S9xDeinitAPU(void)
 {
+    spc_thread::Stop();
+
     if (spc::resampler)
     {
         delete spc::resampler;
@@ -287,14 +504,39 @@ static inline int S9xAPUGetClockRemainder(int32 cpucycles)
            spc::ratio_denominator;
 }
 
+// Returns the SMP clocks elapsed since the last call, and moves the reference
+// time up to now.
+static inline int32 S9xAPUAdvance(void)
+{
+    int32 clocks = S9xAPUGetClock(CPU.Cycles);
+
+    spc::remainder = S9xAPUGetClockRemainder(CPU.Cycles);
+    S9xAPUSetReferenceTime(CPU.Cycles);
+
+    return clocks;
+}
+
 uint8 S9xAPUReadPort(int port)
 {
     S9xAPUExecute();
+
+    if (spc_thread::active)
+    {
+        spc_thread::port_reads++;
+        spc_thread::Sync();
+    }
+
     return ((uint8)SNES::smp.port_read(port & 3));
 }
 
 void S9xAPUWritePort(int port, uint8 byte)
 {
+    if (spc_thread::active)
+    {
+        spc_thread::Post(S9xAPUAdvance(), port & 3, byte, FALSE);
+        return;
+    }
+
     S9xAPUExecute();
     SNES::cpu.port_write(port & 3, byte);
 }
@@ -306,18 +548,39 @@ void S9xAPUSetReferenceTime(int32 cpucycles)
 
 void S9xAPUExecute(void)
 {
-    SNES::smp.clock -= S9xAPUGetClock(CPU.Cycles);
-    SNES::smp.enter();
-
-    spc::remainder = S9xAPUGetClockRemainder(CPU.Cycles);
+    if (spc_thread::active)
+    {
+        spc_thread::Post(S9xAPUAdvance(), -1, 0, FALSE);
+        return;
+    }
 
-    S9xAPUSetReferenceTime(CPU.Cycles);
+    SNES::smp.clock -= S9xAPUAdvance();
+    SNES::smp.enter();
 }
 
 void S9xAPUEndScanline(void)
 {
-    S9xAPUExecute();
-    SNES::dsp.synchronize();
+    const bool8 end_of_frame = CPU.V_Counter + 1 >= Timings.V_Max;
+
+    if (spc_thread::active)
+    {
+        spc_thread::Post(S9xAPUAdvance(), -1, 0, TRUE);
+
+        // Samples are landed once per frame rather than every APU_SAMPLE_BLOCK,
+        // to keep the APU thread from waiting on us. The buffer holds a frame;
+        // the samples themselves are the same, only the callback comes less
+        // often with more at a time (see tests/apu).
+        if (!end_of_frame)
+            return;
+    }
+    else
+    {
+        S9xAPUExecute();
+        SNES::dsp.synchronize();
+    }
+
+    if (end_of_frame)
+        spc_thread::EndFrame();
 
     if (spc::resampler->space_filled() >= APU_SAMPLE_BLOCK || !spc::sound_in_sync)
         S9xLandSamples();
@@ -325,6 +588,8 @@ void S9xAPUEndScanline(void)
 
 void S9xAPUTimingSetSpeedup(int ticks)
 {
+    spc_thread::Sync();
+
     if (ticks != 0)
         printf("APU speedup hack: %d\n", ticks);
 
@@ -339,6 +604,8 @@ void S9xAPUTimingSetSpeedup(int ticks)
 
 void S9xResetAPU(void)
 {
+    spc_thread::Suspend();
+
     spc::reference_time = 0;
     spc::remainder = 0;
 
@@ -352,6 +619,8 @@ void S9xResetAPU(void)
 
 void S9xSoftResetAPU(void)
 {
+    spc_thread::Suspend();
+
     spc::reference_time = 0;
     spc::remainder = 0;
     SNES::cpu.reset();
@@ -365,6 +634,8 @@ void S9xAPUSaveState(uint8 *block)
 {
     uint8 *ptr = block;
 
+    spc_thread::Sync();
+
     SNES::smp.save_state(&ptr);
     SNES::dsp.save_state(&ptr);
 
@@ -384,6 +655,8 @@ void S9xAPULoadState(uint8 *block)
 {
     uint8 *ptr = block;
 
+    spc_thread::Suspend();
+
     SNES::smp.load_state(&ptr);
     SNES::dsp.load_state(&ptr);
 
@@ -408,6 +681,8 @@ void S9xAPULoadBlarggState(uint8 *oldblock)
 {
     uint8 *ptr = oldblock;
 
+    spc_thread::Suspend();
+
     SNES::SPC_State_Copier copier(&ptr, to_var_from_buf);
 
     copier.copy(SNES::smp.apuram, 0x10000); // RAM
@@ -513,6 +788,8 @@ bool8 S9xSPCDump(const char *filename)
     uint8 buf[SPC_FILE_SIZE];
     size_t ignore;
 
+    spc_thread::Sync();
+
     fs = fopen(filename, "wb");
     if (!fs)
         return (FALSE);
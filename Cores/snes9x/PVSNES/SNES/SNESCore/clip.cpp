@@ -7,6 +7,11 @@
 #include "snes9x.h"
 #include "memmap.h"
 
+// Computed for the lines being drawn, from the registers they were flushed with.
+#define PPU		(*RenderState.PPU)
+#define IPPU	(*RenderState.IPPU)
+#define Memory	RenderState
+
 static uint8	region_map[6][6] =
 {
 	{ 0, 0x01, 0x03, 0x07, 0x0f, 0x1f },
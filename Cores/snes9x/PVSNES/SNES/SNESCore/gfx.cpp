@@ -4,6 +4,10 @@
    For further information, consult the LICENSE file in the root directory.
 \*****************************************************************************/
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include "snes9x.h"
 #include "ppu.h"
 #include "tile.h"
@@ -25,6 +29,7 @@ static int	font_width = 8, font_height = 9;
 void (*S9xCustomDisplayString) (const char *, int, int, bool, int) = NULL;
 
 static void SetupOBJ (void);
+static uint32 UpdateLines (void);
 static void DrawOBJS (int);
 static void DisplayFrameRate (void);
 static void DisplayPressedKeys (void);
@@ -37,14 +42,485 @@ static void DrawBackgroundOffsetMosaic (int, uint8, uint8, int);
 static inline void DrawBackgroundMode7 (int, void (*DrawMath) (uint32, uint32, int), void (*DrawNomath) (uint32, uint32, int), int);
 static inline void DrawBackdrop (void);
 static inline void RenderScreen (bool8);
+static void RenderBatch (void);
 static uint16 get_crosshair_color (uint8);
 static void S9xDisplayStringType (const char *, int, int, bool, int);
 
 #define TILE_PLUS(t, x)	(((t) & 0xfc00) | ((t + x) & 0x3ff))
 
+// With Settings.ThreadedRendering, the drawing itself happens on a thread of
+// its own. S9xUpdateScreen() still runs on the CPU thread at every point it
+// always has and still sets up the sprites and RTO flags there, but rather than
+// drawing the lines it copies the PPU state they need into a batch and posts
+// it. The render thread works through the batches in order, pointing
+// RenderState at each one before drawing it, so it sees exactly what the inline
+// renderer would have. Drawing inline, RenderState points at the live state and
+// nothing is copied. VRAM is copied too, but only when it has been written
+// since the last copy, with the 2-bit tile cache flags standing in for a dirty
+// map; the render thread keeps its own tile cache and drops the tiles that
+// changed. Anything that touches the screen or the colour tables the renderer
+// reads waits for the batches to drain first (S9xSyncRenderThread()).
+//
+// It is one thread, not a pool: the renderer keeps its scratch state in GFX and
+// BG and decodes into a single tile cache, so batches can't be drawn side by
+// side, but all of the drawing comes off the CPU thread.
+namespace render_thread {
+struct Batch
+{
+	uint32	StartY;
+	uint32	EndY;
+	int		VRAM;		// Copy to draw from
+	bool8	NewVRAM;	// First batch to draw from it
+	struct SPPU	PPU;
+	bool8	Interlace;
+	bool8	InterlaceOBJ;
+	bool8	PseudoHires;
+	bool8	DoubleWidthPixels;
+	bool8	DoubleHeightPixels;
+	uint8	*XB;
+	uint16	ScreenColors[256];
+	uint8	MaxBrightness;
+	int		RenderedScreenWidth;
+	int		RenderedScreenHeight;
+	uint8	FillRAM[0x40];	// 0x2100-0x213f
+	uint8	OBJWidths[128];
+	uint8	OBJVisibleTiles[128];
+	struct SOBJLine	OBJLines[SNES_HEIGHT_EXTENDED];	// Only StartY-EndY are copied
+	struct SLineData	LineData[240];				// Likewise
+	struct SLineMatrixData	LineMatrixData[240];	// Likewise
+};
+
+static const uint32 QUEUE_SIZE = 32; // Power of 2
+static const int SPIN_COUNT = 64;
+static const int VRAM_COPIES = 3;
+static const int BATCH_LINES = 16;
+static const uint32 TILE_COUNT[7] =
+{
+	MAX_2BIT_TILES, MAX_4BIT_TILES, MAX_8BIT_TILES,
+	MAX_2BIT_TILES, MAX_2BIT_TILES, MAX_4BIT_TILES, MAX_4BIT_TILES
+};
+
+static Batch *queue = NULL;
+static uint8 *vram[VRAM_COPIES];
+static uint8 *vram_dirty[VRAM_COPIES];	// 2-bit tile flags when copied, FALSE = written
+static uint8 *vram_stale[VRAM_COPIES];	// Blocks written since each copy was taken
+static uint32 vram_seq[VRAM_COPIES];	// Last batch to draw from each copy
+static uint8 *tile_cache[7];
+static uint8 *tile_cached[7];
+static struct InternalPPU ippu;		// The render thread's IPPU, with its own tile cache
+static uint8 fill_ram[0x2140];		// Only 0x2100-0x213f are used
+static std::atomic<uint32> head(0); // Written by the CPU thread
+static std::atomic<uint32> tail(0); // Written by the render thread
+static std::atomic<bool> render_waiting(false);
+static std::atomic<bool> cpu_waiting(false);
+static std::atomic<bool> quit(false);
+static std::mutex mutex;
+static std::condition_variable work_cond;
+static std::condition_variable idle_cond;
+static std::thread thread;
+
+// Only touched by the CPU thread
+static bool8 running = FALSE;
+static bool8 active = FALSE;
+static int vram_current = -1;
+static uint32 end_y = 0;	// Last line of the previous S9xUpdateScreen(), for the RTO flags
+
+static void Direct (void);
+static void DropTiles (uint8 **, const uint8 *);
+static void Apply (Batch &);
+
+static void Loop (void)
+{
+	for (;;)
+	{
+		uint32 t = tail.load(std::memory_order_relaxed);
+
+		for (int i = 0; i < SPIN_COUNT && t == head.load(std::memory_order_acquire); i++)
+			std::this_thread::yield();
+
+		if (t == head.load(std::memory_order_acquire))
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			render_waiting = true;
+			work_cond.wait(lock, [t] { return quit || t != head; });
+			render_waiting = false;
+
+			if (quit)
+				break;
+		}
+
+		Apply(queue[t & (QUEUE_SIZE - 1)]);
+		RenderBatch();
+
+		tail = t + 1;
+
+		if (cpu_waiting)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			idle_cond.notify_one();
+		}
+	}
+}
+
+// Waits until the render thread has drawn every posted batch, after which the
+// CPU thread may touch the screen and the renderer's tables directly.
+static void Sync (void)
+{
+	if (!running)
+		return;
+
+	const uint32 h = head.load(std::memory_order_relaxed);
+
+	for (int i = 0; i < SPIN_COUNT && tail.load(std::memory_order_acquire) != h; i++)
+		std::this_thread::yield();
+
+	if (tail.load(std::memory_order_acquire) != h)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		cpu_waiting = true;
+		idle_cond.wait(lock, [h] { return tail == h; });
+		cpu_waiting = false;
+	}
+}
+
+static void Free (void)
+{
+	free(queue);
+	queue = NULL;
+
+	for (int i = 0; i < VRAM_COPIES; i++)
+	{
+		free(vram[i]);
+		free(vram_dirty[i]);
+		free(vram_stale[i]);
+		vram[i] = vram_dirty[i] = vram_stale[i] = NULL;
+	}
+
+	for (int t = 0; t < 7; t++)
+	{
+		free(tile_cache[t]);
+		free(tile_cached[t]);
+		tile_cache[t] = tile_cached[t] = NULL;
+	}
+}
+
+static bool8 Start (void)
+{
+	bool8	ok = (queue = (Batch *) malloc(QUEUE_SIZE * sizeof(Batch))) != NULL;
+
+	for (int i = 0; i < VRAM_COPIES; i++)
+	{
+		ok &= (vram[i] = (uint8 *) malloc(0x10000)) != NULL;
+		ok &= (vram_dirty[i] = (uint8 *) malloc(MAX_2BIT_TILES)) != NULL;
+		ok &= (vram_stale[i] = (uint8 *) malloc(MAX_2BIT_TILES)) != NULL;
+	}
+
+	for (int t = 0; t < 7; t++)
+	{
+		ok &= (tile_cache[t] = (uint8 *) malloc(TILE_COUNT[t] * 64)) != NULL;
+		ok &= (tile_cached[t] = (uint8 *) malloc(TILE_COUNT[t])) != NULL;
+	}
+
+	if (!ok)
+	{
+		Free();
+		return (FALSE);
+	}
+
+	thread = std::thread(Loop);
+	running = TRUE;
+
+	return (TRUE);
+}
+
+static void Stop (void)
+{
+	if (!running)
+		return;
+
+	Sync();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+		work_cond.notify_one();
+	}
+	thread.join();
+
+	quit = false;
+	running = FALSE;
+	active = FALSE;
+	Free();
+}
+
+// Switches between drawing inline and on the render thread. Only called at the
+// start of a frame, when nothing is queued.
+static void StartFrame (void)
+{
+	if (Settings.ThreadedRendering)
+	{
+		if (active || (!running && !Start()))
+			return;
+
+		// Carry on from the live tile cache. Starting afresh wouldn't do: the
+		// hires converters' partner tile depends on the tile number a slot was
+		// first decoded for, so what's drawn would depend on when we switched.
+		for (int t = 0; t < 7; t++)
+		{
+			memcpy(tile_cache[t], IPPU.TileCache[t], TILE_COUNT[t] * 64);
+			memcpy(tile_cached[t], IPPU.TileCached[t], TILE_COUNT[t]);
+		}
+
+		// From here on the live 2-bit flags only mark what's been written
+		memset(IPPU.TileCached[TILE_2BIT], TRUE, MAX_2BIT_TILES);
+
+		for (int i = 0; i < VRAM_COPIES; i++)
+		{
+			vram_seq[i] = tail - 1;
+			memset(vram_stale[i], TRUE, MAX_2BIT_TILES);
+		}
+
+		vram_current = -1;
+
+		// And from its clip windows
+		ippu = IPPU;
+		memcpy(ippu.TileCache, tile_cache, sizeof(tile_cache));
+		memcpy(ippu.TileCached, tile_cached, sizeof(tile_cached));
+
+		active = TRUE;
+	}
+	else
+	{
+		if (active)
+		{
+			Sync();
+
+			// Hand the tile cache and clip windows back, less the tiles written
+			// since the last VRAM copy (whose own flags are spent, so they make
+			// room for those). Until a batch is posted, the live cache is still
+			// the one we started from.
+			if (vram_current >= 0)
+			{
+				memcpy(vram_dirty[vram_current], IPPU.TileCached[TILE_2BIT], MAX_2BIT_TILES);
+
+				for (int t = 0; t < 7; t++)
+				{
+					memcpy(IPPU.TileCache[t], tile_cache[t], TILE_COUNT[t] * 64);
+					memcpy(IPPU.TileCached[t], tile_cached[t], TILE_COUNT[t]);
+				}
+
+				DropTiles(IPPU.TileCached, vram_dirty[vram_current]);
+				memcpy(IPPU.Clip, ippu.Clip, sizeof(IPPU.Clip));
+			}
+
+			active = FALSE;
+		}
+
+		Direct();
+	}
+}
+
+static void Capture (Batch &b, uint32 StartY, uint32 EndY)
+{
+	b.StartY = StartY;
+	b.EndY = EndY;
+	b.PPU = PPU;
+
+	// The batch takes over a pending clip window recomputation (none is done
+	// during forced blanking, so it stays pending until that ends)
+	if (!PPU.ForcedBlanking)
+		PPU.RecomputeClipWindows = FALSE;
+
+	b.Interlace = IPPU.Interlace;
+	b.InterlaceOBJ = IPPU.InterlaceOBJ;
+	b.PseudoHires = IPPU.PseudoHires;
+	b.DoubleWidthPixels = IPPU.DoubleWidthPixels;
+	b.DoubleHeightPixels = IPPU.DoubleHeightPixels;
+	b.XB = IPPU.XB;
+	memcpy(b.ScreenColors, IPPU.ScreenColors, sizeof(b.ScreenColors));
+	b.MaxBrightness = IPPU.MaxBrightness;
+	b.RenderedScreenWidth = IPPU.RenderedScreenWidth;
+	b.RenderedScreenHeight = IPPU.RenderedScreenHeight;
+	memcpy(b.FillRAM, Memory.FillRAM + 0x2100, sizeof(b.FillRAM));
+	memcpy(b.OBJWidths, GFX.OBJWidths, sizeof(b.OBJWidths));
+	memcpy(b.OBJVisibleTiles, GFX.OBJVisibleTiles, sizeof(b.OBJVisibleTiles));
+
+	if (EndY >= StartY)
+	{
+		memcpy(&b.OBJLines[StartY], &GFX.OBJLines[StartY], (EndY - StartY + 1) * sizeof(struct SOBJLine));
+		memcpy(&b.LineData[StartY], &LineData[StartY], (EndY - StartY + 1) * sizeof(struct SLineData));
+		memcpy(&b.LineMatrixData[StartY], &LineMatrixData[StartY], (EndY - StartY + 1) * sizeof(struct SLineMatrixData));
+	}
+}
+
+// Whether any of the eight flags from p on is FALSE.
+static inline bool8 AnyWritten (const uint8 *p)
+{
+	uint64	v;
+	memcpy(&v, p, 8);
+	return (((v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL) != 0);
+}
+
+// Returns the VRAM copy the next batch should draw from, bringing another one
+// up to date if anything has been written since the last. Only the 16-byte
+// blocks written since that copy was last updated are copied into it.
+static int CopyVRAM (bool8 &fresh)
+{
+	fresh = FALSE;
+
+	if (vram_current >= 0 && !memchr(IPPU.TileCached[TILE_2BIT], FALSE, MAX_2BIT_TILES))
+		return (vram_current);
+
+	int	c = -1;
+
+	for (int i = 0; i < VRAM_COPIES && c < 0; i++)
+		if (i != vram_current && (int32) (tail.load(std::memory_order_acquire) - vram_seq[i]) > 0)
+			c = i;
+
+	if (c < 0)
+	{
+		Sync();
+		c = (vram_current + 1) % VRAM_COPIES;
+	}
+
+	const uint8	*written = IPPU.TileCached[TILE_2BIT];
+
+	for (uint32 b = 0; b < MAX_2BIT_TILES; b += 8)
+	{
+		uint64	stale;
+
+		if (AnyWritten(written + b))
+		{
+			for (uint32 i = b; i < b + 8; i++)
+			{
+				if (!written[i])
+				{
+					for (int j = 0; j < VRAM_COPIES; j++)
+						vram_stale[j][i] = TRUE;
+				}
+			}
+		}
+
+		memcpy(&stale, vram_stale[c] + b, 8);
+		if (stale)
+		{
+			for (uint32 i = b; i < b + 8; i++)
+				if (vram_stale[c][i])
+					memcpy(vram[c] + (i << 4), Memory.VRAM + (i << 4), 16);
+
+			memset(vram_stale[c] + b, FALSE, 8);
+		}
+	}
+
+	memcpy(vram_dirty[c], written, MAX_2BIT_TILES);
+	memset(IPPU.TileCached[TILE_2BIT], TRUE, MAX_2BIT_TILES);
+
+	fresh = TRUE;
+	return (vram_current = c);
+}
+
+static void Post (uint32 StartY, uint32 EndY)
+{
+	const uint32 h = head.load(std::memory_order_relaxed);
+
+	if (h - tail.load(std::memory_order_acquire) == QUEUE_SIZE)
+		Sync();
+
+	Batch &b = queue[h & (QUEUE_SIZE - 1)];
+	Capture(b, StartY, EndY);
+	b.VRAM = CopyVRAM(b.NewVRAM);
+	vram_seq[b.VRAM] = h;
+
+	head = h + 1;
+
+	if (render_waiting)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		work_cond.notify_one();
+	}
+}
+
+// Drops the decoded tiles of every block flagged FALSE (written) in dirty, the
+// same entries a write to it would have cleared (see REGISTER_2118()).
+static void DropTiles (uint8 **cached, const uint8 *dirty)
+{
+	for (uint32 b = 0; b < MAX_2BIT_TILES; b++)
+	{
+		if (!(b & 7) && !AnyWritten(dirty + b))
+		{
+			b += 7;
+			continue;
+		}
+
+		if (dirty[b])
+			continue;
+
+		cached[TILE_2BIT][b] = FALSE;
+		cached[TILE_4BIT][b >> 1] = FALSE;
+		cached[TILE_8BIT][b >> 2] = FALSE;
+		cached[TILE_2BIT_EVEN][b] = FALSE;
+		cached[TILE_2BIT_EVEN][(b - 1) & (MAX_2BIT_TILES - 1)] = FALSE;
+		cached[TILE_2BIT_ODD] [b] = FALSE;
+		cached[TILE_2BIT_ODD] [(b - 1) & (MAX_2BIT_TILES - 1)] = FALSE;
+		cached[TILE_4BIT_EVEN][b >> 1] = FALSE;
+		cached[TILE_4BIT_EVEN][((b >> 1) - 1) & (MAX_4BIT_TILES - 1)] = FALSE;
+		cached[TILE_4BIT_ODD] [b >> 1] = FALSE;
+		cached[TILE_4BIT_ODD] [((b >> 1) - 1) & (MAX_4BIT_TILES - 1)] = FALSE;
+	}
+}
+
+// Points RenderState at the live state, for drawing inline.
+static void Direct (void)
+{
+	RenderState.PPU = &PPU;
+	RenderState.IPPU = &IPPU;
+	RenderState.VRAM = Memory.VRAM;
+	RenderState.FillRAM = Memory.FillRAM;
+	RenderState.OBJWidths = GFX.OBJWidths;
+	RenderState.OBJVisibleTiles = GFX.OBJVisibleTiles;
+	RenderState.OBJLines = GFX.OBJLines;
+	RenderState.LineData = LineData;
+	RenderState.LineMatrixData = LineMatrixData;
+}
+
+// Points RenderState at a batch, on the render thread.
+static void Apply (Batch &b)
+{
+	ippu.Interlace = b.Interlace;
+	ippu.InterlaceOBJ = b.InterlaceOBJ;
+	ippu.PseudoHires = b.PseudoHires;
+	ippu.DoubleWidthPixels = b.DoubleWidthPixels;
+	ippu.DoubleHeightPixels = b.DoubleHeightPixels;
+	ippu.XB = b.XB;
+	memcpy(ippu.ScreenColors, b.ScreenColors, sizeof(b.ScreenColors));
+	ippu.MaxBrightness = b.MaxBrightness;
+	ippu.RenderedScreenWidth = b.RenderedScreenWidth;
+	ippu.RenderedScreenHeight = b.RenderedScreenHeight;
+	memcpy(fill_ram + 0x2100, b.FillRAM, sizeof(b.FillRAM));
+
+	RenderState.PPU = &b.PPU;
+	RenderState.IPPU = &ippu;
+	RenderState.VRAM = vram[b.VRAM];
+	RenderState.FillRAM = fill_ram;
+	RenderState.OBJWidths = b.OBJWidths;
+	RenderState.OBJVisibleTiles = b.OBJVisibleTiles;
+	RenderState.OBJLines = b.OBJLines;
+	RenderState.LineData = b.LineData;
+	RenderState.LineMatrixData = b.LineMatrixData;
+
+	if (b.NewVRAM)
+		DropTiles(ippu.TileCached, vram_dirty[b.VRAM]);
+
+	GFX.StartY = b.StartY;
+	GFX.EndY = b.EndY;
+}
+} // namespace render_thread
+
 
 bool8 S9xGraphicsInit (void)
 {
+	render_thread::Direct();
 	S9xInitTileRenderer();
 	memset(BlackColourMap, 0, 256 * sizeof(uint16));
 
@@ -104,6 +580,8 @@ bool8 S9xGraphicsInit (void)
 
 void S9xGraphicsDeinit (void)
 {
+	render_thread::Stop();
+
 	if (GFX.ZERO)       { free(GFX.ZERO);       GFX.ZERO       = NULL; }
 	if (GFX.SubScreen)  { free(GFX.SubScreen);  GFX.SubScreen  = NULL; }
 	if (GFX.ZBuffer)    { free(GFX.ZBuffer);    GFX.ZBuffer    = NULL; }
@@ -112,6 +590,8 @@ void S9xGraphicsDeinit (void)
 
 void S9xGraphicsScreenResize (void)
 {
+	S9xSyncRenderThread();
+
 	IPPU.MaxBrightness = PPU.Brightness;
 
 	IPPU.Interlace    = Memory.FillRAM[0x2133] & 1;
@@ -154,6 +634,8 @@ void S9xGraphicsScreenResize (void)
 
 void S9xBuildDirectColourMaps (void)
 {
+	S9xSyncRenderThread();
+
 	IPPU.XB = mul_brightness[PPU.Brightness];
 
 	for (uint32 p = 0; p < 8; p++)
@@ -167,6 +649,8 @@ void S9xStartScreenRefresh (void)
 	if (GFX.DoInterlace)
 		GFX.DoInterlace--;
 
+	render_thread::StartFrame();
+
 	if (IPPU.RenderThisFrame)
 	{
 		if (!GFX.DoInterlace || !GFX.InterlaceFrame)
@@ -208,6 +692,7 @@ void S9xEndScreenRefresh (void)
 	if (IPPU.RenderThisFrame)
 	{
 		FLUSH_REDRAW();
+		S9xSyncRenderThread();
 
 		if (GFX.DoInterlace && GFX.InterlaceFrame == 0)
 		{
@@ -292,257 +777,41 @@ void RenderLine (uint8 C)
 			p->MatrixC = PPU.MatrixC;
 			p->MatrixD = PPU.MatrixD;
 			p->CentreX = PPU.CentreX;
-			p->CentreY = PPU.CentreY;
-			p->M7HOFS  = PPU.M7HOFS;
-			p->M7VOFS  = PPU.M7VOFS;
-		}
-		else
-		{
-			LineData[C].BG[2].VOffset = PPU.BG[2].VOffset + 1;
-			LineData[C].BG[2].HOffset = PPU.BG[2].HOffset;
-			LineData[C].BG[3].VOffset = PPU.BG[3].VOffset + 1;
-			LineData[C].BG[3].HOffset = PPU.BG[3].HOffset;
-		}
-
-		IPPU.CurrentLine = C + 1;
-	}
-	else
-	{
-		// if we're not rendering this frame, we still need to update this
-		// XXX: Check ForceBlank? Or anything else?
-		if (IPPU.OBJChanged)
-			SetupOBJ();
-		PPU.RangeTimeOver |= GFX.OBJLines[C].RTOFlags;
-	}
-}
-
-static inline void RenderScreen (bool8 sub)
-{
-	uint8	BGActive;
-	int		D;
-
-	if (!sub)
-	{
-		GFX.S = GFX.Screen;
-		if (GFX.DoInterlace && GFX.InterlaceFrame)
-			GFX.S += GFX.RealPPL;
-		GFX.DB = GFX.ZBuffer;
-		GFX.Clip = IPPU.Clip[0];
-		BGActive = Memory.FillRAM[0x212c] & ~Settings.BG_Forced;
-		D = 32;
-	}
-	else
-	{
-		GFX.S = GFX.SubScreen;
-		GFX.DB = GFX.SubZBuffer;
-		GFX.Clip = IPPU.Clip[1];
-		BGActive = Memory.FillRAM[0x212d] & ~Settings.BG_Forced;
-		D = (Memory.FillRAM[0x2130] & 2) << 4; // 'do math' depth flag
-	}
-
-	if (BGActive & 0x10)
-	{
-		BG.TileAddress = PPU.OBJNameBase;
-		BG.NameSelect = PPU.OBJNameSelect;
-		BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 0x10);
-		BG.StartPalette = 128;
-		S9xSelectTileConverter(4, FALSE, sub, FALSE);
-		S9xSelectTileRenderers(PPU.BGMode, sub, TRUE);
-		DrawOBJS(D + 4);
-	}
-
-	BG.NameSelect = 0;
-	S9xSelectTileRenderers(PPU.BGMode, sub, FALSE);
-
-	#define DO_BG(n, pal, depth, hires, offset, Zh, Zl, voffoff) \
-		if (BGActive & (1 << n)) \
-		{ \
-			BG.StartPalette = pal; \
-			BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & (1 << n)); \
-			BG.TileSizeH = (!hires && PPU.BG[n].BGSize) ? 16 : 8; \
-			BG.TileSizeV = (PPU.BG[n].BGSize) ? 16 : 8; \
-			S9xSelectTileConverter(depth, hires, sub, PPU.BGMosaic[n]); \
-			\
-			if (offset) \
-			{ \
-				BG.OffsetSizeH = (!hires && PPU.BG[2].BGSize) ? 16 : 8; \
-				BG.OffsetSizeV = (PPU.BG[2].BGSize) ? 16 : 8; \
-				\
-				if (PPU.BGMosaic[n] && (hires || PPU.Mosaic > 1)) \
-					DrawBackgroundOffsetMosaic(n, D + Zh, D + Zl, voffoff); \
-				else \
-					DrawBackgroundOffset(n, D + Zh, D + Zl, voffoff); \
-			} \
-			else \
-			{ \
-				if (PPU.BGMosaic[n] && (hires || PPU.Mosaic > 1)) \
-					DrawBackgroundMosaic(n, D + Zh, D + Zl); \
-				else \
-					DrawBackground(n, D + Zh, D + Zl); \
-			} \
-		}
-
-	switch (PPU.BGMode)
-	{
-		case 0:
-			DO_BG(0,  0, 2, FALSE, FALSE, 15, 11, 0);
-			DO_BG(1, 32, 2, FALSE, FALSE, 14, 10, 0);
-			DO_BG(2, 64, 2, FALSE, FALSE,  7,  3, 0);
-			DO_BG(3, 96, 2, FALSE, FALSE,  6,  2, 0);
-			break;
-
-		case 1:
-			DO_BG(0,  0, 4, FALSE, FALSE, 15, 11, 0);
-			DO_BG(1,  0, 4, FALSE, FALSE, 14, 10, 0);
-			DO_BG(2,  0, 2, FALSE, FALSE, (PPU.BG3Priority ? 17 : 7), 3, 0);
-			break;
-
-		case 2:
-			DO_BG(0,  0, 4, FALSE, TRUE,  15,  7, 8);
-			DO_BG(1,  0, 4, FALSE, TRUE,  11,  3, 8);
-			break;
-
-		case 3:
-			DO_BG(0,  0, 8, FALSE, FALSE, 15,  7, 0);
-			DO_BG(1,  0, 4, FALSE, FALSE, 11,  3, 0);
-			break;
-
-		case 4:
-			DO_BG(0,  0, 8, FALSE, TRUE,  15,  7, 0);
-			DO_BG(1,  0, 2, FALSE, TRUE,  11,  3, 0);
-			break;
-
-		case 5:
-			DO_BG(0,  0, 4, TRUE,  FALSE, 15,  7, 0);
-			DO_BG(1,  0, 2, TRUE,  FALSE, 11,  3, 0);
-			break;
-
-		case 6:
-			DO_BG(0,  0, 4, TRUE,  TRUE,  15,  7, 8);
-			break;
-
-		case 7:
-			if (BGActive & 0x01)
-			{
-				BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 1);
-				DrawBackgroundMode7(0, GFX.DrawMode7BG1Math, GFX.DrawMode7BG1Nomath, D);
-			}
-
-			if ((Memory.FillRAM[0x2133] & 0x40) && (BGActive & 0x02))
-			{
-				BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 2);
-				DrawBackgroundMode7(1, GFX.DrawMode7BG2Math, GFX.DrawMode7BG2Nomath, D);
-			}
-
-			break;
-	}
-
-	#undef DO_BG
-
-	BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 0x20);
-
-	DrawBackdrop();
-}
-
-void S9xUpdateScreen (void)
-{
-	if (IPPU.OBJChanged || IPPU.InterlaceOBJ)
-		SetupOBJ();
-
-	// XXX: Check ForceBlank? Or anything else?
-	PPU.RangeTimeOver |= GFX.OBJLines[GFX.EndY].RTOFlags;
-
-	GFX.StartY = IPPU.PreviousLine;
-	if ((GFX.EndY = IPPU.CurrentLine - 1) >= PPU.ScreenHeight)
-		GFX.EndY = PPU.ScreenHeight - 1;
-
-	if (!PPU.ForcedBlanking)
-	{
-		// If force blank, may as well completely skip all this. We only did
-		// the OBJ because (AFAWK) the RTO flags are updated even during force-blank.
-
-		if (PPU.RecomputeClipWindows)
-		{
-			S9xComputeClipWindows();
-			PPU.RecomputeClipWindows = FALSE;
-		}
-
-		if (Settings.SupportHiRes)
-		{
-			if (!IPPU.DoubleWidthPixels && (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires))
-			{
-				#ifdef USE_OPENGL
-				if (Settings.OpenGLEnable && GFX.RealPPL == 256)
-				{
-					// Have to back out of the speed up hack where the low res.
-					// SNES image was rendered into a 256x239 sized buffer,
-					// ignoring the true, larger size of the buffer.
-					GFX.RealPPL = GFX.Pitch >> 1;
-
-					for (int32 y = (int32) GFX.StartY - 1; y >= 0; y--)
-					{
-						uint16	*p = GFX.Screen + y * GFX.PPL     + 255;
-						uint16	*q = GFX.Screen + y * GFX.RealPPL + 510;
-
-						for (int x = 255; x >= 0; x--, p--, q -= 2)
-							*q = *(q + 1) = *p;
-					}
-
-					GFX.PPL = GFX.RealPPL; // = GFX.Pitch >> 1 above
-				}
-				else
-				#endif
-				// Have to back out of the regular speed hack
-				for (uint32 y = 0; y < GFX.StartY; y++)
-				{
-					uint16	*p = GFX.Screen + y * GFX.PPL + 255;
-					uint16	*q = GFX.Screen + y * GFX.PPL + 510;
-
-					for (int x = 255; x >= 0; x--, p--, q -= 2)
-						*q = *(q + 1) = *p;
-				}
-
-				IPPU.DoubleWidthPixels = TRUE;
-				IPPU.RenderedScreenWidth = 512;
-			}
-
-			if (!IPPU.DoubleHeightPixels && IPPU.Interlace && (PPU.BGMode == 5 || PPU.BGMode == 6))
-			{
-				IPPU.DoubleHeightPixels = TRUE;
-				IPPU.RenderedScreenHeight = PPU.ScreenHeight << 1;
-				GFX.PPL = GFX.RealPPL << 1;
-				GFX.DoInterlace = 2;
-
-				for (int32 y = (int32) GFX.StartY - 2; y >= 0; y--)
-					memmove(GFX.Screen + (y + 1) * GFX.PPL, GFX.Screen + y * GFX.RealPPL, GFX.PPL * sizeof(uint16));
-			}
+			p->CentreY = PPU.CentreY;
+			p->M7HOFS  = PPU.M7HOFS;
+			p->M7VOFS  = PPU.M7VOFS;
+		}
+		else
+		{
+			LineData[C].BG[2].VOffset = PPU.BG[2].VOffset + 1;
+			LineData[C].BG[2].HOffset = PPU.BG[2].HOffset;
+			LineData[C].BG[3].VOffset = PPU.BG[3].VOffset + 1;
+			LineData[C].BG[3].HOffset = PPU.BG[3].HOffset;
 		}
 
-		if ((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2131] & 0x3f))
-			GFX.FixedColour = BUILD_PIXEL(IPPU.XB[PPU.FixedColourRed], IPPU.XB[PPU.FixedColourGreen], IPPU.XB[PPU.FixedColourBlue]);
+		IPPU.CurrentLine = C + 1;
 
-		if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires ||
-			((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2130] & 2) && (Memory.FillRAM[0x2131] & 0x3f) && (Memory.FillRAM[0x212d] & 0x1f)))
-			// If hires (Mode 5/6 or pseudo-hires) or math is to be done
-			// involving the subscreen, then we need to render the subscreen...
-			RenderScreen(TRUE);
+		// Give the render thread something to be getting on with. A split must
+		// not change what is drawn, so it only falls at the top of a mosaic block
+		// (the mosaic code takes StartY as a block start for all but the first
+		// clip window), and the RTO flags are left for the next real flush.
+		if (render_thread::active && IPPU.CurrentLine - IPPU.PreviousLine >= render_thread::BATCH_LINES &&
+			(PPU.Mosaic <= 1 || ((uint32) IPPU.CurrentLine - PPU.MosaicStart) % PPU.Mosaic == 0))
+		{
+			if (IPPU.OBJChanged || IPPU.InterlaceOBJ)
+				SetupOBJ();
 
-		RenderScreen(FALSE);
+			UpdateLines();
+		}
 	}
 	else
 	{
-		const uint16	black = BUILD_PIXEL(0, 0, 0);
-
-		GFX.S = GFX.Screen + GFX.StartY * GFX.PPL;
-		if (GFX.DoInterlace && GFX.InterlaceFrame)
-			GFX.S += GFX.RealPPL;
-
-		for (uint32 l = GFX.StartY; l <= GFX.EndY; l++, GFX.S += GFX.PPL)
-			for (int x = 0; x < IPPU.RenderedScreenWidth; x++)
-				GFX.S[x] = black;
+		// if we're not rendering this frame, we still need to update this
+		// XXX: Check ForceBlank? Or anything else?
+		if (IPPU.OBJChanged)
+			SetupOBJ();
+		PPU.RangeTimeOver |= GFX.OBJLines[C].RTOFlags;
 	}
-
-	IPPU.PreviousLine = IPPU.CurrentLine;
 }
 
 static void SetupOBJ (void)
@@ -781,6 +1050,276 @@ static void SetupOBJ (void)
 	IPPU.OBJChanged = FALSE;
 }
 
+// Everything S9xUpdateScreen() does bar the RTO flags: works out which lines
+// are due and draws them, or has them drawn. Returns the last line.
+static uint32 UpdateLines (void)
+{
+	uint32	StartY = IPPU.PreviousLine;
+	uint32	EndY = IPPU.CurrentLine - 1;
+	if (EndY >= PPU.ScreenHeight)
+		EndY = PPU.ScreenHeight - 1;
+
+	if (!PPU.ForcedBlanking && Settings.SupportHiRes)
+	{
+		// Lines already drawn get stretched in place, so they must be finished.
+
+		if (!IPPU.DoubleWidthPixels && (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires))
+		{
+			S9xSyncRenderThread();
+
+			#ifdef USE_OPENGL
+			if (Settings.OpenGLEnable && GFX.RealPPL == 256)
+			{
+				// Have to back out of the speed up hack where the low res.
+				// SNES image was rendered into a 256x239 sized buffer,
+				// ignoring the true, larger size of the buffer.
+				GFX.RealPPL = GFX.Pitch >> 1;
+
+				for (int32 y = (int32) StartY - 1; y >= 0; y--)
+				{
+					uint16	*p = GFX.Screen + y * GFX.PPL     + 255;
+					uint16	*q = GFX.Screen + y * GFX.RealPPL + 510;
+
+					for (int x = 255; x >= 0; x--, p--, q -= 2)
+						*q = *(q + 1) = *p;
+				}
+
+				GFX.PPL = GFX.RealPPL; // = GFX.Pitch >> 1 above
+			}
+			else
+			#endif
+			// Have to back out of the regular speed hack
+			for (uint32 y = 0; y < StartY; y++)
+			{
+				uint16	*p = GFX.Screen + y * GFX.PPL + 255;
+				uint16	*q = GFX.Screen + y * GFX.PPL + 510;
+
+				for (int x = 255; x >= 0; x--, p--, q -= 2)
+					*q = *(q + 1) = *p;
+			}
+
+			IPPU.DoubleWidthPixels = TRUE;
+			IPPU.RenderedScreenWidth = 512;
+		}
+
+		if (!IPPU.DoubleHeightPixels && IPPU.Interlace && (PPU.BGMode == 5 || PPU.BGMode == 6))
+		{
+			S9xSyncRenderThread();
+
+			IPPU.DoubleHeightPixels = TRUE;
+			IPPU.RenderedScreenHeight = PPU.ScreenHeight << 1;
+			GFX.PPL = GFX.RealPPL << 1;
+			GFX.DoInterlace = 2;
+
+			for (int32 y = (int32) StartY - 2; y >= 0; y--)
+				memmove(GFX.Screen + (y + 1) * GFX.PPL, GFX.Screen + y * GFX.RealPPL, GFX.PPL * sizeof(uint16));
+		}
+	}
+
+	if (render_thread::active)
+		render_thread::Post(StartY, EndY);
+	else
+	{
+		GFX.StartY = StartY;
+		GFX.EndY = EndY;
+		RenderBatch();
+	}
+
+	IPPU.PreviousLine = IPPU.CurrentLine;
+
+	return (EndY);
+}
+
+void S9xUpdateScreen (void)
+{
+	if (IPPU.OBJChanged || IPPU.InterlaceOBJ)
+		SetupOBJ();
+
+	// XXX: Check ForceBlank? Or anything else?
+	PPU.RangeTimeOver |= GFX.OBJLines[render_thread::end_y].RTOFlags;
+
+	render_thread::end_y = UpdateLines();
+}
+
+void S9xSyncRenderThread (void)
+{
+	render_thread::Sync();
+}
+
+// Everything from here down draws, on the render thread if there is one, and
+// sees the registers as they were when its lines were flushed.
+#define PPU		(*RenderState.PPU)
+#define IPPU	(*RenderState.IPPU)
+#define Memory	RenderState
+#define LineData		RenderState.LineData
+#define LineMatrixData	RenderState.LineMatrixData
+
+static void RenderBatch (void)
+{
+	if (!PPU.ForcedBlanking)
+	{
+		// If force blank, may as well completely skip all this. We only did
+		// the OBJ because (AFAWK) the RTO flags are updated even during force-blank.
+
+		if (PPU.RecomputeClipWindows)
+		{
+			S9xComputeClipWindows();
+			PPU.RecomputeClipWindows = FALSE;
+		}
+
+		if ((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2131] & 0x3f))
+			GFX.FixedColour = BUILD_PIXEL(IPPU.XB[PPU.FixedColourRed], IPPU.XB[PPU.FixedColourGreen], IPPU.XB[PPU.FixedColourBlue]);
+
+		if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires ||
+			((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2130] & 2) && (Memory.FillRAM[0x2131] & 0x3f) && (Memory.FillRAM[0x212d] & 0x1f)))
+			// If hires (Mode 5/6 or pseudo-hires) or math is to be done
+			// involving the subscreen, then we need to render the subscreen...
+			RenderScreen(TRUE);
+
+		RenderScreen(FALSE);
+	}
+	else
+	{
+		const uint16	black = BUILD_PIXEL(0, 0, 0);
+
+		GFX.S = GFX.Screen + GFX.StartY * GFX.PPL;
+		if (GFX.DoInterlace && GFX.InterlaceFrame)
+			GFX.S += GFX.RealPPL;
+
+		for (uint32 l = GFX.StartY; l <= GFX.EndY; l++, GFX.S += GFX.PPL)
+			for (int x = 0; x < IPPU.RenderedScreenWidth; x++)
+				GFX.S[x] = black;
+	}
+}
+
+static inline void RenderScreen (bool8 sub)
+{
+	uint8	BGActive;
+	int		D;
+
+	if (!sub)
+	{
+		GFX.S = GFX.Screen;
+		if (GFX.DoInterlace && GFX.InterlaceFrame)
+			GFX.S += GFX.RealPPL;
+		GFX.DB = GFX.ZBuffer;
+		GFX.Clip = IPPU.Clip[0];
+		BGActive = Memory.FillRAM[0x212c] & ~Settings.BG_Forced;
+		D = 32;
+	}
+	else
+	{
+		GFX.S = GFX.SubScreen;
+		GFX.DB = GFX.SubZBuffer;
+		GFX.Clip = IPPU.Clip[1];
+		BGActive = Memory.FillRAM[0x212d] & ~Settings.BG_Forced;
+		D = (Memory.FillRAM[0x2130] & 2) << 4; // 'do math' depth flag
+	}
+
+	if (BGActive & 0x10)
+	{
+		BG.TileAddress = PPU.OBJNameBase;
+		BG.NameSelect = PPU.OBJNameSelect;
+		BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 0x10);
+		BG.StartPalette = 128;
+		S9xSelectTileConverter(4, FALSE, sub, FALSE);
+		S9xSelectTileRenderers(PPU.BGMode, sub, TRUE);
+		DrawOBJS(D + 4);
+	}
+
+	BG.NameSelect = 0;
+	S9xSelectTileRenderers(PPU.BGMode, sub, FALSE);
+
+	#define DO_BG(n, pal, depth, hires, offset, Zh, Zl, voffoff) \
+		if (BGActive & (1 << n)) \
+		{ \
+			BG.StartPalette = pal; \
+			BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & (1 << n)); \
+			BG.TileSizeH = (!hires && PPU.BG[n].BGSize) ? 16 : 8; \
+			BG.TileSizeV = (PPU.BG[n].BGSize) ? 16 : 8; \
+			S9xSelectTileConverter(depth, hires, sub, PPU.BGMosaic[n]); \
+			\
+			if (offset) \
+			{ \
+				BG.OffsetSizeH = (!hires && PPU.BG[2].BGSize) ? 16 : 8; \
+				BG.OffsetSizeV = (PPU.BG[2].BGSize) ? 16 : 8; \
+				\
+				if (PPU.BGMosaic[n] && (hires || PPU.Mosaic > 1)) \
+					DrawBackgroundOffsetMosaic(n, D + Zh, D + Zl, voffoff); \
+				else \
+					DrawBackgroundOffset(n, D + Zh, D + Zl, voffoff); \
+			} \
+			else \
+			{ \
+				if (PPU.BGMosaic[n] && (hires || PPU.Mosaic > 1)) \
+					DrawBackgroundMosaic(n, D + Zh, D + Zl); \
+				else \
+					DrawBackground(n, D + Zh, D + Zl); \
+			} \
+		}
+
+	switch (PPU.BGMode)
+	{
+		case 0:
+			DO_BG(0,  0, 2, FALSE, FALSE, 15, 11, 0);
+			DO_BG(1, 32, 2, FALSE, FALSE, 14, 10, 0);
+			DO_BG(2, 64, 2, FALSE, FALSE,  7,  3, 0);
+			DO_BG(3, 96, 2, FALSE, FALSE,  6,  2, 0);
+			break;
+
+		case 1:
+			DO_BG(0,  0, 4, FALSE, FALSE, 15, 11, 0);
+			DO_BG(1,  0, 4, FALSE, FALSE, 14, 10, 0);
+			DO_BG(2,  0, 2, FALSE, FALSE, (PPU.BG3Priority ? 17 : 7), 3, 0);
+			break;
+
+		case 2:
+			DO_BG(0,  0, 4, FALSE, TRUE,  15,  7, 8);
+			DO_BG(1,  0, 4, FALSE, TRUE,  11,  3, 8);
+			break;
+
+		case 3:
+			DO_BG(0,  0, 8, FALSE, FALSE, 15,  7, 0);
+			DO_BG(1,  0, 4, FALSE, FALSE, 11,  3, 0);
+			break;
+
+		case 4:
+			DO_BG(0,  0, 8, FALSE, TRUE,  15,  7, 0);
+			DO_BG(1,  0, 2, FALSE, TRUE,  11,  3, 0);
+			break;
+
+		case 5:
+			DO_BG(0,  0, 4, TRUE,  FALSE, 15,  7, 0);
+			DO_BG(1,  0, 2, TRUE,  FALSE, 11,  3, 0);
+			break;
+
+		case 6:
+			DO_BG(0,  0, 4, TRUE,  TRUE,  15,  7, 8);
+			break;
+
+		case 7:
+			if (BGActive & 0x01)
+			{
+				BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 1);
+				DrawBackgroundMode7(0, GFX.DrawMode7BG1Math, GFX.DrawMode7BG1Nomath, D);
+			}
+
+			if ((Memory.FillRAM[0x2133] & 0x40) && (BGActive & 0x02))
+			{
+				BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 2);
+				DrawBackgroundMode7(1, GFX.DrawMode7BG2Math, GFX.DrawMode7BG2Nomath, D);
+			}
+
+			break;
+	}
+
+	#undef DO_BG
+
+	BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 0x20);
+
+	DrawBackdrop();
+}
+
 #if defined(__GNUC__) && !defined(__clang__)
 #pragma GCC push_options
 #pragma GCC optimize ("no-tree-vrp")
@@ -797,22 +1336,22 @@ static void DrawOBJS (int D)
 	for (uint32 Y = GFX.StartY, Offset = Y * GFX.PPL; Y <= GFX.EndY; Y++, Offset += GFX.PPL)
 	{
 		int	I = 0;
-		int	tiles = GFX.OBJLines[Y].Tiles;
+		int	tiles = RenderState.OBJLines[Y].Tiles;
 
-		for (int S = GFX.OBJLines[Y].OBJ[I].Sprite; S >= 0 && I < 32; S = GFX.OBJLines[Y].OBJ[++I].Sprite)
+		for (int S = RenderState.OBJLines[Y].OBJ[I].Sprite; S >= 0 && I < 32; S = RenderState.OBJLines[Y].OBJ[++I].Sprite)
 		{
-			tiles += GFX.OBJVisibleTiles[S];
+			tiles += RenderState.OBJVisibleTiles[S];
 			if (tiles <= 0)
 				continue;
 
-			int	BaseTile = (((GFX.OBJLines[Y].OBJ[I].Line << 1) + (PPU.OBJ[S].Name & 0xf0)) & 0xf0) | (PPU.OBJ[S].Name & 0x100) | (PPU.OBJ[S].Palette << 10);
+			int	BaseTile = (((RenderState.OBJLines[Y].OBJ[I].Line << 1) + (PPU.OBJ[S].Name & 0xf0)) & 0xf0) | (PPU.OBJ[S].Name & 0x100) | (PPU.OBJ[S].Palette << 10);
 			int	TileX = PPU.OBJ[S].Name & 0x0f;
-			int	TileLine = (GFX.OBJLines[Y].OBJ[I].Line & 7) * 8;
+			int	TileLine = (RenderState.OBJLines[Y].OBJ[I].Line & 7) * 8;
 			int	TileInc = 1;
 
 			if (PPU.OBJ[S].HFlip)
 			{
-				TileX = (TileX + (GFX.OBJWidths[S] >> 3) - 1) & 0x0f;
+				TileX = (TileX + (RenderState.OBJWidths[S] >> 3) - 1) & 0x0f;
 				BaseTile |= H_FLIP;
 				TileInc = -1;
 			}
@@ -825,7 +1364,7 @@ static void DrawOBJS (int D)
 			if (X == -256)
 				X = 256;
 
-			for (int t = tiles, O = Offset + X * PixWidth; X <= 256 && X < PPU.OBJ[S].HPos + GFX.OBJWidths[S]; TileX = (TileX + TileInc) & 0x0f, X += 8, O += 8 * PixWidth)
+			for (int t = tiles, O = Offset + X * PixWidth; X <= 256 && X < PPU.OBJ[S].HPos + RenderState.OBJWidths[S]; TileX = (TileX + TileInc) & 0x0f, X += 8, O += 8 * PixWidth)
 			{
 				if (X < -7 || --t < 0 || X == 256)
 					continue;
@@ -1748,6 +2287,12 @@ static inline void DrawBackdrop (void)
 	}
 }
 
+#undef PPU
+#undef IPPU
+#undef Memory
+#undef LineData
+#undef LineMatrixData
+
 void S9xReRefresh (void)
 {
 	// Be careful when calling this function from the thread other than the emulation one...
@@ -1864,6 +2409,16 @@ static void DisplayFrameRate (void)
 #endif
 
 	S9xDisplayString(string, 1, IPPU.RenderedScreenWidth - (font_width - 1) * len - 1, false);
+
+#ifdef DEBUGGER
+	// Tiles converted this frame, and how many came out of the decoded-tile store
+	char	tiles[32];
+	uint32	lookups, hits;
+
+	S9xGetTileStoreStats(&lookups, &hits);
+	sprintf(tiles, "%u tiles %u%%", (unsigned int) lookups, lookups ? (unsigned int) (hits * 100ULL / lookups) : 0);
+	S9xDisplayString(tiles, 3, IPPU.RenderedScreenWidth - (font_width - 1) * strlen(tiles) - 1, false);
+#endif
 }
 
 static void DisplayPressedKeys (void)
@@ -9,6 +9,18 @@
 
 #include "port.h"
 
+struct SOBJLine
+{
+	uint8	RTOFlags;
+	int16	Tiles;
+
+	struct
+	{
+		int8	Sprite;
+		uint8	Line;
+	}	OBJ[32];
+};
+
 struct SGFX
 {
 	uint16	*Screen;
@@ -38,17 +50,7 @@ struct SGFX
 
 	struct ClipData	*Clip;
 
-	struct
-	{
-		uint8	RTOFlags;
-		int16	Tiles;
-
-		struct
-		{
-			int8	Sprite;
-			uint8	Line;
-		}	OBJ[32];
-	}	OBJLines[SNES_HEIGHT_EXTENDED];
+	struct SOBJLine	OBJLines[SNES_HEIGHT_EXTENDED];
 
 	void	(*DrawBackdropMath) (uint32, uint32, uint32);
 	void	(*DrawBackdropNomath) (uint32, uint32, uint32);
@@ -92,6 +94,8 @@ struct SBG
 	uint8	*BufferFlip;
 	uint8	*Buffered;
 	uint8	*BufferedFlip;
+	uint8	BufferType;			// TILE_* of Buffer, for the decoded-tile store
+	uint8	BufferFlipType;
 	bool8	DirectColourMode;
 };
 
@@ -189,6 +193,7 @@ void RenderLine (uint8);
 void S9xComputeClipWindows (void);
 void S9xDisplayChar (uint16 *, uint8);
 void S9xGraphicsScreenResize (void);
+void S9xSyncRenderThread (void);
 // called automatically unless Settings.AutoDisplayMessages is false
 void S9xDisplayMessages (uint16 *, int, int, int, int);
 
@@ -29,6 +29,7 @@ struct SDMA				DMA[8];
 struct STimings			Timings;
 struct SGFX				GFX;
 struct SBG				BG;
+struct SRenderState		RenderState;
 struct SLineData		LineData[240];
 struct SLineMatrixData	LineMatrixData[240];
 struct SDSP0			DSP0;
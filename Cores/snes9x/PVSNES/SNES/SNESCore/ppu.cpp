@@ -187,6 +187,8 @@ void S9xUpdateIRQPositions (bool initial)
 
 void S9xFixColourBrightness (void)
 {
+	S9xSyncRenderThread();
+
 	IPPU.XB = mul_brightness[PPU.Brightness];
 
 	for (int i = 0; i < 64; i++)
@@ -1737,6 +1739,8 @@ void S9xResetPPU (void)
 
 void S9xResetPPUFast (void)
 {
+	S9xSyncRenderThread();
+
 	PPU.RecomputeClipWindows = TRUE;
 	IPPU.ColorsChanged = TRUE;
 	IPPU.OBJChanged = TRUE;
@@ -1751,6 +1755,8 @@ void S9xResetPPUFast (void)
 
 void S9xSoftResetPPU (void)
 {
+	S9xSyncRenderThread();
+
 	S9xControlsSoftReset();
 
 	PPU.VMA.High = 0;
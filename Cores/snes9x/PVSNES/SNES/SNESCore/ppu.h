@@ -213,6 +213,26 @@ void S9xDoAutoJoypad (void);
 #include "gfx.h"
 #include "memmap.h"
 
+// What the renderer draws from. gfx.cpp, tile.cpp and clip.cpp read PPU, IPPU
+// and Memory through this. Drawing inline, it points at the live state; with
+// Settings.ThreadedRendering, at the copy the lines being drawn were flushed
+// with, so the live registers are free to move on while the render thread
+// catches up.
+struct SRenderState
+{
+	struct SPPU			*PPU;
+	struct InternalPPU	*IPPU;
+	uint8				*VRAM;
+	uint8				*FillRAM;
+	uint8				*OBJWidths;
+	uint8				*OBJVisibleTiles;
+	struct SOBJLine		*OBJLines;
+	struct SLineData	*LineData;
+	struct SLineMatrixData	*LineMatrixData;
+};
+
+extern struct SRenderState	RenderState;
+
 typedef struct
 {
 	uint8	_5C77;
@@ -244,12 +244,14 @@ void S9xLoadConfigFiles (char **argv, int argc)
 	Settings.DynamicRateControl         =  conf.GetBool("Sound::DynamicRateControl",           false);
 	Settings.DynamicRateLimit           =  conf.GetInt ("Sound::DynamicRateLimit",             5);
 	Settings.InterpolationMethod        =  conf.GetInt ("Sound::InterpolationMethod",          2);
+	Settings.ThreadedAPU                =  conf.GetBool("Sound::ThreadedAPU",                  false);
 
 	// Display
 
 	Settings.SupportHiRes               =  conf.GetBool("Display::HiRes",                      true);
 	Settings.Transparency               =  conf.GetBool("Display::Transparency",               true);
 	Settings.DisableGraphicWindows      = !conf.GetBool("Display::GraphicWindows",             true);
+	Settings.ThreadedRendering          =  conf.GetBool("Display::ThreadedRendering",          false);
 	Settings.DisplayFrameRate           =  conf.GetBool("Display::DisplayFrameRate",           false);
 	Settings.DisplayWatchedAddresses    =  conf.GetBool("Display::DisplayWatchedAddresses",    false);
 	Settings.DisplayPressedKeys         =  conf.GetBool("Display::DisplayInput",               false);
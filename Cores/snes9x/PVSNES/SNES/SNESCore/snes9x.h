@@ -241,11 +241,13 @@ struct SSettings
 	bool8	DynamicRateControl;
 	int32	DynamicRateLimit; /* Multiplied by 1000 */
 	int32	InterpolationMethod;
+	bool8	ThreadedAPU;
 
 	bool8	SupportHiRes;
 	bool8	Transparency;
 	uint8	BG_Forced;
 	bool8	DisableGraphicWindows;
+	bool8	ThreadedRendering;
 
 	bool8	DisplayFrameRate;
 	bool8	DisplayWatchedAddresses;
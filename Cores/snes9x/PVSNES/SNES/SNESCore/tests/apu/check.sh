@@ -0,0 +1,32 @@
+#!/bin/sh
+#
+# Builds threaded.cpp against the APU sources and runs it: the sound output with Settings.ThreadedAPU off and on must
+# match the expected hash, and with it on samples must land once a frame.
+#
+# Usage: check.sh
+#
+
+EXPECTED=26e85f03beff2e25
+
+SRC=`dirname "$0"`/../..
+DIR=`mktemp -d` || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+${CXX:-c++} -std=gnu++11 -O2 -I"$SRC" -DRIGHTSHIFT_IS_SAR -o "$DIR/threaded" "`dirname "$0"`/threaded.cpp" \
+	"$SRC/apu/bapu/smp/smp.cpp" "$SRC/apu/bapu/smp/smp_state.cpp" "$SRC/apu/bapu/dsp/sdsp.cpp" -lpthread || exit 1
+
+"$DIR/threaded" > "$DIR/out"
+RESULT=$?
+cat "$DIR/out"
+
+for MODE in inline threaded; do
+	HASH=`sed -n "s/^$MODE: .*hash \([0-9a-f]*\).*/\1/p" "$DIR/out"`
+	if [ "$HASH" = "$EXPECTED" ]; then
+		echo "$MODE: $HASH OK"
+	else
+		echo "$MODE: got '$HASH', expected $EXPECTED"
+		RESULT=1
+	fi
+done
+
+exit $RESULT
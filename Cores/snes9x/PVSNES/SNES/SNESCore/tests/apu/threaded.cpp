@@ -0,0 +1,258 @@
+/*****************************************************************************\
+     Snes9x - Portable Super Nintendo Entertainment System (TM) emulator.
+                This file is licensed under the Snes9x License.
+   For further information, consult the LICENSE file in the root directory.
+\*****************************************************************************/
+
+// Checks Settings.ThreadedAPU against running the APU inline. A synthetic CPU
+// timeline uploads a small sound program over the IPL protocol and then pokes
+// the ports a few times a frame, with a stretch of frames full of port reads in
+// the middle to push the threaded mode into its inline fallback and back. Both
+// modes must produce the same samples, and while the thread is in use samples
+// must land exactly once a frame, on its last line.
+//
+// Built and run by check.sh, which compares the hash with the expected one.
+
+#include "../../apu/apu.cpp"
+#include <vector>
+
+struct SSettings Settings;
+struct SCPUState CPU;
+struct STimings Timings;
+
+void S9xMSU1Generate(size_t) {}
+void S9xMSU1SetOutput(Resampler *) {}
+void S9xMSU1DeInit(void) {}
+const char *S9xGetFilenameInc(const char *, enum s9x_getdirtype) { return "/dev/null"; }
+bool8 S9xOpenSoundDevice(void) { return TRUE; }
+
+static const int H_MAX = 1364;
+static const int V_MAX = 262;
+static const int FRAMES = 1000;
+static const int BURST_START = 300;
+static const int BURST_END = 400;
+static const int BURST_READS = 50;
+
+static uint64 hash;
+static uint64 landed;
+static int line;
+static int errors;
+static int threaded_frames;
+static int landings;
+static int16 buf[65536];
+
+static void SamplesAvailable(void *)
+{
+    const int n = S9xGetSampleCount();
+
+    if (spc_thread::active && CPU.V_Counter != V_MAX - 1)
+    {
+        if (errors++ < 10)
+            printf("samples landed on line %d with the APU thread in use\n", CPU.V_Counter);
+    }
+
+    S9xMixSamples((uint8 *)buf, n);
+
+    for (int i = 0; i < n; i++)
+        hash = (hash ^ (uint16)buf[i]) * 1099511628211ULL;
+
+    landed += n;
+    landings++;
+}
+
+static void Advance(int cycles)
+{
+    CPU.Cycles += cycles;
+
+    while (CPU.Cycles >= H_MAX)
+    {
+        const int32 over = CPU.Cycles - H_MAX;
+        const bool8 threaded = spc_thread::active;
+
+        CPU.Cycles = H_MAX;
+        CPU.V_Counter = line;
+        S9xAPUEndScanline();
+        CPU.Cycles = 0;
+        S9xAPUSetReferenceTime(CPU.Cycles);
+        CPU.Cycles = over;
+
+        if (line == V_MAX - 1)
+        {
+            if (threaded)
+            {
+                threaded_frames++;
+
+                if (landings != 1 && errors++ < 10)
+                    printf("%d landings in a frame on the APU thread\n", landings);
+            }
+
+            landings = 0;
+        }
+
+        line = (line + 1) % V_MAX;
+    }
+}
+
+static uint8 Read(int port)
+{
+    Advance(8);
+    return S9xAPUReadPort(port);
+}
+
+static void Write(int port, uint8 byte)
+{
+    Advance(8);
+    S9xAPUWritePort(port, byte);
+}
+
+static void WaitFor(int port, uint8 byte)
+{
+    for (int i = 0; Read(port) != byte; i++)
+    {
+        if (i > 1000000)
+        {
+            printf("timed out waiting for the SPC700\n");
+            exit(1);
+        }
+
+        Advance(12);
+    }
+}
+
+// DSP register writes followed by a loop echoing ports 0-2 into voice 0's
+// pitch, playing a looped BRR square wave.
+static std::vector<uint8> Program(void)
+{
+    static const uint8 brr[9] = { 0xC3, 0x77, 0x77, 0x77, 0x77, 0x99, 0x99, 0x99, 0x99 };
+    static const uint8 regs[][2] = {
+        { 0x6C, 0x20 }, { 0x0C, 0x7F }, { 0x1C, 0x7F }, { 0x2C, 0x00 }, { 0x3C, 0x00 },
+        { 0x5D, 0x02 }, { 0x00, 0x7F }, { 0x01, 0x7F }, { 0x02, 0x00 }, { 0x03, 0x10 },
+        { 0x04, 0x00 }, { 0x05, 0x00 }, { 0x07, 0x7F }, { 0x5C, 0x00 }, { 0x4C, 0x01 }
+    };
+    static const uint8 loop[] = { 0xE4, 0xF4, 0xC4, 0xF5, 0xE4, 0xF6, 0x8F, 0x03, 0xF2, 0xC4, 0xF3, 0x2F, 0xF3 };
+    std::vector<uint8> prog(0x100, 0);
+
+    // Sample directory at $0200, BRR data at $0210
+    prog[0] = prog[2] = 0x10;
+    prog[1] = prog[3] = 0x02;
+    memcpy(&prog[0x10], brr, sizeof(brr));
+
+    for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); i++)
+    {
+        const uint8 mov[6] = { 0x8F, regs[i][0], 0xF2, 0x8F, regs[i][1], 0xF3 };
+        prog.insert(prog.end(), mov, mov + 6);
+    }
+
+    prog.insert(prog.end(), loop, loop + sizeof(loop));
+
+    return prog;
+}
+
+static void Run(bool8 threaded)
+{
+    Settings.ThreadedAPU = threaded;
+    S9xResetAPU();
+    CPU.Cycles = 0;
+    S9xAPUSetReferenceTime(0);
+    line = 0;
+    landings = 0;
+    hash = 1469598103934665603ULL;
+    landed = 0;
+    threaded_frames = 0;
+
+    const std::vector<uint8> prog = Program();
+
+    WaitFor(0, 0xAA);
+    WaitFor(1, 0xBB);
+    Write(2, 0x00);
+    Write(3, 0x02);
+    Write(1, 1);
+    Write(0, 0xCC);
+    WaitFor(0, 0xCC);
+
+    for (size_t i = 0; i < prog.size(); i++)
+    {
+        Write(1, prog[i]);
+        Write(0, i & 0xFF);
+        WaitFor(0, i & 0xFF);
+    }
+
+    uint8 kick = (prog.size() + 1) & 0xFF;
+    if (!kick)
+        kick++;
+
+    Write(2, 0x00);
+    Write(3, 0x03);
+    Write(1, 0);
+    Write(0, kick);
+    WaitFor(0, kick);
+
+    // Finish the frame the upload ended in
+    Advance((V_MAX - line) * H_MAX - CPU.Cycles);
+
+    for (int f = 0; f < FRAMES; f++)
+    {
+        for (int l = 0; l < 4; l++)
+        {
+            Advance(H_MAX * 60 + (f * 37 + l * 101) % 900);
+            Write(2, 0x08 + ((f * 7 + l) & 0x1F));
+            Write(0, f + l);
+
+            if (l & 1)
+                Read(1);
+
+            if (f >= BURST_START && f < BURST_END)
+            {
+                for (int r = 0; r < BURST_READS; r++)
+                    Read(1);
+            }
+        }
+
+        Advance((V_MAX - line) * H_MAX - CPU.Cycles);
+    }
+
+    // Inline, up to a block of samples may still be waiting
+    S9xLandSamples();
+}
+
+int main(void)
+{
+    memset(&Settings, 0, sizeof(Settings));
+    Settings.SoundPlaybackRate = 48000;
+    Settings.SoundInputRate = 31955;
+    Settings.SoundSync = TRUE;
+    Settings.Stereo = TRUE;
+    Settings.SixteenBitSound = TRUE;
+    Settings.InterpolationMethod = DSP_INTERPOLATION_GAUSSIAN;
+    Timings.V_Max = V_MAX;
+    Timings.H_Max = H_MAX;
+
+    S9xInitAPU();
+    S9xInitSound(100);
+    S9xSetSamplesAvailableCallback(SamplesAvailable, NULL);
+    S9xAPUTimingSetSpeedup(0);
+
+    Run(FALSE);
+    const uint64 inline_hash = hash;
+    printf("inline:   %llu samples, hash %016llx\n", (unsigned long long)landed, (unsigned long long)inline_hash);
+
+    Run(TRUE);
+    printf("threaded: %llu samples, hash %016llx, %d of %d frames on the APU thread\n", (unsigned long long)landed,
+           (unsigned long long)hash, threaded_frames, FRAMES);
+
+    if (hash != inline_hash)
+    {
+        printf("threaded output differs from inline\n");
+        errors++;
+    }
+
+    if (threaded_frames == 0 || threaded_frames == FRAMES)
+    {
+        printf("expected both threaded and fallback frames\n");
+        errors++;
+    }
+
+    S9xDeinitAPU();
+
+    return errors ? 1 : 0;
+}
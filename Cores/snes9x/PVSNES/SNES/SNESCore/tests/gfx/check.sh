@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Builds threaded.cpp against the core and runs it drawing inline, threaded, and switching between the two every 37
+# frames: all three must give the expected hash. The emulation thread and total CPU times are printed alongside; the
+# difference between the first two is the drawing taken off the emulation thread, less what handing it over costs.
+#
+# Usage: check.sh
+#
+
+EXPECTED=7f704322f4f48744
+
+SRC=`dirname "$0"`/../..
+DIR=`mktemp -d` || exit 1
+trap 'rm -rf "$DIR"' EXIT
+
+CXXFLAGS="-std=gnu++11 -O2 -I$SRC -I$SRC/apu -I$SRC/apu/bapu -DRIGHTSHIFT_IS_SAR -DHAVE_STDINT_H -DPIXEL_FORMAT=RGB565 -DZLIB -w"
+
+for FILE in apu/apu.cpp apu/bapu/dsp/sdsp.cpp apu/bapu/smp/smp.cpp apu/bapu/smp/smp_state.cpp bml.cpp bsx.cpp c4.cpp \
+	c4emu.cpp cheats.cpp cheats2.cpp clip.cpp conffile.cpp controls.cpp cpu.cpp cpuexec.cpp cpuops.cpp crosshairs.cpp \
+	dma.cpp dsp.cpp dsp1.cpp dsp2.cpp dsp3.cpp dsp4.cpp fxemu.cpp fxinst.cpp gfx.cpp globals.cpp logger.cpp memmap.cpp \
+	movie.cpp msu1.cpp obc1.cpp ppu.cpp sa1.cpp sa1cpu.cpp screenshot.cpp sdd1.cpp sdd1emu.cpp seta.cpp seta010.cpp \
+	seta011.cpp seta018.cpp sha256.cpp snapshot.cpp snes9x.cpp spc7110.cpp spc7110dec.cpp srtc.cpp statemanager.cpp \
+	stream.cpp tile.cpp; do
+	${CXX:-c++} $CXXFLAGS -c "$SRC/$FILE" -o "$DIR/`echo $FILE | tr / _`.o" || exit 1
+done
+
+${CXX:-c++} $CXXFLAGS -o "$DIR/threaded" "`dirname "$0"`/threaded.cpp" "$DIR"/*.o -lz -lpthread || exit 1
+
+RESULT=0
+for MODE in 0 1 2; do
+	OUT=`"$DIR/threaded" $MODE | grep "^mode "`
+	echo "$OUT"
+	HASH=`echo "$OUT" | sed -n 's/^mode [0-9]: hash \([0-9a-f]*\).*/\1/p'`
+	if [ "$HASH" != "$EXPECTED" ]; then
+		echo "mode $MODE: got '$HASH', expected $EXPECTED"
+		RESULT=1
+	fi
+done
+
+exit $RESULT
@@ -0,0 +1,228 @@
+/*****************************************************************************\
+     Snes9x - Portable Super Nintendo Entertainment System (TM) emulator.
+                This file is licensed under the Snes9x License.
+   For further information, consult the LICENSE file in the root directory.
+\*****************************************************************************/
+
+// Checks Settings.ThreadedRendering against drawing inline, and times both. A
+// spin-loop ROM runs while the PPU is driven from outside: registers, VRAM,
+// CGRAM and OAM between frames, and per-line HDMA of scroll, brightness,
+// windows, VRAM, CGRAM, mode 7 and BG mode within them, going through every BG
+// mode, mosaic, hires and interlace. Every finished frame is hashed.
+//
+// Usage: threaded <0 inline, 1 threaded, 2 switching every 37 frames>
+//
+// Built and run by check.sh, which compares the hash with the expected one.
+
+#include "snes9x.h"
+#include "memmap.h"
+#include "apu/apu.h"
+#include "gfx.h"
+#include "ppu.h"
+#include "controls.h"
+#include "cpuexec.h"
+#include "snapshot.h"
+#include "display.h"
+#include "conffile.h"
+#include <time.h>
+
+static const int FRAMES = 600;
+
+static int cur_frame;
+static uint64 hash = 1469598103934665603ULL;
+static uint32 rng = 12345;
+static uint32 rnd() { rng = rng * 1103515245 + 12345; return rng >> 8; }
+
+static double cpu_ms(clockid_t clock)
+{
+	struct timespec	t;
+	clock_gettime(clock, &t);
+	return (t.tv_sec * 1e3 + t.tv_nsec / 1e6);
+}
+
+bool8 S9xInitUpdate(void) { return TRUE; }
+bool8 S9xDeinitUpdate(int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		uint16 *p = GFX.Screen + y * GFX.RealPPL;
+		for (int x = 0; x < w; x++)
+			hash = (hash ^ p[x]) * 1099511628211ULL;
+	}
+	hash = (hash ^ (w * 1000 + h)) * 1099511628211ULL;
+	return TRUE;
+}
+bool8 S9xContinueUpdate(int w, int h) { return TRUE; }
+void S9xSetPalette(void) {}
+void S9xSyncSpeed(void) {}
+void S9xMessage(int, int, const char *) {}
+void S9xExit(void) { exit(1); }
+const char *S9xGetDirectory(enum s9x_getdirtype) { return "."; }
+const char *S9xGetFilename(const char *e, enum s9x_getdirtype) { return "/dev/null"; }
+const char *S9xGetFilenameInc(const char *e, enum s9x_getdirtype) { return "/dev/null"; }
+const char *S9xBasename(const char *f) { return f; }
+bool8 S9xOpenSnapshotFile(const char *, bool8, STREAM *) { return FALSE; }
+void S9xCloseSnapshotFile(STREAM) {}
+void S9xAutoSaveSRAM(void) {}
+bool8 S9xOpenSoundDevice(void) { return TRUE; }
+bool S9xPollButton(uint32, bool *) { return false; }
+bool S9xPollAxis(uint32, int16 *) { return false; }
+bool S9xPollPointer(uint32, int16 *, int16 *) { return false; }
+void S9xHandlePortCommand(s9xcommand_t, int16, int16) {}
+void S9xToggleSoundChannel(int) {}
+const char *S9xStringInput(const char *) { return NULL; }
+const char *S9xChooseFilename(bool8) { return NULL; }
+const char *S9xChooseMovieFilename(bool8) { return NULL; }
+bool8 S9xMapInput(const char *, s9xcommand_t *) { return FALSE; }
+void S9xSetTitle(const char *) {}
+
+static void ppu(uint16 a, uint8 v) { S9xSetPPU(v, a); }
+static void cpu(uint16 a, uint8 v) { S9xSetCPU(v, a); }
+
+// WRAM tables for HDMA, one entry per line
+static void hdma(int ch, uint8 mode, uint8 reg, uint32 addr, int bytes, int lines, uint8 (*gen)(int line, int i))
+{
+	uint8 *t = Memory.RAM + addr;
+	int n = 0;
+	for (int l = 0; l < lines; l++)
+	{
+		t[n++] = 1;
+		for (int i = 0; i < bytes; i++)
+			t[n++] = gen(l, i);
+	}
+	t[n++] = 0;
+	cpu(0x4300 + ch * 16, mode);
+	cpu(0x4301 + ch * 16, reg);
+	cpu(0x4302 + ch * 16, addr & 0xff);
+	cpu(0x4303 + ch * 16, (addr >> 8) & 0xff);
+	cpu(0x4304 + ch * 16, 0x7e);
+}
+
+
+static uint8 g_scroll(int l, int i) { return i ? 0 : (uint8) (l * (cur_frame % 5) + cur_frame); }
+static uint8 g_bright(int l, int i) { return (l >= 100 && l < 104 && cur_frame % 3 == 0) ? 0x80 : 0x0f - ((l >> 5) & 3); }
+static uint8 g_win(int l, int i) { return i ? (uint8) (200 - l / 2) : (uint8) (20 + l / 3); }
+static uint8 g_vram(int l, int i) { return (uint8) (l * 7 + i * 13 + cur_frame); }
+static uint8 g_cg(int l, int i) { return i < 2 ? (uint8) (l & 0xff) : (uint8) (l * 3 + cur_frame + i); }
+static uint8 g_m7(int l, int i) { return i ? (uint8) (1 + (l >> 6)) : (uint8) (l * 2); }
+static uint8 g_mode(int l, int i) { return l < 120 ? (cur_frame & 7) : ((cur_frame % 4) == 1 ? 5 : 1); }
+
+static void scene(int f)
+{
+	cur_frame = f;
+	int mode = f & 7;
+
+	if (f % 50 == 0)
+	{
+		// Fill VRAM, CGRAM and OAM
+		ppu(0x2115, 0x80);
+		ppu(0x2116, 0); ppu(0x2117, 0);
+		for (int i = 0; i < 0x8000; i++) { ppu(0x2118, rnd()); ppu(0x2119, rnd()); }
+		ppu(0x2121, 0);
+		for (int i = 0; i < 512; i++) ppu(0x2122, rnd());
+		ppu(0x2102, 0); ppu(0x2103, 0);
+		for (int i = 0; i < 544; i++) ppu(0x2104, rnd() & (i < 512 && (i & 3) == 1 ? 0xbf : 0xff));
+	}
+	else
+	{
+		// Some VRAM every frame
+		ppu(0x2116, rnd()); ppu(0x2117, rnd() & 0x7f);
+		for (int i = 0; i < 64; i++) { ppu(0x2118, rnd()); ppu(0x2119, rnd()); }
+		ppu(0x2102, rnd()); ppu(0x2103, 0);
+		for (int i = 0; i < 16; i++) ppu(0x2104, rnd());
+	}
+
+	ppu(0x2100, 0x0f);
+	ppu(0x2101, rnd() & 0xe3);
+	ppu(0x2105, mode | (rnd() & 0xf8));
+	ppu(0x2106, (f % 7 == 0) ? (rnd() & 0xff) : 0);
+	for (int i = 0; i < 4; i++) ppu(0x2107 + i, rnd() & 0xff);
+	ppu(0x210b, rnd()); ppu(0x210c, rnd());
+	for (int i = 0; i < 8; i++) { ppu(0x210d + i, rnd()); ppu(0x210d + i, rnd() & 3); }
+	for (int i = 0; i < 6; i++) { ppu(0x211b + i, rnd()); ppu(0x211b + i, rnd() & 0x1f); }
+	ppu(0x211a, rnd() & 0xc3);
+	ppu(0x2123, rnd()); ppu(0x2124, rnd()); ppu(0x2125, rnd());
+	ppu(0x2126, rnd()); ppu(0x2127, rnd()); ppu(0x2128, rnd()); ppu(0x2129, rnd());
+	ppu(0x212a, rnd()); ppu(0x212b, rnd());
+	ppu(0x212c, rnd() & 0x1f); ppu(0x212d, rnd() & 0x1f);
+	ppu(0x212e, rnd() & 0x1f); ppu(0x212f, rnd() & 0x1f);
+	ppu(0x2130, rnd() & 0xf3); ppu(0x2131, rnd());
+	ppu(0x2132, rnd()); ppu(0x2132, rnd());
+	ppu(0x2133, (f % 11 == 3 ? 0x01 : 0) | (f % 6 == 2 ? 0x08 : 0) | (rnd() & 0x40));
+
+	hdma(0, 2, 0x0d, 0x1000, 2, 224, g_scroll);
+	hdma(1, 0, 0x00, 0x2000, 1, 224, g_bright);
+	hdma(2, 1, 0x26, 0x3000, 2, 224, g_win);
+	hdma(3, 1, 0x18, 0x4000, 2, 224, g_vram);
+	hdma(4, 3, 0x21, 0x5000, 4, 224, g_cg);
+	hdma(5, 2, 0x1b, 0x6000, 2, 224, g_m7);
+	hdma(6, 0, 0x05, 0x7000, 1, 224, g_mode);
+	ppu(0x2116, rnd()); ppu(0x2117, rnd() & 0x7f);
+	cpu(0x420c, (f % 9 == 4 ? 0x00 : 0x7f));
+}
+
+int main(int argc, char **argv)
+{
+	int mode = argc > 1 ? atoi(argv[1]) : 0;
+
+	memset(&Settings, 0, sizeof(Settings));
+	Settings.SupportHiRes = TRUE;
+	Settings.Transparency = TRUE;
+	Settings.MaxSpriteTilesPerLine = 34;
+	Settings.SoundPlaybackRate = 32000;
+	Settings.SoundInputRate = 31950;
+	Settings.Stereo = TRUE;
+	Settings.SixteenBitSound = TRUE;
+	Settings.FrameTimeNTSC = 16667;
+	Settings.FrameTimePAL = 20000;
+	Settings.StopEmulation = TRUE;
+	Settings.ThreadedRendering = mode == 1;
+
+	Memory.Init();
+	S9xInitAPU();
+	S9xInitSound(100);
+
+	GFX.Pitch = 1024;
+	GFX.Screen = (uint16 *) calloc(1024 * 478 * 2, 1);
+	S9xGraphicsInit();
+
+	static uint8 rom[0x8000];
+	uint8 code[] = { 0x78, 0x18, 0xfb, 0x80, 0xfe }; // sei; clc; xce; bra *
+	memcpy(rom, code, sizeof(code));
+	memcpy(rom + 0x7fc0, "THREADED RENDERING   ", 21);
+	rom[0x7fd5] = 0x20; rom[0x7fd7] = 0x08; rom[0x7fd9] = 0x01;
+	rom[0x7ffc] = 0x00; rom[0x7ffd] = 0x80;
+	if (!Memory.LoadROMMem(rom, sizeof(rom)))
+	{
+		printf("load failed\n");
+		return 1;
+	}
+	Settings.StopEmulation = FALSE;
+	Settings.BlockInvalidVRAMAccess = FALSE;
+	Settings.BlockInvalidVRAMAccessMaster = FALSE;
+
+	double main0 = cpu_ms(CLOCK_THREAD_CPUTIME_ID), process0 = cpu_ms(CLOCK_PROCESS_CPUTIME_ID);
+
+	for (int f = 0; f < FRAMES; f++)
+	{
+		if (mode == 2)
+			Settings.ThreadedRendering = (f / 37) & 1;
+		if (f == 150)
+			S9xSoftReset();
+		scene(f);
+		S9xMainLoop();
+	}
+
+	// The emulation thread's CPU time, and the whole process's
+	printf("mode %d: hash %016llx, %.0f ms emulation thread, %.0f ms total\n", mode, (unsigned long long) hash,
+		cpu_ms(CLOCK_THREAD_CPUTIME_ID) - main0, cpu_ms(CLOCK_PROCESS_CPUTIME_ID) - process0);
+
+	S9xGraphicsDeinit();
+	return 0;
+}
+
+void S9xExtraUsage(void) {}
+void S9xParseArg(char **, int &, int) {}
+void S9xParsePortConfig(ConfigFile &, int) {}
+void _makepath(char *path, const char *, const char *, const char *fname, const char *ext) { sprintf(path, "%s.%s", fname ? fname : "", ext ? ext : ""); }
+void _splitpath(const char *path, char *drive, char *dir, char *fname, char *ext) { *drive = *dir = *ext = 0; strcpy(fname, "x"); }
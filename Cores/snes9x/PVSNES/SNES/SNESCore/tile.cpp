@@ -17,10 +17,38 @@
 #include "ppu.h"
 #include "tile.h"
 
+// Draw from the state the batch was flushed with (see SRenderState).
+#define PPU		(*RenderState.PPU)
+#define IPPU	(*RenderState.IPPU)
+#define Memory	RenderState
+#define LineMatrixData	RenderState.LineMatrixData
+
 static uint32	pixbit[8][16];
 static uint8	hrbit_odd[256];
 static uint8	hrbit_even[256];
 
+// Decoded tiles are also kept in a store keyed by the VRAM bytes they were
+// decoded from, rather than by where those bytes are. IPPU.TileCached has to
+// forget a tile whenever its VRAM is written, even if it's written with the
+// same data, and games that stream their graphics in from ROM do that all the
+// time; the store lets such a tile be copied back out instead of converted
+// again. It's 2-way set associative and nothing is ever invalidated: an entry
+// holds its source bytes and only matches tiles with those exact bytes.
+#define TILE_STORE_SETS	4096
+
+struct STileStoreEntry
+{
+	uint8	Type;			// TILE_*, 0xff when unused
+	uint8	Result;			// TRUE or BLANK_TILE
+	uint8	Source[128];	// Both tiles, for the hires converters
+	uint8	Tile[64];
+};
+
+static struct STileStoreEntry	tile_store[TILE_STORE_SETS][2];
+static uint8	tile_store_lru[TILE_STORE_SETS];	// Way to replace next
+static uint32	tile_store_lookups = 0;
+static uint32	tile_store_hits = 0;
+
 void S9xInitTileRenderer (void)
 {
 	int	i;
@@ -78,6 +106,9 @@ void S9xInitTileRenderer (void)
 		hrbit_odd[i]  = m;
 		hrbit_even[i] = s;
 	}
+
+	for (i = 0; i < TILE_STORE_SETS; i++)
+		tile_store[i][0].Type = tile_store[i][1].Type = 0xff;
 }
 
 // Here are the tile converters, selected by S9xSelectTileConverter().
@@ -183,9 +214,9 @@ static uint8 ConvertTile2h_odd (uint8 *pCache, uint32 TileAddr, uint32 Tile)
 	uint8			line;
 
 	if (Tile == 0x3ff)
-		tp2 = tp1 - (0x3ff << 4);
+		tp2 = &Memory.VRAM[(TileAddr - (0x3ff << 4)) & 0xffff];
 	else
-		tp2 = tp1 + (1 << 4);
+		tp2 = &Memory.VRAM[(TileAddr + (1 << 4)) & 0xffff];
 
 	for (line = 8; line != 0; line--, tp1 += 2, tp2 += 2)
 	{
@@ -211,9 +242,9 @@ static uint8 ConvertTile4h_odd (uint8 *pCache, uint32 TileAddr, uint32 Tile)
 	uint8			line;
 
 	if (Tile == 0x3ff)
-		tp2 = tp1 - (0x3ff << 5);
+		tp2 = &Memory.VRAM[(TileAddr - (0x3ff << 5)) & 0xffff];
 	else
-		tp2 = tp1 + (1 << 5);
+		tp2 = &Memory.VRAM[(TileAddr + (1 << 5)) & 0xffff];
 
 	for (line = 8; line != 0; line--, tp1 += 2, tp2 += 2)
 	{
@@ -249,9 +280,9 @@ static uint8 ConvertTile2h_even (uint8 *pCache, uint32 TileAddr, uint32 Tile)
 	uint8			line;
 
 	if (Tile == 0x3ff)
-		tp2 = tp1 - (0x3ff << 4);
+		tp2 = &Memory.VRAM[(TileAddr - (0x3ff << 4)) & 0xffff];
 	else
-		tp2 = tp1 + (1 << 4);
+		tp2 = &Memory.VRAM[(TileAddr + (1 << 4)) & 0xffff];
 
 	for (line = 8; line != 0; line--, tp1 += 2, tp2 += 2)
 	{
@@ -277,9 +308,9 @@ static uint8 ConvertTile4h_even (uint8 *pCache, uint32 TileAddr, uint32 Tile)
 	uint8			line;
 
 	if (Tile == 0x3ff)
-		tp2 = tp1 - (0x3ff << 5);
+		tp2 = &Memory.VRAM[(TileAddr - (0x3ff << 5)) & 0xffff];
 	else
-		tp2 = tp1 + (1 << 5);
+		tp2 = &Memory.VRAM[(TileAddr + (1 << 5)) & 0xffff];
 
 	for (line = 8; line != 0; line--, tp1 += 2, tp2 += 2)
 	{
@@ -301,6 +332,72 @@ static uint8 ConvertTile4h_even (uint8 *pCache, uint32 TileAddr, uint32 Tile)
 
 #undef DOBIT
 
+// Bytes of VRAM each converter reads from each of its tiles
+static const uint32	TileSourceSize[7] = { 16, 32, 64, 16, 16, 32, 32 };
+
+static uint8 ConvertTileStored (uint8 (*Convert) (uint8 *, uint32, uint32), int Type, uint8 *pCache, uint32 TileAddr, uint32 Tile)
+{
+	uint32	size = TileSourceSize[Type];
+	uint32	len = size;
+	uint8	source[128];
+
+	memcpy(source, &Memory.VRAM[TileAddr], size);
+
+	if (Type >= TILE_2BIT_EVEN)
+	{
+		// The hires converters take the right half of each pixel pair from the next tile
+		uint32	shift = (Type >= TILE_4BIT_EVEN) ? 5 : 4;
+		uint32	Addr2 = (Tile == 0x3ff) ? TileAddr - (0x3ff << shift) : TileAddr + (1 << shift);
+
+		memcpy(source + size, &Memory.VRAM[Addr2 & 0xffff], size);
+		len += size;
+	}
+
+	uint64	h = (uint64) (Type + 1) * 0x9e3779b97f4a7c15ULL;
+
+	for (uint32 i = 0; i < len; i += 8)
+	{
+		uint64	w;
+		memcpy(&w, source + i, 8);
+		h = (h ^ w) * 0xff51afd7ed558ccdULL;
+		h ^= h >> 32;
+	}
+
+	uint32	set = (uint32) h & (TILE_STORE_SETS - 1);
+	struct STileStoreEntry	*e = tile_store[set];
+
+	tile_store_lookups++;
+
+	for (int way = 0; way < 2; way++)
+	{
+		if (e[way].Type == Type && !memcmp(e[way].Source, source, len))
+		{
+			memcpy(pCache, e[way].Tile, 64);
+			tile_store_lru[set] = way ^ 1;
+			tile_store_hits++;
+			return (e[way].Result);
+		}
+	}
+
+	uint8	result = Convert(pCache, TileAddr, Tile);
+	int		way = tile_store_lru[set];
+
+	e[way].Type = Type;
+	e[way].Result = result;
+	memcpy(e[way].Source, source, len);
+	memcpy(e[way].Tile, pCache, 64);
+	tile_store_lru[set] = way ^ 1;
+
+	return (result);
+}
+
+void S9xGetTileStoreStats (uint32 *lookups, uint32 *hits)
+{
+	*lookups = tile_store_lookups;
+	*hits = tile_store_hits;
+	tile_store_lookups = tile_store_hits = 0;
+}
+
 // First-level include: Get all the renderers.
 #include "tile.cpp"
 
@@ -425,6 +522,7 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 			BG.ConvertTile      = BG.ConvertTileFlip = ConvertTile8;
 			BG.Buffer           = BG.BufferFlip      = IPPU.TileCache[TILE_8BIT];
 			BG.Buffered         = BG.BufferedFlip    = IPPU.TileCached[TILE_8BIT];
+			BG.BufferType       = BG.BufferFlipType  = TILE_8BIT;
 			BG.TileShift        = 6;
 			BG.PaletteShift     = 0;
 			BG.PaletteMask      = 0;
@@ -440,18 +538,22 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 					BG.ConvertTile     = ConvertTile4h_even;
 					BG.Buffer          = IPPU.TileCache[TILE_4BIT_EVEN];
 					BG.Buffered        = IPPU.TileCached[TILE_4BIT_EVEN];
+					BG.BufferType      = TILE_4BIT_EVEN;
 					BG.ConvertTileFlip = ConvertTile4h_odd;
 					BG.BufferFlip      = IPPU.TileCache[TILE_4BIT_ODD];
 					BG.BufferedFlip    = IPPU.TileCached[TILE_4BIT_ODD];
+					BG.BufferFlipType  = TILE_4BIT_ODD;
 				}
 				else
 				{
 					BG.ConvertTile     = ConvertTile4h_odd;
 					BG.Buffer          = IPPU.TileCache[TILE_4BIT_ODD];
 					BG.Buffered        = IPPU.TileCached[TILE_4BIT_ODD];
+					BG.BufferType      = TILE_4BIT_ODD;
 					BG.ConvertTileFlip = ConvertTile4h_even;
 					BG.BufferFlip      = IPPU.TileCache[TILE_4BIT_EVEN];
 					BG.BufferedFlip    = IPPU.TileCached[TILE_4BIT_EVEN];
+					BG.BufferFlipType  = TILE_4BIT_EVEN;
 				}
 			}
 			else
@@ -459,6 +561,7 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 				BG.ConvertTile = BG.ConvertTileFlip = ConvertTile4;
 				BG.Buffer      = BG.BufferFlip      = IPPU.TileCache[TILE_4BIT];
 				BG.Buffered    = BG.BufferedFlip    = IPPU.TileCached[TILE_4BIT];
+				BG.BufferType  = BG.BufferFlipType  = TILE_4BIT;
 			}
 
 			BG.TileShift        = 5;
@@ -476,18 +579,22 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 					BG.ConvertTile     = ConvertTile2h_even;
 					BG.Buffer          = IPPU.TileCache[TILE_2BIT_EVEN];
 					BG.Buffered        = IPPU.TileCached[TILE_2BIT_EVEN];
+					BG.BufferType      = TILE_2BIT_EVEN;
 					BG.ConvertTileFlip = ConvertTile2h_odd;
 					BG.BufferFlip      = IPPU.TileCache[TILE_2BIT_ODD];
 					BG.BufferedFlip    = IPPU.TileCached[TILE_2BIT_ODD];
+					BG.BufferFlipType  = TILE_2BIT_ODD;
 				}
 				else
 				{
 					BG.ConvertTile     = ConvertTile2h_odd;
 					BG.Buffer          = IPPU.TileCache[TILE_2BIT_ODD];
 					BG.Buffered        = IPPU.TileCached[TILE_2BIT_ODD];
+					BG.BufferType      = TILE_2BIT_ODD;
 					BG.ConvertTileFlip = ConvertTile2h_even;
 					BG.BufferFlip      = IPPU.TileCache[TILE_2BIT_EVEN];
 					BG.BufferedFlip    = IPPU.TileCached[TILE_2BIT_EVEN];
+					BG.BufferFlipType  = TILE_2BIT_EVEN;
 				}
 			}
 			else
@@ -495,6 +602,7 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 				BG.ConvertTile = BG.ConvertTileFlip = ConvertTile2;
 				BG.Buffer      = BG.BufferFlip      = IPPU.TileCache[TILE_2BIT];
 				BG.Buffered    = BG.BufferedFlip    = IPPU.TileCached[TILE_2BIT];
+				BG.BufferType  = BG.BufferFlipType  = TILE_2BIT;
 			}
 
 			BG.TileShift        = 4;
@@ -522,13 +630,13 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 	{ \
 		pCache = &BG.BufferFlip[TileNumber << 6]; \
 		if (!BG.BufferedFlip[TileNumber]) \
-			BG.BufferedFlip[TileNumber] = BG.ConvertTileFlip(pCache, TileAddr, Tile & 0x3ff); \
+			BG.BufferedFlip[TileNumber] = ConvertTileStored(BG.ConvertTileFlip, BG.BufferFlipType, pCache, TileAddr, Tile & 0x3ff); \
 	} \
 	else \
 	{ \
 		pCache = &BG.Buffer[TileNumber << 6]; \
 		if (!BG.Buffered[TileNumber]) \
-			BG.Buffered[TileNumber] = BG.ConvertTile(pCache, TileAddr, Tile & 0x3ff); \
+			BG.Buffered[TileNumber] = ConvertTileStored(BG.ConvertTile, BG.BufferType, pCache, TileAddr, Tile & 0x3ff); \
 	}
 
 #define IS_BLANK_TILE() \
@@ -845,8 +953,6 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 
 #define CLIP_10_BIT_SIGNED(a)	(((a) & 0x2000) ? ((a) | ~0x3ff) : ((a) & 0x3ff))
 
-extern struct SLineMatrixData	LineMatrixData[240];
-
 #define NO_INTERLACE	1
 #define Z1				(D + 7)
 #define Z2				(D + 7)
@@ -10,5 +10,6 @@
 void S9xInitTileRenderer (void);
 void S9xSelectTileRenderers (int, bool8, bool8);
 void S9xSelectTileConverter (int, bool8, bool8, bool8);
+void S9xGetTileStoreStats (uint32 *, uint32 *);
 
 #endif
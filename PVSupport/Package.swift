@@ -41,6 +41,7 @@ let package = Package(
                 "Audio/TPCircularBuffer.c",
                 "Audio/CARingBuffer/CAAudioTimeStamp.cpp",
                 "Audio/CARingBuffer/CARingBuffer.cpp",
+                "Audio/CARingBuffer/PVAudioRing.cpp",
                 "EmulatorCore/PVEmulatorCore.m",
                 "Logging/PVProvenanceLogging.m",
                 "Logging/PVLogEntry.m",
@@ -64,6 +65,7 @@ let package = Package(
                 "Audio/TPCircularBuffer.c",
                 "Audio/CARingBuffer/CAAudioTimeStamp.cpp",
                 "Audio/CARingBuffer/CARingBuffer.cpp",
+                "Audio/CARingBuffer/PVAudioRing.cpp",
                 "EmulatorCore/PVEmulatorCore.m",
                 "Logging/PVProvenanceLogging.m",
                 "Logging/PVLogEntry.m",
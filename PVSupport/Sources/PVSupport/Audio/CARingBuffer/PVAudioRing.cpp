@@ -0,0 +1,200 @@
+//
+//  PVAudioRing.cpp
+//  PVSupport
+//
+
+#include "PVAudioRing.h"
+
+#include <string.h>
+#include <new>
+
+static size_t RoundUpPow2(size_t v)
+{
+    size_t r = 1;
+
+    while (r < v)
+        r <<= 1;
+    return r;
+}
+
+PVAudioRing::PVAudioRing(size_t size)
+    : _mask(RoundUpPow2(size ? size : 1) - 1),
+      _head(0), _cachedTail(0), _maxFill(0), _overrunBytes(0), _writerResetSeen(0),
+      _tail(0), _minFill(0), _underrunBytes(0), _readerResetSeen(0),
+      _resetRequest(0)
+{
+    // Over-allocate so the data can start on a cache line of its own.
+    _storage.reset(new uint8_t[capacity() + CacheLineSize]);
+    _data = _storage.get() + (-(uintptr_t)_storage.get() & (CacheLineSize - 1));
+    memset(_data, 0, capacity());
+    _minFill.store(capacity(), std::memory_order_relaxed);
+}
+
+PVAudioRing::~PVAudioRing()
+{
+}
+
+void PVAudioRing::commitWrite(const PVAudioRingSegment *segments, size_t count, size_t length)
+{
+    const size_t head = _head.load(std::memory_order_relaxed);
+    size_t pos = head;
+    size_t remaining = length;
+
+    for (size_t i = 0; i < count && remaining; i++) {
+        const uint8_t *src = (const uint8_t *)segments[i].data;
+        size_t n = segments[i].length < remaining ? segments[i].length : remaining;
+
+        remaining -= n;
+        while (n) {
+            const size_t offset = pos & _mask;
+            const size_t chunk = n < capacity() - offset ? n : capacity() - offset;
+
+            memcpy(_data + offset, src, chunk);
+            src += chunk;
+            pos += chunk;
+            n -= chunk;
+        }
+    }
+
+    _head.store(head + length, std::memory_order_release);
+
+    const uint32_t reset = _resetRequest.load(std::memory_order_relaxed);
+    const size_t fill = head + length - _cachedTail;
+
+    if (reset != _writerResetSeen) {
+        _writerResetSeen = reset;
+        _maxFill.store(fill, std::memory_order_relaxed);
+    } else if (fill > _maxFill.load(std::memory_order_relaxed))
+        _maxFill.store(fill, std::memory_order_relaxed);
+}
+
+size_t PVAudioRing::writeSegments(const PVAudioRingSegment *segments, size_t count)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < count; i++)
+        total += segments[i].length;
+
+    const size_t space = freeSpaceForWriter();
+    const size_t length = total < space ? total : space;
+
+    if (length < total)
+        _overrunBytes.fetch_add(total - length, std::memory_order_relaxed);
+    commitWrite(segments, count, length);
+    return length;
+}
+
+size_t PVAudioRing::read(void *data, size_t length)
+{
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    const size_t fill = _head.load(std::memory_order_acquire) - tail;
+    const size_t n = length < fill ? length : fill;
+    const size_t offset = tail & _mask;
+    const size_t first = n < capacity() - offset ? n : capacity() - offset;
+
+    memcpy(data, _data + offset, first);
+    memcpy((uint8_t *)data + first, _data, n - first);
+    _tail.store(tail + n, std::memory_order_release);
+
+    if (n < length)
+        _underrunBytes.fetch_add(length - n, std::memory_order_relaxed);
+
+    const uint32_t reset = _resetRequest.load(std::memory_order_relaxed);
+
+    if (reset != _readerResetSeen) {
+        _readerResetSeen = reset;
+        _minFill.store(fill - n, std::memory_order_relaxed);
+    } else if (fill - n < _minFill.load(std::memory_order_relaxed))
+        _minFill.store(fill - n, std::memory_order_relaxed);
+
+    return n;
+}
+
+void PVAudioRing::clear()
+{
+    _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+PVAudioRingStats PVAudioRing::stats() const
+{
+    PVAudioRingStats s;
+    const size_t tail = _tail.load(std::memory_order_acquire);
+    const size_t head = _head.load(std::memory_order_acquire);
+
+    s.capacity = capacity();
+    s.fill = head - tail;
+    s.minFill = _minFill.load(std::memory_order_relaxed);
+    s.maxFill = _maxFill.load(std::memory_order_relaxed);
+    s.bytesWritten = head;
+    s.bytesRead = tail;
+    s.overrunBytes = _overrunBytes.load(std::memory_order_relaxed);
+    s.underrunBytes = _underrunBytes.load(std::memory_order_relaxed);
+
+    return s;
+}
+
+// MARK: - C interface
+
+PVAudioRing *PVAudioRingCreate(size_t capacity)
+{
+    try {
+        return new PVAudioRing(capacity);
+    } catch (const std::bad_alloc &) {
+        return NULL;
+    }
+}
+
+void PVAudioRingDestroy(PVAudioRing *ring)
+{
+    delete ring;
+}
+
+size_t PVAudioRingWrite(PVAudioRing *ring, const void *data, size_t length)
+{
+    return ring->write(data, length);
+}
+
+size_t PVAudioRingWriteSegments(PVAudioRing *ring, const PVAudioRingSegment *segments, size_t count)
+{
+    return ring->writeSegments(segments, count);
+}
+
+size_t PVAudioRingWriteFrames(PVAudioRing *ring, const int16_t *samples, size_t frames, unsigned channels)
+{
+    return ring->writeFrames(samples, frames, channels);
+}
+
+size_t PVAudioRingRead(PVAudioRing *ring, void *data, size_t length)
+{
+    return ring->read(data, length);
+}
+
+void PVAudioRingClear(PVAudioRing *ring)
+{
+    ring->clear();
+}
+
+size_t PVAudioRingAvailableToRead(const PVAudioRing *ring)
+{
+    return ring->availableToRead();
+}
+
+size_t PVAudioRingAvailableToWrite(const PVAudioRing *ring)
+{
+    return ring->availableToWrite();
+}
+
+void PVAudioRingGetStats(const PVAudioRing *ring, PVAudioRingStats *stats)
+{
+    *stats = ring->stats();
+}
+
+void PVAudioRingResetWatermarks(PVAudioRing *ring)
+{
+    ring->resetWatermarks();
+}
+
+double PVAudioRingRateAdjustment(const PVAudioRing *ring, double maxDelta)
+{
+    return 1.0 + maxDelta * (1.0 - 2.0 * ring->fillRatio());
+}
@@ -0,0 +1,190 @@
+//
+//  PVAudioRing.h
+//  PVSupport
+//
+//  Single-producer/single-consumer audio ring buffer.
+//
+//  The emulator thread writes, the audio render callback reads. Neither side
+//  takes a lock or allocates: the storage is allocated once up front, and the
+//  only shared state is a pair of monotonically increasing byte positions that
+//  live on separate cache lines, so the two threads don't keep stealing the
+//  same line from each other. Each write or read touches the other side's
+//  line exactly once, to load its position.
+//
+//  Fill-level telemetry (high/low watermarks, overrun and underrun counts) is
+//  kept alongside so a core can do dynamic rate control; see
+//  PVAudioRingRateAdjustment().
+//
+//  The C interface is usable from Objective-C and Swift; C++ code can use the
+//  class directly.
+//
+
+#ifndef PVAudioRing_h
+#define PVAudioRing_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct PVAudioRingSegment {
+    const void *data;
+    size_t      length;     // In bytes.
+} PVAudioRingSegment;
+
+typedef struct PVAudioRingStats {
+    size_t   capacity;      // Usable size in bytes.
+    size_t   fill;          // Bytes currently buffered.
+    size_t   minFill;       // Lowest fill left after a read since the last reset.
+    size_t   maxFill;       // Highest fill after a write since the last reset.
+    uint64_t bytesWritten;
+    uint64_t bytesRead;
+    uint64_t overrunBytes;  // Bytes the writer had to drop because the ring was full.
+    uint64_t underrunBytes; // Bytes the reader asked for that weren't there.
+} PVAudioRingStats;
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <memory>
+
+class PVAudioRing {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit PVAudioRing(size_t capacity);
+    ~PVAudioRing();
+
+    PVAudioRing(const PVAudioRing &) = delete;
+    PVAudioRing &operator=(const PVAudioRing &) = delete;
+
+    size_t capacity() const { return _mask + 1; }
+
+    // Producer side. Each returns the number of bytes actually written; what
+    // doesn't fit is dropped and counted as an overrun.
+    size_t write(const void *data, size_t length) {
+        PVAudioRingSegment seg = { data, length };
+        return writeSegments(&seg, 1);
+    }
+
+    // Writes the segments back to back and publishes them with a single store,
+    // so the reader never sees a partially written batch.
+    size_t writeSegments(const PVAudioRingSegment *segments, size_t count);
+
+    // Interleaved 16-bit frames, e.g. straight from EmulateSpecStruct::SoundBuf.
+    // Only whole frames are written; returns the number of frames written.
+    size_t writeFrames(const int16_t *samples, size_t frames, unsigned channels) {
+        const size_t frameSize = channels * sizeof(int16_t);
+        const size_t fit = freeSpaceForWriter() / frameSize;
+        const size_t n = frames < fit ? frames : fit;
+        const PVAudioRingSegment seg = { samples, n * frameSize };
+
+        if (n < frames)
+            _overrunBytes.fetch_add((frames - n) * frameSize, std::memory_order_relaxed);
+        commitWrite(&seg, 1, n * frameSize);
+        return n;
+    }
+
+    // Consumer side. Returns the number of bytes read; the shortfall, if any,
+    // is counted as an underrun.
+    size_t read(void *data, size_t length);
+
+    // Drops everything buffered. Consumer side only.
+    void clear();
+
+    // Safe to call from either side, or a third thread.
+    size_t availableToRead() const {
+        // Tail first: head only ever moves forward, so this can't go negative.
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        return _head.load(std::memory_order_acquire) - tail;
+    }
+    size_t availableToWrite() const { return capacity() - availableToRead(); }
+    double fillRatio() const { return (double)availableToRead() / capacity(); }
+
+    PVAudioRingStats stats() const;
+
+    // Restarts the watermarks. Each side applies it on its next write/read, so
+    // this doesn't touch state owned by the other thread.
+    void resetWatermarks() { _resetRequest.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    // Keeps the producer and consumer fields on different cache lines. Padding
+    // rather than alignas() so that plain operator new can still be used
+    // before C++17.
+    enum { CacheLineSize = 64 };
+
+    // Also leaves the reader's position in _cachedTail for commitWrite().
+    size_t freeSpaceForWriter() {
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        return capacity() - (_head.load(std::memory_order_relaxed) - _cachedTail);
+    }
+
+    void commitWrite(const PVAudioRingSegment *segments, size_t count, size_t length);
+
+    // Immutable after construction.
+    uint8_t *_data;
+    size_t _mask;
+    std::unique_ptr<uint8_t[]> _storage;
+
+    char _pad0[CacheLineSize];
+
+    // Producer-owned.
+    std::atomic<size_t> _head;
+    size_t _cachedTail;
+    std::atomic<size_t> _maxFill;
+    std::atomic<uint64_t> _overrunBytes;
+    uint32_t _writerResetSeen;
+
+    char _pad1[CacheLineSize];
+
+    // Consumer-owned.
+    std::atomic<size_t> _tail;
+    std::atomic<size_t> _minFill;
+    std::atomic<uint64_t> _underrunBytes;
+    uint32_t _readerResetSeen;
+
+    char _pad2[CacheLineSize];
+
+    std::atomic<uint32_t> _resetRequest;
+};
+
+#else
+
+typedef struct PVAudioRing PVAudioRing;
+
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+PVAudioRing *PVAudioRingCreate(size_t capacity);
+void PVAudioRingDestroy(PVAudioRing *ring);
+
+size_t PVAudioRingWrite(PVAudioRing *ring, const void *data, size_t length);
+size_t PVAudioRingWriteSegments(PVAudioRing *ring, const PVAudioRingSegment *segments, size_t count);
+size_t PVAudioRingWriteFrames(PVAudioRing *ring, const int16_t *samples, size_t frames, unsigned channels);
+size_t PVAudioRingRead(PVAudioRing *ring, void *data, size_t length);
+void PVAudioRingClear(PVAudioRing *ring);
+
+size_t PVAudioRingAvailableToRead(const PVAudioRing *ring);
+size_t PVAudioRingAvailableToWrite(const PVAudioRing *ring);
+void PVAudioRingGetStats(const PVAudioRing *ring, PVAudioRingStats *stats);
+void PVAudioRingResetWatermarks(PVAudioRing *ring);
+
+// Resampling ratio for dynamic rate control: 1.0 at half full, drifting by up
+// to +/- maxDelta as the ring empties/fills. Multiply the core's output rate
+// by it so the fill level settles around the middle instead of slowly
+// draining or overflowing when the host and emulated clocks disagree.
+double PVAudioRingRateAdjustment(const PVAudioRing *ring, double maxDelta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PVAudioRing_h */
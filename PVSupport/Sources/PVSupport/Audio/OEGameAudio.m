@@ -36,6 +36,7 @@
 typedef struct
 {
     TPCircularBuffer *buffer;
+    PVAudioRing *ring;  // Read instead of buffer when the core has one.
     int channelCount;
     int bytesPerSample;
 } OEGameAudioContext;
@@ -88,13 +89,21 @@ OSStatus RenderCallback(void                       *in,
 
 
     OEGameAudioContext *context = (OEGameAudioContext*)in;
-    uint32_t availableBytes = 0;
-    void *head = TPCircularBufferTail(context->buffer, &availableBytes);
     int bytesRequested = inNumberFrames * context->bytesPerSample * context->channelCount;
-    availableBytes = MIN(availableBytes, bytesRequested);
     char *outBuffer = ioData->mBuffers[0].mData;
     if(outBuffer == nil) { return noErr; }
 
+    if (context->ring) {
+        // Lock-free; a shortfall is counted as an underrun and played as silence.
+        size_t readBytes = PVAudioRingRead(context->ring, outBuffer, bytesRequested);
+        memset(outBuffer + readBytes, 0, bytesRequested - readBytes);
+        return noErr;
+    }
+
+    uint32_t availableBytes = 0;
+    void *head = TPCircularBufferTail(context->buffer, &availableBytes);
+    availableBytes = MIN(availableBytes, bytesRequested);
+
     if (availableBytes) {
         memcpy(outBuffer, head, availableBytes);
     } else {
@@ -232,8 +241,12 @@ PV_OBJC_DIRECT_MEMBERS
     _contexts = malloc(sizeof(OEGameAudioContext) * bufferCount);
     
     for (int i = 0; i < bufferCount; ++i) {
+		PVAudioRing *ring = [gameCore audioRingAtIndex:i];
+		if (ring) {
+			PVAudioRingClear(ring);
+		}
 		TPCircularBufferClear(&([gameCore ringBufferAtIndex:i]->buffer));
-		_contexts[i] = (OEGameAudioContext){&([gameCore ringBufferAtIndex:i]->buffer), (int)[gameCore channelCountForBuffer:i], (int)([gameCore audioBitDepth] /8)};
+		_contexts[i] = (OEGameAudioContext){&([gameCore ringBufferAtIndex:i]->buffer), ring, (int)[gameCore channelCountForBuffer:i], (int)([gameCore audioBitDepth] /8)};
         
         //Create the converter node
         err = AUGraphAddNode(mGraph, (const AudioComponentDescription *)&desc, &mConverterNode);
@@ -20,8 +20,10 @@
 
 #if SWIFT_PACKAGE
 #import <DebugUtils.h>
+#import <PVAudioRing.h>
 #else
 #import <PVSupport/DebugUtils.h>
+#import <PVSupport/PVAudioRing.h>
 #endif
 
 #if TARGET_OS_OSX
@@ -180,6 +182,9 @@ typedef NS_ENUM(NSInteger, GLESVersion) {
 - (NSUInteger)audioBufferSizeForBuffer:(NSUInteger)buffer;
 - (double)audioSampleRateForBuffer:(NSUInteger)buffer;
 - (OERingBuffer * _Nonnull)ringBufferAtIndex:(NSUInteger)index;
+// Cores that write their audio to a PVAudioRing return it here, and it's read
+// instead of the OERingBuffer. NULL by default.
+- (PVAudioRing * _Nullable)audioRingAtIndex:(NSUInteger)index;
 
 - (BOOL)saveStateToFileAtPath:(NSString * _Nonnull)path
                         error:(NSError * __nullable * __nullable)error DEPRECATED_MSG_ATTRIBUTE("Use saveStateToFileAtPath:completionHandler: instead.");
@@ -464,6 +464,12 @@ NSString *const PVEmulatorCoreErrorDomain = @"org.provenance-emu.EmulatorCore.Er
 
 - (void)getAudioBuffer:(void *)buffer frameCount:(uint32_t)frameCount bufferIndex:(NSUInteger)index {
     uint32_t maxLength = (uint32_t)(frameCount * [self channelCountForBuffer:index] * self.audioBitDepth);
+    PVAudioRing *ring = [self audioRingAtIndex:index];
+
+    if (ring) {
+        PVAudioRingRead(ring, buffer, maxLength);
+        return;
+    }
 	[[self ringBufferAtIndex:index] read:buffer
                                maxLength:maxLength];
 }
@@ -510,6 +516,10 @@ NSString *const PVEmulatorCoreErrorDomain = @"org.provenance-emu.EmulatorCore.Er
     return ringBuffers[index];
 }
 
+- (PVAudioRing *)audioRingAtIndex:(NSUInteger)index {
+    return NULL;
+}
+
 -(NSUInteger)discCount {
     return 0;
 }
@@ -0,0 +1 @@
+../Audio/CARingBuffer/PVAudioRing.h
\ No newline at end of file
@@ -50,6 +50,7 @@ FOUNDATION_EXPORT const unsigned char PVSupport_FrameworkVersionString[];
     #import <PVSupport/TPCircularBuffer.h>
     #import <PVSupport/OERingBuffer.h>
     #import <PVSupport/OEGameAudio.h>
+    #import <PVSupport/PVAudioRing.h>
     #ifdef __cplusplus
         #import <PVSupport/CARingBuffer.h>
         //#import <PVSupport/CAAtomic.h>